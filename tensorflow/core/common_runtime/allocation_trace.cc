@@ -0,0 +1,262 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/allocation_trace.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Every trace starts with this magic number and a format version.
+constexpr uint32 kTraceMagic = 0x54464154;  // "TFAT"
+constexpr uint32 kTraceVersion = 1;
+constexpr size_t kHeaderSize = 8;
+
+// Buffered events are written once they take up this many bytes.
+constexpr size_t kWriteBlockSize = 64 << 10;
+
+thread_local int64 current_step_id = 0;
+
+}  // namespace
+
+constexpr uint64 AllocationTraceWriter::kFlushIntervalMicros;
+
+Status AllocationTraceWriter::Create(
+    Env* env, const string& filename,
+    std::unique_ptr<AllocationTraceWriter>* writer) {
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(filename, &file));
+  writer->reset(new AllocationTraceWriter(std::move(file)));
+  return (*writer)->Flush();
+}
+
+AllocationTraceWriter::AllocationTraceWriter(std::unique_ptr<WritableFile> file)
+    : file_(std::move(file)) {
+  core::PutFixed32(&buffer_, kTraceMagic);
+  core::PutFixed32(&buffer_, kTraceVersion);
+}
+
+AllocationTraceWriter::~AllocationTraceWriter() {
+  if (file_ != nullptr) {
+    Close().IgnoreError();
+  }
+}
+
+void AllocationTraceWriter::Record(const AllocationTraceEvent& event) {
+  if (!has_events_) {
+    last_micros_ = event.timestamp_micros;
+    last_flush_micros_ = event.timestamp_micros;
+    has_events_ = true;
+  }
+  // Events from different threads may not arrive in timestamp order.
+  const uint64 micros = std::max(last_micros_, event.timestamp_micros);
+
+  buffer_.push_back(static_cast<char>(event.type));
+  core::PutVarint64(&buffer_, micros - last_micros_);
+  core::PutVarint64(&buffer_, static_cast<uint64>(event.step_id));
+  core::PutVarint64(&buffer_, event.id);
+  if (event.type == AllocationTraceEvent::kAllocate) {
+    core::PutVarint64(&buffer_, event.num_bytes);
+    core::PutVarint32(&buffer_, event.alignment);
+  }
+  last_micros_ = micros;
+
+  if (buffer_.size() >= kWriteBlockSize ||
+      micros - last_flush_micros_ >= kFlushIntervalMicros) {
+    FlushBuffer();
+    last_flush_micros_ = micros;
+  }
+}
+
+void AllocationTraceWriter::FlushBuffer() {
+  if (status_.ok() && !buffer_.empty()) {
+    status_ = file_->Append(buffer_);
+    if (status_.ok()) {
+      status_ = file_->Flush();
+    }
+  }
+  buffer_.clear();
+}
+
+Status AllocationTraceWriter::Flush() {
+  if (file_ != nullptr) {
+    FlushBuffer();
+  }
+  return status_;
+}
+
+Status AllocationTraceWriter::Close() {
+  if (file_ == nullptr) {
+    return status_;
+  }
+  FlushBuffer();
+  if (status_.ok()) {
+    status_ = file_->Close();
+  }
+  file_.reset();
+  return status_;
+}
+
+Status ReadAllocationTrace(Env* env, const string& filename,
+                           std::vector<AllocationTraceEvent>* events) {
+  string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, filename, &contents));
+  if (contents.size() < kHeaderSize ||
+      core::DecodeFixed32(contents.data()) != kTraceMagic) {
+    return errors::DataLoss("Not an allocation trace: ", filename);
+  }
+  const uint32 version = core::DecodeFixed32(contents.data() + 4);
+  if (version != kTraceVersion) {
+    return errors::Unimplemented("Unsupported allocation trace version ",
+                                 version, " in ", filename);
+  }
+
+  StringPiece input(contents);
+  input.remove_prefix(kHeaderSize);
+  uint64 micros = 0;
+  while (!input.empty()) {
+    AllocationTraceEvent event;
+    const uint8 type = static_cast<uint8>(input[0]);
+    input.remove_prefix(1);
+    uint64 delta_micros, step_id;
+    bool ok = type <= AllocationTraceEvent::kDeallocate &&
+              core::GetVarint64(&input, &delta_micros) &&
+              core::GetVarint64(&input, &step_id) &&
+              core::GetVarint64(&input, &event.id);
+    if (ok && type == AllocationTraceEvent::kAllocate) {
+      ok = core::GetVarint64(&input, &event.num_bytes) &&
+           core::GetVarint32(&input, &event.alignment);
+    }
+    if (!ok) {
+      return errors::DataLoss("Corrupt allocation trace record ",
+                              events->size(), " in ", filename);
+    }
+    micros += delta_micros;
+    event.type = static_cast<AllocationTraceEvent::Type>(type);
+    event.timestamp_micros = micros;
+    event.step_id = static_cast<int64>(step_id);
+    events->push_back(event);
+  }
+  return Status::OK();
+}
+
+ScopedAllocationTraceStep::ScopedAllocationTraceStep(int64 step_id)
+    : previous_step_id_(current_step_id) {
+  current_step_id = step_id;
+}
+
+ScopedAllocationTraceStep::~ScopedAllocationTraceStep() {
+  current_step_id = previous_step_id_;
+}
+
+int64 ScopedAllocationTraceStep::CurrentStepId() { return current_step_id; }
+
+string AllocationTraceReplayStats::DebugString() const {
+  return strings::StrCat(
+      "Allocations:          ", num_allocs, "\n",
+      "Deallocations:        ", num_deallocs, "\n",
+      "Failed allocations:   ", num_failed_allocs, "\n",
+      "Recovered failures:   ", num_recovered_allocs, "\n",
+      "Peak requested bytes: ", peak_requested_bytes, "\n",
+      "Peak bytes in use:    ", peak_bytes_in_use, "\n",
+      "Fragmentation:        ", fragmentation, "\n",
+      "AllocateRaw latency (ns):\n", allocate_nanos.ToString(),
+      "DeallocateRaw latency (ns):\n", deallocate_nanos.ToString());
+}
+
+void ReplayAllocationTrace(const std::vector<AllocationTraceEvent>& events,
+                           Allocator* allocator,
+                           AllocationTraceReplayStats* stats) {
+  struct LiveAllocation {
+    void* ptr;
+    uint64 num_bytes;
+  };
+  // Maps ids in the trace to the replayed allocations.
+  std::unordered_map<uint64, LiveAllocation> live;
+  Env* env = Env::Default();
+  AllocationAttributes attrs;
+  attrs.no_retry_on_failure = true;
+  int64 requested_bytes = 0;
+  int64 requested_bytes_at_peak = 0;
+
+  auto deallocate = [&](void* ptr) {
+    const uint64 start_nanos = env->NowNanos();
+    allocator->DeallocateRaw(ptr);
+    stats->deallocate_nanos.Add(env->NowNanos() - start_nanos);
+    ++stats->num_deallocs;
+  };
+
+  for (const AllocationTraceEvent& event : events) {
+    if (event.type == AllocationTraceEvent::kDeallocate) {
+      auto it = live.find(event.id);
+      if (it == live.end()) {
+        // The allocation failed during replay, or predates the trace.
+        continue;
+      }
+      deallocate(it->second.ptr);
+      requested_bytes -= it->second.num_bytes;
+      live.erase(it);
+      continue;
+    }
+
+    const size_t alignment = std::max<size_t>(event.alignment, 1);
+    const uint64 start_nanos = env->NowNanos();
+    void* ptr = allocator->AllocateRaw(alignment, event.num_bytes, attrs);
+    stats->allocate_nanos.Add(env->NowNanos() - start_nanos);
+    ++stats->num_allocs;
+    if (event.id == 0) {
+      if (ptr != nullptr) {
+        ++stats->num_recovered_allocs;
+        deallocate(ptr);
+      }
+      continue;
+    }
+    if (ptr == nullptr) {
+      ++stats->num_failed_allocs;
+      continue;
+    }
+    DCHECK_EQ(live.count(event.id), 0);
+    live[event.id] = LiveAllocation{ptr, event.num_bytes};
+    requested_bytes += event.num_bytes;
+    stats->peak_requested_bytes =
+        std::max(stats->peak_requested_bytes, requested_bytes);
+
+    absl::optional<AllocatorStats> allocator_stats = allocator->GetStats();
+    if (allocator_stats &&
+        allocator_stats->bytes_in_use > stats->peak_bytes_in_use) {
+      stats->peak_bytes_in_use = allocator_stats->bytes_in_use;
+      requested_bytes_at_peak = requested_bytes;
+    }
+  }
+
+  if (stats->peak_bytes_in_use > 0) {
+    stats->fragmentation =
+        1.0 - static_cast<double>(requested_bytes_at_peak) /
+                  static_cast<double>(stats->peak_bytes_in_use);
+  }
+  for (const auto& allocation : live) {
+    deallocate(allocation.second.ptr);
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,148 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_ALLOCATION_TRACE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_ALLOCATION_TRACE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/histogram/histogram.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// One AllocateRaw() or DeallocateRaw() call on a traced allocator.
+struct AllocationTraceEvent {
+  enum Type : uint8 { kAllocate = 0, kDeallocate = 1 };
+
+  Type type = kAllocate;
+  // When the call was made, in microseconds since the trace started.
+  uint64 timestamp_micros = 0;
+  // The step the calling thread was running, or 0 outside of a step. See
+  // ScopedAllocationTraceStep.
+  int64 step_id = 0;
+  // Identifies an allocation: the events that allocate and deallocate the
+  // same buffer have the same id. 0 for an allocation that failed.
+  uint64 id = 0;
+  // Only set for kAllocate events.
+  uint64 num_bytes = 0;
+  uint32 alignment = 0;
+};
+
+// Writes allocation events to a file in a compact binary format: a fixed
+// header followed by one varint-encoded record per event, with timestamps
+// delta-encoded. Events are buffered and written in blocks, or once
+// kFlushIntervalMicros have passed since the last write, so that the file is
+// readable while the trace is still being recorded. Not thread-safe.
+class AllocationTraceWriter {
+ public:
+  // Buffered events are written once the newest event is this much later
+  // than the last write, even if they don't fill a block.
+  static constexpr uint64 kFlushIntervalMicros = 1000000;
+
+  // Creates `filename` and writes the trace header to it.
+  static Status Create(Env* env, const string& filename,
+                       std::unique_ptr<AllocationTraceWriter>* writer);
+
+  ~AllocationTraceWriter();
+
+  // Appends `event`, with its timestamp taken as absolute micros. Write
+  // errors are reported by Flush() and Close().
+  void Record(const AllocationTraceEvent& event);
+
+  // Writes buffered events to the file.
+  Status Flush();
+
+  // Writes buffered events and closes the file.
+  Status Close();
+
+ private:
+  explicit AllocationTraceWriter(std::unique_ptr<WritableFile> file);
+
+  void FlushBuffer();
+
+  std::unique_ptr<WritableFile> file_;
+  string buffer_;
+  bool has_events_ = false;
+  uint64 last_micros_ = 0;
+  uint64 last_flush_micros_ = 0;
+  Status status_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AllocationTraceWriter);
+};
+
+// Reads every event of a trace written by AllocationTraceWriter.
+Status ReadAllocationTrace(Env* env, const string& filename,
+                           std::vector<AllocationTraceEvent>* events);
+
+// Tags the allocations made by the current thread, while in scope, with
+// `step_id`. The executor opens one around each node it processes.
+class ScopedAllocationTraceStep {
+ public:
+  explicit ScopedAllocationTraceStep(int64 step_id);
+  ~ScopedAllocationTraceStep();
+
+  // The step id of the innermost scope on this thread, or 0.
+  static int64 CurrentStepId();
+
+ private:
+  const int64 previous_step_id_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedAllocationTraceStep);
+};
+
+// Results of replaying a trace against an allocator.
+struct AllocationTraceReplayStats {
+  int64 num_allocs = 0;
+  int64 num_deallocs = 0;
+  // Traced allocations that the replay allocator failed to satisfy, and
+  // traced failures that the replay allocator could satisfy.
+  int64 num_failed_allocs = 0;
+  int64 num_recovered_allocs = 0;
+
+  // Peak of the bytes requested by live allocations.
+  int64 peak_requested_bytes = 0;
+  // Peak bytes in use, as reported by the allocator's GetStats(), or 0 if
+  // it doesn't report them.
+  int64 peak_bytes_in_use = 0;
+  // Fraction of the bytes in use that weren't requested, at the moment the
+  // bytes in use peaked, or 0 if unknown.
+  double fragmentation = 0;
+
+  // Latency of each AllocateRaw() and DeallocateRaw() call, in nanoseconds.
+  histogram::Histogram allocate_nanos;
+  histogram::Histogram deallocate_nanos;
+
+  string DebugString() const;
+};
+
+// Replays `events` in order against `allocator`, as fast as possible, and
+// frees whatever the trace leaves allocated. Allocations are made with
+// `no_retry_on_failure`, since nothing else would free memory while one
+// waits. Allocations whose id is 0 in the trace (i.e. that failed when
+// traced) are attempted and immediately freed if they succeed.
+void ReplayAllocationTrace(const std::vector<AllocationTraceEvent>& events,
+                           Allocator* allocator,
+                           AllocationTraceReplayStats* stats);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_ALLOCATION_TRACE_H_
@@ -0,0 +1,233 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/allocation_trace.h"
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+#include "tensorflow/core/common_runtime/pool_allocator.h"
+#include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+string TracePath(const string& name) {
+  return io::JoinPath(testing::TmpDir(), name);
+}
+
+AllocationTraceEvent Allocate(uint64 micros, int64 step_id, uint64 id,
+                              uint64 num_bytes) {
+  AllocationTraceEvent event;
+  event.type = AllocationTraceEvent::kAllocate;
+  event.timestamp_micros = micros;
+  event.step_id = step_id;
+  event.id = id;
+  event.num_bytes = num_bytes;
+  event.alignment = 64;
+  return event;
+}
+
+AllocationTraceEvent Deallocate(uint64 micros, int64 step_id, uint64 id) {
+  AllocationTraceEvent event;
+  event.type = AllocationTraceEvent::kDeallocate;
+  event.timestamp_micros = micros;
+  event.step_id = step_id;
+  event.id = id;
+  return event;
+}
+
+TEST(AllocationTraceTest, WriteAndRead) {
+  const string path = TracePath("write_and_read.alloc_trace");
+  std::unique_ptr<AllocationTraceWriter> writer;
+  TF_ASSERT_OK(AllocationTraceWriter::Create(Env::Default(), path, &writer));
+  writer->Record(Allocate(1000, 7, 0x1000, 256));
+  writer->Record(Allocate(1005, -1, 0x2000, 1 << 30));
+  // Out-of-order timestamps are clamped.
+  writer->Record(Deallocate(1003, 7, 0x1000));
+  writer->Record(Deallocate(1010, 0, 0x2000));
+  TF_ASSERT_OK(writer->Close());
+
+  std::vector<AllocationTraceEvent> events;
+  TF_ASSERT_OK(ReadAllocationTrace(Env::Default(), path, &events));
+  ASSERT_EQ(4, events.size());
+
+  EXPECT_EQ(AllocationTraceEvent::kAllocate, events[0].type);
+  EXPECT_EQ(0, events[0].timestamp_micros);
+  EXPECT_EQ(7, events[0].step_id);
+  EXPECT_EQ(0x1000, events[0].id);
+  EXPECT_EQ(256, events[0].num_bytes);
+  EXPECT_EQ(64, events[0].alignment);
+
+  EXPECT_EQ(5, events[1].timestamp_micros);
+  EXPECT_EQ(-1, events[1].step_id);
+  EXPECT_EQ(1 << 30, events[1].num_bytes);
+
+  EXPECT_EQ(AllocationTraceEvent::kDeallocate, events[2].type);
+  EXPECT_EQ(5, events[2].timestamp_micros);
+  EXPECT_EQ(0x1000, events[2].id);
+  EXPECT_EQ(10, events[3].timestamp_micros);
+}
+
+TEST(AllocationTraceTest, RejectsCorruptTrace) {
+  const string path = TracePath("corrupt.alloc_trace");
+  std::vector<AllocationTraceEvent> events;
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path, "not a trace"));
+  EXPECT_TRUE(
+      errors::IsDataLoss(ReadAllocationTrace(Env::Default(), path, &events)));
+
+  std::unique_ptr<AllocationTraceWriter> writer;
+  TF_ASSERT_OK(AllocationTraceWriter::Create(Env::Default(), path, &writer));
+  writer->Record(Allocate(0, 0, 0x1000, 1 << 20));
+  TF_ASSERT_OK(writer->Close());
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), path, &contents));
+  contents.pop_back();
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path, contents));
+  EXPECT_TRUE(
+      errors::IsDataLoss(ReadAllocationTrace(Env::Default(), path, &events)));
+}
+
+TEST(AllocationTraceTest, FlushesWithoutClose) {
+  const string path = TracePath("flush.alloc_trace");
+  std::unique_ptr<AllocationTraceWriter> writer;
+  TF_ASSERT_OK(AllocationTraceWriter::Create(Env::Default(), path, &writer));
+
+  // The header is written as soon as the trace is created.
+  std::vector<AllocationTraceEvent> events;
+  TF_ASSERT_OK(ReadAllocationTrace(Env::Default(), path, &events));
+  EXPECT_TRUE(events.empty());
+
+  // Events are written once the flush interval has passed, even though they
+  // are far from filling a block.
+  const uint64 interval = AllocationTraceWriter::kFlushIntervalMicros;
+  writer->Record(Allocate(100, 1, 0x1000, 512));
+  writer->Record(Deallocate(200, 1, 0x1000));
+  writer->Record(Allocate(100 + interval, 2, 0x2000, 256));
+  TF_ASSERT_OK(ReadAllocationTrace(Env::Default(), path, &events));
+  ASSERT_EQ(3, events.size());
+  EXPECT_EQ(0x2000, events[2].id);
+  EXPECT_EQ(100 + interval, events[2].timestamp_micros);
+
+  // Flush() writes the rest.
+  writer->Record(Deallocate(200 + interval, 2, 0x2000));
+  TF_ASSERT_OK(writer->Flush());
+  events.clear();
+  TF_ASSERT_OK(ReadAllocationTrace(Env::Default(), path, &events));
+  ASSERT_EQ(4, events.size());
+  EXPECT_EQ(AllocationTraceEvent::kDeallocate, events[3].type);
+}
+
+TEST(AllocationTraceTest, StopAllAllocationTraces) {
+  const string path = TracePath("stop_all.alloc_trace");
+  BFCAllocator a(new BasicCPUAllocator(port::kNUMANoAffinity, {}, {}),
+                 1 << 24, true, "cpu_bfc");
+  TF_ASSERT_OK(a.StartAllocationTrace(path));
+  a.DeallocateRaw(a.AllocateRaw(64, 1024));
+
+  // This is what runs at exit, for allocators that are never destroyed.
+  BFCAllocator::StopAllAllocationTraces();
+  EXPECT_FALSE(a.StopAllocationTrace().ok());
+
+  std::vector<AllocationTraceEvent> events;
+  TF_ASSERT_OK(ReadAllocationTrace(Env::Default(), path, &events));
+  ASSERT_EQ(2, events.size());
+  EXPECT_EQ(AllocationTraceEvent::kAllocate, events[0].type);
+  EXPECT_EQ(1024, events[0].num_bytes);
+  EXPECT_EQ(AllocationTraceEvent::kDeallocate, events[1].type);
+}
+
+TEST(AllocationTraceTest, RecordAndReplayBFCAllocator) {
+  const string path = TracePath("bfc.alloc_trace");
+  {
+    BFCAllocator a(new BasicCPUAllocator(port::kNUMANoAffinity, {}, {}),
+                   1 << 24, true, "cpu_bfc");
+    void* before = a.AllocateRaw(64, 1024);
+    TF_ASSERT_OK(a.StartAllocationTrace(path));
+    EXPECT_FALSE(a.StartAllocationTrace(path).ok());
+    {
+      ScopedAllocationTraceStep step(42);
+      void* p1 = a.AllocateRaw(64, 1000);
+      void* p2 = a.AllocateRaw(64, 3000);
+      a.DeallocateRaw(p1);
+      a.DeallocateRaw(before);
+      a.DeallocateRaw(p2);
+    }
+    // Too large for the allocator to satisfy.
+    AllocationAttributes attrs;
+    attrs.no_retry_on_failure = true;
+    EXPECT_EQ(nullptr, a.AllocateRaw(64, 1 << 25, attrs));
+    TF_ASSERT_OK(a.StopAllocationTrace());
+    a.DeallocateRaw(a.AllocateRaw(64, 16));
+  }
+
+  std::vector<AllocationTraceEvent> events;
+  TF_ASSERT_OK(ReadAllocationTrace(Env::Default(), path, &events));
+  ASSERT_EQ(6, events.size());
+  EXPECT_EQ(AllocationTraceEvent::kAllocate, events[0].type);
+  EXPECT_EQ(42, events[0].step_id);
+  EXPECT_EQ(1000, events[0].num_bytes);
+  EXPECT_EQ(3000, events[1].num_bytes);
+  EXPECT_EQ(events[0].id, events[2].id);
+  EXPECT_EQ(AllocationTraceEvent::kDeallocate, events[3].type);
+  EXPECT_EQ(events[1].id, events[4].id);
+  EXPECT_EQ(0, events[5].step_id);
+  EXPECT_EQ(0, events[5].id);
+
+  // The deallocation of `before` has nothing to replay, and the failed
+  // allocation fails again.
+  BFCAllocator replay(new BasicCPUAllocator(port::kNUMANoAffinity, {}, {}),
+                      1 << 24, true, "replay_bfc");
+  AllocationTraceReplayStats stats;
+  ReplayAllocationTrace(events, &replay, &stats);
+  EXPECT_EQ(3, stats.num_allocs);
+  EXPECT_EQ(2, stats.num_deallocs);
+  EXPECT_EQ(0, stats.num_failed_allocs);
+  EXPECT_EQ(0, stats.num_recovered_allocs);
+  EXPECT_EQ(4000, stats.peak_requested_bytes);
+  // 1000 and 3000 bytes round up to 1024 and 3072.
+  EXPECT_EQ(4096, stats.peak_bytes_in_use);
+  EXPECT_NEAR(1.0 - 4000.0 / 4096.0, stats.fragmentation, 1e-9);
+  HistogramProto allocate_nanos;
+  stats.allocate_nanos.EncodeToProto(&allocate_nanos, false);
+  EXPECT_EQ(3, allocate_nanos.num());
+  EXPECT_EQ(0, replay.GetStats()->bytes_in_use);
+}
+
+TEST(AllocationTraceTest, ReplayFreesLiveAllocations) {
+  std::vector<AllocationTraceEvent> events = {
+      Allocate(0, 1, 0x1000, 512),
+      Allocate(1, 1, 0x2000, 1 << 20),
+      Allocate(2, 1, 0x3000, 256),
+      Deallocate(3, 1, 0x3000),
+  };
+  BFCAllocator replay(new BasicCPUAllocator(port::kNUMANoAffinity, {}, {}),
+                      1 << 16, false, "replay_bfc");
+  AllocationTraceReplayStats stats;
+  ReplayAllocationTrace(events, &replay, &stats);
+  EXPECT_EQ(3, stats.num_allocs);
+  EXPECT_EQ(1, stats.num_failed_allocs);
+  EXPECT_EQ(2, stats.num_deallocs);
+  EXPECT_EQ(768, stats.peak_requested_bytes);
+  EXPECT_EQ(0, replay.GetStats()->bytes_in_use);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -16,19 +16,40 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
 
 #include <atomic>
+#include <cstdlib>
+#include <unordered_set>
 
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
+namespace {
+
+// The allocators recording a trace, for StopAllAllocationTraces().
+mutex* TracingAllocatorsMu() {
+  static mutex* mu = new mutex;
+  return mu;
+}
+
+std::unordered_set<BFCAllocator*>* TracingAllocators() {
+  static auto* allocators = new std::unordered_set<BFCAllocator*>;
+  return allocators;
+}
+
+}  // namespace
+
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name,
                            bool garbage_collection,
@@ -74,9 +95,30 @@ BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
       CHECK_NE(BinForSize(bin_size * 2), BinFromIndex(b));
     }
   }
+
+  string trace_dir;
+  TF_CHECK_OK(
+      ReadStringFromEnvVar("TF_BFC_ALLOCATOR_TRACE_DIR", "", &trace_dir));
+  if (!trace_dir.empty()) {
+    const string filename = io::JoinPath(
+        trace_dir, strings::StrCat(name_, ".", Env::Default()->NowMicros(),
+                                   ".alloc_trace"));
+    Status s = StartAllocationTrace(filename);
+    if (s.ok()) {
+      LOG(INFO) << "Recording allocations of " << name_ << " to " << filename;
+    } else {
+      LOG(WARNING) << "Failed to start allocation trace for " << name_
+                   << ": " << s;
+    }
+  }
 }
 
 BFCAllocator::~BFCAllocator() {
+  {
+    mutex_lock l(*TracingAllocatorsMu());
+    TracingAllocators()->erase(this);
+  }
+
   // Return memory back.
   VLOG(2) << "Number of regions allocated: "
           << region_manager_.regions().size();
@@ -220,8 +262,12 @@ void* BFCAllocator::AllocateRawInternalWithRetry(
     return r;
   } else {
     static const int64 kMaxMillisToWait = 10000;  // 10 seconds
+    num_waiting_for_memory_.fetch_add(1);
     r = retry_helper_.AllocateRaw(
         [this, &allocation_attr](size_t a, size_t nb, bool v) {
+          // Chunks freed into the size-class caches can only satisfy this
+          // request once they're back in the bins.
+          FlushSizeClassCaches();
           uint64 freed_by_count = 0;
           if (allocation_attr.freed_by_func != nullptr) {
             freed_by_count = (*allocation_attr.freed_by_func)();
@@ -229,13 +275,33 @@ void* BFCAllocator::AllocateRawInternalWithRetry(
           return AllocateRawInternal(a, nb, v, freed_by_count);
         },
         kMaxMillisToWait, unused_alignment, num_bytes);
+    num_waiting_for_memory_.fetch_sub(1);
     return r;
   }
 }
 
-void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
+void* BFCAllocator::AllocateRaw(size_t alignment, size_t num_bytes,
                                 const AllocationAttributes& allocation_attr) {
+  void* result = AllocateRawUntraced(alignment, num_bytes, allocation_attr);
+  if (tracing_.load(std::memory_order_relaxed)) {
+    RecordTraceEvent(AllocationTraceEvent::kAllocate, result, num_bytes,
+                     alignment);
+  }
+  return result;
+}
+
+void* BFCAllocator::AllocateRawUntraced(
+    size_t unused_alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
   VLOG(1) << "AllocateRaw " << Name() << "  " << num_bytes;
+  if (size_class_caches_enabled() && num_bytes > 0 &&
+      num_bytes <= max_cached_bytes_ &&
+      allocation_attr.freed_by_func == nullptr && timing_counter_ == nullptr) {
+    void* result = AllocateFromCache(RoundedBytes(num_bytes), num_bytes);
+    if (result != nullptr) {
+      return result;
+    }
+  }
   if (allocation_attr.no_retry_on_failure) {
     // Return immediately upon the first failure if this is for allocating an
     // optional scratch space.
@@ -246,6 +312,11 @@ void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
     }
     void* result = AllocateRawInternal(unused_alignment, num_bytes,
                                        dump_log_on_failure, freed_by_count);
+    if (result == nullptr && size_class_caches_enabled()) {
+      FlushSizeClassCaches();
+      result = AllocateRawInternal(unused_alignment, num_bytes,
+                                   dump_log_on_failure, freed_by_count);
+    }
     if (result == nullptr) {
       static std::atomic<int32> log_counter{0};
       int32 counter_value = log_counter.load(std::memory_order_relaxed);
@@ -449,7 +520,8 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
 }
 
 void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
-                                 size_t num_bytes, uint64 freed_before) {
+                                 size_t num_bytes, uint64 freed_before,
+                                 bool for_cache) {
   // First identify the first bin that could satisfy rounded_bytes.
   for (; bin_num < kNumBins; bin_num++) {
     // Start searching from the first bin for the smallest chunk that fits
@@ -486,13 +558,19 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
         // chunk as being in use.
         chunk->allocation_id = next_allocation_id_++;
 
-        // Update stats.
-        ++stats_.num_allocs;
-        stats_.bytes_in_use += chunk->size;
-        stats_.peak_bytes_in_use =
-            std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
-        stats_.largest_alloc_size =
-            std::max<std::size_t>(stats_.largest_alloc_size, chunk->size);
+        // Update stats, unless a size-class cache accounts for the chunk.
+        if (!for_cache) {
+          ++stats_.num_allocs;
+          stats_.bytes_in_use += chunk->size;
+          uncached_bytes_in_use_.store(stats_.bytes_in_use,
+                                       std::memory_order_relaxed);
+          stats_.peak_bytes_in_use = std::max(
+              stats_.peak_bytes_in_use,
+              stats_.bytes_in_use +
+                  cached_bytes_in_use_.load(std::memory_order_relaxed));
+          stats_.largest_alloc_size =
+              std::max<std::size_t>(stats_.largest_alloc_size, chunk->size);
+        }
 
         VLOG(4) << "Returning: " << chunk->ptr;
         if (VLOG_IS_ON(4)) {
@@ -547,6 +625,13 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
 void BFCAllocator::DeallocateRaw(void* ptr) {
   VLOG(1) << "DeallocateRaw " << Name() << " "
           << (ptr ? RequestedSize(ptr) : 0);
+  if (ptr != nullptr && tracing_.load(std::memory_order_relaxed)) {
+    RecordTraceEvent(AllocationTraceEvent::kDeallocate, ptr, 0, 0);
+  }
+  if (ptr != nullptr && size_class_caches_enabled() &&
+      DeallocateToCache(ptr)) {
+    return;
+  }
   DeallocateRawInternal(ptr);
   retry_helper_.NotifyDealloc();
 }
@@ -646,7 +731,7 @@ void BFCAllocator::RemoveFreeChunkFromBin(BFCAllocator::ChunkHandle h) {
   c->bin_num = kInvalidBinNum;
 }
 
-void BFCAllocator::MarkFree(BFCAllocator::ChunkHandle h) {
+void BFCAllocator::MarkFree(BFCAllocator::ChunkHandle h, bool for_cache) {
   Chunk* c = ChunkFromHandle(h);
   CHECK(c->in_use() && (c->bin_num == kInvalidBinNum));
 
@@ -658,8 +743,12 @@ void BFCAllocator::MarkFree(BFCAllocator::ChunkHandle h) {
     c->freed_at_count = timing_counter_->next();
   }
 
-  // Updates the stats.
-  stats_.bytes_in_use -= c->size;
+  // Updates the stats, unless a size-class cache accounted for the chunk.
+  if (!for_cache) {
+    stats_.bytes_in_use -= c->size;
+    uncached_bytes_in_use_.store(stats_.bytes_in_use,
+                                 std::memory_order_relaxed);
+  }
 }
 
 BFCAllocator::ChunkHandle BFCAllocator::TryToCoalesce(ChunkHandle h,
@@ -783,6 +872,10 @@ bool BFCAllocator::TracksAllocationSizes() const { return true; }
 
 size_t BFCAllocator::RequestedSize(const void* ptr) const {
   CHECK(ptr);
+  CachedAllocation allocation;
+  if (FindCachedAllocation(ptr, &allocation)) {
+    return allocation.requested_size;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -952,15 +1045,318 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
 }
 
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
-  mutex_lock l(lock_);
-  return stats_;
+  AllocatorStats stats;
+  {
+    mutex_lock l(lock_);
+    stats = stats_;
+  }
+  if (size_class_caches_enabled()) {
+    stats.bytes_in_use += cached_bytes_in_use_.load(std::memory_order_relaxed);
+    stats.peak_bytes_in_use = std::max(
+        stats.peak_bytes_in_use,
+        cached_peak_bytes_in_use_.load(std::memory_order_relaxed));
+    stats.largest_alloc_size = std::max(
+        stats.largest_alloc_size,
+        cached_largest_alloc_size_.load(std::memory_order_relaxed));
+    for (const auto& cache : size_class_caches_) {
+      stats.num_allocs += cache->num_allocs.load(std::memory_order_relaxed);
+    }
+  }
+  return stats;
 }
 
 void BFCAllocator::ClearStats() {
   mutex_lock l(lock_);
   stats_.num_allocs = 0;
-  stats_.peak_bytes_in_use = stats_.bytes_in_use;
+  stats_.peak_bytes_in_use =
+      stats_.bytes_in_use +
+      cached_bytes_in_use_.load(std::memory_order_relaxed);
   stats_.largest_alloc_size = 0;
+  cached_peak_bytes_in_use_.store(stats_.peak_bytes_in_use,
+                                  std::memory_order_relaxed);
+  cached_largest_alloc_size_.store(0, std::memory_order_relaxed);
+  for (const auto& cache : size_class_caches_) {
+    cache->num_allocs.store(0, std::memory_order_relaxed);
+  }
+}
+
+Status BFCAllocator::StartAllocationTrace(const string& filename) {
+  std::unique_ptr<AllocationTraceWriter> writer;
+  TF_RETURN_IF_ERROR(
+      AllocationTraceWriter::Create(Env::Default(), filename, &writer));
+  mutex_lock registry_lock(*TracingAllocatorsMu());
+  {
+    mutex_lock l(trace_mu_);
+    if (trace_writer_ != nullptr) {
+      return errors::FailedPrecondition("Allocator ", name_,
+                                        " is already recording a trace");
+    }
+    trace_writer_ = std::move(writer);
+    tracing_.store(true, std::memory_order_relaxed);
+  }
+
+  // Close every trace at exit. Otherwise the tail of the trace is lost when the
+  // allocator outlives the process, as the process-wide allocators do.
+  static bool registered_at_exit = false;
+  if (!registered_at_exit) {
+    std::atexit(&BFCAllocator::StopAllAllocationTraces);
+    registered_at_exit = true;
+  }
+  TracingAllocators()->insert(this);
+  return Status::OK();
+}
+
+Status BFCAllocator::StopAllocationTrace() {
+  {
+    mutex_lock l(*TracingAllocatorsMu());
+    TracingAllocators()->erase(this);
+  }
+  return CloseAllocationTrace();
+}
+
+/*static*/ void BFCAllocator::StopAllAllocationTraces() {
+  mutex_lock l(*TracingAllocatorsMu());
+  for (BFCAllocator* allocator : *TracingAllocators()) {
+    Status s = allocator->CloseAllocationTrace();
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to write allocation trace for "
+                   << allocator->Name() << ": " << s;
+    }
+  }
+  TracingAllocators()->clear();
+}
+
+Status BFCAllocator::CloseAllocationTrace() {
+  std::unique_ptr<AllocationTraceWriter> writer;
+  {
+    mutex_lock l(trace_mu_);
+    tracing_.store(false, std::memory_order_relaxed);
+    writer = std::move(trace_writer_);
+  }
+  if (writer == nullptr) {
+    return errors::FailedPrecondition("Allocator ", name_,
+                                      " is not recording a trace");
+  }
+  return writer->Close();
+}
+
+void BFCAllocator::RecordTraceEvent(AllocationTraceEvent::Type type,
+                                    const void* ptr, size_t num_bytes,
+                                    size_t alignment) {
+  AllocationTraceEvent event;
+  event.type = type;
+  event.step_id = ScopedAllocationTraceStep::CurrentStepId();
+  event.id = reinterpret_cast<std::uintptr_t>(ptr);
+  event.num_bytes = num_bytes;
+  event.alignment = alignment;
+  mutex_lock l(trace_mu_);
+  if (trace_writer_ != nullptr) {
+    event.timestamp_micros = Env::Default()->NowMicros();
+    trace_writer_->Record(event);
+  }
+}
+
+namespace {
+
+// A size-class cache takes up to this many bytes worth of chunks from the
+// bins at a time, and returns as many once it holds twice that.
+constexpr size_t kCacheBatchBytes = 64 << 10;
+constexpr int kMaxCacheBatchChunks = 32;
+
+constexpr int kMaxSizeClassCaches = 64;
+constexpr int kNumCachedAllocationShards = 64;
+
+int CacheBatchSize(size_t rounded_bytes) {
+  return std::max<int>(
+      1, std::min<size_t>(kMaxCacheBatchChunks,
+                          kCacheBatchBytes / rounded_bytes));
+}
+
+// Each thread sticks to one size-class cache, assigned round-robin.
+int ThreadCacheIndex() {
+  static std::atomic<int> next_index{0};
+  static thread_local int index =
+      next_index.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+void AtomicMax(std::atomic<int64>* value, int64 candidate) {
+  int64 current = value->load(std::memory_order_relaxed);
+  while (candidate > current &&
+         !value->compare_exchange_weak(current, candidate,
+                                       std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+void BFCAllocator::EnableSizeClassCaches(size_t max_cached_bytes) {
+  {
+    mutex_lock l(lock_);
+    CHECK_EQ(stats_.num_allocs, 0)
+        << "Size-class caches must be enabled before the first allocation";
+  }
+  max_cached_bytes = RoundedBytes(max_cached_bytes);
+  if (max_cached_bytes == 0) return;
+
+  const int num_size_classes = max_cached_bytes / MinAllocationSize();
+  const int num_caches =
+      std::max(1, std::min(port::MaxParallelism(), kMaxSizeClassCaches));
+  for (int i = 0; i < num_caches; ++i) {
+    size_class_caches_.emplace_back(new SizeClassCache);
+    mutex_lock l(size_class_caches_.back()->mu);
+    size_class_caches_.back()->free_chunks.resize(num_size_classes);
+  }
+  for (int i = 0; i < kNumCachedAllocationShards; ++i) {
+    cached_allocations_.emplace_back(new CachedAllocationShard);
+  }
+  max_cached_bytes_ = max_cached_bytes;
+}
+
+void BFCAllocator::FlushSizeClassCaches() {
+  if (!size_class_caches_enabled()) return;
+  std::vector<CachedChunk> chunks;
+  for (const auto& cache : size_class_caches_) {
+    mutex_lock l(cache->mu);
+    for (std::vector<CachedChunk>& free_chunks : cache->free_chunks) {
+      chunks.insert(chunks.end(), free_chunks.begin(), free_chunks.end());
+      free_chunks.clear();
+    }
+  }
+  if (!chunks.empty()) {
+    ReturnCachedChunks(chunks);
+  }
+}
+
+BFCAllocator::SizeClassCache* BFCAllocator::ThreadCache() {
+  return size_class_caches_[ThreadCacheIndex() % size_class_caches_.size()]
+      .get();
+}
+
+BFCAllocator::CachedAllocationShard* BFCAllocator::CachedAllocationShardFor(
+    const void* ptr) const {
+  // Chunk pointers are multiples of the minimum allocation size.
+  const std::uintptr_t index =
+      reinterpret_cast<std::uintptr_t>(ptr) >> min_alloc_size_exponent_;
+  return cached_allocations_[index % cached_allocations_.size()].get();
+}
+
+bool BFCAllocator::FindCachedAllocation(const void* ptr,
+                                        CachedAllocation* allocation) const {
+  if (!size_class_caches_enabled()) return false;
+  CachedAllocationShard* shard = CachedAllocationShardFor(ptr);
+  mutex_lock l(shard->mu);
+  auto it = shard->allocations.find(ptr);
+  if (it == shard->allocations.end()) return false;
+  *allocation = it->second;
+  return true;
+}
+
+void* BFCAllocator::AllocateFromCache(size_t rounded_bytes, size_t num_bytes) {
+  const size_t size_class = rounded_bytes / MinAllocationSize() - 1;
+  SizeClassCache* cache = ThreadCache();
+  CachedChunk chunk;
+  {
+    mutex_lock l(cache->mu);
+    std::vector<CachedChunk>& free_chunks = cache->free_chunks[size_class];
+    if (free_chunks.empty()) {
+      RefillCache(rounded_bytes, CacheBatchSize(rounded_bytes), &free_chunks);
+      if (free_chunks.empty()) return nullptr;
+    }
+    chunk = free_chunks.back();
+    free_chunks.pop_back();
+  }
+  {
+    CachedAllocationShard* shard = CachedAllocationShardFor(chunk.ptr);
+    mutex_lock l(shard->mu);
+    shard->allocations[chunk.ptr] = CachedAllocation{chunk.size, num_bytes};
+  }
+
+  const int64 size = chunk.size;
+  cache->num_allocs.fetch_add(1, std::memory_order_relaxed);
+  const int64 bytes_in_use =
+      cached_bytes_in_use_.fetch_add(size, std::memory_order_relaxed) + size +
+      uncached_bytes_in_use_.load(std::memory_order_relaxed);
+  AtomicMax(&cached_peak_bytes_in_use_, bytes_in_use);
+  AtomicMax(&cached_largest_alloc_size_, size);
+  return chunk.ptr;
+}
+
+bool BFCAllocator::DeallocateToCache(void* ptr) {
+  CachedAllocation allocation;
+  {
+    CachedAllocationShard* shard = CachedAllocationShardFor(ptr);
+    mutex_lock l(shard->mu);
+    auto it = shard->allocations.find(ptr);
+    if (it == shard->allocations.end()) return false;
+    allocation = it->second;
+    shard->allocations.erase(it);
+  }
+  cached_bytes_in_use_.fetch_sub(allocation.size, std::memory_order_relaxed);
+
+  // The chunk goes back to the size class it was cached for, which may be
+  // smaller than the chunk itself.
+  const size_t rounded_bytes = RoundedBytes(allocation.requested_size);
+  const size_t size_class = rounded_bytes / MinAllocationSize() - 1;
+  const int batch_size = CacheBatchSize(rounded_bytes);
+  std::vector<CachedChunk> overflow;
+  {
+    SizeClassCache* cache = ThreadCache();
+    mutex_lock l(cache->mu);
+    std::vector<CachedChunk>& free_chunks = cache->free_chunks[size_class];
+    free_chunks.push_back(CachedChunk{ptr, allocation.size});
+    if (free_chunks.size() > static_cast<size_t>(2 * batch_size)) {
+      // Keep the most recently freed chunks, which are likelier to be warm.
+      overflow.assign(free_chunks.begin(), free_chunks.begin() + batch_size);
+      free_chunks.erase(free_chunks.begin(), free_chunks.begin() + batch_size);
+    }
+  }
+  if (!overflow.empty()) {
+    ReturnCachedChunks(overflow);
+  } else if (num_waiting_for_memory_.load(std::memory_order_relaxed) > 0) {
+    retry_helper_.NotifyDealloc();
+  }
+  return true;
+}
+
+void BFCAllocator::RefillCache(size_t rounded_bytes, int count,
+                               std::vector<CachedChunk>* chunks) {
+  const BinNum bin_num = BinNumForSize(rounded_bytes);
+  mutex_lock l(lock_);
+  if (!timestamped_chunks_.empty()) {
+    MergeTimestampedChunks(0);
+  }
+  for (int i = 0; i < count; ++i) {
+    void* ptr = FindChunkPtr(bin_num, rounded_bytes, rounded_bytes, 0,
+                             /*for_cache=*/true);
+    // Only grow the pool for the chunk that's needed right now.
+    if (ptr == nullptr && i == 0 &&
+        Extend(Allocator::kAllocatorAlignment, rounded_bytes)) {
+      ptr = FindChunkPtr(bin_num, rounded_bytes, rounded_bytes, 0,
+                         /*for_cache=*/true);
+    }
+    if (ptr == nullptr) break;
+    const Chunk* c = ChunkFromHandle(region_manager_.get_handle(ptr));
+    chunks->push_back(CachedChunk{ptr, c->size});
+  }
+}
+
+void BFCAllocator::ReturnCachedChunks(const std::vector<CachedChunk>& chunks) {
+  {
+    mutex_lock l(lock_);
+    for (const CachedChunk& chunk : chunks) {
+      BFCAllocator::ChunkHandle h = region_manager_.get_handle(chunk.ptr);
+      CHECK(h != kInvalidChunkHandle);
+      MarkFree(h, /*for_cache=*/true);
+      if (timing_counter_) {
+        InsertFreeChunkIntoBin(h);
+        timestamped_chunks_.push_back(h);
+      } else {
+        InsertFreeChunkIntoBin(TryToCoalesce(h, false));
+      }
+    }
+  }
+  retry_helper_.NotifyDealloc();
 }
 
 std::array<BFCAllocator::BinDebugInfo, BFCAllocator::kNumBins>
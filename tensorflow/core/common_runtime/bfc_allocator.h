@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
 #include <array>
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <string>
@@ -24,6 +25,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/common_runtime/allocation_trace.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
 #include "tensorflow/core/framework/allocator.h"
@@ -81,9 +83,105 @@ class BFCAllocator : public Allocator {
 
   void SetSafeFrontier(uint64 count) override;
 
+  // Puts a front-end of size-class caches before the bins, for allocations of
+  // at most `max_cached_bytes`. Each cache is shared by a subset of threads
+  // and holds free chunks per size class, taken from the bins in batches.
+  // Freed chunks go back to the calling thread's cache until it holds too
+  // many, at which point a batch is returned to the bins and coalesced as
+  // usual. Most small allocations and deallocations then only take their
+  // cache's lock rather than lock_.
+  //
+  // Must be called before the first allocation. Allocations that need a
+  // timing counter or a freed_by_func bypass the caches, since cached chunks
+  // don't record when they were freed. GetStats() counts cached chunks that
+  // aren't handed out as free, and AllocationId() is the same for every
+  // allocation a cached chunk serves.
+  void EnableSizeClassCaches(size_t max_cached_bytes);
+
+  // Returns every chunk held by a size-class cache to the bins.
+  void FlushSizeClassCaches() LOCKS_EXCLUDED(lock_);
+
+  // Starts recording every AllocateRaw() and DeallocateRaw() call to
+  // `filename`, for replay with ReplayAllocationTrace(). Setting the
+  // TF_BFC_ALLOCATOR_TRACE_DIR environment variable starts a trace in that
+  // directory for every BFCAllocator as it's created.
+  Status StartAllocationTrace(const string& filename) LOCKS_EXCLUDED(trace_mu_);
+
+  // Stops recording and closes the trace file.
+  Status StopAllocationTrace() LOCKS_EXCLUDED(trace_mu_);
+
+  // Stops the traces of every BFCAllocator in the process. This runs at exit
+  // once any trace has been started, since the process-wide allocators traced
+  // through TF_BFC_ALLOCATOR_TRACE_DIR are never destroyed.
+  static void StopAllAllocationTraces();
+
  private:
   struct Bin;
 
+  // A free chunk held by a size-class cache. As far as the bins are concerned
+  // it is in use, but it is not counted in stats_.
+  struct CachedChunk {
+    void* ptr;
+    size_t size;
+  };
+
+  // One shard of the size-class caches, with the free chunks of each size
+  // class. Threads are spread across shards so few contend for each lock.
+  struct SizeClassCache {
+    mutex mu;
+    std::vector<std::vector<CachedChunk>> free_chunks GUARDED_BY(mu);
+    std::atomic<int64> num_allocs{0};
+  };
+
+  // A chunk a size-class cache has handed out, keyed by its pointer in one of
+  // several shards.
+  struct CachedAllocation {
+    size_t size;
+    size_t requested_size;
+  };
+  struct CachedAllocationShard {
+    mutex mu;
+    std::unordered_map<const void*, CachedAllocation> allocations
+        GUARDED_BY(mu);
+  };
+
+  // Returns a chunk of `rounded_bytes` from the calling thread's cache,
+  // refilling it from the bins if needed, or nullptr if the bins can't.
+  void* AllocateFromCache(size_t rounded_bytes, size_t num_bytes)
+      LOCKS_EXCLUDED(lock_);
+
+  // Returns `ptr` to the calling thread's cache if a cache handed it out.
+  bool DeallocateToCache(void* ptr) LOCKS_EXCLUDED(lock_);
+
+  // Takes up to `count` chunks of `rounded_bytes` from the bins, growing the
+  // pool only if not even one is free.
+  void RefillCache(size_t rounded_bytes, int count,
+                   std::vector<CachedChunk>* chunks) LOCKS_EXCLUDED(lock_);
+
+  // Returns cached chunks to the bins.
+  void ReturnCachedChunks(const std::vector<CachedChunk>& chunks)
+      LOCKS_EXCLUDED(lock_);
+
+  SizeClassCache* ThreadCache();
+  CachedAllocationShard* CachedAllocationShardFor(const void* ptr) const;
+
+  // Looks up an allocation handed out by a size-class cache.
+  bool FindCachedAllocation(const void* ptr, CachedAllocation* allocation)
+      const;
+
+  bool size_class_caches_enabled() const { return max_cached_bytes_ > 0; }
+
+  void* AllocateRawUntraced(size_t alignment, size_t num_bytes,
+                            const AllocationAttributes& allocation_attr);
+
+  // Closes the trace file, if any, without unregistering this allocator from
+  // StopAllAllocationTraces().
+  Status CloseAllocationTrace() LOCKS_EXCLUDED(trace_mu_);
+
+  void RecordTraceEvent(AllocationTraceEvent::Type type, const void* ptr,
+                        size_t num_bytes, size_t alignment)
+      LOCKS_EXCLUDED(trace_mu_);
+
   void* AllocateRawInternal(size_t alignment, size_t num_bytes,
                             bool dump_log_on_failure,
                             uint64 freed_before_count);
@@ -383,8 +481,10 @@ class BFCAllocator : public Allocator {
 
   // Returns a pointer to an underlying allocated chunk of size
   // 'rounded_bytes'.
+  // Chunks taken `for_cache` aren't counted in stats_.
   void* FindChunkPtr(BinNum bin_num, size_t rounded_bytes, size_t num_bytes,
-                     uint64 freed_before) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+                     uint64 freed_before, bool for_cache = false)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // Splits the chunk specified by 'h' into two chunks, one at least
   // of size 'num_bytes'.
@@ -425,7 +525,8 @@ class BFCAllocator : public Allocator {
   const Chunk* ChunkFromHandle(ChunkHandle h) const
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
-  void MarkFree(ChunkHandle h) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void MarkFree(ChunkHandle h, bool for_cache = false)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   ChunkHandle TryToCoalesce(ChunkHandle h, bool ignore_freed_at)
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
@@ -531,6 +632,23 @@ class BFCAllocator : public Allocator {
   // Stats.
   AllocatorStats stats_ GUARDED_BY(lock_);
 
+  // Size-class caches, see EnableSizeClassCaches(). Allocations handed out by
+  // a cache are accounted for by the atomics below rather than stats_, and
+  // stats_.bytes_in_use is mirrored so that peaks can include both.
+  size_t max_cached_bytes_ = 0;
+  std::vector<std::unique_ptr<SizeClassCache>> size_class_caches_;
+  std::vector<std::unique_ptr<CachedAllocationShard>> cached_allocations_;
+  std::atomic<int64> cached_bytes_in_use_{0};
+  std::atomic<int64> cached_peak_bytes_in_use_{0};
+  std::atomic<int64> cached_largest_alloc_size_{0};
+  std::atomic<int64> uncached_bytes_in_use_{0};
+  std::atomic<int> num_waiting_for_memory_{0};
+
+  // Allocation trace, see StartAllocationTrace().
+  mutex trace_mu_;
+  std::unique_ptr<AllocationTraceWriter> trace_writer_ GUARDED_BY(trace_mu_);
+  std::atomic<bool> tracing_{false};
+
   friend class GPUBFCAllocatorPrivateMethodsTest;
   TF_DISALLOW_COPY_AND_ASSIGN(BFCAllocator);
 };
@@ -0,0 +1,253 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/pool_allocator.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace {
+
+SubAllocator* NewCPUSubAllocator() {
+  return new BasicCPUAllocator(port::kNUMANoAffinity, {}, {});
+}
+
+static void CheckStats(Allocator* a, int64 num_allocs, int64 bytes_in_use,
+                       int64 peak_bytes_in_use, int64 largest_alloc_size) {
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  EXPECT_TRUE(stats);
+  if (!stats) {
+    return;
+  }
+  LOG(INFO) << "Alloc stats: " << std::endl << stats->DebugString();
+  EXPECT_EQ(stats->bytes_in_use, bytes_in_use);
+  EXPECT_EQ(stats->peak_bytes_in_use, peak_bytes_in_use);
+  EXPECT_EQ(stats->num_allocs, num_allocs);
+  EXPECT_EQ(stats->largest_alloc_size, largest_alloc_size);
+}
+
+TEST(BFCAllocatorTest, SizeClassCacheNoDups) {
+  BFCAllocator a(NewCPUSubAllocator(), 1 << 26, false, "cpu_bfc");
+  a.EnableSizeClassCaches(4096);
+  CheckStats(&a, 0, 0, 0, 0);
+
+  std::vector<void*> ptrs;
+  for (int s = 1; s < 1024; s++) {
+    void* raw = a.AllocateRaw(1, s);
+    ptrs.push_back(raw);
+  }
+  CheckStats(&a, 1023, 654336, 654336, 1024);
+
+  std::sort(ptrs.begin(), ptrs.end());
+
+  // Make sure none of them are equal, and that none of them overlap.
+  for (size_t i = 1; i < ptrs.size(); i++) {
+    ASSERT_NE(ptrs[i], ptrs[i - 1]);  // No dups
+    size_t req_size = a.RequestedSize(ptrs[i - 1]);
+    ASSERT_GT(req_size, 0);
+    ASSERT_GE(static_cast<char*>(ptrs[i]) - static_cast<char*>(ptrs[i - 1]),
+              req_size);
+  }
+
+  for (size_t i = 0; i < ptrs.size(); i++) {
+    a.DeallocateRaw(ptrs[i]);
+  }
+  CheckStats(&a, 1023, 0, 654336, 1024);
+}
+
+TEST(BFCAllocatorTest, SizeClassCacheStats) {
+  BFCAllocator a(NewCPUSubAllocator(), 1 << 26, false, "cpu_bfc");
+  a.EnableSizeClassCaches(1024);
+
+  // 300 bytes go through a cache, 4096 bytes through the bins.
+  void* cached = a.AllocateRaw(1, 300);
+  void* uncached = a.AllocateRaw(1, 4096);
+  CheckStats(&a, 2, 4608, 4608, 4096);
+  EXPECT_EQ(300, a.RequestedSize(cached));
+  EXPECT_EQ(512, a.AllocatedSize(cached));
+  EXPECT_EQ(4096, a.RequestedSize(uncached));
+
+  a.DeallocateRaw(cached);
+  CheckStats(&a, 2, 4096, 4608, 4096);
+  a.DeallocateRaw(uncached);
+  CheckStats(&a, 2, 0, 4608, 4096);
+
+  a.ClearStats();
+  CheckStats(&a, 0, 0, 0, 0);
+
+  // A chunk freed into the cache is handed out again.
+  void* reused = a.AllocateRaw(1, 500);
+  EXPECT_EQ(cached, reused);
+  EXPECT_EQ(500, a.RequestedSize(reused));
+  CheckStats(&a, 1, 512, 512, 512);
+  a.DeallocateRaw(reused);
+}
+
+// Frees many small cached chunks, then asks for the whole pool, which only
+// fits once the chunks held by the caches are coalesced again.
+void FillAndEmptyCaches(BFCAllocator* a, size_t pool_size) {
+  std::vector<void*> ptrs;
+  for (size_t i = 0; i < pool_size / 256; i++) {
+    void* raw = a->AllocateRaw(1, 256);
+    ASSERT_NE(nullptr, raw);
+    ptrs.push_back(raw);
+  }
+  for (void* raw : ptrs) {
+    a->DeallocateRaw(raw);
+  }
+}
+
+TEST(BFCAllocatorTest, FlushSizeClassCaches) {
+  const size_t kPoolSize = 1 << 20;
+  BFCAllocator a(NewCPUSubAllocator(), kPoolSize, false, "cpu_bfc");
+  a.EnableSizeClassCaches(1024);
+  FillAndEmptyCaches(&a, kPoolSize);
+
+  a.FlushSizeClassCaches();
+  AllocationAttributes attrs;
+  attrs.no_retry_on_failure = true;
+  void* all = a.AllocateRaw(1, kPoolSize, attrs);
+  EXPECT_NE(nullptr, all);
+  a.DeallocateRaw(all);
+}
+
+TEST(BFCAllocatorTest, OutOfMemoryFlushesSizeClassCaches) {
+  const size_t kPoolSize = 1 << 20;
+  BFCAllocator a(NewCPUSubAllocator(), kPoolSize, false, "cpu_bfc");
+  a.EnableSizeClassCaches(1024);
+
+  FillAndEmptyCaches(&a, kPoolSize);
+  AllocationAttributes attrs;
+  attrs.no_retry_on_failure = true;
+  void* all = a.AllocateRaw(1, kPoolSize, attrs);
+  EXPECT_NE(nullptr, all);
+  a.DeallocateRaw(all);
+
+  FillAndEmptyCaches(&a, kPoolSize);
+  all = a.AllocateRaw(1, kPoolSize);
+  EXPECT_NE(nullptr, all);
+  a.DeallocateRaw(all);
+}
+
+TEST(BFCAllocatorTest, SizeClassCacheThreaded) {
+  BFCAllocator a(NewCPUSubAllocator(), 1 << 26, false, "cpu_bfc");
+  a.EnableSizeClassCaches(4096);
+  const int kNumThreads = 8;
+  std::atomic<int> num_errors(0);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; t++) {
+      pool.Schedule([&a, &num_errors, t]() {
+        random::PhiloxRandom philox(t, 17);
+        random::SimplePhilox rand(&philox);
+        for (int round = 0; round < 50; round++) {
+          std::vector<std::pair<uint8*, size_t>> allocs;
+          for (int i = 0; i < 100; i++) {
+            // Mostly cached sizes, some that go through the bins.
+            size_t bytes = 1 + rand.Uniform(i % 10 == 0 ? 16384 : 4096);
+            uint8* p = static_cast<uint8*>(a.AllocateRaw(1, bytes));
+            std::fill(p, p + bytes, static_cast<uint8>(t));
+            allocs.emplace_back(p, bytes);
+          }
+          for (const auto& alloc : allocs) {
+            if (std::any_of(alloc.first, alloc.first + alloc.second,
+                            [t](uint8 b) { return b != t; })) {
+              ++num_errors;
+            }
+            a.DeallocateRaw(alloc.first);
+          }
+        }
+      });
+    }
+    // The pool's destructor waits for the threads.
+  }
+  EXPECT_EQ(0, num_errors);
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(0, stats->bytes_in_use);
+  EXPECT_EQ(kNumThreads * 50 * 100, stats->num_allocs);
+}
+
+static void BM_AllocationThreadedSmall(int iters, int num_threads,
+                                       int cached) {
+  testing::StopTiming();
+  BFCAllocator a(NewCPUSubAllocator(), 1 << 28, false, "cpu_bfc");
+  if (cached) {
+    a.EnableSizeClassCaches(64 << 10);
+  }
+  thread::ThreadPool pool(Env::Default(), "test", num_threads);
+  std::atomic_int_fast32_t count(iters);
+  mutex done_lock;
+  condition_variable done;
+  bool done_flag = false;
+
+  testing::StartTiming();
+  for (int t = 0; t < num_threads; t++) {
+    pool.Schedule([&a, &count, &done_lock, &done, &done_flag, iters]() {
+      // Exercise a few different small allocation sizes, keeping some
+      // allocations live so that chunks aren't simply reused in place.
+      std::vector<int> sizes = {256, 4096, 16384, 512, 1024, 64, 2048};
+      std::vector<void*> live(16, nullptr);
+      int size_index = 0;
+      for (int i = 0; i < iters; i++) {
+        void*& slot = live[i % live.size()];
+        if (slot != nullptr) {
+          a.DeallocateRaw(slot);
+        }
+        slot = a.AllocateRaw(1, sizes[size_index++ % sizes.size()]);
+        const int64 remaining = count.fetch_sub(1);
+        if (remaining <= 1) {
+          if (remaining == 1) {
+            mutex_lock l(done_lock);
+            done_flag = true;
+            done.notify_all();
+          }
+          break;
+        }
+      }
+      for (void* p : live) {
+        if (p != nullptr) {
+          a.DeallocateRaw(p);
+        }
+      }
+    });
+  }
+  mutex_lock l(done_lock);
+  if (!done_flag) {
+    done.wait(l);
+  }
+}
+BENCHMARK(BM_AllocationThreadedSmall)
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(4, 0)
+    ->ArgPair(4, 1)
+    ->ArgPair(16, 0)
+    ->ArgPair(16, 1);
+
+}  // namespace
+}  // namespace tensorflow
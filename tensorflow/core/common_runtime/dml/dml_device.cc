@@ -25,7 +25,11 @@ limitations under the License.
 #include "dml_upload_heap.h"
 #include "tensorflow/core/common_runtime/dml/dml_util.h"
 #include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/env_var.h"
 
 // {D113B493-BBA2-4993-8608-D706A73B91CE}
 static const GUID PIX_EVAL_CAPTURABLE_WORK_GUID = {
@@ -46,6 +50,185 @@ DmlDevice::DmlDevice(const DmlDeviceState* state, const SessionOptions& options,
       state_->upload_heap.get(), state_->readback_heap.get(),
       state_->dml_allocator.get(), state_->descriptor_allocator.get());
   set_dml_device_context(device_context_);
+
+  Status s = ReadStringFromEnvVar("TF_DIRECTML_KERNEL_CACHE_MANIFEST", "",
+                                  &kernel_cache_manifest_path_);
+  if (!s.ok()) {
+    LOG(WARNING) << "DirectML device: ignoring kernel cache manifest: " << s;
+    kernel_cache_manifest_path_.clear();
+  }
+
+  // Each adapter has its own kernel manager, so give each one its own manifest
+  // rather than having them overwrite each other's.
+  if (!kernel_cache_manifest_path_.empty() && state_->adapter_index != 0) {
+    kernel_cache_manifest_path_ = strings::StrCat(
+        kernel_cache_manifest_path_, ".adapter", state_->adapter_index);
+  }
+
+  if (!kernel_cache_manifest_path_.empty()) {
+    state_->kernel_manager->AddManifestWriter();
+  }
+
+  // Kernels are pre-built in the background so that device creation isn't
+  // delayed. Requests for a kernel that hasn't been replayed yet simply create
+  // it as usual.
+  if (!kernel_cache_manifest_path_.empty() &&
+      Env::Default()->FileExists(kernel_cache_manifest_path_).ok() &&
+      state_->kernel_manager->TryBeginManifestReplay()) {
+    manifest_replay_thread_.reset(Env::Default()->StartThread(
+        ThreadOptions(), "dml_kernel_cache_replay", [this]() {
+          ReplayKernelCacheManifest(kernel_cache_manifest_path_);
+        }));
+  }
+}
+
+DmlDevice::~DmlDevice() {
+  cancel_manifest_replay_ = true;
+  manifest_replay_thread_.reset();  // Joins
+
+  // Save the manifest on shutdown so that the next process can replay it. Only
+  // the last device sharing the kernel manager writes it, since the others
+  // would write the same cache. A kernel manager that never ran anything (e.g.
+  // one whose devices were created just to enumerate devices) shouldn't clobber
+  // a manifest written by a previous process.
+  if (!kernel_cache_manifest_path_.empty() &&
+      state_->kernel_manager->ReleaseManifestWriter() &&
+      state_->kernel_manager->GetCacheSize() != 0) {
+    Status s = state_->kernel_manager->SaveManifest(
+        Env::Default(), kernel_cache_manifest_path_);
+    if (!s.ok()) {
+      LOG(WARNING) << "DirectML device: failed to write kernel cache manifest: "
+                   << s;
+    }
+  }
+}
+
+size_t DmlDevice::ReplayKernelCacheManifest(const string& path) {
+  std::vector<DmlKernelKey> keys;
+  Status s = DmlKernelManager::LoadManifest(Env::Default(), path, &keys);
+  if (!s.ok()) {
+    LOG(WARNING) << "DirectML device: failed to load kernel cache manifest: "
+                 << s;
+    return 0;
+  }
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+
+  size_t kernels_built = 0;
+  size_t kernels_skipped = 0;
+  for (const DmlKernelKey& key : keys) {
+    if (cancel_manifest_replay_) {
+      break;
+    }
+
+    s = WarmKernelCache(key);
+    if (s.ok()) {
+      ++kernels_built;
+    } else if (errors::IsUnimplemented(s)) {
+      ++kernels_skipped;
+      LOG(INFO) << "DirectML device: skipping replay of '" << key.op_type_name
+                << "' kernel: " << s.error_message();
+    } else {
+      VLOG(1) << "DirectML device: failed to replay '" << key.op_type_name
+              << "' kernel: " << s;
+    }
+  }
+
+  auto end_time = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> replay_seconds = end_time - start_time;
+
+  LOG(INFO) << "DirectML device: pre-built " << kernels_built << " of "
+            << keys.size() << " kernels from manifest in "
+            << replay_seconds.count() << "s (" << kernels_skipped
+            << " skipped).";
+
+  return kernels_built;
+}
+
+Status DmlDevice::WarmKernelCache(const DmlKernelKey& key) {
+  Status status;
+  std::unique_ptr<OpKernel> op_kernel =
+      CreateOpKernel(DeviceType(DEVICE_DML), this, GetAllocator(),
+                     *key.node_def, TF_GRAPH_DEF_VERSION, &status);
+  TF_RETURN_IF_ERROR(status);
+
+  auto* cacheable_kernel = dynamic_cast<DmlCacheableKernel*>(op_kernel.get());
+  if (!cacheable_kernel) {
+    return errors::Unimplemented("Op kernel '", key.op_type_name,
+                                 "' doesn't support kernel caching");
+  }
+
+  if (op_kernel->num_inputs() != static_cast<int>(key.input_tensors.size())) {
+    return errors::InvalidArgument("Kernel key for '", key.op_type_name,
+                                   "' has the wrong number of inputs");
+  }
+
+  // Check that every input can be reconstructed before allocating any of them.
+  // Ref inputs need the variable they refer to, and resource inputs need a
+  // resource manager to look their handles up in. Inputs which can't be
+  // memcpy'd (resources, variants, strings) can't be placed in DML memory,
+  // whose pointers are opaque handles that can't be dereferenced on the CPU.
+  // Likewise, host memory inputs are only materialized if the key recorded
+  // their contents.
+  for (size_t i = 0; i < key.input_tensors.size(); ++i) {
+    const DataType input_type = op_kernel->input_type(i);
+
+    if (IsRefType(input_type)) {
+      return errors::Unimplemented("Kernel key for '", key.op_type_name,
+                                   "' has a ref input");
+    }
+
+    if (!DataTypeCanUseMemcpy(input_type)) {
+      return errors::Unimplemented("Kernel key for '", key.op_type_name,
+                                   "' has a ", DataTypeString(input_type),
+                                   " input");
+    }
+
+    if (!key.input_tensors[i].is_constant_cpu_input &&
+        op_kernel->input_memory_types()[i] == HOST_MEMORY) {
+      return errors::Unimplemented("Kernel key for '", key.op_type_name,
+                                   "' has a non-constant host memory input");
+    }
+  }
+
+  // Materialize inputs matching the recorded key. Constant CPU inputs carry
+  // their recorded contents; other inputs only need the right shape and type
+  // since kernel construction doesn't read their contents.
+  gtl::InlinedVector<Tensor, 4> input_tensors(key.input_tensors.size());
+  gtl::InlinedVector<TensorValue, 4> inputs(key.input_tensors.size());
+  gtl::InlinedVector<AllocatorAttributes, 4> input_alloc_attrs(
+      key.input_tensors.size());
+
+  for (size_t i = 0; i < key.input_tensors.size(); ++i) {
+    const DmlInputTensorKey& input_key = key.input_tensors[i];
+
+    if (input_key.is_constant_cpu_input) {
+      input_tensors[i] = absl::get<Tensor>(input_key.tensor);
+      input_alloc_attrs[i].set_on_host(true);
+    } else {
+      const auto& shape_and_type =
+          absl::get<TensorShapeAndType>(input_key.tensor);
+      input_tensors[i] = Tensor(GetAllocator(), shape_and_type.dtype,
+                                shape_and_type.shape);
+      if (!input_tensors[i].IsInitialized()) {
+        return errors::ResourceExhausted(
+            "OOM when allocating replay input of shape ",
+            shape_and_type.shape.DebugString());
+      }
+    }
+
+    inputs[i].tensor = &input_tensors[i];
+  }
+
+  OpKernelContext::Params params;
+  params.device = this;
+  params.op_kernel = op_kernel.get();
+  params.inputs = &inputs;
+  params.input_alloc_attrs = &input_alloc_attrs;
+  params.op_device_context = device_context_;
+
+  OpKernelContext ctx(&params, op_kernel->num_outputs());
+  return cacheable_kernel->WarmKernelCache(&ctx);
 }
 
 Status DmlDevice::Sync() {
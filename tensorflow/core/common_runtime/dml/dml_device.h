@@ -15,19 +15,25 @@ limitations under the License.
 
 #pragma once
 
+#include <atomic>
+
 #include "dml_common.h"
 #include "dml_device_context.h"
 #include "dml_device_state.h"
 #include "tensorflow/core/common_runtime/local_device.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/public/session_options.h"
 
 namespace tensorflow {
 
+struct DmlKernelKey;
+
 // Implements tensorflow::Device using a shared DmlDeviceState.
 class DmlDevice : public LocalDevice {
  public:  // Methods
   DmlDevice(const DmlDeviceState* state, const SessionOptions& options,
             const DeviceAttributes& attributes);
+  ~DmlDevice() override;
 
   ID3D12Device* GetD3D12Device() const { return state_->d3d_device.Get(); }
   IDMLDevice* GetDmlDevice() const { return state_->dml_device.Get(); }
@@ -84,9 +90,26 @@ class DmlDevice : public LocalDevice {
   Allocator* cpu_allocator_;          // not owned
   DMLDeviceContext* device_context_;  // ref-counted
 
+  // Path of the kernel cache manifest, from the
+  // TF_DIRECTML_KERNEL_CACHE_MANIFEST environment variable. Adapters other than
+  // the first append ".adapter<index>" to it. Empty if unset.
+  string kernel_cache_manifest_path_;
+
+  // Pre-builds kernels recorded in the kernel cache manifest. Joined on
+  // destruction.
+  std::unique_ptr<Thread> manifest_replay_thread_;
+  std::atomic<bool> cancel_manifest_replay_{false};
+
   Status MaybeCopyTensorToDML(const AllocatorAttributes alloc_attrs,
                               const Tensor& from, Tensor& to,
                               Notification& note, Status& copy_status);
+
+  // Pre-builds the kernels recorded in the manifest at `path` and returns the
+  // number of kernels built. Keys which can't be replayed are skipped.
+  size_t ReplayKernelCacheManifest(const string& path);
+  Status WarmKernelCache(const DmlKernelKey& key);
+
+  friend class DmlDeviceTest;
 };
 
 }  // namespace tensorflow
\ No newline at end of file
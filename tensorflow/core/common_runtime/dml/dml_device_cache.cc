@@ -187,7 +187,8 @@ const DmlDeviceState* DmlDeviceCache::GetOrCreateDeviceState(
               << " (" << adapter.Name() << ")";
 
     device_states_[adapter_index] =
-        DmlDeviceState::Create(adapter, gpu_options, memory_limit_in_bytes);
+        DmlDeviceState::Create(adapter, adapter_index, gpu_options,
+                               memory_limit_in_bytes);
   }
 
   return device_states_[adapter_index].get();
@@ -38,8 +38,8 @@ static constexpr GUID kTensorflowDirectmlCreatorId = {
 namespace tensorflow {
 
 /*static*/ std::unique_ptr<DmlDeviceState> DmlDeviceState::Create(
-    const DmlAdapter& adapter, const GPUOptions& gpu_options,
-    uint64_t memory_limit_in_bytes) {
+    const DmlAdapter& adapter, uint32_t adapter_index,
+    const GPUOptions& gpu_options, uint64_t memory_limit_in_bytes) {
   D3D_FEATURE_LEVEL feature_level = adapter.IsComputeOnly()
                                         ? D3D_FEATURE_LEVEL_1_0_CORE
                                         : D3D_FEATURE_LEVEL_11_0;
@@ -148,6 +148,7 @@ namespace tensorflow {
   // Construct the final state object
   auto state = absl::make_unique<DmlDeviceState>();
   state->adapter = absl::make_unique<DmlAdapter>(adapter);
+  state->adapter_index = adapter_index;
   state->d3d_device = std::move(d3d_device);
   state->command_queue = std::move(command_queue);
   state->sharing_contract = std::move(sharing_contract);
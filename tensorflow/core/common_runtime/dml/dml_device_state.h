@@ -41,6 +41,7 @@ class GPUOptions;
 struct DmlDeviceState {
  public:
   static std::unique_ptr<DmlDeviceState> Create(const DmlAdapter& adapter,
+                                                uint32_t adapter_index,
                                                 const GPUOptions& gpu_options,
                                                 uint64_t memory_limit_in_bytes);
 
@@ -48,6 +49,7 @@ struct DmlDeviceState {
   ~DmlDeviceState();
 
   std::unique_ptr<DmlAdapter> adapter;
+  uint32_t adapter_index = 0;  // Index of `adapter` in the DmlDeviceCache
   Microsoft::WRL::ComPtr<ID3D12Device> d3d_device;
   Microsoft::WRL::ComPtr<ID3D12CommandQueue> command_queue;
   Microsoft::WRL::ComPtr<ID3D12SharingContract> sharing_contract;
@@ -0,0 +1,99 @@
+/* Copyright (c) Microsoft Corporation.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/dml/dml_device.h"
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/dml/dml_device_cache.h"
+#include "tensorflow/core/common_runtime/dml/dml_kernel_key.h"
+#include "tensorflow/core/common_runtime/dml/dml_kernel_manager.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+
+class DmlDeviceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    auto& device_cache = DmlDeviceCache::Instance();
+    ASSERT_GT(device_cache.GetAdapterCount(), 0);
+
+    constexpr int64 kMemoryLimit = 256 * 1024 * 1024;
+    const DmlDeviceState* state =
+        device_cache.GetOrCreateDeviceState(0, GPUOptions(), kMemoryLimit);
+
+    const DeviceAttributes attributes = Device::BuildDeviceAttributes(
+        "/job:localhost/replica:0/task:0/device:DML:0",
+        DeviceType(DEVICE_DML), Bytes(kMemoryLimit), DeviceLocality());
+    device_ = absl::make_unique<DmlDevice>(state, SessionOptions(), attributes);
+  }
+
+  size_t ReplayKernelCacheManifest(const string& path) {
+    return device_->ReplayKernelCacheManifest(path);
+  }
+
+  std::unique_ptr<DmlDevice> device_;
+};
+
+namespace {
+
+DmlInputTensorKey ShapeInput(const TensorShape& shape, DataType dtype) {
+  DmlInputTensorKey input = {};
+  input.is_constant_cpu_input = false;
+  input.tensor = TensorShapeAndType{shape, dtype};
+  return input;
+}
+
+// Writes a manifest holding `keys`, most-recently used first.
+void WriteManifest(const string& path, const std::vector<DmlKernelKey>& keys) {
+  DmlKernelCacheManifest manifest;
+  manifest.set_version(DmlKernelManager::kManifestVersion);
+  for (const DmlKernelKey& key : keys) {
+    key.ToProto(manifest.add_kernels());
+  }
+  TF_ASSERT_OK(WriteBinaryProto(Env::Default(), path, manifest));
+}
+
+// Tests that keys whose inputs can't be materialized in DML memory, such as the
+// resource handle of a ResourceGatherNd, are skipped instead of replayed.
+TEST_F(DmlDeviceTest, ReplaySkipsResourceInputs) {
+  auto node_def = std::make_shared<NodeDef>();
+  TF_ASSERT_OK(NodeDefBuilder("gather", "ResourceGatherNd")
+                   .Input("resource", 0, DT_RESOURCE)
+                   .Input("indices", 0, DT_INT32)
+                   .Attr("dtype", DT_FLOAT)
+                   .Finalize(node_def.get()));
+
+  DmlKernelKey key = {};
+  key.op_type_name = "ResourceGatherNd";
+  key.node_def = node_def;
+  key.input_tensors.push_back(ShapeInput({}, DT_RESOURCE));
+  key.input_tensors.push_back(ShapeInput({2, 1}, DT_INT32));
+
+  const string path =
+      io::JoinPath(testing::TmpDir(), "dml_device_test_manifest.pb");
+  WriteManifest(path, {key});
+
+  const size_t cache_size = device_->GetKernelManager()->GetCacheSize();
+  EXPECT_EQ(ReplayKernelCacheManifest(path), 0);
+  EXPECT_EQ(device_->GetKernelManager()->GetCacheSize(), cache_size);
+}
+
+}  // namespace
+}  // namespace tensorflow
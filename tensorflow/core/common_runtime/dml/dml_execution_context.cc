@@ -99,7 +99,7 @@ DmlGpuEvent DmlExecutionContext::CopyBufferRegionRaw(
     uint64_t src_offset, D3D12_RESOURCE_STATES src_state, uint64_t byte_count) {
   std::unique_lock<std::mutex> lock(batch_state_->mutex);
 
-  batch_state_->WriteBatch().emplace_back([=](DmlCommandList& command_list) {
+  batch_state_->Enqueue([=](DmlCommandList& command_list) {
     command_list.CopyBufferRegion(dst_buffer, dst_offset, dst_state, src_buffer,
                                   src_offset, src_state, byte_count);
   });
@@ -125,7 +125,7 @@ DmlGpuEvent DmlExecutionContext::FillBufferWithPatternRaw(
   std::unique_lock<std::mutex> lock(batch_state_->mutex);
 
   absl::InlinedVector<uint8_t, 16> value_copy(value.begin(), value.end());
-  batch_state_->WriteBatch().emplace_back(
+  batch_state_->Enqueue(
       [=, value = std::move(value_copy)](DmlCommandList& command_list) {
         command_list.FillBufferWithPattern(dst, dst_offset, dst_size_in_bytes,
                                            value);
@@ -142,7 +142,7 @@ DmlGpuEvent DmlExecutionContext::InitializeOperator(
     ID3D12DescriptorHeap* descriptor_heap) {
   std::unique_lock<std::mutex> lock(batch_state_->mutex);
 
-  batch_state_->WriteBatch().emplace_back(
+  batch_state_->Enqueue(
       [=,
        binding_table = std::move(binding_table)](DmlCommandList& command_list) {
         command_list.InitializeOperator(initializer, binding_table.Get(),
@@ -160,7 +160,7 @@ DmlGpuEvent DmlExecutionContext::ExecuteOperator(
     ID3D12DescriptorHeap* descriptor_heap) {
   std::unique_lock<std::mutex> lock(batch_state_->mutex);
 
-  batch_state_->WriteBatch().emplace_back(
+  batch_state_->Enqueue(
       [=,
        binding_table = std::move(binding_table)](DmlCommandList& command_list) {
         command_list.ExecuteOperator(op, binding_table.Get(), descriptor_heap);
@@ -180,7 +180,7 @@ DmlGpuEvent DmlExecutionContext::ResourceBarrier(
   // the lambda.
   absl::InlinedVector<D3D12_RESOURCE_BARRIER, 4> barriers_copy(barriers.begin(),
                                                                barriers.end());
-  batch_state_->WriteBatch().emplace_back(
+  batch_state_->Enqueue(
       [=, barriers = std::move(barriers_copy)](DmlCommandList& command_list) {
         command_list.ResourceBarrier(barriers);
       });
@@ -193,7 +193,7 @@ DmlGpuEvent DmlExecutionContext::ResourceBarrier(
 DmlGpuEvent DmlExecutionContext::UavBarrier() {
   std::unique_lock<std::mutex> lock(batch_state_->mutex);
 
-  batch_state_->WriteBatch().emplace_back(
+  batch_state_->Enqueue(
       [=](DmlCommandList& command_list) { command_list.UavBarrier(); });
 
   batch_state_->command_added.notify_all();
@@ -201,8 +201,27 @@ DmlGpuEvent DmlExecutionContext::UavBarrier() {
   return batch_state_->next_flush_event;
 }
 
+DmlGpuEvent DmlExecutionContext::ExtendOpenCommand(
+    const std::function<std::shared_ptr<OpenCommand>(OpenCommand*)>& extend) {
+  std::unique_lock<std::mutex> lock(batch_state_->mutex);
+
+  std::shared_ptr<OpenCommand> new_command =
+      extend(batch_state_->open_command.get());
+
+  if (new_command) {
+    batch_state_->SealOpenCommand();
+    batch_state_->open_command = std::move(new_command);
+  }
+
+  batch_state_->command_added.notify_all();
+
+  return batch_state_->next_flush_event;
+}
+
 StatusOr<DmlGpuEvent> DmlExecutionContext::Flush() {
   std::unique_lock<std::mutex> lock(batch_state_->mutex);
+  batch_state_->SealOpenCommand();
+
   auto event = batch_state_->next_flush_event;
   if (batch_state_->WriteBatch().empty()) {
     --event.fence_value;
@@ -221,7 +240,7 @@ Status DmlExecutionContext::GetCommandRecorderStatus() const {
 DmlGpuEvent DmlExecutionContext::GetCurrentCompletionEvent() {
   std::unique_lock<std::mutex> lock(batch_state_->mutex);
   auto event = batch_state_->next_flush_event;
-  if (batch_state_->WriteBatch().empty()) {
+  if (batch_state_->WriteBatchEmpty()) {
     --event.fence_value;
   }
   return event;
@@ -259,7 +278,7 @@ D3D12_COMMAND_LIST_TYPE DmlExecutionContext::GetCommandListTypeForQueue()
 
     auto& batch = state->WriteBatch();
 
-    if (batch.empty()) {
+    if (state->WriteBatchEmpty()) {
       // Wait for new work to be batched.
       state->command_added.wait(lock);
 
@@ -275,6 +294,9 @@ D3D12_COMMAND_LIST_TYPE DmlExecutionContext::GetCommandListTypeForQueue()
     bool flush = false;
     if (state->flush_requested || batch.size() >= batch_flush_size ||
         elapsed_us >= batch_flush_time_us) {
+      // The open command must execute with this batch, since that's what the
+      // event returned by ExtendOpenCommand refers to
+      state->SealOpenCommand();
       state->write_batch_index = (state->write_batch_index + 1) % 2;
       flush = true;
       ++state->next_flush_event.fence_value;
@@ -42,6 +42,18 @@ class DmlCommandQueue;
 // safe to release.
 class DmlExecutionContext {
  public:
+  // A command which stays open, so that the caller can keep extending it (e.g.
+  // with more copies), until it's sealed. See ExtendOpenCommand.
+  class OpenCommand {
+   public:
+    virtual ~OpenCommand() = default;
+
+    // Called exactly once, with the context's lock held. Returns the function
+    // which records the command into a command list; the command can't be
+    // extended after this.
+    virtual std::function<void(DmlCommandList&)> Seal() = 0;
+  };
+
   DmlExecutionContext(ID3D12Device* d3d12_device, IDMLDevice* dml_device,
                       ID3D12CommandQueue* queue);
 
@@ -99,6 +111,19 @@ class DmlExecutionContext {
   // only includes a UAV barrier (elides an extra copy).
   DmlGpuEvent UavBarrier();
 
+  // Calls `extend` with the context's lock held, passing the open command (or
+  // null if there is none). If `extend` returns a command, the open command is
+  // sealed and the returned command is opened in its place. Returns the event
+  // which is signaled once the open command has executed.
+  //
+  // The open command isn't enqueued until it's sealed, which happens just
+  // before any other command is enqueued, or the batched commands are flushed
+  // or handed to the execution thread. Whatever is added to an open command
+  // therefore executes after all work enqueued before it, and before all work
+  // enqueued after it.
+  DmlGpuEvent ExtendOpenCommand(
+      const std::function<std::shared_ptr<OpenCommand>(OpenCommand*)>& extend);
+
   // Indicates that any batched commands should be recorded and executed as soon
   // as possible, even if the batch is small. This is a no-op if nothing is
   // batched.
@@ -131,6 +156,26 @@ class DmlExecutionContext {
     uint32_t write_batch_index = 0;
     Batch& WriteBatch() { return batches[write_batch_index]; }
 
+    // Logically the last command in the write batch, but not added to it until
+    // it's sealed.
+    std::shared_ptr<OpenCommand> open_command;
+
+    // Seals the open command, if any, and adds it to the write batch.
+    void SealOpenCommand() {
+      if (open_command) {
+        WriteBatch().emplace_back(open_command->Seal());
+        open_command.reset();
+      }
+    }
+
+    // Adds a command to the write batch, behind the open command.
+    void Enqueue(Command command) {
+      SealOpenCommand();
+      WriteBatch().emplace_back(std::move(command));
+    }
+
+    bool WriteBatchEmpty() { return WriteBatch().empty() && !open_command; }
+
     bool exit_requested = false;
     bool flush_requested = false;
 
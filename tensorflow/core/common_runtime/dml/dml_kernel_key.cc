@@ -17,6 +17,8 @@ limitations under the License.
 
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
 
 namespace tensorflow {
 
@@ -28,33 +30,78 @@ static uint64 TensorShapeHash(const TensorShape& s) {
   return hash;
 }
 
-static uint64 DmlInputTensorKeyHash(const DmlInputTensorKey& k) {
-  uint64 hash = 0;
-
+// The shape, type and (for constant CPU inputs) contents of an input tensor,
+// regardless of whether it's held by an owning key or a borrowed view.
+namespace {
+struct InputTensorRef {
+  const TensorShape* shape;
+  DataType dtype;
+  const Tensor* contents;  // null unless this is a constant CPU input
+};
+}  // namespace
+
+static InputTensorRef GetInputTensorRef(const DmlInputTensorKey& k) {
   if (k.is_constant_cpu_input) {
     const Tensor& tensor = absl::get<Tensor>(k.tensor);
+    return {&tensor.shape(), tensor.dtype(), &tensor};
+  }
 
-    hash = TensorShapeHash(tensor.shape());
-    hash = Hash64Combine(hash, tensor.dtype());
+  const TensorShapeAndType& tensor = absl::get<TensorShapeAndType>(k.tensor);
+  return {&tensor.shape, tensor.dtype, nullptr};
+}
 
+static InputTensorRef GetInputTensorRef(const DmlInputTensorKeyView& k) {
+  const Tensor& tensor = k.GetTensor();
+  return {&tensor.shape(), tensor.dtype(),
+          k.is_constant_cpu_input ? &tensor : nullptr};
+}
+
+static uint64 InputTensorHash(const InputTensorRef& k) {
+  uint64 hash = TensorShapeHash(*k.shape);
+  hash = Hash64Combine(hash, k.dtype);
+
+  if (k.contents) {
     // Hash the contents of the tensor too. Note that this only works for
     // primitive types (i.e. where DataTypeCanUseMemcpy is true)
-    hash = Hash64Combine(
-        hash, Hash64(tensor.tensor_data().data(), tensor.tensor_data().size()));
-  } else {
-    const TensorShapeAndType& tensor = absl::get<TensorShapeAndType>(k.tensor);
-
-    hash = TensorShapeHash(tensor.shape);
-    hash = Hash64Combine(hash, tensor.dtype);
+    auto data = k.contents->tensor_data();
+    hash = Hash64Combine(hash, Hash64(data.data(), data.size()));
   }
 
   return hash;
 }
 
-uint64 DmlKernelKeyHash(const DmlKernelKey& k) {
-  uint64 hash = Hash64(k.op_type_name);
+static bool InputTensorsEqual(const InputTensorRef& a,
+                              const InputTensorRef& b) {
+  if ((a.contents != nullptr) != (b.contents != nullptr)) {
+    return false;
+  }
+
+  if (*a.shape != *b.shape || a.dtype != b.dtype) {
+    return false;
+  }
+
+  // If this is a constant CPU input, the tensor contents also form part of
+  // the key, so we need to compare those too
+  if (a.contents) {
+    auto data_0 = a.contents->tensor_data();
+    auto data_1 = b.contents->tensor_data();
+    if (data_0.size() != data_1.size()) {
+      return false;
+    }
+
+    if (memcmp(data_0.data(), data_1.data(), data_0.size())) {
+      return false;
+    }
+  }
+
+  return true;
+}
 
-  AttrSlice attributes(*k.node_def);
+uint64 DmlKernelAttributesHash(StringPiece op_type_name,
+                               const NodeDef& node_def) {
+  uint64 hash = Hash64(op_type_name.data(), op_type_name.size());
+
+  AttrSlice attributes(node_def);
   for (const auto& kvp : attributes) {
     const AttrValue& attr = kvp.second;
 
@@ -63,13 +110,93 @@ uint64 DmlKernelKeyHash(const DmlKernelKey& k) {
     hash = Hash64CombineUnordered(hash, AttrValueHash(attr));
   }
 
+  return hash;
+}
+
+uint64 DmlKernelKeyHash(const DmlKernelKey& k) {
+  uint64 hash = DmlKernelAttributesHash(k.op_type_name, *k.node_def);
+
   for (const DmlInputTensorKey& input : k.input_tensors) {
-    hash = Hash64Combine(hash, DmlInputTensorKeyHash(input));
+    hash = Hash64Combine(hash, InputTensorHash(GetInputTensorRef(input)));
+  }
+
+  return hash;
+}
+
+uint64 DmlKernelKeyHash(const DmlKernelKeyView& k) {
+  uint64 hash = k.attributes_hash;
+
+  for (const DmlInputTensorKeyView& input : k.input_tensors) {
+    hash = Hash64Combine(hash, InputTensorHash(GetInputTensorRef(input)));
   }
 
   return hash;
 }
 
+static uint64 TensorShapeFingerprint(const TensorShape& s) {
+  uint64 fingerprint = s.dims();
+  for (int i = 0; i < s.dims(); ++i) {
+    fingerprint = FingerprintCat64(fingerprint, s.dim_size(i));
+  }
+  return fingerprint;
+}
+
+static uint64 DmlInputTensorKeyFingerprint(const DmlInputTensorKey& k) {
+  uint64 fingerprint = k.is_constant_cpu_input;
+
+  if (k.is_constant_cpu_input) {
+    const Tensor& tensor = absl::get<Tensor>(k.tensor);
+    auto data = tensor.tensor_data();
+
+    fingerprint =
+        FingerprintCat64(fingerprint, TensorShapeFingerprint(tensor.shape()));
+    fingerprint = FingerprintCat64(fingerprint, tensor.dtype());
+    fingerprint = FingerprintCat64(
+        fingerprint, Fingerprint64(StringPiece(data.data(), data.size())));
+  } else {
+    const TensorShapeAndType& tensor = absl::get<TensorShapeAndType>(k.tensor);
+
+    fingerprint =
+        FingerprintCat64(fingerprint, TensorShapeFingerprint(tensor.shape));
+    fingerprint = FingerprintCat64(fingerprint, tensor.dtype);
+  }
+
+  return fingerprint;
+}
+
+uint64 DmlKernelKeyFingerprint(const DmlKernelKey& k) {
+  uint64 fingerprint = Fingerprint64(k.op_type_name);
+
+  // The attribute map is unordered, so sort by name before combining. Attribute
+  // values are serialized deterministically so that the result doesn't depend
+  // on map ordering within the AttrValue protos either.
+  std::vector<std::pair<StringPiece, const AttrValue*>> attributes;
+  for (const auto& kvp : AttrSlice(*k.node_def)) {
+    attributes.emplace_back(kvp.first, &kvp.second);
+  }
+  std::sort(attributes.begin(), attributes.end(),
+            [](const std::pair<StringPiece, const AttrValue*>& a,
+               const std::pair<StringPiece, const AttrValue*>& b) {
+              return a.first < b.first;
+            });
+
+  string serialized_attr;
+  for (const auto& attribute : attributes) {
+    serialized_attr.clear();
+    SerializeToStringDeterministic(*attribute.second, &serialized_attr);
+
+    fingerprint = FingerprintCat64(fingerprint, Fingerprint64(attribute.first));
+    fingerprint = FingerprintCat64(fingerprint, Fingerprint64(serialized_attr));
+  }
+
+  for (const DmlInputTensorKey& input : k.input_tensors) {
+    fingerprint =
+        FingerprintCat64(fingerprint, DmlInputTensorKeyFingerprint(input));
+  }
+
+  return fingerprint;
+}
+
 DmlInputTensorKey DmlInputTensorKey::Clone() const {
   DmlInputTensorKey clone = {};
 
@@ -98,16 +225,88 @@ DmlKernelKey DmlKernelKey::Clone() const {
   return clone;
 }
 
+void DmlKernelKey::ToProto(DmlKernelKeyProto* proto) const {
+  proto->Clear();
+  proto->set_op_type_name(this->op_type_name);
+  *proto->mutable_node_def() = *this->node_def;
+
+  for (const DmlInputTensorKey& input : this->input_tensors) {
+    DmlInputTensorKeyProto* input_proto = proto->add_input_tensors();
+    input_proto->set_is_constant_cpu_input(input.is_constant_cpu_input);
+
+    if (input.is_constant_cpu_input) {
+      const Tensor& tensor = absl::get<Tensor>(input.tensor);
+      tensor.shape().AsProto(input_proto->mutable_shape());
+      input_proto->set_dtype(tensor.dtype());
+      tensor.AsProtoTensorContent(input_proto->mutable_tensor());
+    } else {
+      const TensorShapeAndType& tensor =
+          absl::get<TensorShapeAndType>(input.tensor);
+      tensor.shape.AsProto(input_proto->mutable_shape());
+      input_proto->set_dtype(tensor.dtype);
+    }
+  }
+
+  proto->set_fingerprint(DmlKernelKeyFingerprint(*this));
+}
+
+/*static*/ Status DmlKernelKey::FromProto(const DmlKernelKeyProto& proto,
+                                         DmlKernelKey* key) {
+  DmlKernelKey result = {};
+  result.op_type_name = proto.op_type_name();
+  result.node_def = std::make_shared<NodeDef>(proto.node_def());
+
+  for (const DmlInputTensorKeyProto& input_proto : proto.input_tensors()) {
+    DmlInputTensorKey input = {};
+    input.is_constant_cpu_input = input_proto.is_constant_cpu_input();
+
+    if (!TensorShape::IsValid(input_proto.shape())) {
+      return errors::InvalidArgument("Invalid input shape in kernel key for '",
+                                     proto.op_type_name(), "'");
+    }
+
+    if (input.is_constant_cpu_input) {
+      Tensor tensor;
+      if (!tensor.FromProto(cpu_allocator(), input_proto.tensor())) {
+        return errors::InvalidArgument(
+            "Invalid constant CPU input in kernel key for '",
+            proto.op_type_name(), "'");
+      }
+      input.tensor = std::move(tensor);
+    } else {
+      input.tensor = TensorShapeAndType{TensorShape(input_proto.shape()),
+                                        input_proto.dtype()};
+    }
+
+    result.input_tensors.push_back(std::move(input));
+  }
+
+  if (DmlKernelKeyFingerprint(result) != proto.fingerprint()) {
+    return errors::DataLoss("Fingerprint mismatch in kernel key for '",
+                            proto.op_type_name(), "'");
+  }
+
+  *key = std::move(result);
+  return Status::OK();
+}
+
+// Compares the attributes of two kernels. Keys created by the same op kernel
+// share a NodeDef, which avoids a full attribute comparison on cache hits.
+static bool AttributesEqual(const NodeDef& a, const NodeDef& b) {
+  if (&a == &b) {
+    return true;
+  }
+
+  AttrSlice::Scratch scratch = {};
+  return AttrSlice(a).EqualAttrs(AttrSlice(b), &scratch);
+}
+
 bool DmlKernelKey::operator==(const DmlKernelKey& other) const {
   if (this->op_type_name != other.op_type_name) {
     return false;
   }
 
-  AttrSlice my_attributes(*this->node_def);
-  AttrSlice other_attributes(*other.node_def);
-
-  AttrSlice::Scratch scratch = {};
-  if (!my_attributes.EqualAttrs(other_attributes, &scratch)) {
+  if (!AttributesEqual(*this->node_def, *other.node_def)) {
     return false;
   }
 
@@ -118,52 +317,54 @@ bool DmlKernelKey::operator==(const DmlKernelKey& other) const {
   return true;
 }
 
-bool DmlInputTensorKey::operator==(const DmlInputTensorKey& other) const {
-  if (this->is_constant_cpu_input != other.is_constant_cpu_input) {
+bool DmlKernelKey::operator==(const DmlKernelKeyView& other) const {
+  if (this->op_type_name != other.op_type_name) {
     return false;
   }
 
-  // Compare the tensors
+  if (!AttributesEqual(*this->node_def, **other.node_def)) {
+    return false;
+  }
 
-  if (is_constant_cpu_input) {
-    const auto& tensor0 = absl::get<Tensor>(this->tensor);
-    const auto& tensor1 = absl::get<Tensor>(other.tensor);
+  if (this->input_tensors.size() != other.input_tensors.size()) {
+    return false;
+  }
 
-    if (tensor0.shape() != tensor1.shape()) {
+  for (size_t i = 0; i < this->input_tensors.size(); ++i) {
+    if (!InputTensorsEqual(GetInputTensorRef(this->input_tensors[i]),
+                           GetInputTensorRef(other.input_tensors[i]))) {
       return false;
     }
+  }
 
-    if (tensor0.dtype() != tensor1.dtype()) {
-      return false;
-    }
+  return true;
+}
 
-    // If this is a constant CPU input, the tensor contents also form part of
-    // the key, so we need to compare those too
-    if (this->is_constant_cpu_input) {
-      auto data_0 = tensor0.tensor_data();
-      auto data_1 = tensor1.tensor_data();
-      if (data_0.size() != data_1.size()) {
-        return false;
-      }
+bool DmlInputTensorKey::operator==(const DmlInputTensorKey& other) const {
+  return InputTensorsEqual(GetInputTensorRef(*this), GetInputTensorRef(other));
+}
 
-      if (memcmp(data_0.data(), data_1.data(), data_0.size())) {
-        return false;
-      }
-    }
-  } else {
-    const auto& tensor0 = absl::get<TensorShapeAndType>(this->tensor);
-    const auto& tensor1 = absl::get<TensorShapeAndType>(other.tensor);
+DmlKernelKey DmlKernelKeyView::Clone() const {
+  DmlKernelKey clone = {};
+  clone.op_type_name = string(this->op_type_name);
+  clone.node_def = *this->node_def;
 
-    if (tensor0.shape != tensor1.shape) {
-      return false;
-    }
+  for (const DmlInputTensorKeyView& input : this->input_tensors) {
+    const Tensor& tensor = input.GetTensor();
 
-    if (tensor0.dtype != tensor1.dtype) {
-      return false;
+    DmlInputTensorKey input_clone = {};
+    input_clone.is_constant_cpu_input = input.is_constant_cpu_input;
+
+    if (input.is_constant_cpu_input) {
+      input_clone.tensor = tensor::DeepCopy(tensor);
+    } else {
+      input_clone.tensor = TensorShapeAndType{tensor.shape(), tensor.dtype()};
     }
+
+    clone.input_tensors.push_back(std::move(input_clone));
   }
 
-  return true;
+  return clone;
 }
 
-}  // namespace tensorflow
\ No newline at end of file
+}  // namespace tensorflow
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/protobuf/dml_kernel_cache.pb.h"
 
 namespace tensorflow {
 
@@ -49,6 +50,8 @@ struct DmlInputTensorKey {
   bool operator==(const DmlInputTensorKey& other) const;
 };
 
+struct DmlKernelKeyView;
+
 // Uniquely identifes a DML kernel instance. This is used for caching of
 // kernels, since DML kernels are immutable once constructed.
 struct DmlKernelKey {
@@ -61,9 +64,67 @@ struct DmlKernelKey {
 
   DmlKernelKey Clone() const;  // Performs a deep copy
   bool operator==(const DmlKernelKey& other) const;
+  bool operator==(const DmlKernelKeyView& other) const;
+
+  // Serializes this key into `proto`, including its fingerprint.
+  void ToProto(DmlKernelKeyProto* proto) const;
+
+  // Deserializes a key previously written by ToProto. Fails if the proto is
+  // malformed or if its recorded fingerprint doesn't match the fingerprint of
+  // the deserialized key.
+  static Status FromProto(const DmlKernelKeyProto& proto, DmlKernelKey* key);
+};
+
+// A borrowed input tensor in a DmlKernelKeyView. Regular inputs are referenced
+// directly. Ref inputs can only be read by value from the OpKernelContext, so
+// those are held by value instead (which copies the buffer reference, but not
+// the data).
+struct DmlInputTensorKeyView {
+  absl::variant<const Tensor*, Tensor> tensor;
+  bool is_constant_cpu_input;
+
+  const Tensor& GetTensor() const {
+    return tensor.index() == 0 ? *absl::get<const Tensor*>(tensor)
+                               : absl::get<Tensor>(tensor);
+  }
+};
+
+// A non-owning equivalent of DmlKernelKey, which borrows the NodeDef and input
+// tensors of the kernel being executed. This is what the DmlKernelWrapper uses
+// to look up kernels in the cache, since building one doesn't copy any tensors
+// or NodeDefs; a deep copy is only made (via Clone) when a kernel is inserted.
+//
+// A view compares and hashes identically to the DmlKernelKey it would Clone
+// into. The borrowed objects must outlive the view.
+struct DmlKernelKeyView {
+  StringPiece op_type_name;
+
+  // Points at the shared_ptr held by the op kernel, so that cached keys share
+  // its NodeDef instead of copying it.
+  const std::shared_ptr<const NodeDef>* node_def;
+
+  // DmlKernelAttributesHash(op_type_name, **node_def). This is computed once
+  // per op kernel rather than on every lookup.
+  uint64 attributes_hash;
+
+  absl::InlinedVector<DmlInputTensorKeyView, 6> input_tensors;
+
+  DmlKernelKey Clone() const;  // Performs a deep copy into an owning key
 };
 
+// Hashes the op type and attributes of a kernel. This forms the first part of
+// DmlKernelKeyHash, and can be precomputed by callers which reuse a NodeDef.
+uint64 DmlKernelAttributesHash(StringPiece op_type_name,
+                               const NodeDef& node_def);
+
 uint64 DmlKernelKeyHash(const DmlKernelKey& k);
+uint64 DmlKernelKeyHash(const DmlKernelKeyView& k);
+
+// Computes a fingerprint of the key which, unlike DmlKernelKeyHash, is stable
+// across processes and builds. Keys which compare equal always have the same
+// fingerprint; in particular the fingerprint is independent of the order of
+// attributes in the NodeDef and of the node's name.
+uint64 DmlKernelKeyFingerprint(const DmlKernelKey& k);
 
 // Template specialization of std::hash for DmlKernelKey
 template <>
@@ -71,4 +132,29 @@ struct hash<DmlKernelKey> {
   size_t operator()(const DmlKernelKey& k) const { return DmlKernelKeyHash(k); }
 };
 
+// Transparent hash and equality functors, which allow containers keyed on
+// DmlKernelKey to be searched with a DmlKernelKeyView without a deep copy.
+struct DmlKernelKeyHasher {
+  using is_transparent = void;
+
+  size_t operator()(const DmlKernelKey& k) const { return DmlKernelKeyHash(k); }
+  size_t operator()(const DmlKernelKeyView& k) const {
+    return DmlKernelKeyHash(k);
+  }
+};
+
+struct DmlKernelKeyEq {
+  using is_transparent = void;
+
+  bool operator()(const DmlKernelKey& a, const DmlKernelKey& b) const {
+    return a == b;
+  }
+  bool operator()(const DmlKernelKey& a, const DmlKernelKeyView& b) const {
+    return a == b;
+  }
+  bool operator()(const DmlKernelKeyView& a, const DmlKernelKey& b) const {
+    return b == a;
+  }
+};
+
 }  // namespace tensorflow
\ No newline at end of file
@@ -0,0 +1,207 @@
+/* Copyright (c) Microsoft Corporation.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/dml/dml_kernel_key.h"
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+DmlInputTensorKey ShapeInput(const TensorShape& shape, DataType dtype) {
+  DmlInputTensorKey input = {};
+  input.is_constant_cpu_input = false;
+  input.tensor = TensorShapeAndType{shape, dtype};
+  return input;
+}
+
+DmlInputTensorKey ConstantInput(const Tensor& tensor) {
+  DmlInputTensorKey input = {};
+  input.is_constant_cpu_input = true;
+  input.tensor = tensor;
+  return input;
+}
+
+// Builds a Conv2D-like key. The attributes are inserted in the order given by
+// `reverse_attrs` to check that fingerprints don't depend on map ordering.
+DmlKernelKey CreateKey(const string& node_name, bool reverse_attrs = false) {
+  auto node_def = std::make_shared<NodeDef>();
+  node_def->set_name(node_name);
+  node_def->set_op("Conv2D");
+
+  std::vector<std::pair<string, AttrValue>> attrs(3);
+  attrs[0].first = "T";
+  SetAttrValue(DT_FLOAT, &attrs[0].second);
+  attrs[1].first = "padding";
+  SetAttrValue("SAME", &attrs[1].second);
+  attrs[2].first = "strides";
+  SetAttrValue(std::vector<int32>{1, 2, 2, 1}, &attrs[2].second);
+  if (reverse_attrs) {
+    std::reverse(attrs.begin(), attrs.end());
+  }
+  for (const auto& attr : attrs) {
+    node_def->mutable_attr()->insert({attr.first, attr.second});
+  }
+
+  DmlKernelKey key = {};
+  key.op_type_name = "Conv2D";
+  key.node_def = node_def;
+  key.input_tensors.push_back(ShapeInput({8, 32, 32, 3}, DT_FLOAT));
+  key.input_tensors.push_back(ShapeInput({3, 3, 3, 16}, DT_FLOAT));
+  key.input_tensors.push_back(
+      ConstantInput(test::AsTensor<int32>({1, 2, 3, 4})));
+  return key;
+}
+
+TEST(DmlKernelKeyTest, FingerprintIsDeterministic) {
+  DmlKernelKey key0 = CreateKey("conv0");
+  DmlKernelKey key1 = CreateKey("conv1", /*reverse_attrs=*/true);
+
+  // Equal keys must have equal fingerprints, regardless of node name or
+  // attribute order
+  EXPECT_TRUE(key0 == key1);
+  EXPECT_EQ(DmlKernelKeyFingerprint(key0), DmlKernelKeyFingerprint(key1));
+  EXPECT_EQ(DmlKernelKeyFingerprint(key0),
+            DmlKernelKeyFingerprint(key0.Clone()));
+}
+
+TEST(DmlKernelKeyTest, FingerprintDistinguishesKeys) {
+  const uint64 base = DmlKernelKeyFingerprint(CreateKey("conv"));
+
+  DmlKernelKey different_shape = CreateKey("conv");
+  different_shape.input_tensors[0] = ShapeInput({8, 64, 64, 3}, DT_FLOAT);
+  EXPECT_NE(base, DmlKernelKeyFingerprint(different_shape));
+
+  DmlKernelKey different_dtype = CreateKey("conv");
+  different_dtype.input_tensors[1] = ShapeInput({3, 3, 3, 16}, DT_HALF);
+  EXPECT_NE(base, DmlKernelKeyFingerprint(different_dtype));
+
+  DmlKernelKey different_constant = CreateKey("conv");
+  different_constant.input_tensors[2] =
+      ConstantInput(test::AsTensor<int32>({1, 2, 3, 5}));
+  EXPECT_NE(base, DmlKernelKeyFingerprint(different_constant));
+
+  DmlKernelKey different_attr = CreateKey("conv");
+  auto node_def = std::make_shared<NodeDef>(*different_attr.node_def);
+  SetAttrValue("VALID", &(*node_def->mutable_attr())["padding"]);
+  different_attr.node_def = node_def;
+  EXPECT_NE(base, DmlKernelKeyFingerprint(different_attr));
+
+  // A constant CPU input and a regular input with the same shape and type
+  // identify different kernels
+  DmlKernelKey not_constant = CreateKey("conv");
+  not_constant.input_tensors[2] = ShapeInput({4}, DT_INT32);
+  EXPECT_NE(base, DmlKernelKeyFingerprint(not_constant));
+}
+
+// Builds a view which borrows from `key`, as the DmlKernelWrapper would borrow
+// from its OpKernelContext.
+DmlKernelKeyView CreateView(const DmlKernelKey& key,
+                            std::vector<Tensor>* storage) {
+  storage->clear();
+  storage->reserve(key.input_tensors.size());
+  for (const DmlInputTensorKey& input : key.input_tensors) {
+    if (input.is_constant_cpu_input) {
+      storage->push_back(absl::get<Tensor>(input.tensor));
+    } else {
+      const auto& shape_and_type = absl::get<TensorShapeAndType>(input.tensor);
+      storage->emplace_back(shape_and_type.dtype, shape_and_type.shape);
+    }
+  }
+
+  DmlKernelKeyView view = {};
+  view.op_type_name = key.op_type_name;
+  view.node_def = &key.node_def;
+  view.attributes_hash =
+      DmlKernelAttributesHash(key.op_type_name, *key.node_def);
+  for (size_t i = 0; i < key.input_tensors.size(); ++i) {
+    view.input_tensors.push_back(
+        {&(*storage)[i], key.input_tensors[i].is_constant_cpu_input});
+  }
+  return view;
+}
+
+TEST(DmlKernelKeyTest, ViewMatchesKey) {
+  DmlKernelKey key = CreateKey("conv");
+  std::vector<Tensor> storage;
+  DmlKernelKeyView view = CreateView(key, &storage);
+
+  EXPECT_EQ(DmlKernelKeyHash(view), DmlKernelKeyHash(key));
+  EXPECT_TRUE(key == view);
+  EXPECT_TRUE(DmlKernelKeyEq()(view, key));
+
+  // Cloning a view yields an owning key which shares the NodeDef
+  DmlKernelKey clone = view.Clone();
+  EXPECT_TRUE(clone == key);
+  EXPECT_EQ(clone.node_def, key.node_def);
+  EXPECT_EQ(DmlKernelKeyHash(clone), DmlKernelKeyHash(key));
+
+  // A view with a different shape or constant value doesn't match
+  DmlKernelKey other_shape = CreateKey("conv");
+  other_shape.input_tensors[0] = ShapeInput({8, 32, 32, 4}, DT_FLOAT);
+  EXPECT_FALSE(other_shape == view);
+
+  DmlKernelKey other_constant = CreateKey("conv");
+  other_constant.input_tensors[2] =
+      ConstantInput(test::AsTensor<int32>({4, 3, 2, 1}));
+  EXPECT_FALSE(other_constant == view);
+
+  // Ref inputs are held by value
+  DmlKernelKeyView by_value = view;
+  by_value.input_tensors[0].tensor = storage[0];
+  EXPECT_TRUE(key == by_value);
+  EXPECT_EQ(DmlKernelKeyHash(by_value), DmlKernelKeyHash(key));
+}
+
+TEST(DmlKernelKeyTest, ProtoRoundTrip) {
+  DmlKernelKey key = CreateKey("conv");
+
+  DmlKernelKeyProto proto;
+  key.ToProto(&proto);
+  EXPECT_EQ(proto.fingerprint(), DmlKernelKeyFingerprint(key));
+
+  // Round-trip through the wire format as well, as the manifest would
+  string serialized;
+  ASSERT_TRUE(proto.SerializeToString(&serialized));
+  DmlKernelKeyProto parsed_proto;
+  ASSERT_TRUE(parsed_proto.ParseFromString(serialized));
+
+  DmlKernelKey parsed;
+  TF_ASSERT_OK(DmlKernelKey::FromProto(parsed_proto, &parsed));
+  EXPECT_TRUE(parsed == key);
+  EXPECT_EQ(DmlKernelKeyHash(parsed), DmlKernelKeyHash(key));
+  EXPECT_EQ(parsed.node_def->name(), "conv");
+
+  const Tensor& constant = absl::get<Tensor>(parsed.input_tensors[2].tensor);
+  test::ExpectTensorEqual<int32>(constant, test::AsTensor<int32>({1, 2, 3, 4}));
+}
+
+TEST(DmlKernelKeyTest, FromProtoRejectsFingerprintMismatch) {
+  DmlKernelKeyProto proto;
+  CreateKey("conv").ToProto(&proto);
+
+  // Simulate a manifest written by a build whose key format differs
+  proto.mutable_input_tensors(0)->mutable_shape()->mutable_dim(0)->set_size(16);
+
+  DmlKernelKey parsed;
+  Status s = DmlKernelKey::FromProto(proto, &parsed);
+  EXPECT_EQ(s.code(), error::DATA_LOSS);
+}
+
+}  // namespace
+}  // namespace tensorflow
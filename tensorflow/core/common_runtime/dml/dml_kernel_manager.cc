@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/dml/dml_kernel_manager.h"
 
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
@@ -30,103 +32,258 @@ static size_t GetMaxCacheSize() {
   return DmlKernelManager::kDefaultMaxCacheSize;
 }
 
-DmlKernelManager::DmlKernelManager() : max_cache_size_(GetMaxCacheSize()) {}
+DmlKernelManager::DmlKernelManager()
+    : max_cache_size_(GetMaxCacheSize()), clock_hand_(clock_.end()) {}
 
-void DmlKernelManager::TrimCache() const {
-  assert(lru_list_.size() == kernel_cache_.size());
+DmlKernelManager::~DmlKernelManager() {
+  QueuedReference* ref = queued_references_.load(std::memory_order_acquire);
+  while (ref) {
+    QueuedReference* next = ref->next;
+    delete ref;
+    ref = next;
+  }
+}
 
-  if (kernel_cache_.size() <= max_cache_size_) {
-    // The cache is within the maximum size; nothing to do
-    return;
+DmlKernelManager::CacheEntryPtr DmlKernelManager::InsertKernel(
+    DmlKernelKey key, std::shared_ptr<DmlKernel> kernel) const {
+  const uint64 hash = DmlKernelKeyHash(key);
+  auto entry = std::make_shared<const DmlCachedKernel>(std::move(key), hash,
+                                                       std::move(kernel));
+
+  if (max_cache_size_ == 0) {
+    return entry;  // Caching is disabled
   }
 
-  // Find the least-recently used element
-  const DmlKernelKey* lru_key = lru_list_.back();
+  CacheShard& shard = GetShard(hash);
 
-  VLOG(3) << "DmlKernelManager: evicting '" << lru_key->op_type_name
-          << "' from cache, key=0x" << lru_key;
+  mutex_lock clock_lock(clock_mutex_);
 
-  // Erase it from the LRU list and the cache
-  lru_list_.pop_back();
-  size_t elements_removed = kernel_cache_.erase(*lru_key);
+  {
+    mutex_lock shard_lock(shard.mu);
 
-  assert(elements_removed == 1);
-}
+    // Another thread may have already inserted an instance of this kernel
+    // into the cache while we weren't holding the lock. That's okay; in this
+    // case, the .insert() is a no-op and the kernel will not be cached.
+    auto result = shard.kernels.insert(entry);
 
-void DmlKernelManager::OnRecentlyUsed(const DmlKernelKey* key,
-                                      CacheEntry* entry) const {
-  if (entry->lru_iter == lru_list_.begin()) {
-    return;  // This entry is already the most-recently used
+    if (!result.second) {
+      (*result.first)->Touch();
+      return *result.first;
+    }
   }
 
-  // Remove it from the LRU list and re-insert it at the beginning (the list is
-  // ordered from most-recently to least-recently used)
-  lru_list_.erase(entry->lru_iter);
-  lru_list_.push_front(key);
-  entry->lru_iter = lru_list_.begin();
+  // Make room before adding the new entry to the clock, so that the new entry
+  // itself is never chosen as the victim.
+  TrimCache(max_cache_size_ - 1);
+  clock_.insert(clock_hand_, ClockEntry{entry.get(), &shard});
+
+  return entry;
+}
+
+void DmlKernelManager::TrimCache(size_t max_size) const {
+  while (clock_.size() > max_size) {
+    if (clock_hand_ == clock_.end()) {
+      clock_hand_ = clock_.begin();
+    }
+
+    // Give entries which were used since the last sweep a second chance
+    if (clock_hand_->entry->referenced_.exchange(
+            false, std::memory_order_relaxed)) {
+      ++clock_hand_;
+      continue;
+    }
+
+    const DmlKernelKey* key = &clock_hand_->entry->key();
+    CacheShard* shard = clock_hand_->shard;
+
+    VLOG(3) << "DmlKernelManager: evicting '" << key->op_type_name
+            << "' from cache, key=0x" << key;
+
+    clock_hand_ = clock_.erase(clock_hand_);
+
+    // Release the entry after dropping the shard lock, since this may invoke
+    // the kernel's destructor and we don't want readers waiting on arbitrary
+    // code. Callers may also still hold the entry, in which case the kernel
+    // lives on until they release it.
+    CacheEntryPtr evicted_entry;
+    {
+      mutex_lock shard_lock(shard->mu);
+      auto it = shard->kernels.find(*key);
+      assert(it != shard->kernels.end());
+      evicted_entry = *it;
+      shard->kernels.erase(it);
+    }
+  }
 }
 
-void DmlKernelManager::OnKernelCreation(const DmlKernelKey* key,
+void DmlKernelManager::OnKernelCreation(StringPiece op_type_name,
                                         DmlKernel* kernel) const {
-  VLOG(3) << "DmlKernelManager: instantating '" << key->op_type_name
-          << "' kernel, key=0x" << key << ", kernel=0x" << kernel;
+  VLOG(3) << "DmlKernelManager: instantating '" << op_type_name
+          << "' kernel, kernel=0x" << kernel;
 }
 
 void DmlKernelManager::QueueReference(std::shared_ptr<DmlKernel> kernel,
                                       DmlGpuEvent gpu_event) const {
-  std::unique_lock<std::mutex> lock(mutex_);
+  auto* ref = new QueuedReference{std::move(kernel), std::move(gpu_event),
+                                  /*next=*/nullptr};
+  PushQueuedReferences(ref, ref);
+}
 
-  QueuedReference ref = {};
-  ref.kernel = std::move(kernel);
-  ref.gpu_event = std::move(gpu_event);
-  queued_references_.push_back(std::move(ref));
+void DmlKernelManager::PushQueuedReferences(QueuedReference* first,
+                                            QueuedReference* last) const {
+  QueuedReference* head = queued_references_.load(std::memory_order_relaxed);
+  do {
+    last->next = head;
+  } while (!queued_references_.compare_exchange_weak(
+      head, first, std::memory_order_release, std::memory_order_relaxed));
 }
 
 void DmlKernelManager::ReleaseCompletedReferences() const {
-  std::unique_lock<std::mutex> lock(mutex_);
-
-  std::vector<QueuedReference> references_to_free;
-
-  // Search the `queued_references_` for references that can be freed, and move
-  // them into `references_to_free`. While searching for freeable references,
-  // this loop also compacts the elements of `queued_references_` such that all
-  // remaining valid objects are at the beginning of the vector. The invalid,
-  // moved-from objects at the end are then erase()'d after the loop.
-  auto dst = queued_references_.begin();
-  for (auto it = dst; it != queued_references_.end(); ++it) {
-    if (it->gpu_event.IsSignaled()) {
-      // Move this reference into references_to_free
-      references_to_free.push_back(std::move(*it));
+  // Detach the entire list. References queued concurrently start a new list,
+  // and concurrent callers of this method simply find less (or nothing) to do.
+  QueuedReference* ref =
+      queued_references_.exchange(nullptr, std::memory_order_acquire);
+
+  // References whose events haven't been signaled yet are collected here and
+  // pushed back once the list has been walked.
+  QueuedReference* pending_first = nullptr;
+  QueuedReference* pending_last = nullptr;
+
+  size_t references_freed = 0;
+  while (ref) {
+    QueuedReference* next = ref->next;
+
+    if (ref->gpu_event.IsSignaled()) {
+      // Deleting the node releases its reference to the kernel. No locks are
+      // held here, so it's safe for this to invoke the kernel destructor.
+      delete ref;
+      ++references_freed;
     } else {
-      // Compact the queued_references_ vector
-      if (it != dst) {
-        *dst = std::move(*it);
+      ref->next = pending_first;
+      pending_first = ref;
+      if (!pending_last) {
+        pending_last = ref;
       }
-      ++dst;
     }
+
+    ref = next;
   }
 
-  queued_references_.erase(dst, queued_references_.end());
-  lock.unlock();
+  if (pending_first) {
+    PushQueuedReferences(pending_first, pending_last);
+  }
 
-  VLOG(2) << "DmlKernelManager: cleared " << references_to_free.size()
+  VLOG(2) << "DmlKernelManager: cleared " << references_freed
           << " references.";
-
-  // Clearing this vector releases the references. This is done outside the
-  // lock because kernel destructors are invoked when the reference count
-  // reaches zero, and we don't want to hold locks over arbitrary code.
-  references_to_free.clear();
 }
 
 size_t DmlKernelManager::GetCacheSize() const {
-  std::unique_lock<std::mutex> lock(mutex_);
-  return kernel_cache_.size();
+  mutex_lock clock_lock(clock_mutex_);
+  return clock_.size();
 }
 
 void DmlKernelManager::ClearCache() {
-  std::unique_lock<std::mutex> lock(mutex_);
-  lru_list_.clear();
-  kernel_cache_.clear();
+  mutex_lock clock_lock(clock_mutex_);
+  clock_.clear();
+  clock_hand_ = clock_.end();
+
+  for (CacheShard& shard : shards_) {
+    mutex_lock shard_lock(shard.mu);
+    shard.kernels.clear();
+  }
+}
+
+std::vector<DmlKernelKey> DmlKernelManager::GetCachedKernelKeys() const {
+  mutex_lock clock_lock(clock_mutex_);
+
+  std::vector<DmlKernelKey> keys;
+  std::vector<DmlKernelKey> unreferenced_keys;
+  keys.reserve(clock_.size());
+
+  // Walking backwards from the hand visits entries from most-recently to
+  // least-recently inserted. Keys can't be erased without the clock lock, so
+  // it's safe to read them here without the shard locks.
+  auto it = clock_hand_;
+  for (size_t i = 0; i < clock_.size(); ++i) {
+    if (it == clock_.begin()) {
+      it = clock_.end();
+    }
+    --it;
+
+    if (it->entry->referenced_.load(std::memory_order_relaxed)) {
+      keys.push_back(it->entry->key().Clone());
+    } else {
+      unreferenced_keys.push_back(it->entry->key().Clone());
+    }
+  }
+
+  for (DmlKernelKey& key : unreferenced_keys) {
+    keys.push_back(std::move(key));
+  }
+
+  return keys;
+}
+
+Status DmlKernelManager::SaveManifest(Env* env, const string& path) const {
+  // Serialize outside the lock; constant CPU inputs may be large
+  std::vector<DmlKernelKey> keys = GetCachedKernelKeys();
+
+  DmlKernelCacheManifest manifest;
+  manifest.set_version(kManifestVersion);
+  for (const DmlKernelKey& key : keys) {
+    key.ToProto(manifest.add_kernels());
+  }
+
+  const string tmp_path = strings::StrCat(path, ".tmp", env->NowMicros());
+  TF_RETURN_IF_ERROR(WriteBinaryProto(env, tmp_path, manifest));
+  TF_RETURN_IF_ERROR(env->RenameFile(tmp_path, path));
+
+  VLOG(1) << "DmlKernelManager: wrote " << keys.size()
+          << " kernel keys to manifest " << path;
+
+  return Status::OK();
+}
+
+/*static*/ Status DmlKernelManager::LoadManifest(
+    Env* env, const string& path, std::vector<DmlKernelKey>* keys) {
+  DmlKernelCacheManifest manifest;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(env, path, &manifest));
+
+  if (manifest.version() != kManifestVersion) {
+    return errors::FailedPrecondition("Kernel cache manifest ", path,
+                                      " has version ", manifest.version(),
+                                      ", expected ", kManifestVersion);
+  }
+
+  keys->clear();
+  keys->reserve(manifest.kernels_size());
+
+  // The manifest is ordered most-recently used first; return the keys in
+  // reverse so that replaying them leaves the most-recently used kernel at the
+  // front of the LRU list.
+  for (int i = manifest.kernels_size() - 1; i >= 0; --i) {
+    DmlKernelKey key;
+    Status s = DmlKernelKey::FromProto(manifest.kernels(i), &key);
+    if (!s.ok()) {
+      LOG(WARNING) << "DmlKernelManager: skipping manifest entry: " << s;
+      continue;
+    }
+    keys->push_back(std::move(key));
+  }
+
+  return Status::OK();
+}
+
+bool DmlKernelManager::TryBeginManifestReplay() const {
+  return !manifest_replayed_.exchange(true);
+}
+
+void DmlKernelManager::AddManifestWriter() const { ++manifest_writers_; }
+
+bool DmlKernelManager::ReleaseManifestWriter() const {
+  const int writers = --manifest_writers_;
+  DCHECK_GE(writers, 0);
+  return writers == 0;
 }
 
 }  // namespace tensorflow
\ No newline at end of file
@@ -15,18 +15,72 @@ limitations under the License.
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <list>
 #include <memory>
 
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/dml/dml_common.h"
 #include "tensorflow/core/common_runtime/dml/dml_gpu_event.h"
 #include "tensorflow/core/common_runtime/dml/dml_kernel_context.h"
 #include "tensorflow/core/common_runtime/dml/dml_kernel_key.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
 class DmlKernel;
 class DmlKernelConstruction;
 class NoOpInitializationHelper;
+class Env;
+class OpKernelContext;
+
+// Implemented by op kernels which create their DmlKernels through the
+// DmlKernelManager (i.e. the DmlKernelWrapper). Used when replaying a kernel
+// cache manifest to build and cache a kernel without executing it.
+class DmlCacheableKernel {
+ public:
+  virtual ~DmlCacheableKernel() = default;
+
+  // Creates the DmlKernel for the inputs in `ctx` and inserts it into the
+  // device's kernel cache, if it isn't already cached.
+  virtual Status WarmKernelCache(OpKernelContext* ctx) = 0;
+};
+
+// An entry in the DmlKernelManager's cache: a kernel and the key it was cached
+// under. Holding on to an entry lets callers recognize repeated lookups of the
+// same key without copying it. Entries are immutable, and remain valid after
+// the kernel manager evicts them.
+class DmlCachedKernel {
+ public:
+  DmlCachedKernel(DmlKernelKey key, uint64 hash,
+                  std::shared_ptr<DmlKernel> kernel)
+      : key_(std::move(key)), hash_(hash), kernel_(std::move(kernel)) {}
+
+  const DmlKernelKey& key() const { return key_; }
+
+  // DmlKernelKeyHash(key())
+  uint64 hash() const { return hash_; }
+
+  const std::shared_ptr<DmlKernel>& kernel() const { return kernel_; }
+
+  // Marks the entry as recently used, as a cache hit in the kernel manager
+  // would. This is just an atomic store.
+  void Touch() const { referenced_.store(true, std::memory_order_relaxed); }
+
+ private:
+  friend class DmlKernelManager;
+
+  const DmlKernelKey key_;
+  const uint64 hash_;
+  const std::shared_ptr<DmlKernel> kernel_;
+
+  // The CLOCK reference bit. Set on every cache hit and cleared when the clock
+  // hand sweeps past the entry; entries are only evicted once the hand finds
+  // this bit cleared.
+  mutable std::atomic<bool> referenced_{false};
+};
 
 // Creates, caches, and manages GPU lifetime of DirectML operator kernel
 // instances. Note that this class manages instances of DmlKernel-derived
@@ -45,78 +99,88 @@ class NoOpInitializationHelper;
 // boilerplate of worrying about dynamic shapes, caching DML operators, managing
 // lifetime on the GPU timeline, etc.
 //
+// Cached kernels are evicted with the CLOCK (second chance) approximation of
+// LRU. The cache is sharded by key hash and cache hits only take a shared lock
+// on one shard, so concurrent executors don't serialize on kernel lookups.
+//
 // This class is thread-safe.
 class DmlKernelManager {
  public:
   // Can be overridden by the TF_DIRECTML_KERNEL_CACHE_SIZE environment variable
   static constexpr size_t kDefaultMaxCacheSize = 1536;
 
-  DmlKernelManager();
+  // Version written to DmlKernelCacheManifest::version. Manifests with a
+  // different version are ignored on load.
+  static constexpr int kManifestVersion = 1;
 
-  template <typename TKernel>
+  DmlKernelManager();
+  ~DmlKernelManager();
+
+  // `TKey` may be either a DmlKernelKey or a DmlKernelKeyView. Either way, a
+  // deep copy of the key is made if the kernel is inserted into the cache.
+  //
+  // If `entry` is non-null, it receives the cache entry for `key`. This is
+  // normally the entry holding the new kernel, but may hold an equivalent
+  // kernel if another thread cached one first. If caching is disabled, it
+  // receives an entry which was never inserted into the cache.
+  template <typename TKernel, typename TKey>
   std::shared_ptr<TKernel> CreateCachedKernel(
-      DmlKernelConstruction* ctx, const DmlKernelKey& key,
-      const typename TKernel::InitHelper* init_helper) const {
+      DmlKernelConstruction* ctx, const TKey& key,
+      const typename TKernel::InitHelper* init_helper,
+      std::shared_ptr<const DmlCachedKernel>* entry = nullptr) const {
     static_assert(std::is_base_of<DmlKernel, TKernel>::value,
                   "Kernel type does not inherit from DmlKernel");
 
     // Create a new kernel. Because this can potentially be
-    // slow, we don't hold the lock over the kernel creation.
+    // slow, we don't hold any locks over the kernel creation.
     auto kernel = std::make_shared<TKernel>(ctx, init_helper);
-    OnKernelCreation(&key, kernel.get());
+    OnKernelCreation(key.op_type_name, kernel.get());
 
     // Make a deep copy of the key so that we own the memory
-    auto key_copy = key.Clone();
-
-    std::unique_lock<std::mutex> lock(mutex_);
-
-    CacheEntry entry = {};
-    entry.kernel = kernel;
+    std::shared_ptr<const DmlCachedKernel> inserted_entry =
+        InsertKernel(key.Clone(), kernel);
 
-    // Another thread may have already inserted an instance of this kernel
-    // into the cache while we weren't holding the lock. That's okay; in this
-    // case, the .emplace() is a no-op and the kernel will not be cached.
-    auto result = kernel_cache_.emplace(key_copy, std::move(entry));
-
-    // Retrieve the iterator to the newly-inserted element, or the existing
-    // element if another thread beat us to it.
-    auto it = result.first;
-
-    bool insertion_succeeded = result.second;
-    if (insertion_succeeded) {
-      // If this was a newly-inserted cache entry, also add an LRU entry
-      lru_list_.push_front(&it->first);
-      it->second.lru_iter = lru_list_.begin();
-    }
-
-    // Update the LRU cache
-    OnRecentlyUsed(&it->first, &it->second);
-
-    if (insertion_succeeded) {
-      TrimCache();
+    if (entry) {
+      *entry = std::move(inserted_entry);
     }
 
     return kernel;
   }
 
-  template <typename TKernel>
-  std::shared_ptr<TKernel> TryGetCachedKernel(const DmlKernelKey& key) const {
+  // `TKey` may be either a DmlKernelKey or a DmlKernelKeyView. Looking up a
+  // view doesn't copy any part of the key.
+  template <typename TKernel, typename TKey>
+  std::shared_ptr<TKernel> TryGetCachedKernel(const TKey& key) const {
     static_assert(std::is_base_of<DmlKernel, TKernel>::value,
                   "Kernel type does not inherit from DmlKernel");
 
-    std::unique_lock<std::mutex> lock(mutex_);
+    std::shared_ptr<const DmlCachedKernel> entry = TryGetCacheEntry(key);
+    if (!entry) {
+      return nullptr;
+    }
+
+    return std::static_pointer_cast<TKernel>(entry->kernel());
+  }
+
+  // Like TryGetCachedKernel, but returns the whole cache entry. The entry
+  // shares its key with the cache, so holding on to it doesn't copy the key.
+  template <typename TKey>
+  std::shared_ptr<const DmlCachedKernel> TryGetCacheEntry(
+      const TKey& key) const {
+    const CacheShard& shard = GetShard(DmlKernelKeyHash(key));
+    tf_shared_lock lock(shard.mu);
 
-    auto it = kernel_cache_.find(key);
+    auto it = shard.kernels.find(key);
 
-    if (it == kernel_cache_.end()) {
+    if (it == shard.kernels.end()) {
       return nullptr;
     }
 
-    // Update the LRU cache
-    OnRecentlyUsed(&it->first, &it->second);
+    // Mark the entry as recently used. This is just an atomic store, so hits
+    // only ever need the shared lock.
+    (*it)->Touch();
 
-    auto kernel = std::static_pointer_cast<TKernel>(it->second.kernel);
-    return kernel;
+    return *it;
   }
 
   // Ensures that a reference is maintained on a kernel at least until the given
@@ -134,48 +198,130 @@ class DmlKernelManager {
   // Frees all cached kernels which have completed execution on the GPU.
   void ClearCache();
 
+  // Returns deep copies of the keys of all cached kernels, ordered
+  // approximately from most-recently to least-recently used: entries which
+  // have been hit since the clock hand last passed them come first, and each
+  // group is ordered from most-recently to least-recently inserted.
+  std::vector<DmlKernelKey> GetCachedKernelKeys() const;
+
+  // Writes the keys of all cached kernels to a manifest file at `path`. The
+  // file is written to a temporary location and then renamed, so concurrent
+  // readers (possibly in other processes) never observe a partial manifest.
+  Status SaveManifest(Env* env, const string& path) const;
+
+  // Reads the keys from a manifest previously written by SaveManifest. The
+  // returned keys are ordered from least-recently to most-recently used, which
+  // is the order in which they should be replayed to reproduce the LRU state.
+  // Entries which fail to deserialize are skipped with a warning.
+  static Status LoadManifest(Env* env, const string& path,
+                             std::vector<DmlKernelKey>* keys);
+
+  // Returns true exactly once per kernel manager. Devices sharing this kernel
+  // manager use this to ensure the manifest is only replayed once.
+  bool TryBeginManifestReplay() const;
+
+  // Devices sharing this kernel manager register themselves as writers of the
+  // manifest, and release themselves on destruction. ReleaseManifestWriter
+  // returns true only for the last writer to be released, so that the manifest
+  // is written once per kernel manager rather than once per device.
+  void AddManifestWriter() const;
+  bool ReleaseManifestWriter() const;
+
  private:
-  // A non-owning pointer to the key for the kernel which is used to keep track
-  // of the least-recently-used kernel. This is a pointer into a kernel_cache_
-  // element. This is okay because std::unordered_map is guaranteed never to
-  // invalidate pointers/references to elements.
-  using LruEntry = const DmlKernelKey*;
+  // The cache is split into shards selected by key hash, so that lookups of
+  // unrelated kernels don't contend on the same lock.
+  static constexpr size_t kShardCount = 16;
 
-  struct CacheEntry {
-    std::shared_ptr<DmlKernel> kernel;
+  using CacheEntryPtr = std::shared_ptr<const DmlCachedKernel>;
 
-    // An iterator into the lru_list_. The position of this iterator in the list
-    // indicates how recently used this cache entry is.
-    std::list<LruEntry>::iterator lru_iter;
+  // Transparent hash and equality functors, which allow the entries of a shard
+  // to be looked up by DmlKernelKey or DmlKernelKeyView.
+  struct CacheEntryHasher {
+    using is_transparent = void;
+
+    size_t operator()(const CacheEntryPtr& e) const { return e->hash(); }
+    size_t operator()(const DmlKernelKey& k) const {
+      return DmlKernelKeyHash(k);
+    }
+    size_t operator()(const DmlKernelKeyView& k) const {
+      return DmlKernelKeyHash(k);
+    }
   };
 
+  struct CacheEntryEq {
+    using is_transparent = void;
+
+    bool operator()(const CacheEntryPtr& a, const CacheEntryPtr& b) const {
+      return a == b || a->key() == b->key();
+    }
+    template <typename TKey>
+    bool operator()(const CacheEntryPtr& a, const TKey& b) const {
+      return a->key() == b;
+    }
+    template <typename TKey>
+    bool operator()(const TKey& a, const CacheEntryPtr& b) const {
+      return b->key() == a;
+    }
+  };
+
+  struct CacheShard {
+    mutable mutex mu;
+
+    absl::flat_hash_set<CacheEntryPtr, CacheEntryHasher, CacheEntryEq> kernels
+        GUARDED_BY(mu);
+  };
+
+  // A non-owning pointer to a cache entry, in the order the entries were
+  // inserted into the clock.
+  struct ClockEntry {
+    const DmlCachedKernel* entry;
+    CacheShard* shard;
+  };
+
+  // An entry in the lock-free list of references that are waiting on the GPU.
   struct QueuedReference {
     std::shared_ptr<DmlKernel> kernel;
     DmlGpuEvent gpu_event;
+    QueuedReference* next;
   };
 
-  // Trims the cache by least recently used until it's below the max cache size.
-  void TrimCache() const;
+  CacheShard& GetShard(uint64 hash) const {
+    return shards_[hash % kShardCount];
+  }
+
+  // Inserts a newly created kernel, unless another thread has already cached
+  // an equivalent one. Returns the cache entry for `key`.
+  CacheEntryPtr InsertKernel(DmlKernelKey key,
+                             std::shared_ptr<DmlKernel> kernel) const;
+
+  // Evicts entries by sweeping the clock hand until the cache holds at most
+  // `max_size` kernels.
+  void TrimCache(size_t max_size) const EXCLUSIVE_LOCKS_REQUIRED(clock_mutex_);
 
-  // Marks the cache entry as being recently used, for the purposes of the LRU
-  // cache. `key` and `entry` must be pointers into elements of the
-  // kernel_cache_ map.
-  void OnRecentlyUsed(const DmlKernelKey* key, CacheEntry* entry) const;
+  // Atomically pushes the list [first, last] onto queued_references_.
+  void PushQueuedReferences(QueuedReference* first,
+                            QueuedReference* last) const;
 
-  void OnKernelCreation(const DmlKernelKey* key, DmlKernel* kernel) const;
+  void OnKernelCreation(StringPiece op_type_name, DmlKernel* kernel) const;
 
-  mutable std::mutex mutex_;
   const size_t max_cache_size_;
 
-  // All of these members are protected by mutex_
+  mutable std::array<CacheShard, kShardCount> shards_;
+
+  // Serializes insertions and evictions. This is never taken on a cache hit.
+  // When held together with a shard's mutex, it must be acquired first.
+  mutable mutex clock_mutex_;
 
-  mutable std::unordered_map<DmlKernelKey, CacheEntry, hash<DmlKernelKey>>
-      kernel_cache_;
+  // The eviction order. New entries are inserted just behind the hand, which
+  // gives them a full revolution before they're first considered for eviction.
+  mutable std::list<ClockEntry> clock_ GUARDED_BY(clock_mutex_);
+  mutable std::list<ClockEntry>::iterator clock_hand_ GUARDED_BY(clock_mutex_);
 
-  // Ordered by most-recently to least-recently used.
-  mutable std::list<LruEntry> lru_list_;
+  // The head of a singly-linked list of references queued by QueueReference.
+  mutable std::atomic<QueuedReference*> queued_references_{nullptr};
 
-  mutable std::vector<QueuedReference> queued_references_;
+  mutable std::atomic<bool> manifest_replayed_{false};
+  mutable std::atomic<int> manifest_writers_{0};
 };
 
 }  // namespace tensorflow
\ No newline at end of file
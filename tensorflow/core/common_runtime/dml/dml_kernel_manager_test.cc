@@ -23,7 +23,11 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/dml/dml_operator_helper.h"
 #include "tensorflow/core/common_runtime/dml/dml_util.h"
 #include "tensorflow/core/kernels/dml_ops_common.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -106,7 +110,8 @@ TEST_F(DmlKernelManagerTest, CacheEviction) {
   }
 }
 
-// Tests LRU cache eviction
+// Tests CLOCK cache eviction, which approximates LRU. With a single sweep of
+// the clock hand, the result matches an exact LRU.
 TEST_F(DmlKernelManagerTest, LeastRecentlyUsed) {
   // First fill up the cache and keep weak pointers to them (so we can tell when
   // they are released)
@@ -128,7 +133,7 @@ TEST_F(DmlKernelManagerTest, LeastRecentlyUsed) {
     EXPECT_TRUE(!kernel.expired());
   }
 
-  // Touch key0 and key 2 which makes them most-recently-used
+  // Touch key0 and key 2 which sets their reference bits
   kernel_manager_.TryGetCachedKernel<DmlMockKernel>(CreateKey("key0"));
   kernel_manager_.TryGetCachedKernel<DmlMockKernel>(CreateKey("key2"));
 
@@ -137,7 +142,8 @@ TEST_F(DmlKernelManagerTest, LeastRecentlyUsed) {
   }
 
   // Add a bunch more kernels, which should cause the kernel manager to evict
-  // the least recently used kernels (which should start with key1, then key3)
+  // the oldest kernels without a reference bit (which should start with key1,
+  // then key3)
 
   kernel_manager_.CreateCachedKernel<DmlMockKernel>(&ctx_, CreateKey("foo"),
                                                     &init_helper_);
@@ -160,6 +166,168 @@ TEST_F(DmlKernelManagerTest, LeastRecentlyUsed) {
   }
 }
 
+// Tests that a referenced kernel survives one sweep of the clock hand, but is
+// evicted on the next sweep if it isn't used again.
+TEST_F(DmlKernelManagerTest, SecondChance) {
+  std::vector<std::weak_ptr<DmlMockKernel>> kernels;
+  for (size_t i = 0; i < DmlKernelManager::kDefaultMaxCacheSize; ++i) {
+    std::string key_name = "key" + std::to_string(i);
+    kernels.push_back(kernel_manager_.CreateCachedKernel<DmlMockKernel>(
+        &ctx_, CreateKey(key_name.c_str()), &init_helper_));
+  }
+
+  // Reference every kernel. The next insertion clears all reference bits in a
+  // full sweep, then evicts key0.
+  for (size_t i = 0; i < DmlKernelManager::kDefaultMaxCacheSize; ++i) {
+    std::string key_name = "key" + std::to_string(i);
+    kernel_manager_.TryGetCachedKernel<DmlMockKernel>(
+        CreateKey(key_name.c_str()));
+  }
+
+  kernel_manager_.CreateCachedKernel<DmlMockKernel>(&ctx_, CreateKey("foo"),
+                                                    &init_helper_);
+  EXPECT_TRUE(kernels[0].expired());
+  for (size_t i = 1; i < kernels.size(); ++i) {
+    EXPECT_TRUE(!kernels[i].expired());
+  }
+  EXPECT_TRUE(kernel_manager_.GetCacheSize() ==
+              DmlKernelManager::kDefaultMaxCacheSize);
+
+  // key1 lost its reference bit in the sweep, so it's evicted next even though
+  // it was used more recently than "foo" was inserted
+  kernel_manager_.CreateCachedKernel<DmlMockKernel>(&ctx_, CreateKey("bar"),
+                                                    &init_helper_);
+  EXPECT_TRUE(kernels[1].expired());
+  EXPECT_TRUE(!kernels[2].expired());
+  EXPECT_TRUE(kernel_manager_.TryGetCachedKernel<DmlMockKernel>(
+                  CreateKey("foo")) != nullptr);
+}
+
+// Tests that kernels can be looked up with a borrowed key view
+TEST_F(DmlKernelManagerTest, LookupByView) {
+  DmlKernelKey key = CreateKey("key0");
+  key.input_tensors.push_back({TensorShapeAndType{{2, 3}, DT_FLOAT}, false});
+
+  auto kernel = kernel_manager_.CreateCachedKernel<DmlMockKernel>(
+      &ctx_, key, &init_helper_);
+
+  Tensor input(DT_FLOAT, {2, 3});
+  DmlKernelKeyView view = {};
+  view.op_type_name = key.op_type_name;
+  view.node_def = &key.node_def;
+  view.attributes_hash =
+      DmlKernelAttributesHash(key.op_type_name, *key.node_def);
+  view.input_tensors.push_back({&input, false});
+
+  EXPECT_TRUE(kernel_manager_.TryGetCachedKernel<DmlMockKernel>(view) ==
+              kernel);
+
+  // Inserting through a view which matches an existing key is a no-op
+  kernel_manager_.CreateCachedKernel<DmlMockKernel>(&ctx_, view, &init_helper_);
+  EXPECT_TRUE(kernel_manager_.GetCacheSize() == 1);
+
+  Tensor other_input(DT_FLOAT, {3, 2});
+  view.input_tensors[0] = {&other_input, false};
+  EXPECT_TRUE(kernel_manager_.TryGetCachedKernel<DmlMockKernel>(view) ==
+              nullptr);
+}
+
+// Tests that cache entries share their key with the cache, and that touching
+// an entry spares it from eviction like a cache hit does
+TEST_F(DmlKernelManagerTest, CacheEntry) {
+  std::shared_ptr<const DmlCachedKernel> entry0;
+  auto kernel0 = kernel_manager_.CreateCachedKernel<DmlMockKernel>(
+      &ctx_, CreateKey("key0"), &init_helper_, &entry0);
+  ASSERT_TRUE(entry0 != nullptr);
+  EXPECT_TRUE(entry0->kernel() == kernel0);
+  EXPECT_TRUE(entry0->hash() == DmlKernelKeyHash(CreateKey("key0")));
+
+  // Looking up the key again returns the same entry rather than a copy
+  EXPECT_TRUE(kernel_manager_.TryGetCacheEntry(CreateKey("key0")) == entry0);
+
+  std::vector<std::weak_ptr<DmlMockKernel>> kernels;
+  kernels.push_back(kernel0);
+  kernel0.reset();
+  for (size_t i = 1; i < DmlKernelManager::kDefaultMaxCacheSize; ++i) {
+    std::string key_name = "key" + std::to_string(i);
+    kernels.push_back(kernel_manager_.CreateCachedKernel<DmlMockKernel>(
+        &ctx_, CreateKey(key_name.c_str()), &init_helper_));
+  }
+
+  // The lookup above set key0's reference bit; the first sweep clears it and
+  // evicts key1 instead
+  kernel_manager_.CreateCachedKernel<DmlMockKernel>(&ctx_, CreateKey("foo"),
+                                                    &init_helper_);
+  EXPECT_TRUE(!kernels[0].expired());
+  EXPECT_TRUE(kernels[1].expired());
+
+  // Touching the entry spares key0 from the next sweep as well, which evicts
+  // "foo" once the hand comes back around
+  entry0->Touch();
+  for (size_t i = 1; i < DmlKernelManager::kDefaultMaxCacheSize; ++i) {
+    std::string key_name = "new" + std::to_string(i);
+    kernel_manager_.CreateCachedKernel<DmlMockKernel>(
+        &ctx_, CreateKey(key_name.c_str()), &init_helper_);
+  }
+  EXPECT_TRUE(!kernels[0].expired());
+  EXPECT_TRUE(kernel_manager_.TryGetCacheEntry(CreateKey("foo")) == nullptr);
+
+  // An evicted entry keeps its kernel alive for as long as it's held
+  kernel_manager_.ClearCache();
+  EXPECT_TRUE(!kernels[0].expired());
+  EXPECT_TRUE(kernel_manager_.TryGetCacheEntry(CreateKey("key0")) == nullptr);
+  entry0.reset();
+  EXPECT_TRUE(kernels[0].expired());
+}
+
+// Tests that the cache manifest records every cached key and that loading it
+// yields the keys in replay order (least-recently used first).
+TEST_F(DmlKernelManagerTest, Manifest) {
+  for (const char* name : {"key0", "key1", "key2"}) {
+    kernel_manager_.CreateCachedKernel<DmlMockKernel>(&ctx_, CreateKey(name),
+                                                      &init_helper_);
+  }
+
+  // Touch key0 which sets its reference bit, making it most-recently-used
+  kernel_manager_.TryGetCachedKernel<DmlMockKernel>(CreateKey("key0"));
+
+  const string path =
+      io::JoinPath(testing::TmpDir(), "dml_kernel_cache_manifest.pb");
+  TF_ASSERT_OK(kernel_manager_.SaveManifest(Env::Default(), path));
+
+  std::vector<DmlKernelKey> keys;
+  TF_ASSERT_OK(DmlKernelManager::LoadManifest(Env::Default(), path, &keys));
+
+  ASSERT_EQ(keys.size(), 3);
+  EXPECT_TRUE(keys[0] == CreateKey("key1"));
+  EXPECT_TRUE(keys[1] == CreateKey("key2"));
+  EXPECT_TRUE(keys[2] == CreateKey("key0"));
+
+  // Replaying the manifest into an empty cache reproduces the LRU order
+  DmlKernelManager replayed;
+  for (const DmlKernelKey& key : keys) {
+    replayed.CreateCachedKernel<DmlMockKernel>(&ctx_, key, &init_helper_);
+  }
+
+  std::vector<DmlKernelKey> replayed_keys = replayed.GetCachedKernelKeys();
+  std::vector<DmlKernelKey> original_keys =
+      kernel_manager_.GetCachedKernelKeys();
+  ASSERT_EQ(replayed_keys.size(), original_keys.size());
+  for (size_t i = 0; i < replayed_keys.size(); ++i) {
+    EXPECT_TRUE(replayed_keys[i] == original_keys[i]);
+  }
+
+  // The manifest may only be replayed once per kernel manager
+  EXPECT_TRUE(replayed.TryBeginManifestReplay());
+  EXPECT_FALSE(replayed.TryBeginManifestReplay());
+
+  // Only the last device sharing the kernel manager writes the manifest
+  replayed.AddManifestWriter();
+  replayed.AddManifestWriter();
+  EXPECT_FALSE(replayed.ReleaseManifestWriter());
+  EXPECT_TRUE(replayed.ReleaseManifestWriter());
+}
+
 // Spawn off a bunch of threads and randomly call methods on the kernel manager.
 // The kernel manager is expected to always be thread-safe.
 TEST_F(DmlKernelManagerTest, ThreadSafety) {
@@ -292,4 +460,73 @@ TEST_F(DmlKernelManagerTest, QueueReference) {
   EXPECT_TRUE(kernel2_weak.expired());
 }
 
-}  // namespace tensorflow
\ No newline at end of file
+// Benchmarks measuring the cost of a cache hit against the number of cached
+// kernels, for both owning keys and borrowed key views.
+static void FillKernelManagerForBenchmark(
+    DmlKernelManager* kernel_manager, int num_keys,
+    std::shared_ptr<const NodeDef>* node_def) {
+  DmlKernelConstruction ctx(nullptr, nullptr, nullptr, {}, nullptr);
+  const NoOpInitializationHelper init_helper(nullptr, nullptr);
+
+  *node_def = std::make_shared<NodeDef>();
+  for (int i = 0; i < num_keys; ++i) {
+    DmlKernelKey key;
+    key.op_type_name = "Conv2D";
+    key.node_def = *node_def;
+    key.input_tensors.push_back(
+        {TensorShapeAndType{{1, i + 1, 32, 32}, DT_FLOAT}, false});
+    key.input_tensors.push_back(
+        {TensorShapeAndType{{3, 3, 32, 32}, DT_FLOAT}, false});
+    kernel_manager->CreateCachedKernel<DmlMockKernel>(&ctx, key, &init_helper);
+  }
+}
+
+static void BM_KernelManagerLookupKey(int iters, int num_keys) {
+  testing::StopTiming();
+  DmlKernelManager kernel_manager;
+  std::shared_ptr<const NodeDef> node_def;
+  FillKernelManagerForBenchmark(&kernel_manager, num_keys, &node_def);
+
+  Tensor input(DT_FLOAT, {1, num_keys / 2 + 1, 32, 32});
+  Tensor filter(DT_FLOAT, {3, 3, 32, 32});
+  testing::StartTiming();
+
+  // Mirrors what the DmlKernelWrapper did before key views: build an owning
+  // key from the inputs on every lookup
+  for (int i = 0; i < iters; ++i) {
+    DmlKernelKey key;
+    key.op_type_name = "Conv2D";
+    key.node_def = node_def;
+    key.input_tensors.push_back(
+        {TensorShapeAndType{input.shape(), input.dtype()}, false});
+    key.input_tensors.push_back(
+        {TensorShapeAndType{filter.shape(), filter.dtype()}, false});
+    CHECK(kernel_manager.TryGetCachedKernel<DmlMockKernel>(key));
+  }
+}
+BENCHMARK(BM_KernelManagerLookupKey)->Range(1, 1024);
+
+static void BM_KernelManagerLookupView(int iters, int num_keys) {
+  testing::StopTiming();
+  DmlKernelManager kernel_manager;
+  std::shared_ptr<const NodeDef> node_def;
+  FillKernelManagerForBenchmark(&kernel_manager, num_keys, &node_def);
+
+  Tensor input(DT_FLOAT, {1, num_keys / 2 + 1, 32, 32});
+  Tensor filter(DT_FLOAT, {3, 3, 32, 32});
+  const uint64 attributes_hash = DmlKernelAttributesHash("Conv2D", *node_def);
+  testing::StartTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    DmlKernelKeyView key = {};
+    key.op_type_name = "Conv2D";
+    key.node_def = &node_def;
+    key.attributes_hash = attributes_hash;
+    key.input_tensors.push_back({&input, false});
+    key.input_tensors.push_back({&filter, false});
+    CHECK(kernel_manager.TryGetCachedKernel<DmlMockKernel>(key));
+  }
+}
+BENCHMARK(BM_KernelManagerLookupView)->Range(1, 1024);
+
+}  // namespace tensorflow
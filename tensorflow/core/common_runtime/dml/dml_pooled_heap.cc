@@ -31,79 +31,8 @@ static uint64_t Align(uint64_t offset, uint64_t alignment) {
   return (offset + alignment - 1) & ~(alignment - 1);
 }
 
-absl::optional<uint64_t> DmlPooledHeap::FindOffsetForAllocation(
-    const Chunk& chunk, uint64_t size_in_bytes) {
-  assert(size_in_bytes != 0);
-
-  if (chunk.capacity_in_bytes < size_in_bytes) {
-    // This chunk isn't even big enough to accommodate this allocation
-    return absl::nullopt;
-  }
-
-  if (chunk.allocations.empty()) {
-    // The entire chunk is empty - allocate from the beginning
-    return 0;
-  }
-
-  // Chunks are used as ring buffers, which means this allocation should go
-  // after the most recent previous allocation
-
-  const auto& last_allocation = chunk.allocations.back();
-  uint64_t new_allocation_begin =
-      last_allocation.offset_in_chunk + last_allocation.size_in_bytes;
-  new_allocation_begin = Align(new_allocation_begin, kAllocationAlignment);
-
-  if (new_allocation_begin + size_in_bytes < new_allocation_begin) {
-    // Overflow
-    return absl::nullopt;
-  }
-
-  const auto& first_allocation = chunk.allocations.front();
-  if (first_allocation.offset_in_chunk <= last_allocation.offset_in_chunk) {
-    // This is the case where there's potentially free space at the beginning
-    // and end of the chunk, but not the middle: e.g.
-    //   |------XXXXYYYZZ------|
-    //          ^^^^   ^^
-    //          first  last
-
-    if (new_allocation_begin + size_in_bytes <= chunk.capacity_in_bytes) {
-      // There's enough space between the end of the last allocation and the end
-      // of the chunk
-      return new_allocation_begin;
-    } else {
-      // Otherwise there's not enough space at the end of the chunk - try the
-      // beginning of the chunk instead
-      new_allocation_begin = 0;
-      if (new_allocation_begin + size_in_bytes <=
-          first_allocation.offset_in_chunk) {
-        // There was enough space between the start of the buffer, and the start
-        // of the first allocation
-        return new_allocation_begin;
-      }
-    }
-  } else {
-    // This is the case where there's potentially free space in the middle of
-    // the chunk, but not at the edges e.g.
-    //   |YYYZZ---------XXXX-|
-    //       ^^         ^^^^
-    //       last       first
-
-    if (new_allocation_begin + size_in_bytes <=
-        first_allocation.offset_in_chunk) {
-      // There's enough space between the end of the last allocation, and the
-      // start of the first one
-      return new_allocation_begin;
-    }
-  }
-
-  // Not enough space in this chunk to accommodate the requested allocation
-  return absl::nullopt;
-}
-
-Status DmlPooledHeap::CreateChunk(ID3D12Device* device, uint64_t size_in_bytes,
-                                  /*out*/ DmlPooledHeap::Chunk* chunk) {
-  assert(chunk != nullptr);
-
+Status DmlPooledHeap::CreateChunk(ID3D12Device* device,
+                                  uint64_t size_in_bytes) {
   auto resource_desc = CD3DX12_RESOURCE_DESC::Buffer(size_in_bytes);
   Microsoft::WRL::ComPtr<ID3D12Resource> upload_buffer;
   HRESULT hr = device->CreateCommittedResource(
@@ -118,7 +47,7 @@ Status DmlPooledHeap::CreateChunk(ID3D12Device* device, uint64_t size_in_bytes,
 
   DML_CHECK_SUCCEEDED(hr);
 
-  *chunk = Chunk{size_in_bytes, std::move(upload_buffer)};
+  chunks_.emplace_back(size_in_bytes, std::move(upload_buffer));
 
   return Status::OK();
 }
@@ -143,56 +72,73 @@ Status DmlPooledHeap::Reserve(uint64_t size_in_bytes,
                               /*out*/ uint64_t* offset_in_chunk) {
   assert(chunk_ptr != nullptr);
   assert(offset_in_chunk != nullptr);
+  assert(size_in_bytes != 0);
 
-  // Try to find a chunk with enough free space to accommodate the requested
-  // allocation size
+  // Find the chunk whose best-fitting free range is the smallest, which keeps
+  // large free ranges available for large allocations
+  Chunk* best_chunk = nullptr;
+  uint64_t best_range_size = 0;
   for (Chunk& chunk : chunks_) {
-    absl::optional<uint64_t> offsetForAllocation =
-        FindOffsetForAllocation(chunk, size_in_bytes);
-    if (offsetForAllocation) {
-      // There's enough space in this chunk - return
-      *chunk_ptr = &chunk;
-      *offset_in_chunk = *offsetForAllocation;
-      return Status::OK();
+    uint64_t range_size = chunk.allocator.BestFitRangeSize(size_in_bytes);
+    if (range_size != 0 && (!best_chunk || range_size < best_range_size)) {
+      best_chunk = &chunk;
+      best_range_size = range_size;
     }
   }
 
-  // No chunks were able to accommodate the allocation - create a new chunk and
-  // return that instead
+  if (!best_chunk) {
+    // No chunks were able to accommodate the allocation - create a new chunk
+    // and allocate from that instead
 
-  // At least double the capacity of the pool
-  const uint64_t new_chunk_size =
-      std::max({total_capacity_, kMinChunkSize, size_in_bytes});
+    // At least double the capacity of the pool
+    const uint64_t new_chunk_size =
+        Align(std::max({total_capacity_, kMinChunkSize, size_in_bytes}),
+              kAllocationAlignment);
 
-  DmlPooledHeap::Chunk chunk;
-  TF_RETURN_IF_ERROR(CreateChunk(device_.Get(), new_chunk_size, &chunk));
+    TF_RETURN_IF_ERROR(CreateChunk(device_.Get(), new_chunk_size));
+    total_capacity_ += new_chunk_size;
 
-  chunks_.push_back(std::move(chunk));
-  total_capacity_ += new_chunk_size;
+    best_chunk = &chunks_.back();
+
+    VLOG(3) << "Expanding pooled heap 0x" << this << " ("
+            << HeapTypeString(heap_props_.Type) << "), new capacity="
+            << strings::HumanReadableNumBytes(total_capacity_);
+  }
 
-  // Allocate from the beginning of the new chunk
-  *chunk_ptr = &chunks_.back();
-  *offset_in_chunk = 0;
+  absl::optional<uint64_t> offset =
+      best_chunk->allocator.Allocate(size_in_bytes);
+  assert(offset);
 
-  VLOG(3) << "Expanding pooled heap 0x" << this << " ("
-          << HeapTypeString(heap_props_.Type) << "), new capacity="
-          << strings::HumanReadableNumBytes(total_capacity_);
+  *chunk_ptr = best_chunk;
+  *offset_in_chunk = *offset;
 
   return Status::OK();
 }
 
+void DmlPooledHeap::FreeAfterEvent(Chunk* chunk, uint64_t offset_in_chunk,
+                                   uint64_t size_in_bytes,
+                                   const DmlGpuEvent& done_event) {
+  if (!fence_) {
+    fence_ = done_event.fence;
+  }
+
+  // Reclamation only queries a single fence, so every event must come from it
+  assert(fence_.Get() == done_event.fence.Get());
+
+  chunk->allocator.FreeAfterFence(offset_in_chunk, size_in_bytes,
+                                  done_event.fence_value);
+}
+
 void DmlPooledHeap::ReclaimAllocations() {
+  if (!fence_) {
+    return;  // Nothing has been freed yet
+  }
+
+  // Query the fence once, then release every allocation at or below its
+  // completed value in a single batch per chunk
+  const uint64_t completed_value = fence_->GetCompletedValue();
   for (Chunk& chunk : chunks_) {
-    auto* allocs = &chunk.allocations;
-
-    // Remove all allocations which have had their fences signaled - this
-    // indicates that they are no longer being used by the GPU. We can stop as
-    // soon as we find an allocation which is still in use, because we only use
-    // a single command queue and executions always complete in the order they
-    // were submitted.
-    while (!allocs->empty() && allocs->front().done_event.IsSignaled()) {
-      allocs->pop_front();
-    }
+    chunk.allocator.Reclaim(completed_value);
   }
 }
 
@@ -203,7 +149,7 @@ void DmlPooledHeap::Trim() {
 
   // Release any chunks which have no allocations
   auto it = std::remove_if(chunks_.begin(), chunks_.end(), [](const Chunk& c) {
-    return c.allocations.empty();
+    return c.allocator.IsEmpty();
   });
   chunks_.erase(it, chunks_.end());
 
@@ -225,50 +171,12 @@ void DmlPooledHeap::AssertInvariants() {
   assert(
       std::is_sorted(chunks_.begin(), chunks_.end(), chunk_capacity_comparer));
 
-  // Allocations in a chunk should be sorted by ascending fence value
-  for (const auto& chunk : chunks_) {
-    auto alloc_fence_value_comparer = [](const Allocation& lhs,
-                                         const Allocation& rhs) {
-      return lhs.done_event.fence_value < rhs.done_event.fence_value;
-    };
-    assert(std::is_sorted(chunk.allocations.begin(), chunk.allocations.end(),
-                          alloc_fence_value_comparer));
-  }
-
   // Validate chunk properties
   for (const auto& chunk : chunks_) {
     assert(chunk.resource != nullptr);
     assert(chunk.capacity_in_bytes == chunk.resource->GetDesc().Width);
-  }
-
-  // Validate allocation properties
-  for (const auto& chunk : chunks_) {
-    for (const auto& alloc : chunk.allocations) {
-      assert(alloc.offset_in_chunk + alloc.size_in_bytes <=
-             chunk.capacity_in_bytes);
-      assert(alloc.offset_in_chunk % kAllocationAlignment ==
-             0);  // Validate alignment
-    }
-  }
-
-  // Validate no overlapping allocations
-  for (const auto& chunk : chunks_) {
-    auto alloc_offset_comparer = [](const Allocation& lhs,
-                                    const Allocation& rhs) {
-      return lhs.offset_in_chunk < rhs.offset_in_chunk;
-    };
-
-    std::vector<Allocation> allocations_sorted_by_offset(
-        chunk.allocations.begin(), chunk.allocations.end());
-    std::sort(allocations_sorted_by_offset.begin(),
-              allocations_sorted_by_offset.end(), alloc_offset_comparer);
-
-    for (size_t i = 1; i < allocations_sorted_by_offset.size(); ++i) {
-      const auto& alloc = allocations_sorted_by_offset[i - 1];
-      const auto& next_alloc = allocations_sorted_by_offset[i];
-      assert(alloc.offset_in_chunk + alloc.size_in_bytes <=
-             next_alloc.offset_in_chunk);
-    }
+    assert(chunk.capacity_in_bytes == chunk.allocator.Capacity());
+    chunk.allocator.AssertInvariants();
   }
 
   // Validate total capacity of pool
@@ -17,13 +17,14 @@ limitations under the License.
 
 #include "dml_common.h"
 #include "dml_gpu_event.h"
+#include "dml_range_allocator.h"
 #include "tensorflow/core/lib/core/status.h"
 
 namespace tensorflow {
 
-// Base class for implementing a non-blocking, ring-buffer style D3D12 heap
-// allocator where allocations are automatically freed once usage has completed
-// on the GPU.
+// Base class for implementing a non-blocking D3D12 heap allocator where
+// allocations are automatically freed once usage has completed on the GPU.
+// Within each chunk, allocations are placed best-fit by a DmlRangeAllocator.
 class DmlPooledHeap {
  public:
   // Releases unused capacity.
@@ -37,28 +38,20 @@ class DmlPooledHeap {
   // In bytes; as per D3D12 requirement for buffers
   static constexpr uint64_t kAllocationAlignment = 512;
 
-  // A suballoction from a chunk
-  struct Allocation {
-    uint64_t size_in_bytes;
-
-    // The offset, in bytes, from the beginning of the chunk to the beginning of
-    // this allocation
-    uint64_t offset_in_chunk;
-
-    // The event that will be signaled to when the GPU is done executing work
-    // that uses this allocation
-    DmlGpuEvent done_event;
-  };
-
   // Represents a single contiguous heap from which we carve out suballocations.
-  // Ranges are suballocated from the heap in a ring-buffer fashion.
   struct Chunk {
+    Chunk(uint64_t capacity_in_bytes,
+          Microsoft::WRL::ComPtr<ID3D12Resource> resource)
+        : capacity_in_bytes(capacity_in_bytes),
+          resource(std::move(resource)),
+          allocator(capacity_in_bytes, kAllocationAlignment) {}
+
     uint64_t capacity_in_bytes;  // The total size of the heap, in bytes
     Microsoft::WRL::ComPtr<ID3D12Resource> resource;
 
-    // Allocations are sorted by ascending fence value - that is, least to most
-    // recently allocated
-    std::list<Allocation> allocations;
+    // Tracks which ranges of the heap are free, and which are waiting on the
+    // GPU before they can be reused
+    DmlRangeAllocator allocator;
   };
 
   // Calls AssertInvariants on construction and again on destruction
@@ -79,22 +72,22 @@ class DmlPooledHeap {
 
   // Finds or creates a chunk with enough space to accommodate an allocation of
   // the given size, and returns a pointer to the chunk and allocation offset.
+  // The space stays reserved until it's passed to FreeAfterEvent.
   Status Reserve(uint64_t size_in_bytes,
                  /*out*/ DmlPooledHeap::Chunk** chunk_ptr,
                  /*out*/ uint64_t* offset_in_chunk);
 
+  // Returns space obtained from Reserve to the chunk once `done_event` is
+  // signaled.
+  void FreeAfterEvent(Chunk* chunk, uint64_t offset_in_chunk,
+                      uint64_t size_in_bytes, const DmlGpuEvent& done_event);
+
   void ReclaimAllocations();  // Frees all allocations which are no longer being
                               // used by the GPU.
 
  private:
-  // Attempts to find enough unused space in the supplied chunk to accommodate
-  // the given allocation size. Returns the offset of that memory if successful,
-  // null if there wasn't enough space.
-  static absl::optional<uint64_t> FindOffsetForAllocation(
-      const Chunk& chunk, uint64_t size_in_bytes);
-
-  Status CreateChunk(ID3D12Device* device, uint64_t size_in_bytes,
-                     /*out*/ DmlPooledHeap::Chunk* chunk);
+  // Creates a new chunk and appends it to chunks_.
+  Status CreateChunk(ID3D12Device* device, uint64_t size_in_bytes);
   void AssertInvariants();
 
   Microsoft::WRL::ComPtr<ID3D12Device> device_;
@@ -104,6 +97,10 @@ class DmlPooledHeap {
   // sorted ascending by capacity (heap size)
   std::vector<Chunk> chunks_;
   uint64_t total_capacity_ = 0;  // Total size of all chunks, in bytes
+
+  // The fence which signals the done events of every allocation from this
+  // heap. Null until the first allocation is freed.
+  Microsoft::WRL::ComPtr<ID3D12Fence> fence_;
 };
 
 }  // namespace tensorflow
@@ -0,0 +1,145 @@
+/* Copyright (c) Microsoft Corporation.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/dml/dml_range_allocator.h"
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+DmlRangeAllocator::DmlRangeAllocator(uint64 capacity, uint64 alignment)
+    : capacity_(capacity), alignment_(alignment), free_bytes_(capacity) {
+  DCHECK(alignment != 0 && (alignment & (alignment - 1)) == 0);
+  DCHECK_EQ(capacity % alignment, 0);
+
+  if (capacity != 0) {
+    InsertFreeRange(0, capacity);
+  }
+}
+
+uint64 DmlRangeAllocator::AlignSize(uint64 size_in_bytes) const {
+  return (size_in_bytes + alignment_ - 1) & ~(alignment_ - 1);
+}
+
+void DmlRangeAllocator::InsertFreeRange(uint64 offset, uint64 size) {
+  free_by_offset_.emplace(offset, size);
+  free_by_size_.emplace(size, offset);
+}
+
+void DmlRangeAllocator::EraseFreeRange(std::map<uint64, uint64>::iterator it) {
+  free_by_size_.erase({it->second, it->first});
+  free_by_offset_.erase(it);
+}
+
+absl::optional<uint64> DmlRangeAllocator::Allocate(uint64 size_in_bytes) {
+  DCHECK_NE(size_in_bytes, 0);
+
+  const uint64 aligned_size = AlignSize(size_in_bytes);
+  if (aligned_size < size_in_bytes) {
+    return absl::nullopt;  // Overflow
+  }
+
+  // The smallest free range that fits; ties go to the lowest offset
+  auto best_fit = free_by_size_.lower_bound({aligned_size, 0});
+  if (best_fit == free_by_size_.end()) {
+    return absl::nullopt;
+  }
+
+  const uint64 range_size = best_fit->first;
+  const uint64 range_offset = best_fit->second;
+
+  // Allocate from the front of the range and return the remainder to the free
+  // list. Both ends stay aligned because every size is a multiple of the
+  // alignment.
+  EraseFreeRange(free_by_offset_.find(range_offset));
+  if (range_size > aligned_size) {
+    InsertFreeRange(range_offset + aligned_size, range_size - aligned_size);
+  }
+
+  free_bytes_ -= aligned_size;
+  return range_offset;
+}
+
+void DmlRangeAllocator::FreeAfterFence(uint64 offset, uint64 size_in_bytes,
+                                       uint64 fence_value) {
+  pending_frees_.emplace(fence_value, Range{offset, AlignSize(size_in_bytes)});
+}
+
+void DmlRangeAllocator::Reclaim(uint64 completed_fence_value) {
+  auto end = pending_frees_.upper_bound(completed_fence_value);
+
+  for (auto it = pending_frees_.begin(); it != end; ++it) {
+    uint64 offset = it->second.offset;
+    uint64 size = it->second.size;
+    free_bytes_ += size;
+
+    // Coalesce with the following range, if it's free
+    auto next = free_by_offset_.lower_bound(offset);
+    if (next != free_by_offset_.end() && next->first == offset + size) {
+      size += next->second;
+      EraseFreeRange(next);
+    }
+
+    // Coalesce with the preceding range, if it's free
+    auto prev = free_by_offset_.lower_bound(offset);
+    if (prev != free_by_offset_.begin()) {
+      --prev;
+      if (prev->first + prev->second == offset) {
+        offset = prev->first;
+        size += prev->second;
+        EraseFreeRange(prev);
+      }
+    }
+
+    InsertFreeRange(offset, size);
+  }
+
+  pending_frees_.erase(pending_frees_.begin(), end);
+}
+
+uint64 DmlRangeAllocator::BestFitRangeSize(uint64 size_in_bytes) const {
+  auto best_fit = free_by_size_.lower_bound({AlignSize(size_in_bytes), 0});
+  return best_fit == free_by_size_.end() ? 0 : best_fit->first;
+}
+
+uint64 DmlRangeAllocator::LargestFreeRange() const {
+  return free_by_size_.empty() ? 0 : free_by_size_.rbegin()->first;
+}
+
+void DmlRangeAllocator::AssertInvariants() const {
+#ifdef _DEBUG
+  assert(free_by_offset_.size() == free_by_size_.size());
+
+  uint64 total_free = 0;
+  uint64 previous_end = 0;
+  bool first = true;
+  for (const auto& range : free_by_offset_) {
+    assert(range.first % alignment_ == 0);
+    assert(range.second % alignment_ == 0);
+    assert(range.first + range.second <= capacity_);
+    assert(free_by_size_.count({range.second, range.first}) == 1);
+
+    // Free ranges must be disjoint and fully coalesced
+    assert(first || range.first > previous_end);
+    first = false;
+    previous_end = range.first + range.second;
+
+    total_free += range.second;
+  }
+  assert(total_free == free_bytes_);
+#endif  // #ifdef _DEBUG
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,95 @@
+/* Copyright (c) Microsoft Corporation.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#pragma once
+
+#include <map>
+#include <set>
+
+#include "absl/types/optional.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Manages the free space within a fixed-size range [0, capacity), such as a
+// chunk of a DmlPooledHeap. Allocations are placed with a best-fit policy, and
+// frees are deferred until a fence value has been reached, at which point they
+// are reclaimed in a batch and coalesced with neighbouring free ranges.
+//
+// This class knows nothing about D3D12: fence values are plain integers, which
+// the owner supplies when freeing and reclaiming. This class is not
+// thread-safe.
+class DmlRangeAllocator {
+ public:
+  // `capacity` must be a multiple of `alignment`, which must be a power of 2.
+  DmlRangeAllocator(uint64 capacity, uint64 alignment);
+
+  // Reserves a range of at least `size_in_bytes`, returning its offset. The
+  // offset is always a multiple of the alignment. Returns nullopt if no free
+  // range is large enough. Runs in O(log n) in the number of free ranges.
+  absl::optional<uint64> Allocate(uint64 size_in_bytes);
+
+  // Returns a range previously returned by Allocate, once `fence_value` has
+  // been reached. Until then, the range remains unavailable.
+  void FreeAfterFence(uint64 offset, uint64 size_in_bytes, uint64 fence_value);
+
+  // Makes every range whose fence value is <= `completed_fence_value`
+  // available again.
+  void Reclaim(uint64 completed_fence_value);
+
+  // Returns the size of the free range Allocate would place an allocation of
+  // `size_in_bytes` in, or 0 if there's no range large enough.
+  uint64 BestFitRangeSize(uint64 size_in_bytes) const;
+
+  // Returns the size of the largest range Allocate could currently satisfy.
+  uint64 LargestFreeRange() const;
+
+  // Returns true if the allocator has no live or pending allocations.
+  bool IsEmpty() const { return free_bytes_ == capacity_; }
+
+  uint64 Capacity() const { return capacity_; }
+  uint64 FreeBytes() const { return free_bytes_; }
+  size_t FreeRangeCount() const { return free_by_offset_.size(); }
+  size_t PendingFreeCount() const { return pending_frees_.size(); }
+
+  void AssertInvariants() const;
+
+ private:
+  struct Range {
+    uint64 offset;
+    uint64 size;
+  };
+
+  uint64 AlignSize(uint64 size_in_bytes) const;
+  void InsertFreeRange(uint64 offset, uint64 size);
+  void EraseFreeRange(std::map<uint64, uint64>::iterator it);
+
+  uint64 capacity_;
+  uint64 alignment_;
+
+  // Bytes which are neither allocated nor pending a fence
+  uint64 free_bytes_;
+
+  // Free ranges indexed both by offset (to coalesce neighbours on free) and by
+  // (size, offset) (to find the best fit). Adjacent free ranges are always
+  // coalesced, so no two entries in free_by_offset_ touch.
+  std::map<uint64, uint64> free_by_offset_;
+  std::set<std::pair<uint64, uint64>> free_by_size_;
+
+  // Freed ranges waiting for their fence value, keyed by fence value
+  std::multimap<uint64, Range> pending_frees_;
+};
+
+}  // namespace tensorflow
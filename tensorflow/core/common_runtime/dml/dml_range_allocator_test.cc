@@ -0,0 +1,173 @@
+/* Copyright (c) Microsoft Corporation.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/dml/dml_range_allocator.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr uint64 kAlignment = 512;
+
+// Stands in for an ID3D12Fence: the allocator only ever sees fence values, so
+// the test advances the "GPU" by bumping an integer.
+class FakeFence {
+ public:
+  uint64 Signal() { return ++next_value_; }
+  void Complete(uint64 value) { completed_value_ = value; }
+  uint64 GetCompletedValue() const { return completed_value_; }
+
+ private:
+  uint64 next_value_ = 0;
+  uint64 completed_value_ = 0;
+};
+
+TEST(DmlRangeAllocatorTest, AlignsSizes) {
+  DmlRangeAllocator allocator(4 * kAlignment, kAlignment);
+
+  auto a = allocator.Allocate(1);
+  auto b = allocator.Allocate(kAlignment + 1);
+  ASSERT_TRUE(a && b);
+  EXPECT_EQ(0, *a);
+  EXPECT_EQ(kAlignment, *b);
+  EXPECT_EQ(kAlignment, allocator.FreeBytes());
+  allocator.AssertInvariants();
+}
+
+TEST(DmlRangeAllocatorTest, ExhaustionReturnsNullopt) {
+  DmlRangeAllocator allocator(2 * kAlignment, kAlignment);
+
+  EXPECT_FALSE(allocator.Allocate(3 * kAlignment));
+  ASSERT_TRUE(allocator.Allocate(2 * kAlignment));
+  EXPECT_FALSE(allocator.Allocate(1));
+  EXPECT_EQ(0, allocator.LargestFreeRange());
+}
+
+TEST(DmlRangeAllocatorTest, BestFitPicksSmallestHole) {
+  FakeFence fence;
+  DmlRangeAllocator allocator(16 * kAlignment, kAlignment);
+
+  // Lay out |A:4|B:1|C:2|D:1|E:8| and free A and C, leaving holes of 4 and 2
+  uint64 a = *allocator.Allocate(4 * kAlignment);
+  uint64 b = *allocator.Allocate(1 * kAlignment);
+  uint64 c = *allocator.Allocate(2 * kAlignment);
+  uint64 d = *allocator.Allocate(1 * kAlignment);
+  uint64 e = *allocator.Allocate(8 * kAlignment);
+  (void)b;
+  (void)d;
+  (void)e;
+
+  uint64 value = fence.Signal();
+  allocator.FreeAfterFence(a, 4 * kAlignment, value);
+  allocator.FreeAfterFence(c, 2 * kAlignment, value);
+  fence.Complete(value);
+  allocator.Reclaim(fence.GetCompletedValue());
+
+  EXPECT_EQ(2 * kAlignment, allocator.BestFitRangeSize(kAlignment));
+  EXPECT_EQ(c, *allocator.Allocate(kAlignment));
+
+  // The remainder of C's hole is now the best fit for another small request
+  EXPECT_EQ(c + kAlignment, *allocator.Allocate(kAlignment));
+
+  // Only A's hole remains
+  EXPECT_EQ(a, *allocator.Allocate(3 * kAlignment));
+  allocator.AssertInvariants();
+}
+
+TEST(DmlRangeAllocatorTest, FreedRangeUnavailableUntilFence) {
+  FakeFence fence;
+  DmlRangeAllocator allocator(2 * kAlignment, kAlignment);
+
+  uint64 a = *allocator.Allocate(2 * kAlignment);
+  uint64 value = fence.Signal();
+  allocator.FreeAfterFence(a, 2 * kAlignment, value);
+
+  // The GPU hasn't reached the fence yet
+  allocator.Reclaim(fence.GetCompletedValue());
+  EXPECT_FALSE(allocator.Allocate(kAlignment));
+  EXPECT_FALSE(allocator.IsEmpty());
+  EXPECT_EQ(1, allocator.PendingFreeCount());
+
+  fence.Complete(value);
+  allocator.Reclaim(fence.GetCompletedValue());
+  EXPECT_TRUE(allocator.IsEmpty());
+  EXPECT_EQ(a, *allocator.Allocate(kAlignment));
+}
+
+TEST(DmlRangeAllocatorTest, ReclaimReleasesCompletedBatch) {
+  FakeFence fence;
+  DmlRangeAllocator allocator(8 * kAlignment, kAlignment);
+
+  std::vector<uint64> values;
+  for (int i = 0; i < 8; ++i) {
+    uint64 offset = *allocator.Allocate(kAlignment);
+    uint64 value = fence.Signal();
+    allocator.FreeAfterFence(offset, kAlignment, value);
+    values.push_back(value);
+  }
+  EXPECT_EQ(8, allocator.PendingFreeCount());
+
+  // A single reclaim releases everything up to the completed value, and
+  // nothing after it
+  fence.Complete(values[4]);
+  allocator.Reclaim(fence.GetCompletedValue());
+  EXPECT_EQ(3, allocator.PendingFreeCount());
+  EXPECT_EQ(5 * kAlignment, allocator.FreeBytes());
+
+  // Adjacent reclaimed ranges are coalesced into one
+  EXPECT_EQ(1, allocator.FreeRangeCount());
+  EXPECT_EQ(5 * kAlignment, allocator.LargestFreeRange());
+
+  fence.Complete(values.back());
+  allocator.Reclaim(fence.GetCompletedValue());
+  EXPECT_EQ(0, allocator.PendingFreeCount());
+  EXPECT_TRUE(allocator.IsEmpty());
+  allocator.AssertInvariants();
+}
+
+TEST(DmlRangeAllocatorTest, CoalescingEnablesLargeAllocation) {
+  FakeFence fence;
+  DmlRangeAllocator allocator(4 * kAlignment, kAlignment);
+
+  uint64 a = *allocator.Allocate(kAlignment);
+  uint64 b = *allocator.Allocate(kAlignment);
+  uint64 c = *allocator.Allocate(kAlignment);
+  uint64 d = *allocator.Allocate(kAlignment);
+
+  // Free out of order so coalescing has to merge on both sides: once C is
+  // returned, it joins B on its left and D on its right
+  uint64 value = fence.Signal();
+  allocator.FreeAfterFence(b, kAlignment, value);
+  allocator.FreeAfterFence(d, kAlignment, value);
+  allocator.FreeAfterFence(c, kAlignment, value);
+  fence.Complete(value);
+  allocator.Reclaim(fence.GetCompletedValue());
+
+  EXPECT_EQ(1, allocator.FreeRangeCount());
+  EXPECT_EQ(3 * kAlignment, allocator.LargestFreeRange());
+  EXPECT_EQ(b, *allocator.Allocate(3 * kAlignment));
+
+  value = fence.Signal();
+  allocator.FreeAfterFence(a, kAlignment, value);
+  allocator.FreeAfterFence(b, 3 * kAlignment, value);
+  fence.Complete(value);
+  allocator.Reclaim(fence.GetCompletedValue());
+  EXPECT_EQ(4 * kAlignment, allocator.LargestFreeRange());
+  allocator.AssertInvariants();
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -94,9 +94,9 @@ StatusOr<DmlGpuEvent> DmlReadbackHeap::ReadbackFromGpu(
     DML_CHECK_SUCCEEDED(done_event.fence->Signal(done_event.fence_value));
   };
 
-  // Add an allocation entry to the chunk
-  chunk->allocations.push_back(Allocation{static_cast<uint64_t>(dst.size()),
-                                          offset_in_chunk, done_event});
+  // Return the space to the chunk once the copy has completed
+  FreeAfterEvent(chunk, offset_in_chunk, static_cast<uint64_t>(dst.size()),
+                 done_event);
 
   // Enqueue the done_callback to fire once the copy from src -> readback_heap
   // completes on the GPU. The callback will then perform the copy
@@ -0,0 +1,118 @@
+/* Copyright (c) Microsoft Corporation.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "dml_upload_batch.h"
+
+#include <cstring>
+
+namespace tensorflow {
+
+DmlUploadBatch::DmlUploadBatch(uint8_t* staging_data,
+                               uint64_t staging_capacity)
+    : staging_data_(staging_data), staging_capacity_(staging_capacity) {}
+
+/*static*/ bool DmlUploadBatch::Overlaps(const ScatterList& list,
+                                         uint64_t dst_offset,
+                                         uint64_t size_in_bytes) {
+  // The first entry starting at or after dst_offset must start after the end
+  // of the new range...
+  auto next = list.lower_bound(dst_offset);
+  if (next != list.end() && next->first < dst_offset + size_in_bytes) {
+    return true;
+  }
+
+  // ...and the entry before it must end before the new range starts
+  if (next != list.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second.size_in_bytes > dst_offset) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool DmlUploadBatch::TryAdd(ID3D12Resource* dst, uint64_t dst_offset,
+                            absl::Span<const uint8_t> src) {
+  assert(!src.empty());
+  const uint64_t size_in_bytes = src.size();
+
+  // The data is copied while holding the lock so the batch can't be sealed,
+  // and the staging region read by the GPU, before the copy has finished
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  if (sealed_ || size_in_bytes > staging_capacity_ - staging_bytes_used_) {
+    return false;
+  }
+
+  ScatterList& list = scatter_map_[dst];
+  if (Overlaps(list, dst_offset, size_in_bytes)) {
+    return false;
+  }
+
+  // Uploads are packed back to back so that a run of uploads to consecutive
+  // destinations is also consecutive in the staging region
+  memcpy(staging_data_ + staging_bytes_used_, src.data(), size_in_bytes);
+  list.emplace(dst_offset, ScatterEntry{size_in_bytes, staging_bytes_used_});
+  staging_bytes_used_ += size_in_bytes;
+  ++upload_count_;
+
+  return true;
+}
+
+std::vector<DmlUploadBatch::Copy> DmlUploadBatch::Seal() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  sealed_ = true;
+
+  std::vector<Copy> copies;
+  for (const auto& dst_and_list : scatter_map_) {
+    ID3D12Resource* dst = dst_and_list.first;
+
+    for (const auto& entry : dst_and_list.second) {
+      const uint64_t dst_offset = entry.first;
+      const ScatterEntry& scatter = entry.second;
+
+      // Extend the previous copy if this upload continues it in both the
+      // destination and the staging region
+      if (!copies.empty()) {
+        Copy& last = copies.back();
+        if (last.dst == dst &&
+            last.dst_offset + last.size_in_bytes == dst_offset &&
+            last.staging_offset + last.size_in_bytes ==
+                scatter.staging_offset) {
+          last.size_in_bytes += scatter.size_in_bytes;
+          continue;
+        }
+      }
+
+      copies.push_back(
+          Copy{dst, dst_offset, scatter.staging_offset, scatter.size_in_bytes});
+    }
+  }
+
+  return copies;
+}
+
+uint64_t DmlUploadBatch::StagingBytesUsed() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return staging_bytes_used_;
+}
+
+size_t DmlUploadBatch::UploadCount() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return upload_count_;
+}
+
+}  // namespace tensorflow
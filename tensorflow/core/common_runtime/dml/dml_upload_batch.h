@@ -0,0 +1,89 @@
+/* Copyright (c) Microsoft Corporation.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "dml_common.h"
+
+namespace tensorflow {
+
+// Packs many small host-to-device uploads into one contiguous staging region,
+// and tracks where each one must be scattered to. When the batch is sealed it
+// produces the copies needed to scatter the staging region to the
+// destinations, merging uploads that are contiguous in both the staging region
+// and the same destination resource into a single copy.
+//
+// The batch is the execution context's open command: uploads keep joining it
+// until any other work is enqueued, at which point the batch is sealed and its
+// copies are enqueued ahead of that work. This class writes to the staging
+// memory but never talks to the GPU, and is thread-safe.
+class DmlUploadBatch {
+ public:
+  // A single copy from the staging region into a destination resource.
+  struct Copy {
+    ID3D12Resource* dst;
+    uint64_t dst_offset;
+    uint64_t staging_offset;
+    uint64_t size_in_bytes;
+  };
+
+  // `staging_data` is the CPU-visible address of the staging region, which
+  // must stay valid until the batch is sealed.
+  DmlUploadBatch(uint8_t* staging_data, uint64_t staging_capacity);
+
+  // Attempts to add an upload of `src` to `dst` at `dst_offset`, copying the
+  // data into the staging region. Fails if the batch is sealed, the staging
+  // region is full, or the destination overlaps an upload already in the
+  // batch (whose relative order could otherwise be lost when merging).
+  bool TryAdd(ID3D12Resource* dst, uint64_t dst_offset,
+              absl::Span<const uint8_t> src);
+
+  // Prevents further uploads from joining the batch and returns the copies to
+  // issue, grouped by destination resource and sorted by offset within each.
+  std::vector<Copy> Seal();
+
+  uint64_t StagingCapacity() const { return staging_capacity_; }
+  uint64_t StagingBytesUsed() const;
+  size_t UploadCount() const;
+
+ private:
+  struct ScatterEntry {
+    uint64_t size_in_bytes;
+    uint64_t staging_offset;
+  };
+
+  // Uploads to a single destination resource, keyed by destination offset
+  using ScatterList = std::map<uint64_t, ScatterEntry>;
+
+  static bool Overlaps(const ScatterList& list, uint64_t dst_offset,
+                       uint64_t size_in_bytes);
+
+  uint8_t* const staging_data_;
+  const uint64_t staging_capacity_;
+
+  mutable std::mutex mutex_;
+  bool sealed_ = false;
+  uint64_t staging_bytes_used_ = 0;
+  size_t upload_count_ = 0;
+  std::unordered_map<ID3D12Resource*, ScatterList> scatter_map_;
+};
+
+}  // namespace tensorflow
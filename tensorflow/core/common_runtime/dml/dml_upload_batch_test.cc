@@ -0,0 +1,198 @@
+/* Copyright (c) Microsoft Corporation.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/dml/dml_upload_batch.h"
+
+#include <functional>
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// The batch never dereferences destination resources, so tests use distinct
+// fake pointers in place of real D3D12 buffers.
+ID3D12Resource* FakeResource(uintptr_t id) {
+  return reinterpret_cast<ID3D12Resource*>(id);
+}
+
+absl::Span<const uint8_t> Bytes(const std::vector<uint8_t>& data) {
+  return absl::Span<const uint8_t>(data.data(), data.size());
+}
+
+// Mimics how DmlExecutionContext handles its open command: the open batch is
+// only sealed and enqueued when other work is enqueued or the context is
+// flushed. Copies are recorded as operations in the order the commands run,
+// alongside markers standing in for other GPU work such as kernels.
+class FakeExecutionContext {
+ public:
+  struct Op {
+    DmlUploadBatch::Copy copy;
+    bool is_marker;
+  };
+
+  void OpenBatch(std::shared_ptr<DmlUploadBatch> batch) {
+    SealOpenBatch();
+    open_batch_ = std::move(batch);
+  }
+
+  void EnqueueMarker() {
+    SealOpenBatch();
+    commands_.push_back([this]() { ops_.push_back(Op{{}, true}); });
+  }
+
+  void Flush() {
+    SealOpenBatch();
+    for (auto& command : commands_) {
+      command();
+    }
+    commands_.clear();
+  }
+
+  const std::vector<Op>& ops() const { return ops_; }
+
+ private:
+  void SealOpenBatch() {
+    if (!open_batch_) {
+      return;
+    }
+
+    std::vector<DmlUploadBatch::Copy> copies = open_batch_->Seal();
+    open_batch_.reset();
+    commands_.push_back([this, copies]() {
+      for (const auto& copy : copies) {
+        ops_.push_back(Op{copy, false});
+      }
+    });
+  }
+
+  std::shared_ptr<DmlUploadBatch> open_batch_;
+  std::vector<std::function<void()>> commands_;
+  std::vector<Op> ops_;
+};
+
+TEST(DmlUploadBatchTest, PacksUploadsContiguously) {
+  std::vector<uint8_t> staging(64);
+  DmlUploadBatch batch(staging.data(), staging.size());
+
+  EXPECT_TRUE(batch.TryAdd(FakeResource(1), 100, Bytes({1, 2, 3})));
+  EXPECT_TRUE(batch.TryAdd(FakeResource(2), 0, Bytes({4})));
+  EXPECT_TRUE(batch.TryAdd(FakeResource(1), 0, Bytes({5, 6})));
+
+  EXPECT_EQ(6, batch.StagingBytesUsed());
+  EXPECT_EQ(3, batch.UploadCount());
+  EXPECT_EQ(std::vector<uint8_t>({1, 2, 3, 4, 5, 6}),
+            std::vector<uint8_t>(staging.begin(), staging.begin() + 6));
+}
+
+TEST(DmlUploadBatchTest, MergesContiguousDestinations) {
+  std::vector<uint8_t> staging(64);
+  DmlUploadBatch batch(staging.data(), staging.size());
+
+  // Three consecutive uploads into the same resource become a single copy
+  ASSERT_TRUE(batch.TryAdd(FakeResource(1), 16, Bytes({1, 1, 1, 1})));
+  ASSERT_TRUE(batch.TryAdd(FakeResource(1), 20, Bytes({2, 2})));
+  ASSERT_TRUE(batch.TryAdd(FakeResource(1), 22, Bytes({3, 3})));
+
+  auto copies = batch.Seal();
+  ASSERT_EQ(1, copies.size());
+  EXPECT_EQ(FakeResource(1), copies[0].dst);
+  EXPECT_EQ(16, copies[0].dst_offset);
+  EXPECT_EQ(0, copies[0].staging_offset);
+  EXPECT_EQ(8, copies[0].size_in_bytes);
+}
+
+TEST(DmlUploadBatchTest, SplitsCopiesAtGapsAndResources) {
+  std::vector<uint8_t> staging(64);
+  DmlUploadBatch batch(staging.data(), staging.size());
+
+  // A gap in the destination, a different resource, and a destination that's
+  // contiguous but was added out of order (so its staging data isn't) all
+  // need their own copies
+  ASSERT_TRUE(batch.TryAdd(FakeResource(1), 0, Bytes({1, 1})));
+  ASSERT_TRUE(batch.TryAdd(FakeResource(1), 8, Bytes({2, 2})));
+  ASSERT_TRUE(batch.TryAdd(FakeResource(2), 2, Bytes({3, 3})));
+  ASSERT_TRUE(batch.TryAdd(FakeResource(2), 0, Bytes({4, 4})));
+
+  auto copies = batch.Seal();
+  ASSERT_EQ(4, copies.size());
+
+  uint64_t total_bytes = 0;
+  for (const auto& copy : copies) {
+    EXPECT_EQ(2, copy.size_in_bytes);
+    total_bytes += copy.size_in_bytes;
+
+    // Each copy must read back the bytes written for its destination
+    uint8_t expected = 0;
+    if (copy.dst == FakeResource(1)) {
+      expected = copy.dst_offset == 0 ? 1 : 2;
+    } else {
+      expected = copy.dst_offset == 2 ? 3 : 4;
+    }
+    EXPECT_EQ(expected, staging[copy.staging_offset]);
+  }
+  EXPECT_EQ(batch.StagingBytesUsed(), total_bytes);
+}
+
+TEST(DmlUploadBatchTest, RejectsOverlapAndExhaustion) {
+  std::vector<uint8_t> staging(4);
+  DmlUploadBatch batch(staging.data(), staging.size());
+
+  ASSERT_TRUE(batch.TryAdd(FakeResource(1), 4, Bytes({1, 1})));
+
+  // Overlapping either end of an existing upload
+  EXPECT_FALSE(batch.TryAdd(FakeResource(1), 3, Bytes({2, 2})));
+  EXPECT_FALSE(batch.TryAdd(FakeResource(1), 5, Bytes({2, 2})));
+
+  // The same range in another resource doesn't overlap
+  EXPECT_TRUE(batch.TryAdd(FakeResource(2), 4, Bytes({3})));
+
+  // Only one staging byte is left
+  EXPECT_FALSE(batch.TryAdd(FakeResource(1), 0, Bytes({4, 4})));
+  EXPECT_TRUE(batch.TryAdd(FakeResource(1), 0, Bytes({4})));
+  EXPECT_EQ(3, batch.UploadCount());
+}
+
+TEST(DmlUploadBatchTest, UploadsOrderedAroundOtherWork) {
+  FakeExecutionContext context;
+  std::vector<uint8_t> staging(64);
+
+  auto batch = std::make_shared<DmlUploadBatch>(staging.data(), staging.size());
+  context.OpenBatch(batch);
+  ASSERT_TRUE(batch->TryAdd(FakeResource(1), 0, Bytes({1})));
+  ASSERT_TRUE(batch->TryAdd(FakeResource(1), 1, Bytes({2})));
+
+  // Enqueueing other work seals the batch, so later uploads (even to the same
+  // range) need a new batch and run after that work
+  context.EnqueueMarker();
+  EXPECT_FALSE(batch->TryAdd(FakeResource(1), 0, Bytes({3})));
+
+  auto next_batch =
+      std::make_shared<DmlUploadBatch>(staging.data() + 32, staging.size() / 2);
+  context.OpenBatch(next_batch);
+  ASSERT_TRUE(next_batch->TryAdd(FakeResource(1), 0, Bytes({3})));
+
+  context.Flush();
+  ASSERT_EQ(3, context.ops().size());
+  EXPECT_FALSE(context.ops()[0].is_marker);
+  EXPECT_EQ(2, context.ops()[0].copy.size_in_bytes);
+  EXPECT_TRUE(context.ops()[1].is_marker);
+  EXPECT_FALSE(context.ops()[2].is_marker);
+  EXPECT_EQ(0, context.ops()[2].copy.dst_offset);
+  EXPECT_EQ(1, context.ops()[2].copy.size_in_bytes);
+}
+
+}  // namespace
+}  // namespace tensorflow
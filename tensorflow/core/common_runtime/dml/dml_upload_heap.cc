@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "dml_upload_heap.h"
 
+#include "absl/memory/memory.h"
 #include "tensorflow/core/lib/core/errors.h"
 
 namespace tensorflow {
@@ -29,6 +30,55 @@ DmlUploadHeap::DmlUploadHeap(ID3D12Device* device,
                     D3D12_RESOURCE_STATE_GENERIC_READ),
       execution_context_(execution_context) {}
 
+// Maps the staging region while uploads can join the batch, and unmaps it when
+// the batch is sealed (or destroyed without ever being sealed).
+class DmlUploadHeap::BatchCommand : public DmlExecutionContext::OpenCommand {
+ public:
+  BatchCommand(Microsoft::WRL::ComPtr<ID3D12Resource> staging_resource,
+               uint64_t offset_in_resource, uint64_t capacity)
+      : staging_resource_(std::move(staging_resource)),
+        offset_in_resource_(offset_in_resource) {
+    void* upload_heap_data = nullptr;
+    DML_CHECK_SUCCEEDED(staging_resource_->Map(0, nullptr, &upload_heap_data));
+    batch_ = absl::make_unique<DmlUploadBatch>(
+        static_cast<uint8_t*>(upload_heap_data) + offset_in_resource,
+        capacity);
+  }
+
+  ~BatchCommand() override {
+    if (!sealed_) {
+      staging_resource_->Unmap(0, nullptr);
+    }
+  }
+
+  DmlUploadBatch* batch() { return batch_.get(); }
+
+  std::function<void(DmlCommandList&)> Seal() override {
+    assert(!sealed_);
+    sealed_ = true;
+
+    // Nothing is written to the staging region once the batch is sealed
+    std::vector<DmlUploadBatch::Copy> copies = batch_->Seal();
+    staging_resource_->Unmap(0, nullptr);
+
+    return [copies = std::move(copies), staging_resource = staging_resource_,
+            offset = offset_in_resource_](DmlCommandList& command_list) {
+      for (const DmlUploadBatch::Copy& copy : copies) {
+        command_list.CopyBufferRegion(
+            copy.dst, copy.dst_offset, D3D12_RESOURCE_STATE_COPY_DEST,
+            staging_resource.Get(), offset + copy.staging_offset,
+            D3D12_RESOURCE_STATE_COPY_SOURCE, copy.size_in_bytes);
+      }
+    };
+  }
+
+ private:
+  Microsoft::WRL::ComPtr<ID3D12Resource> staging_resource_;
+  const uint64_t offset_in_resource_;
+  std::unique_ptr<DmlUploadBatch> batch_;
+  bool sealed_ = false;
+};
+
 StatusOr<DmlGpuEvent> DmlUploadHeap::BeginUploadToGpu(
     const D3D12BufferRegion& dst, absl::Span<const uint8_t> src) {
   std::unique_lock<std::mutex> lock(mutex_);
@@ -42,6 +92,10 @@ StatusOr<DmlGpuEvent> DmlUploadHeap::BeginUploadToGpu(
 
   ReclaimAllocations();
 
+  if (src.size() <= kMaxCoalescedUploadSize) {
+    return BeginCoalescedUpload(dst, src);
+  }
+
   // Allocate space from the upload heap
   Chunk* chunk = nullptr;
   uint64_t offset_in_chunk = 0;
@@ -70,11 +124,68 @@ StatusOr<DmlGpuEvent> DmlUploadHeap::BeginUploadToGpu(
   DmlGpuEvent done_event =
       execution_context_->CopyBufferRegion(dst, upload_resource);
 
-  // Add an allocation entry to the chunk
-  chunk->allocations.push_back(Allocation{static_cast<uint64_t>(src.size()),
-                                          offset_in_chunk, done_event});
+  // Return the space to the chunk once the copy has completed
+  FreeAfterEvent(chunk, offset_in_chunk, static_cast<uint64_t>(src.size()),
+                 done_event);
+
+  return done_event;
+}
+
+StatusOr<DmlGpuEvent> DmlUploadHeap::BeginCoalescedUpload(
+    const D3D12BufferRegion& dst, absl::Span<const uint8_t> src) {
+  CHECK(src.size() <= dst.SizeInBytes());
+  ID3D12Resource* dst_resource = dst.ResourceInCopyDstState();
+
+  Status status;
+  std::shared_ptr<BatchCommand> new_batch;
+  Chunk* chunk = nullptr;
+  uint64_t offset_in_chunk = 0;
+
+  // Runs with the execution context's lock held, so the open batch can't be
+  // sealed while the upload joins it
+  auto extend = [&](DmlExecutionContext::OpenCommand* open_command)
+      -> std::shared_ptr<DmlExecutionContext::OpenCommand> {
+    // The open batch has been sealed if any other work was enqueued since it
+    // was opened. It may also be full, or already write to an overlapping
+    // destination. In all of these cases the upload needs a new batch.
+    if (open_command && open_command == open_batch_ &&
+        open_batch_->batch()->TryAdd(dst_resource, dst.Offset(), src)) {
+      return nullptr;
+    }
+
+    status = CreateBatch(&new_batch, &chunk, &offset_in_chunk);
+    if (!status.ok()) {
+      return nullptr;
+    }
+
+    bool added = new_batch->batch()->TryAdd(dst_resource, dst.Offset(), src);
+    assert(added);
+    (void)added;
+
+    open_batch_ = new_batch.get();
+    return new_batch;
+  };
+
+  DmlGpuEvent done_event = execution_context_->ExtendOpenCommand(extend);
+  TF_RETURN_IF_ERROR(status);
+
+  // The whole staging region is returned to the chunk once the batch has
+  // executed, however much of it was used
+  if (new_batch) {
+    FreeAfterEvent(chunk, offset_in_chunk, kUploadBatchCapacity, done_event);
+  }
 
   return done_event;
 }
 
+Status DmlUploadHeap::CreateBatch(std::shared_ptr<BatchCommand>* batch,
+                                  Chunk** chunk, uint64_t* offset_in_chunk) {
+  TF_RETURN_IF_ERROR(Reserve(kUploadBatchCapacity, chunk, offset_in_chunk));
+
+  *batch = std::make_shared<BatchCommand>((*chunk)->resource,
+                                          *offset_in_chunk,
+                                          kUploadBatchCapacity);
+  return Status::OK();
+}
+
 }  // namespace tensorflow
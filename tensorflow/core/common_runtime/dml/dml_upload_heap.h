@@ -18,13 +18,16 @@ limitations under the License.
 #include "dml_common.h"
 #include "dml_execution_context.h"
 #include "dml_pooled_heap.h"
+#include "dml_upload_batch.h"
 
 namespace tensorflow {
 
 class DmlExecutionContext;
 
-// Implements a non-blocking, ring-buffer style upload heap for copying CPU data
-// to GPU resources. This class is thread-safe.
+// Implements a non-blocking upload heap for copying CPU data to GPU resources.
+// Consecutive small uploads, with no other GPU work enqueued between them, are
+// packed into a shared staging region by a DmlUploadBatch and scattered to
+// their destinations with as few copies as possible. This class is thread-safe.
 class DmlUploadHeap : public DmlPooledHeap {
  public:
   DmlUploadHeap(ID3D12Device* device, DmlExecutionContext* execution_context);
@@ -37,8 +40,30 @@ class DmlUploadHeap : public DmlPooledHeap {
                                          absl::Span<const uint8_t> src);
 
  private:
+  // Uploads no larger than this are coalesced
+  static constexpr uint64_t kMaxCoalescedUploadSize = 16 * 1024;  // 16KB
+
+  // Size of the staging region reserved for each batch of coalesced uploads
+  static constexpr uint64_t kUploadBatchCapacity = 256 * 1024;  // 256KB
+
+  // The execution context's open command for a batch of coalesced uploads
+  class BatchCommand;
+
+  StatusOr<DmlGpuEvent> BeginCoalescedUpload(const D3D12BufferRegion& dst,
+                                             absl::Span<const uint8_t> src);
+
+  // Reserves a staging region for a new batch. The region is returned to its
+  // chunk with FreeAfterEvent once the batch's event is known.
+  Status CreateBatch(std::shared_ptr<BatchCommand>* batch, Chunk** chunk,
+                     uint64_t* offset_in_chunk);
+
   std::mutex mutex_;
   DmlExecutionContext* execution_context_;  // weak; owned by DmlDeviceState
+
+  // The batch most recently opened in the execution context. This is only
+  // compared against the context's open command, and never dereferenced
+  // unless they match, since the context releases the batch once it's sealed.
+  BatchCommand* open_batch_ = nullptr;
 };
 
 }  // namespace tensorflow
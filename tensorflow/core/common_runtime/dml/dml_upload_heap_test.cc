@@ -0,0 +1,141 @@
+/* Copyright (c) Microsoft Corporation.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/dml/dml_upload_heap.h"
+
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/dml/dml_adapter.h"
+#include "tensorflow/core/common_runtime/dml/dml_adapter_impl.h"
+#include "tensorflow/core/common_runtime/dml/dml_execution_context.h"
+#include "tensorflow/core/common_runtime/dml/dml_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace tensorflow {
+
+class DmlUploadHeapTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+#ifdef DML_BUILD_WINDOWS
+    d3d_device_ = CreateD3d12Device(nullptr, D3D_FEATURE_LEVEL_11_0);
+#else
+    auto adapters = EnumerateAdapters();
+    ASSERT_FALSE(adapters.empty());
+
+    D3D_FEATURE_LEVEL dxcore_feature_level = adapters[0].IsComputeOnly()
+                                                 ? D3D_FEATURE_LEVEL_1_0_CORE
+                                                 : D3D_FEATURE_LEVEL_11_0;
+
+    d3d_device_ =
+        CreateD3d12Device(adapters[0].Impl()->Get(), dxcore_feature_level);
+#endif
+
+    dml_device_ =
+        CreateDmlDevice(d3d_device_.Get(), DML_CREATE_DEVICE_FLAG_NONE);
+
+    D3D12_COMMAND_QUEUE_DESC queue_desc = {};
+    queue_desc.Type = D3D12_COMMAND_LIST_TYPE_COMPUTE;
+    DML_CHECK_SUCCEEDED(d3d_device_->CreateCommandQueue(
+        &queue_desc, IID_PPV_ARGS(&command_queue_)));
+
+    execution_context_ = absl::make_unique<DmlExecutionContext>(
+        d3d_device_.Get(), dml_device_.Get(), command_queue_.Get());
+    upload_heap_ = absl::make_unique<DmlUploadHeap>(d3d_device_.Get(),
+                                                    execution_context_.get());
+  }
+
+  // Committed resources are zero-initialized. Buffers are kept in the
+  // COPY_DEST state, since they're only ever used by copies in these tests.
+  ComPtr<ID3D12Resource> CreateBuffer(D3D12_HEAP_TYPE heap_type,
+                                      uint64_t size_in_bytes) {
+    auto heap_props = CD3DX12_HEAP_PROPERTIES(heap_type);
+    auto desc = CD3DX12_RESOURCE_DESC::Buffer(size_in_bytes);
+
+    ComPtr<ID3D12Resource> buffer;
+    DML_CHECK_SUCCEEDED(d3d_device_->CreateCommittedResource(
+        &heap_props, D3D12_HEAP_FLAG_NONE, &desc,
+        D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&buffer)));
+    return buffer;
+  }
+
+  // Copies `src` into CPU memory, after all previously enqueued work
+  std::vector<uint8_t> ReadBuffer(ID3D12Resource* src, uint64_t size_in_bytes) {
+    ComPtr<ID3D12Resource> readback =
+        CreateBuffer(D3D12_HEAP_TYPE_READBACK, size_in_bytes);
+    execution_context_->CopyBufferRegionRaw(
+        readback.Get(), 0, D3D12_RESOURCE_STATE_COPY_DEST, src, 0,
+        D3D12_RESOURCE_STATE_COPY_DEST, size_in_bytes);
+
+    auto event_or = execution_context_->Flush();
+    TF_CHECK_OK(event_or.status());
+    event_or.ValueOrDie().WaitForSignal();
+
+    std::vector<uint8_t> data(size_in_bytes);
+    void* mapped_data = nullptr;
+    DML_CHECK_SUCCEEDED(readback->Map(0, nullptr, &mapped_data));
+    memcpy(data.data(), mapped_data, size_in_bytes);
+    readback->Unmap(0, nullptr);
+    return data;
+  }
+
+  ComPtr<ID3D12Device> d3d_device_;
+  ComPtr<IDMLDevice> dml_device_;
+  ComPtr<ID3D12CommandQueue> command_queue_;
+  std::unique_ptr<DmlExecutionContext> execution_context_;
+  std::unique_ptr<DmlUploadHeap> upload_heap_;
+};
+
+// Tests that small uploads on either side of other work aren't coalesced past
+// it, even when they write to disjoint ranges of the same buffer.
+TEST_F(DmlUploadHeapTest, UploadsOrderedAroundOtherWork) {
+  constexpr uint64_t kHalfSize = 256;
+  ComPtr<ID3D12Resource> buffer =
+      CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, 2 * kHalfSize);
+  ComPtr<ID3D12Resource> snapshot =
+      CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, 2 * kHalfSize);
+
+  // The upload heap only needs the buffer in the COPY_DEST state, but checks
+  // the description of the UAV resource
+  D3D12BufferRegion first_half(0, kHalfSize, buffer.Get(), nullptr,
+                               buffer.Get());
+  D3D12BufferRegion second_half(kHalfSize, kHalfSize, buffer.Get(), nullptr,
+                                buffer.Get());
+
+  std::vector<uint8_t> ones(kHalfSize, 1);
+  std::vector<uint8_t> twos(kHalfSize, 2);
+
+  // Upload, then read the whole buffer with a copy standing in for an operator,
+  // then upload to the other half of the buffer
+  TF_ASSERT_OK(upload_heap_->BeginUploadToGpu(first_half, ones).status());
+  execution_context_->CopyBufferRegionRaw(
+      snapshot.Get(), 0, D3D12_RESOURCE_STATE_COPY_DEST, buffer.Get(), 0,
+      D3D12_RESOURCE_STATE_COPY_DEST, 2 * kHalfSize);
+  TF_ASSERT_OK(upload_heap_->BeginUploadToGpu(second_half, twos).status());
+
+  // The operator must see the first upload but not the second
+  std::vector<uint8_t> expected_snapshot = ones;
+  expected_snapshot.resize(2 * kHalfSize, 0);
+  EXPECT_EQ(expected_snapshot, ReadBuffer(snapshot.Get(), 2 * kHalfSize));
+
+  std::vector<uint8_t> expected_buffer = ones;
+  expected_buffer.insert(expected_buffer.end(), twos.begin(), twos.end());
+  EXPECT_EQ(expected_buffer, ReadBuffer(buffer.Get(), 2 * kHalfSize));
+}
+
+}  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/executor.h"
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
 #include <memory>
@@ -24,6 +25,7 @@ limitations under the License.
 
 #include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
+#include "tensorflow/core/common_runtime/allocation_trace.h"
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
@@ -60,6 +62,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
@@ -78,6 +81,9 @@ namespace {
 // 1-D, 0 element tensor.
 static const Tensor* const kEmptyTensor = new Tensor;
 
+// Upper bound on the number of worker slots in a step's work-stealing queue.
+constexpr int kMaxWorkStealingWorkers = 64;
+
 bool IsInitializationOp(const Node* node) {
   return node->op_def().allows_uninitialized_input();
 }
@@ -130,6 +136,7 @@ void SetReferencedTensors(NodeExecStatsInterface* stats,
 }  // namespace nodestats
 
 class ExecutorImpl;
+class FrameStatePool;
 class GraphView;
 
 struct EdgeInfo {
@@ -293,8 +300,12 @@ class GraphView {
 
 class ExecutorImpl : public Executor {
  public:
-  ExecutorImpl(const LocalExecutorParams& p, std::unique_ptr<const Graph> g)
-      : params_(p), graph_(std::move(g)), gview_() {
+  ExecutorImpl(const LocalExecutorParams& p, std::unique_ptr<const Graph> g,
+               bool work_stealing = false)
+      : params_(p),
+        graph_(std::move(g)),
+        gview_(),
+        work_stealing_(work_stealing) {
     CHECK(p.create_kernel != nullptr);
     CHECK(p.delete_kernel != nullptr);
   }
@@ -322,6 +333,7 @@ class ExecutorImpl : public Executor {
 
  private:
   friend class ExecutorState;
+  friend class FrameStatePool;
 
   struct ControlFlowInfo {
     gtl::FlatSet<string> unique_frame_names;
@@ -333,7 +345,8 @@ class ExecutorImpl : public Executor {
         : input_count(0),
           total_inputs(0),
           pending_counts(nullptr),
-          nodes(nullptr) {}
+          nodes(nullptr),
+          state_pool(nullptr) {}
 
     // The total number of inputs to a frame.
     int input_count;
@@ -352,10 +365,10 @@ class ExecutorImpl : public Executor {
     // The nodes in a frame. Used only for debugging.
     std::vector<const Node*>* nodes;  // Owned
 
-    ~FrameInfo() {
-      delete pending_counts;
-      delete nodes;
-    }
+    // Recycles the runtime state of this frame across iterations and steps.
+    FrameStatePool* state_pool;  // Owned
+
+    ~FrameInfo();
   };
 
   static Status BuildControlFlowInfo(const Graph* graph,
@@ -375,6 +388,10 @@ class ExecutorImpl : public Executor {
   std::unique_ptr<const Graph> graph_;
   GraphView gview_;
 
+  // Whether steps schedule ready nodes through per-worker work-stealing
+  // deques instead of handing each one to the runner.
+  const bool work_stealing_;
+
   // A cached value of params_
   bool device_record_tensor_accesses_ = false;
 
@@ -862,6 +879,8 @@ class ExecutorState {
   void RunAsync(Executor::DoneCallback done);
 
  private:
+  friend class FrameStatePool;
+
   // Either a tensor pointer (pass-by-reference) or a tensor (pass-by-value).
   // TODO(yuanbyu): A better way to do "has_value"?
   struct Entry {
@@ -949,6 +968,15 @@ class ExecutorState {
   typedef gtl::InlinedVector<TaggedNode, 8> TaggedNodeSeq;
   typedef gtl::InlinedVector<Entry, 4> EntryVector;
 
+  // Counts how often frame and iteration state was allocated or recycled by a
+  // FrameStatePool during this step.
+  struct StatePoolStats {
+    std::atomic<int64> frames_allocated{0};
+    std::atomic<int64> frames_reused{0};
+    std::atomic<int64> iterations_allocated{0};
+    std::atomic<int64> iterations_reused{0};
+  };
+
   struct IterationState {
     explicit IterationState(const PendingCounts* pending_counts,
                             int total_input_tensors)
@@ -1000,6 +1028,12 @@ class ExecutorState {
                                     dead_result);
     }
 
+    // Restores the counts to their initial values, for reuse by a new
+    // iteration.
+    void ResetCounts(const PendingCounts& pending_counts) {
+      counts_.CopyFrom(pending_counts);
+    }
+
     ~IterationState() { delete[] input_tensors; }
 
    private:
@@ -1061,7 +1095,7 @@ class ExecutorState {
     FrameState* parent_frame = nullptr;
 
     // The maximum allowed number of parallel iterations.
-    const int max_parallel_iterations;
+    int max_parallel_iterations;
 
     // The number of inputs this frame is still waiting.
     int num_pending_inputs = 0;
@@ -1097,6 +1131,11 @@ class ExecutorState {
     int total_input_tensors = 0;
     std::vector<const Node*>* nodes = nullptr;
 
+    // Where iteration state for this frame is obtained from and returned to,
+    // and the step-wide counters that record it.
+    FrameStatePool* state_pool = nullptr;
+    StatePoolStats* pool_stats = nullptr;
+
     // Lock ordering: ExecutorState.mu_ < mu;
     // during structured traversal: parent_frame->mu < mu.
     mutex mu;
@@ -1109,6 +1148,7 @@ class ExecutorState {
       total_input_tensors = finfo->total_inputs;
       num_pending_inputs = finfo->input_count;
       nodes = finfo->nodes;
+      state_pool = finfo->state_pool;
     }
 
     inline IterationState* GetIteration(int64 iter)
@@ -1240,6 +1280,132 @@ class ExecutorState {
     int front_index_;
   };
 
+  // The ready queue of a step run by the work-stealing executor. Each worker
+  // slot owns a deque: nodes made ready on a worker are pushed to the back of
+  // its deque in one batch, instead of becoming one runner_ closure each, and
+  // the owner pops from the back to keep producer and consumer on the same
+  // core. Idle workers steal from the front of other deques.
+  //
+  // A slot has at most one worker at a time. Whoever pushes to a slot with no
+  // worker must start one, and a worker only gives up its slot once its deque
+  // is empty, both under the deque's lock, so no pushed node is ever left
+  // without a worker to run it.
+  //
+  // Shared between the ExecutorState and its worker closures, since the
+  // state is deleted by whichever worker finishes the step's last node.
+  class WorkStealingQueue {
+   public:
+    struct Item {
+      TaggedNode node;
+      int64 scheduled_nsec;
+    };
+
+    explicit WorkStealingQueue(int num_workers) {
+      for (int i = 0; i < num_workers; ++i) {
+        deques_.emplace_back(new Deque);
+      }
+    }
+
+    int num_workers() const { return deques_.size(); }
+
+    // Picks a slot for nodes made ready outside of a worker, e.g. the
+    // initial ready nodes or those of an asynchronous kernel's callback.
+    int NextWorker() {
+      return next_worker_.fetch_add(1, std::memory_order_relaxed) %
+             num_workers();
+    }
+
+    // Appends `nodes` to the back of `worker`'s deque. Returns true if the
+    // slot had no worker, in which case the caller now owns it and must
+    // start a worker for it.
+    bool Push(int worker, const TaggedNodeSeq& nodes, int64 scheduled_nsec) {
+      Deque* deque = deques_[worker].get();
+      mutex_lock l(deque->mu);
+      for (const TaggedNode& node : nodes) {
+        deque->items.push_back(Item{node, scheduled_nsec});
+      }
+      return Claim(deque);
+    }
+
+    // Claims up to `max_workers` slots that have no worker, appending their
+    // indices to `*workers`. The caller must start a worker for each one;
+    // having nothing in their own deques, they start out stealing.
+    void ClaimIdleWorkers(int max_workers, std::vector<int>* workers) {
+      for (int i = 0; i < num_workers() && max_workers > 0; ++i) {
+        if (num_active_.load(std::memory_order_relaxed) >= num_workers()) {
+          return;
+        }
+        Deque* deque = deques_[i].get();
+        mutex_lock l(deque->mu);
+        if (Claim(deque)) {
+          workers->push_back(i);
+          --max_workers;
+        }
+      }
+    }
+
+    // Takes the next node for `worker` to run: the most recent node in its
+    // own deque, or else the oldest node in another's. Returns false, giving
+    // up the slot, once there is nothing left to run.
+    bool Pop(int worker, Item* item) {
+      Deque* own = deques_[worker].get();
+      while (true) {
+        {
+          mutex_lock l(own->mu);
+          if (!own->items.empty()) {
+            *item = own->items.back();
+            own->items.pop_back();
+            return true;
+          }
+        }
+        if (Steal(worker, item)) return true;
+        {
+          // Nodes pushed after the check above saw the slot still claimed,
+          // so they're this worker's to run.
+          mutex_lock l(own->mu);
+          if (own->items.empty()) {
+            own->has_worker = false;
+            num_active_.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+          }
+        }
+      }
+    }
+
+   private:
+    struct Deque {
+      mutex mu;
+      std::deque<Item> items GUARDED_BY(mu);
+      bool has_worker GUARDED_BY(mu) = false;
+    };
+
+    bool Claim(Deque* deque) EXCLUSIVE_LOCKS_REQUIRED(deque->mu) {
+      if (deque->has_worker) return false;
+      deque->has_worker = true;
+      num_active_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+
+    bool Steal(int thief, Item* item) {
+      for (int i = 1; i < num_workers(); ++i) {
+        Deque* victim = deques_[(thief + i) % num_workers()].get();
+        mutex_lock l(victim->mu);
+        if (!victim->items.empty()) {
+          *item = victim->items.front();
+          victim->items.pop_front();
+          return true;
+        }
+      }
+      return false;
+    }
+
+    std::vector<std::unique_ptr<Deque>> deques_;
+    std::atomic<int> num_active_{0};
+    std::atomic<uint32> next_worker_{0};
+
+    TF_DISALLOW_COPY_AND_ASSIGN(WorkStealingQueue);
+  };
+
   struct AsyncState;
 
   const bool vlog_;  // true if VLOG_IS_ON(1). Used to check vlog cheaply.
@@ -1273,6 +1439,14 @@ class ExecutorState {
   Executor::Args::Runner runner_;
   bool sync_on_finish_;
 
+  // Set when running on the work-stealing executor.
+  std::shared_ptr<WorkStealingQueue> work_stealing_queue_;
+
+  // The work-stealing queue and slot of the worker running on this thread,
+  // if any.
+  static thread_local WorkStealingQueue* current_queue_;
+  static thread_local int current_worker_;
+
   // Owned.
 
   // A flag that is set on error after the frame state has been
@@ -1282,6 +1456,8 @@ class ExecutorState {
   // The root frame in which the execution of this step is started.
   FrameState* root_frame_;
 
+  StatePoolStats pool_stats_;
+
   // Invoked when the execution finishes.
   Executor::DoneCallback done_cb_;
 
@@ -1352,6 +1528,22 @@ class ExecutorState {
   void ScheduleReady(const TaggedNodeSeq& ready,
                      TaggedNodeReadyQueue* inline_ready);
 
+  // ScheduleReady for the work-stealing executor: expensive nodes are pushed
+  // to a worker's deque rather than each being handed to runner_.
+  void ScheduleReadyWorkStealing(const TaggedNodeSeq& ready,
+                                 TaggedNodeReadyQueue* inline_ready,
+                                 int64 scheduled_nsec);
+
+  // Starts a worker for each of the work-stealing queue's slots in
+  // `workers`, which the caller must have claimed.
+  void StartWorkers(const std::vector<int>& workers);
+
+  // The body of a work-stealing worker: runs nodes from `queue` until there
+  // is nothing left to run or steal.
+  static void RunWorker(ExecutorState* state,
+                        const std::shared_ptr<WorkStealingQueue>& queue,
+                        int worker);
+
   // For debugging/logging only.
   inline void MaybeMarkCompleted(FrameState* frame, int64 iter, int64 id);
 
@@ -1382,6 +1574,149 @@ class ExecutorState {
   }
 };
 
+// Recycles the FrameState and IterationState objects of a single frame, along
+// with the input tensor arrays and pending counts they own, across loop
+// iterations and steps. Without it, every iteration of a while loop allocates
+// and frees this state, which dominates the cost of running small loop bodies.
+// This class is thread-safe.
+class FrameStatePool {
+ public:
+  typedef ExecutorState::FrameState FrameState;
+  typedef ExecutorState::IterationState IterationState;
+  typedef ExecutorState::StatePoolStats StatePoolStats;
+
+  explicit FrameStatePool(const ExecutorImpl::FrameInfo* frame_info)
+      : frame_info_(frame_info) {}
+
+  ~FrameStatePool() {
+    for (FrameState* frame : free_frames_) delete frame;
+    for (IterationState* iter : free_iterations_) delete iter;
+  }
+
+  // Returns a frame with the same initial state as a newly constructed one.
+  // The caller must still initialize its name, parent and frame info.
+  FrameState* GetFrame(const ExecutorImpl* impl, int parallel_iters,
+                       StatePoolStats* stats) {
+    FrameState* frame = nullptr;
+    {
+      mutex_lock l(mu_);
+      if (!free_frames_.empty()) {
+        frame = free_frames_.back();
+        free_frames_.pop_back();
+      }
+    }
+
+    if (frame == nullptr) {
+      stats->frames_allocated.fetch_add(1, std::memory_order_relaxed);
+      frame = new FrameState(impl, parallel_iters);
+    } else {
+      stats->frames_reused.fetch_add(1, std::memory_order_relaxed);
+      mutex_lock l(frame->mu);
+      frame->executor = impl;
+      frame->max_parallel_iterations = parallel_iters;
+      frame->iteration_count = 0;
+      frame->num_outstanding_iterations = 1;
+    }
+    frame->pool_stats = stats;
+    return frame;
+  }
+
+  // Releases the frame's iterations and stores it for reuse.
+  void ReleaseFrame(FrameState* frame) {
+    {
+      mutex_lock l(frame->mu);
+      for (IterationState*& iter : frame->iterations) {
+        if (iter != nullptr) {
+          ReleaseIteration(iter);
+          iter = nullptr;
+        }
+      }
+      frame->iterations.clear();
+
+      // Drop any tensors still held by the frame now, rather than when it's
+      // next reused; the vectors keep their capacity.
+      frame->next_iter_roots.clear();
+      frame->inv_values.clear();
+      frame->dead_exits.clear();
+      frame->frame_name.clear();
+      frame->parent_frame = nullptr;
+      frame->parent_iter = -1;
+      frame->pool_stats = nullptr;
+    }
+
+    mutex_lock l(mu_);
+    if (free_frames_.size() < kMaxFreeFrames) {
+      free_frames_.push_back(frame);
+      frame = nullptr;
+    }
+    // Not retained, so delete it. Its iterations were already released above.
+    delete frame;
+  }
+
+  // Returns an iteration with freshly initialized pending counts and empty
+  // inputs.
+  IterationState* GetIteration(StatePoolStats* stats) {
+    IterationState* iter = nullptr;
+    {
+      mutex_lock l(mu_);
+      if (!free_iterations_.empty()) {
+        iter = free_iterations_.back();
+        free_iterations_.pop_back();
+      }
+    }
+
+    if (iter == nullptr) {
+      stats->iterations_allocated.fetch_add(1, std::memory_order_relaxed);
+      return new IterationState(frame_info_->pending_counts,
+                                frame_info_->total_inputs);
+    }
+
+    stats->iterations_reused.fetch_add(1, std::memory_order_relaxed);
+    iter->ResetCounts(*frame_info_->pending_counts);
+    iter->outstanding_ops = 0;
+    iter->outstanding_frame_count = 0;
+    return iter;
+  }
+
+  // Stores the iteration for reuse. Any inputs it still holds (e.g. those
+  // left behind on dead branches) are released immediately.
+  void ReleaseIteration(IterationState* iter) {
+    const int total_inputs = frame_info_->total_inputs;
+    for (int i = 0; i < total_inputs; ++i) {
+      iter->input_tensors[i] = ExecutorState::Entry();
+    }
+
+    {
+      mutex_lock l(mu_);
+      if (free_iterations_.size() < kMaxFreeIterations) {
+        free_iterations_.push_back(iter);
+        return;
+      }
+    }
+    delete iter;
+  }
+
+ private:
+  // Enough for a frame running the default 10 parallel iterations, plus a
+  // few concurrently active instances of it (e.g. inside an outer loop).
+  static constexpr size_t kMaxFreeIterations = 64;
+  static constexpr size_t kMaxFreeFrames = 16;
+
+  const ExecutorImpl::FrameInfo* const frame_info_;
+
+  mutex mu_;
+  std::vector<FrameState*> free_frames_ GUARDED_BY(mu_);
+  std::vector<IterationState*> free_iterations_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FrameStatePool);
+};
+
+ExecutorImpl::FrameInfo::~FrameInfo() {
+  delete state_pool;
+  delete pending_counts;
+  delete nodes;
+}
+
 ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
@@ -1410,25 +1745,32 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
     user_device_ = RenamedDevice::NewRenamedDevice(
         device->name(), device, false, false, args.user_intra_op_threadpool);
   }
+  if (impl_->work_stealing_) {
+    work_stealing_queue_ = std::make_shared<WorkStealingQueue>(
+        std::min(port::MaxParallelism(), kMaxWorkStealingWorkers));
+  }
 
   // We start the entire execution in iteration 0 of the root frame
   // so let us create the root frame and the state for iteration 0.
   // We assume root_frame_->frame_name.empty().
-  root_frame_ = new FrameState(impl_, 1);
+  auto it_root_info = impl_->frame_info_.find("");
+  DCHECK(it_root_info != impl_->frame_info_.end());
+  FrameStatePool* root_pool = it_root_info->second->state_pool;
+  root_frame_ = root_pool->GetFrame(impl_, 1, &pool_stats_);
   root_frame_->frame_id = 0;  // must be 0
   root_frame_->InitializeFrameInfo(root_frame_->frame_name);
 
   // Initialize iteration 0.
   root_frame_->iterations.resize(root_frame_->max_parallel_iterations);
-  root_frame_->iterations[0] = new IterationState(
-      root_frame_->pending_counts, root_frame_->total_input_tensors);
+  root_frame_->iterations[0] = root_pool->GetIteration(&pool_stats_);
 
   outstanding_frames_.insert({root_frame_->frame_name, root_frame_});
 }
 
 ExecutorState::~ExecutorState() {
   for (auto name_frame : outstanding_frames_) {
-    delete name_frame.second;
+    FrameState* frame = name_frame.second;
+    frame->state_pool->ReleaseFrame(frame);
   }
   for (auto it : device_context_map_) {
     it->Unref();
@@ -1506,6 +1848,8 @@ void ExecutorImpl::InitializePending(const Graph* graph,
     PendingCounts* counts = new PendingCounts(finfo->pending_counts_layout);
     DCHECK_EQ(finfo->pending_counts, nullptr);
     finfo->pending_counts = counts;
+    DCHECK_EQ(finfo->state_pool, nullptr);
+    finfo->state_pool = new FrameStatePool(finfo);
   }
   for (const Node* n : graph->nodes()) {
     const int id = n->id();
@@ -1618,6 +1962,7 @@ bool MightTrace(const NodeItem& item,
 
 void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
   WithContext wc(context_);
+  ScopedAllocationTraceStep trace_step(step_id_);
   const GraphView& gview = impl_->gview_;
   TaggedNodeSeq ready;
   TaggedNodeReadyQueue inline_ready;
@@ -2292,6 +2637,11 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
     return;
   }
 
+  if (work_stealing_queue_) {
+    ScheduleReadyWorkStealing(ready, inline_ready, scheduled_nsec);
+    return;
+  }
+
   const GraphView& gview = impl_->gview_;
   const TaggedNode* curr_expensive_node = nullptr;
   for (auto& tagged_node : ready) {
@@ -2322,6 +2672,95 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
   }
 }
 
+void ExecutorState::ScheduleReadyWorkStealing(
+    const TaggedNodeSeq& ready, TaggedNodeReadyQueue* inline_ready,
+    int64 scheduled_nsec) {
+  TaggedNodeSeq deferred;
+  if (inline_ready == nullptr) {
+    deferred = ready;
+  } else {
+    // As in ScheduleReady, inexpensive nodes run inline and one expensive
+    // node may run next on this thread.
+    const GraphView& gview = impl_->gview_;
+    for (auto& tagged_node : ready) {
+      const NodeItem& item = *gview.node(tagged_node.node->id());
+      if (tagged_node.is_dead || !item.kernel->IsExpensive()) {
+        inline_ready->push_back(tagged_node);
+      } else {
+        deferred.push_back(tagged_node);
+      }
+    }
+    if (!deferred.empty() && inline_ready->empty()) {
+      inline_ready->push_back(deferred.back());
+      deferred.pop_back();
+    }
+  }
+  if (deferred.empty()) return;
+
+  // Nodes made ready on one of this step's workers go to its own deque.
+  // Anything else, such as the initial ready nodes, is spread across slots.
+  WorkStealingQueue* queue = work_stealing_queue_.get();
+  std::vector<int> workers;
+  if (current_queue_ == queue) {
+    if (queue->Push(current_worker_, deferred, scheduled_nsec)) {
+      workers.push_back(current_worker_);
+    }
+  } else {
+    const int num_slots = std::min<int>(deferred.size(), queue->num_workers());
+    std::vector<TaggedNodeSeq> per_slot(num_slots);
+    for (size_t i = 0; i < deferred.size(); ++i) {
+      per_slot[i % num_slots].push_back(deferred[i]);
+    }
+    for (const TaggedNodeSeq& nodes : per_slot) {
+      const int worker = queue->NextWorker();
+      if (queue->Push(worker, nodes, scheduled_nsec)) {
+        workers.push_back(worker);
+      }
+    }
+  }
+
+  // Wake idle workers to steal whatever this thread won't get to next.
+  const int num_stealable =
+      static_cast<int>(deferred.size()) - static_cast<int>(workers.size());
+  if (num_stealable > 0) {
+    queue->ClaimIdleWorkers(num_stealable, &workers);
+  }
+  StartWorkers(workers);
+}
+
+void ExecutorState::StartWorkers(const std::vector<int>& workers) {
+  for (int worker : workers) {
+    runner_([this, queue = work_stealing_queue_, worker]() {
+      RunWorker(this, queue, worker);
+    });
+  }
+}
+
+/*static*/ void ExecutorState::RunWorker(
+    ExecutorState* state, const std::shared_ptr<WorkStealingQueue>& queue,
+    int worker) {
+  // The worker may itself be running inside another executor's worker, e.g.
+  // for a synchronous function call, so restore whatever was there before.
+  WorkStealingQueue* saved_queue = current_queue_;
+  const int saved_worker = current_worker_;
+  current_queue_ = queue.get();
+  current_worker_ = worker;
+
+  // `state` is deleted by whoever finishes the step's last node, so it may
+  // only be used while holding a node; the queue is kept alive by `queue`.
+  WorkStealingQueue::Item item{TaggedNode(nullptr, nullptr, -1, false), 0};
+  while (queue->Pop(worker, &item)) {
+    state->Process(item.node, item.scheduled_nsec);
+  }
+
+  current_queue_ = saved_queue;
+  current_worker_ = saved_worker;
+}
+
+thread_local ExecutorState::WorkStealingQueue* ExecutorState::current_queue_ =
+    nullptr;
+thread_local int ExecutorState::current_worker_ = -1;
+
 inline void ExecutorState::MaybeMarkCompleted(FrameState* frame, int64 iter,
                                               int64 node_id) {
   // TODO(misard) Replace with a finer-grain enabling flag once we
@@ -2481,6 +2920,17 @@ void ExecutorState::Finish() {
   CHECK(done_cb != nullptr);
   Device* device = impl_->params_.device;
 
+  if (stats_collector_) {
+    stats_collector_->IncrementCounter(kExecutorFramesAllocatedCounter,
+                                       pool_stats_.frames_allocated);
+    stats_collector_->IncrementCounter(kExecutorFramesReusedCounter,
+                                       pool_stats_.frames_reused);
+    stats_collector_->IncrementCounter(kExecutorIterationsAllocatedCounter,
+                                       pool_stats_.iterations_allocated);
+    stats_collector_->IncrementCounter(kExecutorIterationsReusedCounter,
+                                       pool_stats_.iterations_reused);
+  }
+
   // There are several potential race conditions below. To name a few:
   // 1. Even if the device's status is OK at the precise moment when
   // num_deferred_ops_ reaches 0, it could go bad before device->RefreshStatus()
@@ -2571,7 +3021,10 @@ void ExecutorState::FindOrCreateChildFrame(FrameState* frame, int64 iter,
       TryGetNodeAttr(node->attrs(), "parallel_iterations", &parallel_iters);
   DCHECK(found_parallel_iters)
       << "Could not find \"parallel_iterations\" attr in node " << node->name();
-  FrameState* temp = new FrameState(impl_, parallel_iters);
+  auto it_frame_info = impl_->frame_info_.find(enter_name);
+  DCHECK(it_frame_info != impl_->frame_info_.end());
+  FrameStatePool* pool = it_frame_info->second->state_pool;
+  FrameState* temp = pool->GetFrame(impl_, parallel_iters, &pool_stats_);
   temp->frame_name = child_name;
   temp->frame_id = Hash64(child_name);
   temp->parent_frame = frame;
@@ -2581,8 +3034,7 @@ void ExecutorState::FindOrCreateChildFrame(FrameState* frame, int64 iter,
   // 'iterations' is a fixed-length circular buffer.
   temp->iterations.resize(temp->max_parallel_iterations + 1);
   // Initialize iteration 0.
-  temp->iterations[0] =
-      new IterationState(temp->pending_counts, temp->total_input_tensors);
+  temp->iterations[0] = pool->GetIteration(&pool_stats_);
 
   {
     mutex_lock executor_lock(mu_);
@@ -2597,7 +3049,9 @@ void ExecutorState::FindOrCreateChildFrame(FrameState* frame, int64 iter,
       temp = nullptr;
     }
   }
-  delete temp;  // Not used so delete it.
+  if (temp != nullptr) {
+    pool->ReleaseFrame(temp);  // Not used so return it.
+  }
 }
 
 void ExecutorState::DeleteFrame(FrameState* frame, TaggedNodeSeq* ready) {
@@ -2658,7 +3112,7 @@ void ExecutorState::DeleteFrame(FrameState* frame, TaggedNodeSeq* ready) {
     mutex_lock executor_lock(mu_);
     outstanding_frames_.erase(frame_name);
   }
-  delete frame;
+  frame->state_pool->ReleaseFrame(frame);
 }
 
 void ExecutorState::CleanupFramesIterations(FrameState* frame, int64 iter,
@@ -2838,8 +3292,7 @@ void ExecutorState::FrameState::IncrementIteration(const GraphView* gview,
   const int64 next_iter = iteration_count;
 
   // Initialize the next iteration.
-  IterationState* iter_state =
-      new IterationState(pending_counts, total_input_tensors);
+  IterationState* iter_state = state_pool->GetIteration(pool_stats);
   SetIteration(next_iter, iter_state);
   num_outstanding_iterations++;
   dead_exits.clear();
@@ -2856,8 +3309,8 @@ bool ExecutorState::FrameState::CleanupIterations(const GraphView* gview,
                                                   TaggedNodeSeq* ready) {
   int64 curr_iter = iter;
   while (curr_iter <= iteration_count && IsIterationDone(curr_iter)) {
-    // Delete the iteration curr_iter.
-    delete GetIteration(curr_iter);
+    // Return the iteration curr_iter to the pool.
+    state_pool->ReleaseIteration(GetIteration(curr_iter));
     SetIteration(curr_iter, nullptr);
     --num_outstanding_iterations;
     ++curr_iter;
@@ -2877,10 +3330,13 @@ void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
 
 }  // namespace
 
-Status NewLocalExecutor(const LocalExecutorParams& params,
-                        std::unique_ptr<const Graph> graph,
-                        Executor** executor) {
-  ExecutorImpl* impl = new ExecutorImpl(params, std::move(graph));
+namespace {
+
+Status NewExecutorImpl(const LocalExecutorParams& params,
+                       std::unique_ptr<const Graph> graph, bool work_stealing,
+                       Executor** executor) {
+  ExecutorImpl* impl =
+      new ExecutorImpl(params, std::move(graph), work_stealing);
   const Status s = impl->Initialize();
   if (s.ok()) {
     *executor = impl;
@@ -2890,6 +3346,15 @@ Status NewLocalExecutor(const LocalExecutorParams& params,
   return s;
 }
 
+}  // namespace
+
+Status NewLocalExecutor(const LocalExecutorParams& params,
+                        std::unique_ptr<const Graph> graph,
+                        Executor** executor) {
+  return NewExecutorImpl(params, std::move(graph), /*work_stealing=*/false,
+                         executor);
+}
+
 Status CreateNonCachedKernel(Device* device, FunctionLibraryRuntime* flib,
                              const NodeDef& ndef, int graph_def_version,
                              OpKernel** kernel) {
@@ -2906,21 +3371,30 @@ namespace {
 class DefaultExecutorRegistrar {
  public:
   DefaultExecutorRegistrar() {
-    Factory* factory = new Factory;
+    Factory* factory = new Factory(/*work_stealing=*/false);
     ExecutorFactory::Register("", factory);
     ExecutorFactory::Register("DEFAULT", factory);
+    ExecutorFactory::Register("WORK_STEALING",
+                              new Factory(/*work_stealing=*/true));
   }
 
  private:
   class Factory : public ExecutorFactory {
+   public:
+    explicit Factory(bool work_stealing) : work_stealing_(work_stealing) {}
+
     Status NewExecutor(const LocalExecutorParams& params,
                        std::unique_ptr<const Graph> graph,
                        std::unique_ptr<Executor>* out_executor) override {
       Executor* ret = nullptr;
-      TF_RETURN_IF_ERROR(NewLocalExecutor(params, std::move(graph), &ret));
+      TF_RETURN_IF_ERROR(
+          NewExecutorImpl(params, std::move(graph), work_stealing_, &ret));
       out_executor->reset(ret);
       return Status::OK();
     }
+
+   private:
+    const bool work_stealing_;
   };
 };
 static DefaultExecutorRegistrar registrar;
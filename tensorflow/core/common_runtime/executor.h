@@ -150,6 +150,17 @@ struct LocalExecutorParams {
                                       std::unique_ptr<const Graph> graph,
                                       Executor** executor);
 
+// Counters reported by the local executor to the step's stats collector when
+// the step finishes. Frame and iteration state (one per while loop and loop
+// iteration) is either newly allocated or reused from an earlier iteration or
+// step.
+constexpr char kExecutorFramesAllocatedCounter[] = "executor_frames_allocated";
+constexpr char kExecutorFramesReusedCounter[] = "executor_frames_reused";
+constexpr char kExecutorIterationsAllocatedCounter[] =
+    "executor_iterations_allocated";
+constexpr char kExecutorIterationsReusedCounter[] =
+    "executor_iterations_reused";
+
 // A class to help run multiple executors in parallel and wait until
 // all of them are complete.
 //
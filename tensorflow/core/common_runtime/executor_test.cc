@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
@@ -56,8 +57,10 @@ class ExecutorTest : public ::testing::Test {
     delete exec_;
   }
 
-  // Resets executor_ with a new executor based on a graph 'gdef'.
-  void Create(std::unique_ptr<const Graph> graph) {
+  // Resets executor_ with a new executor based on a graph 'gdef', using the
+  // executor registered as 'executor_type'.
+  void Create(std::unique_ptr<const Graph> graph,
+              const string& executor_type = "") {
     const int version = graph->versions().producer();
     LocalExecutorParams params;
     params.device = device_.get();
@@ -77,7 +80,10 @@ class ExecutorTest : public ::testing::Test {
       return Status::OK();
     };
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, std::move(graph), &exec_));
+    std::unique_ptr<Executor> executor;
+    TF_CHECK_OK(
+        NewExecutor(executor_type, params, std::move(graph), &executor));
+    exec_ = executor.release();
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
   }
 
@@ -250,6 +256,25 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, WorkStealingRandomTree) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  BuildTree(4096, g.get());
+  Create(std::move(g), "WORK_STEALING");
+  Rendezvous::Args args;
+  // Run several steps so that workers of one step may still be winding down
+  // when the next one starts.
+  for (int i = 0; i < 4; ++i) {
+    TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args,
+                               V(1.0), false));
+    TF_ASSERT_OK(Run(rendez_));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out,
+                               &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+  }
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -324,6 +349,74 @@ TEST_F(ExecutorTest, SimpleSwitchDead) {
   EXPECT_TRUE(is_dead);
 }
 
+// Adds a while loop to "g" that increments a float counter from 0 until it
+// reaches "num_iterations", and returns the loop's Exit node.
+static Node* CountingWhileLoop(Graph* g, int num_iterations) {
+  Node* init = test::graph::Constant(g, V(0));
+  Node* enter = test::graph::Enter(g, init, "counting_loop");
+  Node* merge = test::graph::Merge(g, enter, {"counting_loop/next"});
+
+  // Constants used in the loop need a control edge to be part of its frame.
+  Node* limit = test::graph::Constant(g, V(num_iterations));
+  g->AddControlEdge(merge, limit);
+  Node* cond = test::graph::LoopCond(g, test::graph::Less(g, merge, limit));
+  Node* switch_node = test::graph::Switch(g, merge, cond);
+
+  Node* body = test::graph::Identity(g, switch_node, 1);
+  Node* one = test::graph::Constant(g, V(1));
+  g->AddControlEdge(body, one);
+  Node* next = test::graph::Next(g, "counting_loop/next",
+                                 test::graph::Add(g, body, one));
+  g->AddEdge(next, 0, merge, 1);
+
+  return test::graph::Exit(g, switch_node);
+}
+
+TEST_F(ExecutorTest, WhileLoopReusesFrameState) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  Node* exit = CountingWhileLoop(g.get(), 100);
+  test::graph::Send(g.get(), exit, "c", BOB, 1, ALICE);
+  Create(std::move(g));
+
+  // The root frame's single iteration, plus iterations 0 to 100 of the loop
+  const int64 kIterationsPerStep = 102;
+
+  Rendezvous::Args args;
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out, &is_dead));
+  EXPECT_EQ(100.0, V(out));
+
+  // Completed iterations are recycled within the step, so only as many as can
+  // be live at once (the loop runs up to 10 in parallel) are allocated.
+  const int64 frames_allocated =
+      step_stats_collector_.GetCounter(kExecutorFramesAllocatedCounter);
+  const int64 iterations_allocated =
+      step_stats_collector_.GetCounter(kExecutorIterationsAllocatedCounter);
+  EXPECT_EQ(2, frames_allocated);
+  EXPECT_LE(iterations_allocated, 12);
+  EXPECT_EQ(kIterationsPerStep,
+            iterations_allocated + step_stats_collector_.GetCounter(
+                                       kExecutorIterationsReusedCounter));
+
+  // A second step reuses everything from the first.
+  TF_ASSERT_OK(Run(rendez_));
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out, &is_dead));
+  EXPECT_EQ(100.0, V(out));
+  EXPECT_EQ(frames_allocated,
+            step_stats_collector_.GetCounter(kExecutorFramesAllocatedCounter));
+  EXPECT_EQ(2,
+            step_stats_collector_.GetCounter(kExecutorFramesReusedCounter));
+  EXPECT_EQ(iterations_allocated, step_stats_collector_.GetCounter(
+                                      kExecutorIterationsAllocatedCounter));
+  EXPECT_EQ(2 * kIterationsPerStep,
+            iterations_allocated + step_stats_collector_.GetCounter(
+                                       kExecutorIterationsReusedCounter));
+}
+
 TEST_F(ExecutorTest, Abort) {
   // e = a + b + c + d
   std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
@@ -419,8 +512,10 @@ TEST_F(ExecutorTest, RecvInvalidRefDtype) {
 
 // Create a graph that is 'depth' deep. At each level, fan-in and fan-out a
 // maximum of 'width' nodes. All nodes are no-ops and all dependencies are
-// control dependencies.
-static void BM_executor(int iters, int width, int depth) {
+// control dependencies. The graph is run on the executor registered as
+// 'executor_type'.
+static void RunExecutorBenchmark(int iters, int width, int depth,
+                                 const char* executor_type) {
 #ifdef PLATFORM_GOOGLE
   BenchmarkUseRealTime();
 #endif  // PLATFORM_GOOGLE
@@ -454,19 +549,33 @@ static void BM_executor(int iters, int width, int depth) {
   SetBenchmarkLabel(strings::StrCat("Nodes = ", cur));
   SetBenchmarkItemsProcessed(cur * static_cast<int64>(iters));
 #endif  // PLATFORM_GOOGLE
-  test::Benchmark("cpu", g).Run(iters);
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr, executor_type)
+      .Run(iters);
+}
+
+static void BM_executor(int iters, int width, int depth) {
+  RunExecutorBenchmark(iters, width, depth, "");
+}
+
+static void BM_executor_work_stealing(int iters, int width, int depth) {
+  RunExecutorBenchmark(iters, width, depth, "WORK_STEALING");
 }
 
 // Tall skinny graphs
 BENCHMARK(BM_executor)->ArgPair(16, 1024);
 BENCHMARK(BM_executor)->ArgPair(32, 8192);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(16, 1024);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(32, 8192);
 
 // Short fat graphs
 BENCHMARK(BM_executor)->ArgPair(1024, 16);
 BENCHMARK(BM_executor)->ArgPair(8192, 32);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(1024, 16);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(8192, 32);
 
 // Tall fat graph
 BENCHMARK(BM_executor)->ArgPair(1024, 1024);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(1024, 1024);
 
 static void BM_FeedInputFetchOutput(int iters) {
   Graph* g = new Graph(OpRegistry::Global());
@@ -486,4 +595,16 @@ static void BM_FeedInputFetchOutput(int iters) {
 }
 BENCHMARK(BM_FeedInputFetchOutput);
 
+// Runs a while loop of "depth" iterations with a trivial body, so the cost is
+// dominated by creating and cleaning up the executor's per-iteration state.
+static void BM_WhileLoop(int iters, int depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  CountingWhileLoop(g, depth);
+#ifdef PLATFORM_GOOGLE
+  SetBenchmarkItemsProcessed(static_cast<int64>(iters) * depth);
+#endif  // PLATFORM_GOOGLE
+  test::Benchmark("cpu", g).Run(iters);
+}
+BENCHMARK(BM_WhileLoop)->Arg(100)->Arg(1000)->Arg(10000);
+
 }  // namespace tensorflow
@@ -0,0 +1,565 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_schedule_executor.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/allocation_trace.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/framework/cancellation.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace {
+
+typedef gtl::InlinedVector<TensorValue, 4> TensorValueVec;
+typedef gtl::InlinedVector<DeviceContext*, 4> DeviceContextVec;
+typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
+
+// Returns an Unimplemented error naming the first node of `graph` that the
+// static schedule can't express, if any.
+Status CheckStaticallySchedulable(const Graph& graph) {
+  for (const Node* n : graph.op_nodes()) {
+    if (n->IsControlFlow()) {
+      return errors::Unimplemented(
+          "Static schedule executor does not support control flow. But saw "
+          "control flow node ",
+          n->name());
+    }
+    if (n->IsSend() || n->IsHostSend() || n->IsRecv() || n->IsHostRecv()) {
+      return errors::Unimplemented(
+          "Static schedule executor does not support partitioned graphs. But "
+          "saw send/recv node ",
+          n->name());
+    }
+    if (n->IsCollective()) {
+      return errors::Unimplemented(
+          "Static schedule executor does not support collective ops. But saw "
+          "collective node ",
+          n->name());
+    }
+    for (DataType dt : n->output_types()) {
+      if (IsRefType(dt)) {
+        return errors::Unimplemented(
+            "Static schedule executor does not support reference-typed "
+            "edges. But saw type ",
+            DataTypeString(dt), " in outputs of node ", n->name());
+      }
+    }
+  }
+  return Status::OK();
+}
+
+class StaticScheduleExecutorImpl : public Executor {
+ public:
+  StaticScheduleExecutorImpl(const LocalExecutorParams& params,
+                             std::unique_ptr<const Graph> graph, int max_lanes)
+      : params_(params), graph_(std::move(graph)), max_lanes_(max_lanes) {}
+
+  ~StaticScheduleExecutorImpl() override {
+    for (const KernelState& kernel_state : kernels_) {
+      if (kernel_state.kernel != nullptr) {
+        params_.delete_kernel(kernel_state.kernel);
+      }
+    }
+    for (DeviceContext* device_context : device_context_map_) {
+      if (device_context != nullptr) device_context->Unref();
+    }
+  }
+
+  // Returns an Unimplemented error if the graph must be run by the default
+  // executor instead.
+  Status Initialize() {
+    const Graph& graph = *graph_;
+    TF_RETURN_IF_ERROR(CheckStaticallySchedulable(graph));
+    TF_RETURN_IF_ERROR(
+        params_.device->FillContextMap(&graph, &device_context_map_));
+
+    std::vector<Node*> ordered_nodes;
+    GetReversePostOrder(graph, &ordered_nodes);
+    ordered_nodes.erase(
+        std::remove_if(ordered_nodes.begin(), ordered_nodes.end(),
+                       [](const Node* n) { return !n->IsOp(); }),
+        ordered_nodes.end());
+    if (static_cast<int>(ordered_nodes.size()) != graph.num_op_nodes()) {
+      return errors::InvalidArgument("Graph had ", graph.num_op_nodes(),
+                                     " op nodes but reverse post-order had ",
+                                     ordered_nodes.size());
+    }
+
+    // Assign each node to the wave after the latest of its inputs. The
+    // reverse post-order visits every node after all of its inputs.
+    std::vector<int> kernel_index(graph.num_node_ids(), -1);
+    std::vector<int> wave_of(ordered_nodes.size(), 0);
+    int num_waves = 0;
+    for (size_t i = 0; i < ordered_nodes.size(); ++i) {
+      const Node* n = ordered_nodes[i];
+      kernel_index[n->id()] = i;
+      for (const Edge* e : n->in_edges()) {
+        const int src = kernel_index[e->src()->id()];
+        if (src >= 0) wave_of[i] = std::max(wave_of[i], wave_of[src] + 1);
+      }
+      num_waves = std::max(num_waves, wave_of[i] + 1);
+    }
+
+    // Create the kernels, and find the last wave to consume each output.
+    kernels_.resize(ordered_nodes.size());
+    std::vector<std::vector<int>> last_use(ordered_nodes.size());
+    std::vector<std::vector<int>> num_consumers(ordered_nodes.size());
+    for (size_t i = 0; i < ordered_nodes.size(); ++i) {
+      const Node* n = ordered_nodes[i];
+      KernelState& kernel_state = kernels_[i];
+      TF_RETURN_IF_ERROR(params_.create_kernel(n->def(), &kernel_state.kernel));
+      if (kernel_state.kernel->AsAsync() != nullptr) {
+        return errors::Unimplemented(
+            "Static schedule executor does not support asynchronous kernels. "
+            "But saw asynchronous node ",
+            n->name());
+      }
+      kernel_state.node = n;
+      kernel_state.name = n->name();
+      kernel_state.device_context = ContextFor(n);
+      kernel_state.inputs.resize(n->num_inputs());
+      kernel_state.output_slots.assign(n->num_outputs(), -1);
+
+      last_use[i].assign(n->num_outputs(), -1);
+      num_consumers[i].assign(n->num_outputs(), 0);
+      for (const Edge* e : n->out_edges()) {
+        if (e->IsControlEdge() || !e->dst()->IsOp()) continue;
+        const int dst = kernel_index[e->dst()->id()];
+        int& use = last_use[i][e->src_output()];
+        use = std::max(use, wave_of[dst]);
+        ++num_consumers[i][e->src_output()];
+      }
+
+      // Compute allocator attributes for each node output, and corresponding
+      // node input.
+      kernel_state.output_alloc_attrs.resize(n->num_outputs());
+      OpKernel* op_kernel = kernel_state.kernel;
+      for (int out = 0; out < n->num_outputs(); out++) {
+        DCHECK_LT(out, op_kernel->output_memory_types().size());
+        if (op_kernel->output_memory_types()[out] == HOST_MEMORY) {
+          AllocatorAttributes h;
+          h.set_on_host(true);
+          kernel_state.output_alloc_attrs[out].Merge(h);
+        }
+      }
+    }
+
+    // Split each wave into lanes. Inexpensive kernels stay on the calling
+    // thread's lane, and expensive ones are dealt out across up to
+    // `max_lanes_` lanes, unless there's only one.
+    const int max_lanes =
+        max_lanes_ > 0 ? max_lanes_ : std::max(1, port::MaxParallelism());
+    waves_.resize(num_waves);
+    std::vector<std::vector<int>> wave_kernels(num_waves);
+    for (size_t i = 0; i < ordered_nodes.size(); ++i) {
+      wave_kernels[wave_of[i]].push_back(i);
+    }
+    for (int w = 0; w < num_waves; ++w) {
+      int num_expensive = 0;
+      for (int k : wave_kernels[w]) {
+        if (kernels_[k].kernel->IsExpensive()) ++num_expensive;
+      }
+      const int num_lanes = std::max(1, std::min(num_expensive, max_lanes));
+      std::vector<std::vector<int>>& lanes = waves_[w].lanes;
+      lanes.resize(num_lanes);
+      int next_lane = 0;
+      for (int k : wave_kernels[w]) {
+        if (num_lanes > 1 && kernels_[k].kernel->IsExpensive()) {
+          lanes[next_lane].push_back(k);
+          next_lane = (next_lane + 1) % num_lanes;
+        } else {
+          lanes[0].push_back(k);
+        }
+      }
+      max_wave_lanes_ = std::max(max_wave_lanes_, num_lanes);
+    }
+
+    // Plan the slots that hold node outputs. A slot is free again after the
+    // wave that last consumes its value, and since a value is always consumed
+    // in a later wave than it's produced, slots of values produced in the same
+    // wave never collide.
+    std::vector<int> free_slots;
+    std::vector<std::vector<int>> freed_after(num_waves);
+    for (int w = 0; w < num_waves; ++w) {
+      for (int k : wave_kernels[w]) {
+        KernelState& kernel_state = kernels_[k];
+        for (size_t out = 0; out < kernel_state.output_slots.size(); ++out) {
+          if (num_consumers[k][out] == 0) continue;
+          int slot;
+          if (free_slots.empty()) {
+            slot = num_slots_++;
+          } else {
+            slot = free_slots.back();
+            free_slots.pop_back();
+          }
+          kernel_state.output_slots[out] = slot;
+          freed_after[last_use[k][out]].push_back(slot);
+          // A value with a single consumer is released by that consumer as
+          // soon as it has run. Shared values live until the end of the wave.
+          if (num_consumers[k][out] > 1) {
+            waves_[last_use[k][out]].released_slots.push_back(slot);
+          }
+        }
+      }
+      free_slots.insert(free_slots.end(), freed_after[w].begin(),
+                        freed_after[w].end());
+    }
+
+    // Wire each input to the slot of the output that feeds it.
+    for (size_t i = 0; i < ordered_nodes.size(); ++i) {
+      const Node* n = ordered_nodes[i];
+      for (const Edge* e : n->in_edges()) {
+        if (e->IsControlEdge()) continue;
+        const int src = kernel_index[e->src()->id()];
+        const KernelState& src_state = kernels_[src];
+        InputState& input = kernels_[i].inputs[e->dst_input()];
+        input.slot = src_state.output_slots[e->src_output()];
+        input.is_sole_consumer = num_consumers[src][e->src_output()] == 1;
+        input.alloc_attrs = src_state.output_alloc_attrs[e->src_output()];
+        input.device_context = src_state.device_context;
+      }
+    }
+
+    VLOG(1) << "Static schedule for " << ordered_nodes.size() << " nodes: "
+            << num_waves << " waves, up to " << max_wave_lanes_
+            << " lanes and " << num_slots_ << " slots";
+    return Status::OK();
+  }
+
+  // Gives up the graph, to run it with the default executor instead.
+  std::unique_ptr<const Graph> ReleaseGraph() { return std::move(graph_); }
+
+  void RunAsync(const Args& args, DoneCallback done) override {
+    // The outputs of each node are stored in `slots`, at the indices planned
+    // in Initialize(). Every slot is empty again once the step finishes.
+    std::vector<Tensor> slots(num_slots_);
+
+    Args::Runner runner_copy = args.runner;
+    std::vector<LaneState> lanes(max_wave_lanes_);
+    for (LaneState& lane : lanes) {
+      PrepareParams(args, &runner_copy, &lane);
+    }
+
+    Status status;
+    for (const Wave& wave : waves_) {
+      // Kernels aren't interrupted, but a cancelled step stops at the next
+      // wave.
+      if (args.cancellation_manager != nullptr &&
+          args.cancellation_manager->IsCancelled()) {
+        status = errors::Cancelled("Step was cancelled");
+        break;
+      }
+      const int num_lanes = wave.lanes.size();
+      if (num_lanes == 1) {
+        RunLane(wave.lanes[0], &slots, &lanes[0]);
+      } else {
+        RunLanes(wave, &runner_copy, &slots, &lanes);
+      }
+      for (int l = 0; l < num_lanes; ++l) {
+        status.Update(lanes[l].status);
+      }
+      if (!status.ok()) break;
+      for (int slot : wave.released_slots) {
+        slots[slot] = Tensor();
+      }
+    }
+
+    if (status.ok() && args.sync_on_finish) {
+      status = params_.device->Sync();
+    }
+    // On failure, `slots` still holds the outputs of the nodes that ran, and
+    // they are freed along with it.
+    slots.clear();
+    done(status);
+  }
+
+ private:
+  struct InputState {
+    // The slot holding the value of this input.
+    int slot = -1;
+    // Whether this is the only input to consume the value.
+    bool is_sole_consumer = false;
+    AllocatorAttributes alloc_attrs;
+    // The device context of the node producing the value. Not owned.
+    DeviceContext* device_context = nullptr;
+  };
+
+  // Represents cached graph structure state for each kernel.
+  struct KernelState {
+    // The kernel object. Not owned.
+    //
+    // This pointer is managed by `params_.create_kernel()` and
+    // `params_.delete_kernel()`.
+    OpKernel* kernel = nullptr;
+    const Node* node = nullptr;  // Owned by `graph_`.
+    string name;
+    DeviceContext* device_context = nullptr;  // Not owned.
+    std::vector<InputState> inputs;
+    // The slot each output is stored to, or -1 if nothing consumes it.
+    std::vector<int> output_slots;
+    // Memory space information for each output of `kernel`.
+    std::vector<AllocatorAttributes> output_alloc_attrs;
+  };
+
+  struct Wave {
+    // Indices into `kernels_`. Each lane runs its kernels in order, and the
+    // first lane runs on the calling thread.
+    std::vector<std::vector<int>> lanes;
+    // Slots of values with several consumers, the last of which are in this
+    // wave, to release once it's done.
+    std::vector<int> released_slots;
+  };
+
+  // Per-lane state for a step. Lanes never share these, so no kernel
+  // invocation has to synchronize with another.
+  struct LaneState {
+    OpKernelContext::Params params;
+    TensorValueVec inputs;
+    DeviceContextVec input_device_contexts;
+    AllocatorAttributeVec input_alloc_attrs;
+    // Extra references to inputs that other kernels also consume, so that
+    // the kernel can't forward (and overwrite) their buffers.
+    gtl::InlinedVector<Tensor, 4> shared_inputs;
+    Status status;
+  };
+
+  // Synchronizes the lanes of one wave. Shared with the closures that run
+  // lanes on the runner, since they may only start after the wave is over.
+  struct WaveSync {
+    explicit WaveSync(int num_lanes) : done(num_lanes) {}
+
+    std::atomic<int> next_lane{0};
+    BlockingCounter done;
+  };
+
+  void PrepareParams(const Args& args, Args::Runner* runner,
+                     LaneState* lane) {
+    OpKernelContext::Params& params = lane->params;
+    params.step_id = args.step_id;
+    Device* device = params_.device;
+    params.device = device;
+    params.log_memory = false;
+    params.record_tensor_accesses = false;
+    params.rendezvous = args.rendezvous;
+    params.create_rendezvous = &(params_.rendezvous_factory);
+    params.session_state = args.session_state;
+    params.tensor_store = args.tensor_store;
+    params.cancellation_manager = args.cancellation_manager;
+    params.call_frame = args.call_frame;
+    params.function_library = params_.function_library;
+    params.resource_manager = device->resource_manager();
+    params.step_container = args.step_container;
+    params.slice_reader_cache = nullptr;
+    params.inputs = &lane->inputs;
+    params.input_device_contexts = &lane->input_device_contexts;
+    params.input_alloc_attrs = &lane->input_alloc_attrs;
+    params.runner = runner;
+    params.stats_collector = args.stats_collector;
+    // The graph has no loops or conditionals.
+    params.frame_iter = FrameAndIter(0, 0);
+    params.is_input_dead = false;
+    params.forward_from_array = nullptr;
+  }
+
+  // Runs the lanes of a multi-lane wave. The calling thread and closures on
+  // the runner each take lanes until none are left, so the wave still
+  // completes if the runner's threads are all busy.
+  void RunLanes(const Wave& wave, Args::Runner* runner,
+                std::vector<Tensor>* slots, std::vector<LaneState>* lanes) {
+    const int num_lanes = wave.lanes.size();
+    auto sync = std::make_shared<WaveSync>(num_lanes);
+    auto take_lanes = [this, &wave, slots, lanes, num_lanes](WaveSync* sync) {
+      int l;
+      while ((l = sync->next_lane.fetch_add(1)) < num_lanes) {
+        RunLane(wave.lanes[l], slots, &(*lanes)[l]);
+        sync->done.DecrementCount();
+      }
+    };
+    for (int l = 1; l < num_lanes; ++l) {
+      // Only dereferences the wave's state after taking a lane, while the
+      // calling thread is still waiting for it.
+      (*runner)([sync, take_lanes]() { take_lanes(sync.get()); });
+    }
+    take_lanes(sync.get());
+    sync->done.Wait();
+  }
+
+  // Runs the kernels of one lane in order, stopping at the first failure.
+  void RunLane(const std::vector<int>& lane_kernels,
+               std::vector<Tensor>* slots, LaneState* lane) {
+    ScopedAllocationTraceStep trace_step(lane->params.step_id);
+    lane->status = Status::OK();
+    for (int k : lane_kernels) {
+      lane->status = RunKernel(kernels_[k], slots, lane);
+      if (!lane->status.ok()) return;
+    }
+  }
+
+  Status RunKernel(const KernelState& kernel_state, std::vector<Tensor>* slots,
+                   LaneState* lane) {
+    const size_t num_inputs = kernel_state.inputs.size();
+    const size_t num_outputs = kernel_state.output_slots.size();
+
+    lane->inputs.clear();
+    lane->inputs.resize(num_inputs);
+    lane->input_device_contexts.clear();
+    lane->input_device_contexts.resize(num_inputs);
+    lane->input_alloc_attrs.clear();
+    lane->input_alloc_attrs.resize(num_inputs);
+    lane->shared_inputs.clear();
+    for (size_t j = 0; j < num_inputs; ++j) {
+      const InputState& input = kernel_state.inputs[j];
+      Tensor* t = &(*slots)[input.slot];
+      if (!input.is_sole_consumer) lane->shared_inputs.push_back(*t);
+      lane->inputs[j].tensor = t;
+      lane->input_device_contexts[j] = input.device_context;
+      lane->input_alloc_attrs[j] = input.alloc_attrs;
+    }
+
+    OpKernelContext::Params& params = lane->params;
+    params.op_kernel = kernel_state.kernel;
+    params.op_device_context = kernel_state.device_context;
+    params.output_attr_array = kernel_state.output_alloc_attrs.data();
+
+    NodeExecStatsInterface* stats = nullptr;
+    if (params.stats_collector != nullptr) {
+      stats = params.stats_collector->CreateNodeExecStats(kernel_state.node);
+    }
+    params.track_allocations = stats != nullptr && stats->TrackAllocations();
+    if (stats != nullptr) {
+      stats->SetScheduled(Env::Default()->NowNanos());
+      stats->RecordExecutorStarted();
+    }
+
+    OpKernelContext ctx(&params, num_outputs);
+    if (stats != nullptr) stats->RecordComputeStarted();
+    params_.device->Compute(kernel_state.kernel, &ctx);
+    if (stats != nullptr) stats->RecordComputeEnded();
+
+    Status s = ctx.status();
+    if (s.ok()) s = ProcessOutputs(kernel_state, &ctx, slots, lane, stats);
+
+    if (stats != nullptr) {
+      stats->SetMemory(&ctx);
+      stats->RecordExecutorEnded();
+      stats->Done(params_.device->name());
+    }
+    return s;
+  }
+
+  // Releases the inputs that only this kernel consumes, and stores the
+  // outputs of `ctx` to their slots.
+  Status ProcessOutputs(const KernelState& kernel_state, OpKernelContext* ctx,
+                        std::vector<Tensor>* slots, LaneState* lane,
+                        NodeExecStatsInterface* stats) {
+    for (const InputState& input : kernel_state.inputs) {
+      if (input.is_sole_consumer) (*slots)[input.slot] = Tensor();
+    }
+    lane->shared_inputs.clear();
+
+    for (size_t j = 0; j < kernel_state.output_slots.size(); ++j) {
+      TensorValue val = ctx->release_output(j);
+      const int slot = kernel_state.output_slots[j];
+      if (val.tensor == nullptr) {
+        if (slot < 0) continue;
+        return errors::Internal("Missing ", j, "-th output from ",
+                                kernel_state.name);
+      }
+      if (stats != nullptr && val.tensor->IsInitialized()) {
+        stats->SetOutput(j, val.tensor);
+      }
+      if (slot >= 0) (*slots)[slot] = std::move(*val.tensor);
+      delete val.tensor;
+    }
+    return Status::OK();
+  }
+
+  DeviceContext* ContextFor(const Node* n) const {
+    if (n->id() < static_cast<int>(device_context_map_.size())) {
+      return device_context_map_[n->id()];
+    }
+    return nullptr;
+  }
+
+  const LocalExecutorParams params_;
+  std::unique_ptr<const Graph> graph_;
+  const int max_lanes_;
+
+  // All following members are read-only after Initialize().
+
+  std::vector<KernelState> kernels_;
+
+  std::vector<Wave> waves_;
+
+  int num_slots_ = 0;
+  int max_wave_lanes_ = 1;
+
+  // Indexed by node id. Holds a reference on each non-null context.
+  DeviceContextMap device_context_map_;
+};
+
+class StaticScheduleExecutorRegistrar {
+ public:
+  StaticScheduleExecutorRegistrar() {
+    ExecutorFactory::Register("STATIC_SCHEDULE", new Factory());
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params,
+                       std::unique_ptr<const Graph> graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      Executor* ret;
+      TF_RETURN_IF_ERROR(NewStaticScheduleExecutor(params, std::move(graph),
+                                                   /*max_lanes=*/0, &ret));
+      out_executor->reset(ret);
+      return Status::OK();
+    }
+  };
+};
+static StaticScheduleExecutorRegistrar registrar;
+
+}  // namespace
+
+Status NewStaticScheduleExecutor(const LocalExecutorParams& params,
+                                 std::unique_ptr<const Graph> graph,
+                                 int max_lanes, Executor** executor) {
+  std::unique_ptr<StaticScheduleExecutorImpl> impl =
+      absl::make_unique<StaticScheduleExecutorImpl>(params, std::move(graph),
+                                                    max_lanes);
+  const Status s = impl->Initialize();
+  if (errors::IsUnimplemented(s)) {
+    VLOG(1) << "Falling back to the default executor: " << s;
+    std::unique_ptr<const Graph> released_graph = impl->ReleaseGraph();
+    impl.reset();
+    return NewLocalExecutor(params, std::move(released_graph), executor);
+  }
+  TF_RETURN_IF_ERROR(s);
+  *executor = impl.release();
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,57 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_SCHEDULE_EXECUTOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_SCHEDULE_EXECUTOR_H_
+
+#include "tensorflow/core/common_runtime/executor.h"
+
+namespace tensorflow {
+
+// Creates a new `Executor` that runs `graph` according to a schedule computed
+// once, when the executor is created, instead of tracking pending counts and
+// propagating outputs dynamically on every step.
+//
+// The schedule splits the graph into waves, where each node depends only on
+// nodes in earlier waves. The kernels of a wave are divided between a fixed
+// set of lanes: the calling thread, and up to `max_lanes - 1` closures handed
+// to the step's runner. Lanes synchronize once per wave rather than once per
+// node. A `max_lanes` of 0 uses `port::MaxParallelism()` lanes.
+//
+// Node outputs are held in slots planned ahead of time: a slot is reused once
+// every consumer of its value has run. An output with a single consumer is
+// passed to it as the only reference to its buffer, so the kernel may forward
+// the buffer to one of its own outputs.
+//
+// Graphs that the schedule cannot express are run by the default executor
+// instead. These are graphs containing:
+//
+// 1. Control flow ("Switch", "Merge", "Enter", "Exit" or "NextIteration").
+// 2. Send and receive nodes, i.e. partitioned graphs.
+// 3. Reference-typed edges.
+// 4. Collective ops.
+// 5. Asynchronous kernels.
+//
+// Node stats are recorded when the step has a stats collector, and a cancelled
+// step fails with a Cancelled error before starting its next wave. Like the
+// single-threaded executor, this executor does not log memory or record tensor
+// accesses.
+Status NewStaticScheduleExecutor(const LocalExecutorParams& params,
+                                 std::unique_ptr<const Graph> graph,
+                                 int max_lanes, Executor** executor);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_SCHEDULE_EXECUTOR_H_
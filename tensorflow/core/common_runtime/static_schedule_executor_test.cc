@@ -0,0 +1,326 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_schedule_executor.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/framework/cancellation.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class StaticScheduleExecutorTest : public ::testing::Test {
+ protected:
+  StaticScheduleExecutorTest()
+      : device_(DeviceFactory::NewDevice("CPU", {},
+                                         "/job:localhost/replica:0/task:0")),
+        thread_pool_(new thread::ThreadPool(Env::Default(), "lanes", 4)) {}
+
+  ~StaticScheduleExecutorTest() override { delete exec_; }
+
+  // Resets exec_ with a new executor for `graph` that uses up to `max_lanes`
+  // lanes, run on a thread pool.
+  void Create(std::unique_ptr<const Graph> graph, int max_lanes) {
+    const int version = graph->versions().producer();
+    LocalExecutorParams params;
+    params.device = device_.get();
+    params.create_kernel = [this, version](const NodeDef& ndef,
+                                           OpKernel** kernel) {
+      return CreateNonCachedKernel(device_.get(), nullptr, ndef, version,
+                                   kernel);
+    };
+    params.delete_kernel = [](OpKernel* kernel) {
+      DeleteNonCachedKernel(kernel);
+    };
+    delete exec_;
+    exec_ = nullptr;
+    TF_CHECK_OK(NewStaticScheduleExecutor(params, std::move(graph), max_lanes,
+                                          &exec_));
+    runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
+  }
+
+  Status Run(CallFrameInterface* call_frame,
+             Executor::Args args = Executor::Args()) {
+    args.call_frame = call_frame;
+    args.runner = runner_;
+    return exec_->Run(args);
+  }
+
+  std::unique_ptr<Device> device_;
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+  Executor* exec_ = nullptr;
+  Executor::Args::Runner runner_;
+};
+
+// A float val -> Tensor<float>
+Tensor V(const float val) {
+  Tensor tensor(DT_FLOAT, TensorShape({}));
+  tensor.scalar<float>()() = val;
+  return tensor;
+}
+
+// A bool val -> Tensor<bool>
+Tensor VB(const bool val) {
+  Tensor tensor(DT_BOOL, TensorShape({}));
+  tensor.scalar<bool>()() = val;
+  return tensor;
+}
+
+// Tensor<float> -> a float val.
+float V(const Tensor& tensor) {
+  CHECK_EQ(tensor.dtype(), DT_FLOAT);
+  CHECK(TensorShapeUtils::IsScalar(tensor.shape()));
+  return tensor.scalar<float>()();
+}
+
+TEST_F(StaticScheduleExecutorTest, SimpleAdd) {
+  // c = a + b
+  std::unique_ptr<Graph> g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto in1 = test::graph::Arg(g.get(), 1, DT_FLOAT);
+  auto tmp = test::graph::Add(g.get(), in0, in1);
+  test::graph::Retval(g.get(), 0, tmp);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g), 1);
+  FunctionCallFrame call_frame({DT_FLOAT, DT_FLOAT}, {DT_FLOAT});
+  TF_ASSERT_OK(call_frame.SetArgs({V(1.0), V(2.0)}));
+  TF_ASSERT_OK(Run(&call_frame));
+  std::vector<Tensor> retvals;
+  TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+  EXPECT_EQ(3.0, V(retvals[0]));  // out = 1.0 + 2.0 = 3.0
+}
+
+TEST_F(StaticScheduleExecutorTest, SharedValueIsNotForwarded) {
+  // x = a + a is consumed by both y and z. If y overwrote x's buffer in
+  // place, z would see y's result instead of x.
+  std::unique_ptr<Graph> g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto a = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto x = test::graph::Add(g.get(), a, a);
+  auto y = test::graph::Add(g.get(), x, test::graph::Constant(g.get(), V(1)));
+  auto z = test::graph::Binary(g.get(), "Mul", x,
+                               test::graph::Constant(g.get(), V(2)));
+  test::graph::Retval(g.get(), 0, y);
+  test::graph::Retval(g.get(), 1, z);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g), 1);
+  FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT, DT_FLOAT});
+  TF_ASSERT_OK(call_frame.SetArgs({V(1.0)}));
+  TF_ASSERT_OK(Run(&call_frame));
+  std::vector<Tensor> retvals;
+  TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+  EXPECT_EQ(3.0, V(retvals[0]));  // y = (1.0 + 1.0) + 1.0
+  EXPECT_EQ(4.0, V(retvals[1]));  // z = (1.0 + 1.0) * 2.0
+}
+
+// Builds a graph which adds N copies of one variable "in". I.e.,
+//     a + a + a + ... + a
+// The returned graph is parenthesized randomly.
+void BuildTree(int N, Graph* g) {
+  CHECK_GT(N, 1);
+  // A single input node "in".
+  auto in = test::graph::Arg(g, 0, DT_FLOAT);
+  std::vector<Node*> nodes;
+  // Duplicate "in" N times.
+  for (int i = 0; i < N; ++i) {
+    nodes.push_back(test::graph::Identity(g, in, 0));
+  }
+  random::PhiloxRandom philox(0, 17);
+  random::SimplePhilox rnd(&philox);
+  while (nodes.size() > 1) {
+    // Randomly pick two from nodes and add them, putting the sum back.
+    int x = rnd.Uniform(nodes.size());
+    auto in0 = nodes[x];
+    nodes[x] = nodes.back();
+    nodes.resize(nodes.size() - 1);
+    x = rnd.Uniform(nodes.size());
+    auto in1 = nodes[x];
+    nodes[x] = test::graph::Add(g, in0, in1);
+  }
+  // The final output node "out".
+  test::graph::Retval(g, 0, nodes.back());
+  FixupSourceAndSinkEdges(g);
+}
+
+TEST_F(StaticScheduleExecutorTest, RandomTree) {
+  for (int max_lanes : {1, 4}) {
+    std::unique_ptr<Graph> g = absl::make_unique<Graph>(OpRegistry::Global());
+    BuildTree(4096, g.get());
+    Create(std::move(g), max_lanes);
+    // Run more than once, so that every slot is reused across steps.
+    for (int i = 0; i < 2; ++i) {
+      FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+      TF_ASSERT_OK(call_frame.SetArgs({V(1.0)}));
+      TF_ASSERT_OK(Run(&call_frame));
+      std::vector<Tensor> retvals;
+      TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+      EXPECT_EQ(4096.0, V(retvals[0])) << "max_lanes = " << max_lanes;
+    }
+  }
+}
+
+TEST_F(StaticScheduleExecutorTest, ControlFlowFallsBack) {
+  // out = pred ? -x : x, which the static schedule can't express.
+  std::unique_ptr<Graph> g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto x = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto pred = test::graph::Arg(g.get(), 1, DT_BOOL);
+  auto sw = test::graph::Switch(g.get(), x, pred);
+  auto if_false = test::graph::Identity(g.get(), sw, 0);
+  auto if_true = test::graph::Unary(g.get(), "Neg", sw, 1);
+  auto merge = test::graph::Merge(g.get(), if_false, if_true);
+  test::graph::Retval(g.get(), 0, merge);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g), 4);
+  FunctionCallFrame call_frame({DT_FLOAT, DT_BOOL}, {DT_FLOAT});
+  TF_ASSERT_OK(call_frame.SetArgs({V(3.0), VB(true)}));
+  TF_ASSERT_OK(Run(&call_frame));
+  std::vector<Tensor> retvals;
+  TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+  EXPECT_EQ(-3.0, V(retvals[0]));
+}
+
+TEST_F(StaticScheduleExecutorTest, OpError) {
+  std::unique_ptr<Graph> g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto zero = test::graph::Constant(g.get(), V(0.0));
+  auto inf = test::graph::Unary(g.get(), "Reciprocal", zero);
+  auto check = test::graph::CheckNumerics(g.get(), inf, "message");
+  auto two = test::graph::Constant(g.get(), V(2.0));
+  test::graph::Binary(g.get(), "Mul", check, two);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g), 4);
+  FunctionCallFrame call_frame({}, {});
+  EXPECT_TRUE(errors::IsInvalidArgument(Run(&call_frame)));
+}
+
+TEST_F(StaticScheduleExecutorTest, Cancelled) {
+  std::unique_ptr<Graph> g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto tmp = test::graph::Add(g.get(), in0, in0);
+  test::graph::Retval(g.get(), 0, tmp);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g), 1);
+  CancellationManager cancellation_manager;
+  cancellation_manager.StartCancel();
+  Executor::Args args;
+  args.cancellation_manager = &cancellation_manager;
+  FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+  TF_ASSERT_OK(call_frame.SetArgs({V(1.0)}));
+  EXPECT_TRUE(errors::IsCancelled(Run(&call_frame, args)));
+}
+
+TEST_F(StaticScheduleExecutorTest, RecordsNodeStats) {
+  std::unique_ptr<Graph> g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto in1 = test::graph::Arg(g.get(), 1, DT_FLOAT);
+  auto tmp = test::graph::Add(g.get(), in0, in1);
+  test::graph::Retval(g.get(), 0, tmp);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g), 1);
+  StepStats step_stats;
+  StepStatsCollector stats_collector(&step_stats);
+  Executor::Args args;
+  args.stats_collector = &stats_collector;
+  FunctionCallFrame call_frame({DT_FLOAT, DT_FLOAT}, {DT_FLOAT});
+  TF_ASSERT_OK(call_frame.SetArgs({V(1.0), V(2.0)}));
+  TF_ASSERT_OK(Run(&call_frame, args));
+  stats_collector.Finalize();
+
+  // One entry for each of the two args, the add and the retval.
+  ASSERT_EQ(1, step_stats.dev_stats_size());
+  const DeviceStepStats& dev_stats = step_stats.dev_stats(0);
+  EXPECT_EQ(device_->name(), dev_stats.device());
+  ASSERT_EQ(4, dev_stats.node_stats_size());
+  bool saw_add = false;
+  for (const NodeExecStats& node_stats : dev_stats.node_stats()) {
+    EXPECT_LE(node_stats.op_start_rel_micros(), node_stats.op_end_rel_micros());
+    if (node_stats.node_name() == tmp->name()) {
+      saw_add = true;
+      EXPECT_EQ(1, node_stats.output_size());
+    }
+  }
+  EXPECT_TRUE(saw_add);
+}
+
+static void BM_executor(int iters, int width, int depth) {
+#ifdef PLATFORM_GOOGLE
+  BenchmarkUseRealTime();
+#endif  // PLATFORM_GOOGLE
+  Graph* g = new Graph(OpRegistry::Global());
+  random::PhiloxRandom philox(1729, 17);
+  random::SimplePhilox rand(&philox);
+  uint64 cur = 0;
+  uint32 r = 1 + rand.Rand32() % width;
+  std::vector<Node*> ready_nodes;
+  for (int i = 0; i < r; ++i) {
+    ready_nodes.push_back(test::graph::NoOp(g, {}));
+    ++cur;
+  }
+  for (int i = 0; i < depth; ++i) {
+    std::random_shuffle(ready_nodes.begin(), ready_nodes.end());
+    r = 1 + rand.Rand32() % (ready_nodes.size());
+    std::vector<Node*> control_inputs;
+    for (int j = 0; j < r; ++j) {
+      control_inputs.push_back(ready_nodes.back());
+      ready_nodes.pop_back();
+    }
+    Node* n = test::graph::NoOp(g, control_inputs);
+    ++cur;
+    r = 1 + rand.Rand32() % width;
+    for (int j = 0; j < r; ++j) {
+      ready_nodes.push_back(test::graph::NoOp(g, {n}));
+      ++cur;
+    }
+  }
+  FixupSourceAndSinkEdges(g);
+#ifdef PLATFORM_GOOGLE
+  SetBenchmarkLabel(strings::StrCat("Nodes = ", cur));
+  SetBenchmarkItemsProcessed(cur * static_cast<int64>(iters));
+#endif  // PLATFORM_GOOGLE
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr, "STATIC_SCHEDULE")
+      .Run(iters);
+}
+
+// Tall skinny graphs
+BENCHMARK(BM_executor)->ArgPair(16, 1024);
+BENCHMARK(BM_executor)->ArgPair(32, 8192);
+
+// Short fat graphs
+BENCHMARK(BM_executor)->ArgPair(1024, 16);
+BENCHMARK(BM_executor)->ArgPair(8192, 32);
+
+// Tall fat graph
+BENCHMARK(BM_executor)->ArgPair(1024, 1024);
+
+}  // namespace
+}  // namespace tensorflow
@@ -513,6 +513,17 @@ string StepStatsCollector::ReportAllocsOnResourceExhausted(const string& err) {
   return report;
 }
 
+void StepStatsCollector::IncrementCounter(const string& name, int64 delta) {
+  mutex_lock l(mu_);
+  counters_[name] += delta;
+}
+
+int64 StepStatsCollector::GetCounter(const string& name) {
+  mutex_lock l(mu_);
+  auto it = counters_.find(name);
+  return it == counters_.end() ? 0 : it->second;
+}
+
 void StepStatsCollector::Finalize() {
   mutex_lock l(mu_);
   FinalizeInternal();
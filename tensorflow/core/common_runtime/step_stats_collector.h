@@ -153,6 +153,11 @@ class StepStatsCollectorInterface {
   // "ResourceExhaustedError: OOM when allocating tensor ...
   // on /job:localhost/replica:0/task:0/device:GPU:0 by allocator GPU_0_bfc"
   virtual string ReportAllocsOnResourceExhausted(const string& err) = 0;
+
+  // Adds `delta` to the named counter for this step. Counters report internal
+  // bookkeeping, such as how often the executor reused frame state. The
+  // default implementation discards them.
+  virtual void IncrementCounter(const string& name, int64 delta) {}
 };
 
 // StepStatsCollector manages the collection of a StepStats object.
@@ -181,6 +186,11 @@ class StepStatsCollector : public StepStatsCollectorInterface {
 
   NodeExecStatsInterface* CreateNodeExecStats(const Node* node) override;
   string ReportAllocsOnResourceExhausted(const string& err) override;
+  void IncrementCounter(const string& name, int64 delta) override;
+
+  // Returns the current value of the named counter, or 0 if it was never
+  // incremented.
+  int64 GetCounter(const string& name);
 
   // The following 2 Finalize methods populate the StepStats passed
   // from the constructor. Calling it more than once won't have any effect.
@@ -205,6 +215,7 @@ class StepStatsCollector : public StepStatsCollectorInterface {
   std::unordered_map<string, ThreadNamesMap> thread_names_ GUARDED_BY(mu_);
   StepStats* step_stats_ GUARDED_BY(mu_);
   uint64 collected_nodes_ GUARDED_BY(mu_) = 0;
+  std::unordered_map<string, int64> counters_ GUARDED_BY(mu_);
 };
 
 }  // namespace tensorflow
@@ -207,6 +207,20 @@ REGISTER_OPTIONAL_COPY(VariantDeviceCopyDirection::DEVICE_TO_DEVICE);
 REGISTER_UNARY_VARIANT_DECODE_FUNCTION(WrappedDatasetVariantWrapper,
                                        kWrappedDatasetVariantTypeName);
 
+// Adds the profile of `node` to the arguments of the TraceMe event `name`,
+// which uses the "name#arg_1=value_1,...,arg_n=value_n#" format.
+string AddProfileToTraceMeName(string name, const model::Node& node) {
+  string args = strings::StrCat("id=", node.id(), ",buffered_elements=",
+                                node.buffered_elements());
+  if (!name.empty() && name.back() == '#') {
+    name.back() = ',';
+    strings::StrAppend(&name, args, "#");
+  } else {
+    strings::StrAppend(&name, "#", args, "#");
+  }
+  return name;
+}
+
 }  // namespace
 
 Status GraphDefBuilderWrapper::AddDataset(
@@ -405,12 +419,23 @@ Status DatasetBase::DatasetGraphDefBuilder::AddInputDataset(
 Status DatasetBaseIterator::GetNext(IteratorContext* ctx,
                                     std::vector<Tensor>* out_tensors,
                                     bool* end_of_sequence) {
-  profiler::TraceMe activity([&] { return BuildTraceMeName(); },
-                             profiler::TraceMeLevel::kInfo);
+  const bool profile = collect_profile(ctx);
+  profiler::TraceMe activity(
+      [&] {
+        return profile ? AddProfileToTraceMeName(BuildTraceMeName(), *node_)
+                       : BuildTraceMeName();
+      },
+      profiler::TraceMeLevel::kInfo);
+  const int64 start_nanos = profile ? Env::Default()->NowNanos() : 0;
   RecordStart(ctx, /*stop_output=*/true);
   Status s = GetNextInternal(ctx, out_tensors, end_of_sequence);
   if (s.ok() && !*end_of_sequence) RecordElement(ctx);
   RecordStop(ctx, /*start_output=*/true);
+  if (profile) {
+    node_->record_get_next(
+        Env::Default()->NowNanos() - start_nanos,
+        s.ok() && !*end_of_sequence ? GetAllocatedBytes(*out_tensors) : 0);
+  }
   if (TF_PREDICT_FALSE(errors::IsOutOfRange(s))) {
     s = errors::Internal("Iterator \"", params_.prefix,
                          "\" returned `OutOfRange`. This indicates an "
@@ -877,6 +877,16 @@ class DatasetBaseIterator : public IteratorBase {
     }
   }
 
+  // When modeling is enabled, this method records the fact that this iterator
+  // holds `num_elements` elements taking `num_bytes` bytes in an internal
+  // buffer, without having to materialize them.
+  void RecordBufferEnqueue(IteratorContext* ctx, int64 num_bytes,
+                           int64 num_elements) {
+    if (collect_resource_usage(ctx)) {
+      node_->record_buffer_event(num_bytes, num_elements);
+    }
+  }
+
   // When modeling is enabled, this method records the fact that this iterator
   // has produced an element.
   void RecordElement(IteratorContext* ctx) {
@@ -915,6 +925,11 @@ class DatasetBaseIterator : public IteratorBase {
     return model && model->collect_resource_usage() && node_;
   }
 
+  inline bool collect_profile(IteratorContext* ctx) {
+    const auto& model = ctx->model();
+    return model && model->profile() && node_;
+  }
+
   BaseParams params_;
 };
 
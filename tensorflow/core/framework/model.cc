@@ -15,10 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/framework/model.h"
 
+#include <limits>
 #include <memory>
 
 #include "absl/time/clock.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
 
 namespace tensorflow {
 namespace data {
@@ -626,8 +629,45 @@ class Unknown : public Node {
   }
 };
 
+// Returns the given duration in nanoseconds as a human-readable string.
+string HumanReadableNanos(double nanos) {
+  return strings::HumanReadableElapsedTime(
+      nanos / static_cast<double>(EnvTime::kSecondsToNanos));
+}
+
 }  // namespace
 
+string Node::ProfileString() const {
+  tf_shared_lock l(mu_);
+  string result = strings::StrCat(long_name(), ": elements=", num_elements_);
+  if (num_elements_ == 0) {
+    return result;
+  }
+  const double num_elements = static_cast<double>(num_elements_);
+  strings::StrAppend(
+      &result,
+      ", wall_time/element=", HumanReadableNanos(wall_time_ / num_elements),
+      ", input_time/element=", HumanReadableNanos(input_time_ / num_elements),
+      ", processing_time/element=",
+      HumanReadableNanos(processing_time_ / num_elements),
+      ", bytes/element=",
+      strings::HumanReadableNumBytes(bytes_produced_ / num_elements_),
+      ", buffered_elements={mean=", buffered_elements_histogram_.Average(),
+      ", median=", buffered_elements_histogram_.Median(),
+      ", max=", buffered_elements_histogram_.Percentile(100), "}");
+  return result;
+}
+
+/* static */ std::vector<double> Node::BufferedElementsBucketLimits() {
+  // Buckets double in size, so that small buffers are tracked precisely.
+  std::vector<double> limits;
+  for (double limit = 1; limit <= (1 << 20); limit *= 2) {
+    limits.push_back(limit);
+  }
+  limits.push_back(std::numeric_limits<double>::max());
+  return limits;
+}
+
 std::shared_ptr<Parameter> MakeParameter(const string& name,
                                          std::shared_ptr<SharedState> state,
                                          double min, double max) {
@@ -720,6 +760,9 @@ void Model::Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget,
     case AutotuneAlgorithm::GRADIENT_DESCENT:
       OptimizeGradientDescent(cpu_budget, ram_budget);
       break;
+    case AutotuneAlgorithm::COST_MODEL:
+      OptimizeCostModel(cpu_budget, ram_budget);
+      break;
   }
 }
 
@@ -777,6 +820,49 @@ void Model::RemoveNode(const string& name) {
   lookup_table_.erase(name);
 }
 
+string Model::ProfileReport() {
+  std::shared_ptr<Node> root;
+  {
+    tf_shared_lock l(mu_);
+    root = output_;
+  }
+  if (!root) {
+    return "";
+  }
+  // Visit the nodes in depth-first order, recording the depth of each node.
+  std::vector<std::pair<std::shared_ptr<Node>, int>> nodes;
+  std::vector<std::pair<std::shared_ptr<Node>, int>> stack = {{root, 0}};
+  while (!stack.empty()) {
+    auto node = stack.back();
+    stack.pop_back();
+    nodes.push_back(node);
+    auto inputs = node.first->inputs();
+    for (auto it = inputs.rbegin(); it != inputs.rend(); ++it) {
+      stack.emplace_back(*it, node.second + 1);
+    }
+  }
+  std::vector<int64> exclusive_times;
+  exclusive_times.reserve(nodes.size());
+  int64 bottleneck = -1;
+  for (int64 i = 0; i < nodes.size(); ++i) {
+    exclusive_times.push_back(nodes[i].first->ExclusiveTime());
+    if (exclusive_times[i] > 0 &&
+        (bottleneck < 0 || exclusive_times[i] > exclusive_times[bottleneck])) {
+      bottleneck = i;
+    }
+  }
+  const double total_time = std::max(root->wall_time(), static_cast<int64>(1));
+  string result;
+  for (int64 i = 0; i < nodes.size(); ++i) {
+    strings::StrAppend(&result, string(2 * nodes[i].second, ' '),
+                       nodes[i].first->ProfileString(), ", exclusive_time=",
+                       strings::Printf("%.1f%%", 100.0 * exclusive_times[i] /
+                                                     total_time),
+                       i == bottleneck ? " [bottleneck]" : "", "\n");
+  }
+  return result;
+}
+
 std::map<string, std::shared_ptr<Parameter>> Model::CollectTunableParameters(
     std::shared_ptr<Node> node) {
   std::map<string, std::shared_ptr<Parameter>> parameters;
@@ -951,6 +1037,101 @@ void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget) {
   }
 }
 
+void Model::OptimizeCostModel(int64 cpu_budget, int64 ram_budget) {
+  std::shared_ptr<Node> snapshot;
+  {
+    tf_shared_lock lock(mu_);
+    snapshot = output_->Snapshot(nullptr);
+  }
+  VLOG(2) << "Starting optimization of tunable parameters with CostModel";
+  const double processing_time = TotalProcessingTime(snapshot);
+  auto parameters = CollectTunableParameters(snapshot);
+  auto essential_parameters = CollectEssentialParallelism(snapshot);
+  // We add the number of model's buffered bytes because it is excluded from the
+  // memory budget, but it is included in the maximum number of buffered bytes.
+  ram_budget += TotalBufferedBytes(snapshot);
+  // A parameter will only be increased if the output latency improvement is
+  // greater than this constant.
+  constexpr double kMinDelta = 1.0L;
+
+  // Lower bound on the cost of an increase, so that increases which take no
+  // share of either budget are ranked by their output latency improvement.
+  constexpr double kMinCost = 1e-6L;
+
+  for (auto& pair : parameters) {
+    pair.second->value = pair.second->min;
+  }
+  double cpu_used = 0;
+  for (auto& pair : essential_parameters) {
+    cpu_used += pair.second->value;
+  }
+  double ram_used = TotalMaximumBufferedBytes(snapshot);
+  double output_time = OutputTime(snapshot, /*gradient=*/nullptr);
+  while (output_time > processing_time / cpu_budget && ram_used <= ram_budget) {
+    double best_utility = 0.0L;
+    Parameter* best_parameter = nullptr;
+    double best_value = 0.0L;
+    double best_output_time = 0.0L;
+    double best_cpu_used = 0.0L;
+    double best_ram_used = 0.0L;
+    for (auto& pair : parameters) {
+      Parameter* parameter = pair.second.get();
+      if (parameter->value >= parameter->max) {
+        continue;
+      }
+      const bool essential = essential_parameters.count(pair.first) > 0;
+      const double old_value = parameter->value;
+      // Try doubling the parameter first, and fall back to incrementing it if
+      // doubling does not fit in the budgets or does not pay off.
+      for (double step : {std::max(old_value, 1.0), 1.0}) {
+        const double new_value = std::min(old_value + step, parameter->max);
+        const double new_cpu_used =
+            cpu_used + (essential ? new_value - old_value : 0.0L);
+        if (new_cpu_used > cpu_budget) {
+          continue;
+        }
+        parameter->value = new_value;
+        const double new_output_time =
+            OutputTime(snapshot, /*gradient=*/nullptr);
+        const double new_ram_used = TotalMaximumBufferedBytes(snapshot);
+        parameter->value = old_value;
+        const double delta = output_time - new_output_time;
+        if (new_ram_used > ram_budget || delta <= kMinDelta) {
+          continue;
+        }
+        const double cost = (new_cpu_used - cpu_used) / cpu_budget +
+                            (new_ram_used - ram_used) / ram_budget;
+        const double utility = delta / std::max(cost, kMinCost);
+        if (utility > best_utility) {
+          best_utility = utility;
+          best_parameter = parameter;
+          best_value = new_value;
+          best_output_time = new_output_time;
+          best_cpu_used = new_cpu_used;
+          best_ram_used = new_ram_used;
+        }
+        break;
+      }
+    }
+    if (!best_parameter) {
+      break;
+    }
+    best_parameter->value = best_value;
+    output_time = best_output_time;
+    cpu_used = best_cpu_used;
+    ram_used = best_ram_used;
+  }
+  VLOG(2) << "Number of tunable parameters: " << parameters.size();
+  for (auto& pair : parameters) {
+    auto& parameter = pair.second;
+    VLOG(2) << "Setting tunable parameter " << pair.first << " to "
+            << parameter->value;
+    mutex_lock l(*parameter->state->mu);
+    parameter->state->value = parameter->value;
+    parameter->state->cond_var->notify_all();
+  }
+}
+
 double Model::OutputTime(std::shared_ptr<Node> node,
                          std::map<string, double>* gradient) {
   std::vector<double> input_times(1, 0);
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
 #define TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
 
+#include <algorithm>
 #include <list>
 #include <memory>
 #include <string>
@@ -43,6 +44,7 @@ constexpr char kBufferSize[] = "buffer_size";
 enum class AutotuneAlgorithm {
   HILL_CLIMB = 0,
   GRADIENT_DESCENT = 1,
+  COST_MODEL = 2,
 };
 
 // Represents thread-safe state that can be shared between an input pipeline and
@@ -124,7 +126,10 @@ class Node {
   using Factory = std::function<std::shared_ptr<Node>(Args)>;
 
   explicit Node(Args args)
-      : id_(args.id), name_(args.name), output_(args.output.get()) {}
+      : id_(args.id),
+        name_(args.name),
+        buffered_elements_histogram_(BufferedElementsBucketLimits()),
+        output_(args.output.get()) {}
 
   virtual ~Node() {}
 
@@ -134,6 +139,12 @@ class Node {
     inputs_.push_back(node);
   }
 
+  // Increments the time spent in `GetNext()` of the inputs by the given delta.
+  void add_input_time(int64 delta) LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    input_time_ += delta;
+  }
+
   // Increments the aggregate processing time by the given delta.
   void add_processing_time(int64 delta) LOCKS_EXCLUDED(mu_) {
     mutex_lock l(mu_);
@@ -146,6 +157,12 @@ class Node {
     return autotune_;
   }
 
+  // Returns the number of bytes produced by the node.
+  int64 bytes_produced() const LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    return bytes_produced_;
+  }
+
   // Returns the number of bytes stored in this node's buffer.
   int64 buffered_bytes() const LOCKS_EXCLUDED(mu_) {
     tf_shared_lock l(mu_);
@@ -170,6 +187,12 @@ class Node {
   // Returns the unique node ID.
   int64 id() const LOCKS_EXCLUDED(mu_) { return id_; }
 
+  // Returns the aggregate time spent in `GetNext()` of the inputs.
+  int64 input_time() const LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    return input_time_;
+  }
+
   // Returns the node inputs.
   std::list<std::shared_ptr<Node>> inputs() const LOCKS_EXCLUDED(mu_) {
     tf_shared_lock l(mu_);
@@ -211,6 +234,21 @@ class Node {
     num_elements_++;
   }
 
+  // Records that a call to `GetNext()` of the node took `wall_time`
+  // nanoseconds and produced `bytes` bytes. The time is also accounted as
+  // input time of the output node.
+  void record_get_next(int64 wall_time, int64 bytes) LOCKS_EXCLUDED(mu_) {
+    {
+      mutex_lock l(mu_);
+      wall_time_ += wall_time;
+      bytes_produced_ += bytes;
+      buffered_elements_histogram_.Add(buffered_elements_);
+    }
+    if (output_) {
+      output_->add_input_time(wall_time);
+    }
+  }
+
   // Records that a node thread has started executing.
   void record_start(int64 time_nanos) LOCKS_EXCLUDED(mu_) {
     mutex_lock l(mu_);
@@ -237,6 +275,12 @@ class Node {
     inputs_.remove(input);
   }
 
+  // Returns the aggregate time spent in `GetNext()` of the node.
+  int64 wall_time() const LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    return wall_time_;
+  }
+
   // Sets the value that determines whether autotuning is enabled for this node.
   void set_autotune(bool autotune) LOCKS_EXCLUDED(mu_) {
     mutex_lock l(mu_);
@@ -281,6 +325,18 @@ class Node {
     return result;
   }
 
+  // Returns the aggregate time spent in `GetNext()` of this node that is not
+  // accounted for by `GetNext()` of its inputs.
+  //
+  // For synchronous nodes, this is the time spent in the node itself. For
+  // asynchronous nodes, the inputs are invoked by background threads, so this
+  // is the time the consumer waited for the node beyond the time the node
+  // waited for its inputs.
+  int64 ExclusiveTime() const LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    return std::max(wall_time_ - input_time_, static_cast<int64>(0));
+  }
+
   // Returns the per-element output time for this node and if `gradient` is not
   // `nullptr`, collects the gradient of the output time w.r.t. tunable
   // parameters of the subtree rooted in this node and the last input time.
@@ -315,6 +371,9 @@ class Node {
     return result;
   }
 
+  // Returns a human-readable summary of the profile of this node.
+  string ProfileString() const LOCKS_EXCLUDED(mu_);
+
   // Returns the per-element processing time spent in this node.
   double SelfProcessingTime() const LOCKS_EXCLUDED(mu_) {
     tf_shared_lock l(mu_);
@@ -374,6 +433,9 @@ class Node {
   }
 
  protected:
+  // Returns the bucket limits of the buffered elements histogram.
+  static std::vector<double> BufferedElementsBucketLimits();
+
   // Returns the number of inputs.
   int64 num_inputs() const SHARED_LOCKS_REQUIRED(mu_) {
     int64 num_inputs = 0;
@@ -502,6 +564,15 @@ class Node {
   std::map<std::thread::id, int64> work_start_ GUARDED_BY(mu_);
   std::map<string, std::shared_ptr<Parameter>> parameters_ GUARDED_BY(mu_);
 
+  // Statistics collected when profiling is enabled (see `Model::profile()`).
+  // The wall time and input time are the aggregate time spent in `GetNext()`
+  // of this node and of its inputs respectively. The number of buffered
+  // elements is sampled every time the node produces an element.
+  int64 wall_time_ GUARDED_BY(mu_) = 0;
+  int64 input_time_ GUARDED_BY(mu_) = 0;
+  int64 bytes_produced_ GUARDED_BY(mu_) = 0;
+  histogram::Histogram buffered_elements_histogram_ GUARDED_BY(mu_);
+
   // Statistic of inputs processing time history.
   double input_processing_time_sum_ = 0.0L;
   int64 input_processing_time_count_ = 0;
@@ -570,6 +641,7 @@ class Model {
   // from modules that it could not depend on statically.
   Model(NodeHook remove_node_hook)
       : collect_resource_usage_(false),
+        profile_(false),
         remove_node_hook_(std::move(remove_node_hook)) {
     DCHECK(remove_node_hook_ != nullptr);
   }
@@ -577,6 +649,18 @@ class Model {
   // Indicates whether to collect resource usage.
   bool collect_resource_usage() const { return collect_resource_usage_; }
 
+  // Indicates whether to collect the per-iterator profile of the input
+  // pipeline, i.e. the wall time spent in each iterator and its inputs, the
+  // bytes it produced and the occupancy of its buffer.
+  bool profile() const { return profile_; }
+
+  // Enables collection of the per-iterator profile. Profiling relies on the
+  // resource usage collection, which is enabled as well.
+  void EnableProfiling() {
+    collect_resource_usage_ = true;
+    profile_ = true;
+  }
+
   // Adds a node with the given name and given output.
   std::shared_ptr<Node> AddNode(Node::Factory factory, const string& name,
                                 const string& output_name) LOCKS_EXCLUDED(mu_);
@@ -605,6 +689,12 @@ class Model {
   // Removes the given node.
   void RemoveNode(const string& name) LOCKS_EXCLUDED(mu_);
 
+  // Returns a report of the per-iterator profile of the input pipeline, with
+  // one line per iterator indented by its depth in the tree of iterators. The
+  // iterator with the largest exclusive time (see `Node::ExclusiveTime()`) is
+  // marked as the bottleneck.
+  string ProfileReport() LOCKS_EXCLUDED(mu_);
+
  private:
   // Collects tunable parameters in the tree rooted in the given node, returning
   // a mapping from a (unique) node name to a tunable parameter.
@@ -636,6 +726,19 @@ class Model {
   // an element divided by CPU budget.
   void OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget);
 
+  // This optimization algorithm starts by setting all tunable parameters to
+  // the minimum value. It then repeatedly makes the parameter increase with
+  // the largest decrease in output time per unit of cost, where the cost of an
+  // increase is the share of the CPU budget it takes (for parallelism of
+  // essential transformations) plus the share of the RAM budget it takes (for
+  // buffers, based on the average size of the elements they hold). Parameters
+  // are doubled while that fits in both budgets and incremented otherwise, so
+  // the number of steps grows logarithmically with the parameter values. This
+  // process is repeated until no increase fits in the budgets and decreases
+  // the output time, or the output time is less than or equal to the
+  // processing time needed to produce an element divided by CPU budget.
+  void OptimizeCostModel(int64 cpu_budget, int64 ram_budget);
+
   // Collects the output time and if `gradient` is not `nullptr`, the output
   // time gradient w.r.t. tunable parameters of the subtree rooted in the given
   // node and the last input time.
@@ -671,6 +774,11 @@ class Model {
   // of the parameter) and never stops.
   std::atomic<bool> collect_resource_usage_;
 
+  // Indicates whether the modeling framework should collect the per-iterator
+  // profile. Like resource usage collection, profiling is never disabled once
+  // it has been enabled.
+  std::atomic<bool> profile_;
+
   // A hook invoked immediately before a node is removed from the model.
   const NodeHook remove_node_hook_;
 };
@@ -14,9 +14,11 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/framework/model.h"
+#include <limits>
 #include <memory>
 
 #include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -448,6 +450,60 @@ TEST(SetterGetterTest, Node) {
   EXPECT_EQ(node->num_elements(), 0);
   node->record_element();
   EXPECT_EQ(node->num_elements(), 1);
+
+  EXPECT_EQ(node->wall_time(), 0);
+  EXPECT_EQ(node->input_time(), 0);
+  EXPECT_EQ(node->bytes_produced(), 0);
+  input->record_get_next(/*wall_time=*/30, /*bytes=*/8);
+  EXPECT_EQ(input->wall_time(), 30);
+  EXPECT_EQ(input->bytes_produced(), 8);
+  EXPECT_EQ(input->ExclusiveTime(), 30);
+  EXPECT_EQ(node->input_time(), 30);
+  node->record_get_next(/*wall_time=*/50, /*bytes=*/16);
+  EXPECT_EQ(node->wall_time(), 50);
+  EXPECT_EQ(node->bytes_produced(), 16);
+  EXPECT_EQ(node->ExclusiveTime(), 20);
+}
+
+TEST(ProfileReportTest, Model) {
+  Model model([](std::shared_ptr<Node>) {});
+  EXPECT_FALSE(model.profile());
+  EXPECT_EQ(model.ProfileReport(), "");
+  model.EnableProfiling();
+  EXPECT_TRUE(model.profile());
+  EXPECT_TRUE(model.collect_resource_usage());
+
+  auto factory = [](Node::Args args) {
+    return MakeKnownRatioNode(std::move(args), /*ratio=*/1);
+  };
+  std::shared_ptr<Node> batch =
+      model.AddNode(factory, "Iterator::Batch", "Iterator");
+  std::shared_ptr<Node> map =
+      model.AddNode(factory, "Iterator::Batch::Map", "Iterator::Batch");
+  std::shared_ptr<Node> range = model.AddNode(
+      factory, "Iterator::Batch::Map::Range", "Iterator::Batch::Map");
+  for (int i = 0; i < 10; ++i) {
+    range->record_get_next(/*wall_time=*/10, /*bytes=*/8);
+    range->record_element();
+    map->record_get_next(/*wall_time=*/100, /*bytes=*/8);
+    map->record_element();
+  }
+  batch->record_get_next(/*wall_time=*/1100, /*bytes=*/80);
+  batch->record_element();
+  EXPECT_EQ(batch->ExclusiveTime(), 100);
+  EXPECT_EQ(map->ExclusiveTime(), 900);
+  EXPECT_EQ(range->ExclusiveTime(), 100);
+
+  std::vector<string> lines =
+      str_util::Split(model.ProfileReport(), '\n', str_util::SkipEmpty());
+  ASSERT_EQ(lines.size(), 3);
+  EXPECT_TRUE(str_util::StartsWith(lines[0], "Batch(id:1): elements=1"));
+  EXPECT_TRUE(str_util::StrContains(lines[0], "exclusive_time=9.1%"));
+  EXPECT_TRUE(str_util::StartsWith(lines[1], "  Map(id:2): elements=10"));
+  EXPECT_TRUE(str_util::StrContains(lines[1], "exclusive_time=81.8%"));
+  EXPECT_TRUE(str_util::EndsWith(lines[1], "[bottleneck]"));
+  EXPECT_TRUE(str_util::StartsWith(lines[2], "    Range(id:3): elements=10"));
+  EXPECT_FALSE(str_util::StrContains(lines[2], "[bottleneck]"));
 }
 
 // Returns a weighted sum of a prior and the actual processing time.
@@ -727,6 +783,275 @@ TEST(UnknownGradientTest, Model) {
               (new_output_time - output_time) / kParameterStep,
               kComparisonPrecision);
 }
+
+// A stage of a synthetic pipeline used to compare autotuning algorithms.
+struct SimulatedStage {
+  enum class Kind { kSource, kSync, kParallel, kPrefetch };
+
+  Kind kind;
+  // CPU time (in nanoseconds) it takes to produce an element of the stage.
+  int64 processing_time;
+  // Number of input elements consumed per element produced.
+  double ratio;
+  // Size (in bytes) of an element produced by the stage.
+  int64 element_bytes;
+};
+
+// Simulates running a chain of stages (listed from the output to the source)
+// under the modeling framework. Elements take the same CPU time to produce no
+// matter how the pipeline is tuned, but asynchronous stages overlap their
+// work with the rest of the pipeline and parallel ones split it among their
+// threads.
+class SimulatedPipeline {
+ public:
+  explicit SimulatedPipeline(const std::vector<SimulatedStage>& stages)
+      : model_(std::make_shared<Model>([](std::shared_ptr<Node>) {})) {
+    string output_name;
+    for (int i = 0; i < stages.size(); ++i) {
+      const SimulatedStage& stage = stages[i];
+      string name = strings::StrCat(output_name, "::Stage", i);
+      auto state = std::make_shared<SharedState>(
+          kAutotune, std::make_shared<mutex>(),
+          std::make_shared<condition_variable>());
+      Node::Factory factory;
+      switch (stage.kind) {
+        case SimulatedStage::Kind::kSource:
+          factory = [](Node::Args args) {
+            return MakeSourceNode(std::move(args));
+          };
+          state = nullptr;
+          break;
+        case SimulatedStage::Kind::kSync:
+          factory = [stage](Node::Args args) {
+            return MakeKnownRatioNode(std::move(args), stage.ratio);
+          };
+          state = nullptr;
+          break;
+        case SimulatedStage::Kind::kParallel:
+          factory = [stage, state](Node::Args args) {
+            return MakeAsyncKnownRatioNode(
+                std::move(args), stage.ratio,
+                {MakeParameter(kParallelism, state, /*min=*/1,
+                               /*max=*/kMaxParallelism)});
+          };
+          break;
+        case SimulatedStage::Kind::kPrefetch:
+          factory = [state](Node::Args args) {
+            return MakeAsyncKnownRatioNode(
+                std::move(args), /*ratio=*/1,
+                {MakeParameter(kBufferSize, state, /*min=*/0,
+                               /*max=*/std::numeric_limits<int64>::max())});
+          };
+          break;
+      }
+      stages_.push_back(
+          {stage, name, model_->AddNode(factory, name, output_name), state});
+      output_name = name;
+    }
+  }
+
+  // Produces `num_elements` output elements, recording the processing time
+  // and buffer usage the modeling framework would observe.
+  void Run(int64 num_elements) {
+    double multiplier = num_elements;
+    for (auto& stage : stages_) {
+      const int64 count = std::round(multiplier);
+      model_->AddProcessingTime(stage.name,
+                                count * stage.stage.processing_time);
+      for (int64 i = 0; i < count; ++i) {
+        model_->RecordElement(stage.name);
+      }
+      // Asynchronous stages keep their buffers full in steady state.
+      if (stage.state) {
+        int64 buffered_elements = BufferSize(stage);
+        stage.node->record_buffer_event(
+            buffered_elements * stage.stage.element_bytes -
+                stage.node->buffered_bytes(),
+            buffered_elements - stage.node->buffered_elements());
+      }
+      multiplier *= stage.stage.ratio;
+    }
+  }
+
+  // Runs `rounds` rounds of producing `num_elements` elements and optimizing
+  // the pipeline with `algorithm`, like the model dataset does. Returns the
+  // number of rounds after which the tunable parameters stopped changing.
+  int64 Tune(AutotuneAlgorithm algorithm, int64 cpu_budget, int64 ram_budget,
+             int64 rounds, int64 num_elements) {
+    int64 converged_after = 0;
+    std::vector<int64> values = Values();
+    for (int64 round = 1; round <= rounds; ++round) {
+      Run(num_elements);
+      // Like the model dataset, pass the memory that is not used by the
+      // buffers yet as the budget.
+      model_->Optimize(algorithm, cpu_budget, ram_budget - BufferedBytes());
+      std::vector<int64> new_values = Values();
+      if (new_values != values) {
+        converged_after = round;
+      }
+      values = new_values;
+    }
+    return converged_after;
+  }
+
+  // Returns the steady-state time (in nanoseconds) it takes to produce an
+  // output element with the current parameter values. Each asynchronous stage
+  // (and the consumer) runs the synchronous stages below it on its own
+  // threads, and all stages share `cpu_budget` cores.
+  double OutputTime(int64 cpu_budget) const {
+    double multiplier = 1;
+    double total_work = 0;
+    double segment_work = 0;
+    double segment_threads = 1;
+    double result = 0;
+    for (const auto& stage : stages_) {
+      if (stage.stage.kind == SimulatedStage::Kind::kParallel ||
+          (stage.stage.kind == SimulatedStage::Kind::kPrefetch &&
+           BufferSize(stage) > 0)) {
+        result = std::max(result, segment_work / segment_threads);
+        segment_work = 0;
+        segment_threads = stage.stage.kind == SimulatedStage::Kind::kParallel
+                              ? BufferSize(stage)
+                              : 1;
+      }
+      double work = multiplier * stage.stage.processing_time;
+      segment_work += work;
+      total_work += work;
+      multiplier *= stage.stage.ratio;
+    }
+    result = std::max(result, segment_work / segment_threads);
+    return std::max(result, total_work / cpu_budget);
+  }
+
+  // Returns the memory (in bytes) used by the buffers of the pipeline.
+  int64 BufferedBytes() const {
+    int64 result = 0;
+    for (const auto& stage : stages_) {
+      if (stage.state) {
+        result += BufferSize(stage) * stage.stage.element_bytes;
+      }
+    }
+    return result;
+  }
+
+ private:
+  static constexpr int64 kMaxParallelism = 64;
+
+  struct Stage {
+    SimulatedStage stage;
+    string name;
+    std::shared_ptr<Node> node;
+    // Set for stages with a tunable parameter.
+    std::shared_ptr<SharedState> state;
+  };
+
+  // Returns the parallelism or buffer size of the given stage.
+  static int64 BufferSize(const Stage& stage) {
+    if (stage.state->value == kAutotune) {
+      return stage.stage.kind == SimulatedStage::Kind::kParallel ? 1 : 0;
+    }
+    return stage.state->value;
+  }
+
+  std::vector<int64> Values() const {
+    std::vector<int64> result;
+    for (const auto& stage : stages_) {
+      if (stage.state) {
+        result.push_back(BufferSize(stage));
+      }
+    }
+    return result;
+  }
+
+  std::shared_ptr<Model> model_;
+  std::vector<Stage> stages_;
+};
+
+constexpr int64 SimulatedPipeline::kMaxParallelism;
+
+struct AutotuneSimulationTestCase {
+  string name;
+  std::vector<SimulatedStage> stages;
+  int64 cpu_budget;
+  int64 ram_budget;
+};
+
+class AutotuneSimulationTest
+    : public ::testing::TestWithParam<AutotuneSimulationTestCase> {};
+
+// Compares how fast the autotuning algorithms converge, and the steady-state
+// throughput and memory usage of the pipeline they converge to.
+TEST_P(AutotuneSimulationTest, Model) {
+  constexpr int64 kRounds = 10;
+  constexpr int64 kElementsPerRound = 100;
+  const AutotuneSimulationTestCase& test_case = GetParam();
+  // Output times of the algorithms that kept within the memory budget.
+  std::map<AutotuneAlgorithm, double> output_times;
+  std::map<AutotuneAlgorithm, int64> rounds;
+  for (AutotuneAlgorithm algorithm :
+       {AutotuneAlgorithm::HILL_CLIMB, AutotuneAlgorithm::GRADIENT_DESCENT,
+        AutotuneAlgorithm::COST_MODEL}) {
+    SimulatedPipeline pipeline(test_case.stages);
+    rounds[algorithm] =
+        pipeline.Tune(algorithm, test_case.cpu_budget, test_case.ram_budget,
+                      kRounds, kElementsPerRound);
+    const double output_time = pipeline.OutputTime(test_case.cpu_budget);
+    LOG(INFO) << test_case.name << ": algorithm "
+              << static_cast<int>(algorithm) << " converged after "
+              << rounds[algorithm] << " rounds, output time " << output_time
+              << "ns, buffered bytes " << pipeline.BufferedBytes();
+    if (pipeline.BufferedBytes() <= test_case.ram_budget) {
+      output_times[algorithm] = output_time;
+    }
+  }
+  EXPECT_LE(rounds[AutotuneAlgorithm::COST_MODEL], 3);
+  ASSERT_TRUE(output_times.count(AutotuneAlgorithm::COST_MODEL));
+  for (const auto& pair : output_times) {
+    EXPECT_LE(output_times[AutotuneAlgorithm::COST_MODEL], 1.1 * pair.second);
+  }
+}
+
+using Kind = SimulatedStage::Kind;
+
+INSTANTIATE_TEST_SUITE_P(
+    Test, AutotuneSimulationTest,
+    ::testing::Values(
+        AutotuneSimulationTestCase{"Map",
+                                   {{Kind::kPrefetch, 0, 1, 1024},
+                                    {Kind::kParallel, 10000, 1, 1024},
+                                    {Kind::kSource, 100, 1, 1024}},
+                                   /*cpu_budget=*/8,
+                                   /*ram_budget=*/1 << 30},
+        AutotuneSimulationTestCase{"MapBatchMap",
+                                   {{Kind::kPrefetch, 0, 1, 32 << 10},
+                                    {Kind::kParallel, 20000, 1, 32 << 10},
+                                    {Kind::kSync, 2000, 32, 32 << 10},
+                                    {Kind::kParallel, 5000, 1, 1024},
+                                    {Kind::kSource, 100, 1, 1024}},
+                                   /*cpu_budget=*/16,
+                                   /*ram_budget=*/1 << 30},
+        AutotuneSimulationTestCase{"ManyMaps",
+                                   {{Kind::kPrefetch, 0, 1, 1024},
+                                    {Kind::kParallel, 1000, 1, 1024},
+                                    {Kind::kParallel, 8000, 1, 1024},
+                                    {Kind::kParallel, 2000, 1, 1024},
+                                    {Kind::kParallel, 16000, 1, 1024},
+                                    {Kind::kParallel, 4000, 1, 1024},
+                                    {Kind::kParallel, 500, 1, 1024},
+                                    {Kind::kSource, 100, 1, 1024}},
+                                   /*cpu_budget=*/32,
+                                   /*ram_budget=*/1 << 30},
+        AutotuneSimulationTestCase{"MemoryBound",
+                                   {{Kind::kPrefetch, 0, 1, 16 << 20},
+                                    {Kind::kParallel, 50000, 1, 16 << 20},
+                                    {Kind::kParallel, 10000, 1, 1 << 20},
+                                    {Kind::kSource, 100, 1, 1 << 20}},
+                                   /*cpu_budget=*/16,
+                                   /*ram_budget=*/64 << 20}),
+    [](const ::testing::TestParamInfo<AutotuneSimulationTestCase>& info) {
+      return info.param.name;
+    });
+
 }  // namespace
 }  // namespace model
 }  // namespace data
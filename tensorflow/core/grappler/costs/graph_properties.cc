@@ -550,7 +550,7 @@ class SymbolicShapeRefiner {
       const GraphView& graph,
       const std::unordered_map<string, std::unordered_set<int>>& fed_ports,
       const bool aggressive_shape_inference)
-      : graph_(graph),
+      : graph_(&graph),
         function_library_(OpRegistry::Global(), graph.graph()->library()),
         fed_ports_(fed_ports),
         aggressive_shape_inference_(aggressive_shape_inference) {
@@ -558,9 +558,16 @@ class SymbolicShapeRefiner {
     node_to_context_.reserve(graph.graph()->node_size());
   }
 
-  const GraphView& graph() const { return graph_; }
+  const GraphView& graph() const { return *graph_; }
+
+  // Switches to a new view of the graph after the graph was mutated. The
+  // function library and the feeds of the graph must not have changed.
+  void set_graph(const GraphView& graph) { graph_ = &graph; }
 
   struct NodeContext {
+    // Name of the node when the context was created. Used to detect contexts
+    // of nodes that were removed from the graph.
+    string node_name;
     const OpRegistrationData* op_data;
     DataTypeVector input_types;
     DataTypeVector output_types;
@@ -639,7 +646,7 @@ class SymbolicShapeRefiner {
             "Function inputs should not contain control nodes.");
       }
 
-      const NodeDef* input_node = graph_.GetNode(input_tensor.node());
+      const NodeDef* input_node = graph_->GetNode(input_tensor.node());
       if (input_node == nullptr) {
         return errors::FailedPrecondition(input_tensor.node(),
                                           " was not found in the graph.");
@@ -680,7 +687,7 @@ class SymbolicShapeRefiner {
     for (int i = grappler_function_item.inputs().size() - 1; i >= 0; --i) {
       const string& input = function_node->input(i);
       const string& node_name = NodeName(input);
-      const NodeDef* input_node = graph_.GetNode(node_name);
+      const NodeDef* input_node = graph_->GetNode(node_name);
       if (IsConstant(*input_node)) {
         TF_CHECK_OK(
             ReplaceInputWithConst(*input_node, i, &grappler_function_item));
@@ -779,7 +786,7 @@ class SymbolicShapeRefiner {
 
     for (int dst_input = 0; dst_input < ic->num_inputs(); ++dst_input) {
       const GraphView::InputPort port(node, dst_input);
-      const GraphView::OutputPort fanin = graph_.GetRegularFanin(port);
+      const GraphView::OutputPort fanin = graph_->GetRegularFanin(port);
       int src_output = fanin.port_id;
       const NodeDef* src = fanin.node;
       NodeContext* src_ctx = GetNodeContext(src);
@@ -1136,6 +1143,7 @@ class SymbolicShapeRefiner {
 
   Status AddNode(const NodeDef* node) {
     NodeContext& node_ctx = node_to_context_[node];
+    node_ctx.node_name = node->name();
     TF_RETURN_IF_ERROR(function_library_.LookUp(node->op(), &node_ctx.op_data));
 
     if (node_ctx.op_data->is_function_op) {
@@ -1165,6 +1173,44 @@ class SymbolicShapeRefiner {
     return s;
   }
 
+  // Forgets everything inferred about `nodes`, so that the next update infers
+  // their shapes from scratch. The handles created by the contexts of the
+  // nodes become invalid, so the caller must also remove all the nodes that
+  // might refer to them, i.e. the transitive fanout of `nodes`.
+  void RemoveNodes(const std::unordered_set<const NodeDef*>& nodes) {
+    for (const NodeDef* node : nodes) {
+      node_to_context_.erase(node);
+    }
+    for (auto it = unknown_shapes_.begin(); it != unknown_shapes_.end();) {
+      if (nodes.find(it->first.node) != nodes.end()) {
+        it = unknown_shapes_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    for (auto it = unknown_dims_.begin(); it != unknown_dims_.end();) {
+      if (nodes.find(it->first.node) != nodes.end()) {
+        it = unknown_dims_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  // Removes the contexts of the nodes that are no longer part of the graph,
+  // and returns their former NodeDefs. Since a NodeDef may have been reused
+  // for another node since, the returned pointers must not be dereferenced.
+  std::unordered_set<const NodeDef*> RemoveStaleNodes() {
+    std::unordered_set<const NodeDef*> stale_nodes;
+    for (const auto& node_ctx : node_to_context_) {
+      if (graph_->GetNode(node_ctx.second.node_name) != node_ctx.first) {
+        stale_nodes.insert(node_ctx.first);
+      }
+    }
+    RemoveNodes(stale_nodes);
+    return stale_nodes;
+  }
+
  private:
   // Return the one ShapeHandle used to denote a fully unknown shape for a node
   // output.
@@ -1776,7 +1822,7 @@ class SymbolicShapeRefiner {
     return false;
   }
 
-  const GraphView& graph_;
+  const GraphView* graph_;  // Not owned.
   int graph_def_version_;
   std::unordered_map<const NodeDef*, NodeContext> node_to_context_;
   std::unordered_map<ShapeId, ShapeHandle, HashShapeId> unknown_shapes_;
@@ -2127,21 +2173,60 @@ Status GraphProperties::UpdateEnqueue(
   return Status::OK();
 }
 
+GraphProperties::~GraphProperties() {}
+
 Status GraphProperties::InferStatically(bool assume_valid_feeds,
                                         bool aggressive_shape_inference,
                                         bool include_input_tensor_values,
                                         bool include_output_tensor_values) {
-  FunctionLibraryDefinition function_library(OpRegistry::Global(),
-                                             item_.graph.library());
-  std::unordered_map<string, std::unordered_set<int>> fed_ports;
+  ResetInferenceState();
+  static_inference_options_ = StaticInferenceOptions{
+      assume_valid_feeds, aggressive_shape_inference,
+      include_input_tensor_values, include_output_tensor_values};
+
+  fed_ports_.clear();
   if (!assume_valid_feeds) {
     for (const auto& feed : item_.feed) {
       SafeTensorId tensor_id = ParseTensorName(feed.first);
-      fed_ports[tensor_id.node()].insert(tensor_id.index());
+      fed_ports_[tensor_id.node()].insert(tensor_id.index());
     }
   }
 
-  GraphView graph_view(&item_.graph);
+  return RunStaticInference(/*updated_nodes=*/nullptr);
+}
+
+Status GraphProperties::UpdateStatically(
+    const std::unordered_set<string>& updated_nodes) {
+  if (!static_inference_options_) {
+    return errors::FailedPrecondition(
+        "InferStatically must be called before UpdateStatically");
+  }
+  if (symbolic_shape_refiner_ == nullptr) {
+    const StaticInferenceOptions options = *static_inference_options_;
+    return InferStatically(options.assume_valid_feeds,
+                           options.aggressive_shape_inference,
+                           options.include_input_tensor_values,
+                           options.include_output_tensor_values);
+  }
+  return RunStaticInference(&updated_nodes);
+}
+
+void GraphProperties::ResetInferenceState() {
+  // The refiner refers to the graph view, so it must be destroyed first.
+  symbolic_shape_refiner_.reset();
+  graph_view_.reset();
+}
+
+Status GraphProperties::RunStaticInference(
+    const std::unordered_set<string>* updated_nodes) {
+  const bool aggressive_shape_inference =
+      static_inference_options_->aggressive_shape_inference;
+  const bool include_input_tensor_values =
+      static_inference_options_->include_input_tensor_values;
+  const bool include_output_tensor_values =
+      static_inference_options_->include_output_tensor_values;
+
+  auto graph_view = absl::make_unique<GraphView>(&item_.graph);
 
   // List the resources and the nodes using them. Also collect the Merge nodes,
   // fed nodes, and primary inputs.
@@ -2156,11 +2241,11 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
   for (const NodeDef& node : item_.graph.node()) {
     if (IsQueue(node)) {
       for (const GraphView::InputPort& fanout :
-           graph_view.GetFanouts(node, false)) {
+           graph_view->GetFanouts(node, false)) {
         if (IsEnter(*fanout.node)) {
           const NodeDef& enter = *fanout.node;
           for (const GraphView::InputPort& fanout :
-               graph_view.GetFanouts(enter, false)) {
+               graph_view->GetFanouts(enter, false)) {
             if (IsEnqueue(*fanout.node)) {
               resources[&node].first.insert(fanout.node);
             } else if (IsDequeue(*fanout.node)) {
@@ -2183,7 +2268,7 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
     } else if (IsNextIteration(node)) {
       ++num_loops;
     }
-    if (fed_ports.find(node.name()) != fed_ports.end()) {
+    if (fed_ports_.find(node.name()) != fed_ports_.end()) {
       fed_nodes.insert(&node);
     }
   }
@@ -2215,19 +2300,65 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
     }
   }
 
-  // Heap-allocate SymbolicShapeRefiner in order to not consume a large amount
-  // of stack space.
-  auto refiner = absl::make_unique<SymbolicShapeRefiner>(
-      graph_view, fed_ports, aggressive_shape_inference);
-
+  std::unique_ptr<SymbolicShapeRefiner> refiner;
   TopoQueue new_shapes(topo_order);
-  // Also seed the propagation of shapes in the fanout of primary inputs.
-  for (const NodeDef* node : primary_inputs) {
-    new_shapes.push(node);
-  }
-  // Also seed the propagation of shapes in the fanout of fed nodes.
-  for (const NodeDef* node : fed_nodes) {
-    new_shapes.push(node);
+  if (updated_nodes != nullptr && symbolic_shape_refiner_ != nullptr) {
+    refiner = std::move(symbolic_shape_refiner_);
+    refiner->set_graph(*graph_view);
+
+    // Only the shapes of the updated nodes and of their transitive fanout can
+    // have changed. Nodes that replaced removed nodes in memory are considered
+    // updated as well, even if they weren't listed.
+    const std::unordered_set<const NodeDef*> stale_nodes =
+        refiner->RemoveStaleNodes();
+    std::unordered_set<const NodeDef*> nodes_to_update;
+    std::vector<const NodeDef*> worklist;
+    for (const NodeDef& node : item_.graph.node()) {
+      if (updated_nodes->find(node.name()) != updated_nodes->end() ||
+          stale_nodes.find(&node) != stale_nodes.end()) {
+        nodes_to_update.insert(&node);
+        worklist.push_back(&node);
+      }
+    }
+    while (!worklist.empty()) {
+      const NodeDef* node = worklist.back();
+      worklist.pop_back();
+      for (const GraphView::InputPort& fanout :
+           graph_view->GetFanouts(*node, false)) {
+        if (nodes_to_update.insert(fanout.node).second) {
+          worklist.push_back(fanout.node);
+        }
+      }
+      if (IsEnqueue(*node)) {
+        auto it = resource_handles.find(node);
+        if (it != resource_handles.end() &&
+            nodes_to_update.insert(it->second).second) {
+          worklist.push_back(it->second);
+        }
+      }
+    }
+    VLOG(1) << "Updating the shapes of " << nodes_to_update.size() << " of "
+            << item_.graph.node_size() << " nodes";
+
+    refiner->RemoveNodes(nodes_to_update);
+    for (const NodeDef* node : nodes_to_update) {
+      new_shapes.push(node);
+    }
+  } else {
+    ResetInferenceState();
+    // Heap-allocate SymbolicShapeRefiner in order to not consume a large
+    // amount of stack space.
+    refiner = absl::make_unique<SymbolicShapeRefiner>(
+        *graph_view, fed_ports_, aggressive_shape_inference);
+
+    // Also seed the propagation of shapes in the fanout of primary inputs.
+    for (const NodeDef* node : primary_inputs) {
+      new_shapes.push(node);
+    }
+    // Also seed the propagation of shapes in the fanout of fed nodes.
+    for (const NodeDef* node : fed_nodes) {
+      new_shapes.push(node);
+    }
   }
   // Propagate shapes normally.
   TF_RETURN_IF_ERROR(
@@ -2243,7 +2374,7 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
       continue;
     }
     // Skip any information that comes from fed nodes.
-    if (fed_ports.find(node.name()) != fed_ports.end()) {
+    if (fed_ports_.find(node.name()) != fed_ports_.end()) {
       VLOG(2) << "Skipping feed node shape: " << node.name();
       continue;
     }
@@ -2268,6 +2399,9 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
     }
   }
 
+  input_properties_.clear();
+  output_properties_.clear();
+  incompatible_shape_nodes_.clear();
   for (const NodeDef& node : item_.graph.node()) {
     VLOG(3) << "Filling in graph properties for node: " << node.name();
     auto ctx = refiner->GetNodeContext(&node);
@@ -2290,7 +2424,7 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
         shape_manager->AsTensorProperties(ic->input(i), ctx->input_types[i],
                                           &input_properties[i]);
         input.port_id = i;
-        GraphView::OutputPort fanin = graph_view.GetRegularFanin(input);
+        GraphView::OutputPort fanin = graph_view->GetRegularFanin(input);
         if (include_input_tensor_values) {
           // Export tensor value to input_properties.value.
           if (IsConstant(*fanin.node)) {
@@ -2357,6 +2491,14 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
   VerboseLogUnknownDimensionSources(item_.graph, input_properties_,
                                     output_properties_);
 
+  if (keep_inference_state_) {
+    // Destroy the previous view only once the refiner no longer refers to it.
+    graph_view_ = std::move(graph_view);
+    symbolic_shape_refiner_ = std::move(refiner);
+  } else {
+    ResetInferenceState();
+  }
+
   return Status::OK();
 }
 
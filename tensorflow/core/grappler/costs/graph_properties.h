@@ -16,10 +16,12 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_GRAPH_PROPERTIES_H_
 #define TENSORFLOW_CORE_GRAPPLER_COSTS_GRAPH_PROPERTIES_H_
 
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "absl/types/optional.h"
 #include "tensorflow/core/framework/shape_inference.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
@@ -68,6 +70,7 @@ ABSL_CONST_INIT const char kOutputTypes[] = "_output_dtype_vector";
 // Outputs TensorShapeProto vector.
 ABSL_CONST_INIT const char kOutputShapes[] = "_output_shape_vector";
 
+class GraphView;
 class SymbolicShapeRefiner;
 class TopoQueue;
 
@@ -81,6 +84,7 @@ class GraphProperties {
  public:
   // The item must outlive the properties
   explicit GraphProperties(const GrapplerItem& item) : item_(item) {}
+  ~GraphProperties();
 
   // Infer the shapes through abstract interpretation. Feed information can be
   // incorrect so it should be discarded to ensure correctness of the analysis.
@@ -113,6 +117,23 @@ class GraphProperties {
                            /*aggressive_shape_inference=*/false,
                            /*include_tensor_values=*/true);
   }
+  // Updates the statically inferred properties after `item_.graph` was mutated
+  // in place, using the options of the last call to InferStatically.
+  // `updated_nodes` must contain the names of the nodes that were added, and of
+  // the nodes whose op, attributes or inputs changed; removed nodes don't need
+  // to be listed. The feeds and the function library must not have changed.
+  // If the inference state was kept (see set_keep_inference_state), only the
+  // shapes of the updated nodes and of their transitive fanout are inferred
+  // again; otherwise the shapes of the whole graph are. Either way, the
+  // resulting properties are the same as the ones of a new call to
+  // InferStatically.
+  Status UpdateStatically(const std::unordered_set<string>& updated_nodes);
+  // Keeps the state of the static shape inference around after
+  // InferStatically and UpdateStatically, so that UpdateStatically can be
+  // incremental. The state takes memory proportional to the size of the graph.
+  void set_keep_inference_state(bool keep_inference_state) {
+    keep_inference_state_ = keep_inference_state;
+  }
   // Infer the shape by running the graph on the specified cluster and recording
   // the shapes of the processed tensors.
   Status InferDynamically(Cluster* cluster);
@@ -193,6 +214,19 @@ class GraphProperties {
           resource_handles,
       int num_loops) const;
 
+  // Infers the shapes of the graph and fills in the properties. If
+  // `updated_nodes` is non null and the inference state was kept, only the
+  // shapes of `updated_nodes` and of their transitive fanout are inferred.
+  Status RunStaticInference(const std::unordered_set<string>* updated_nodes);
+  void ResetInferenceState();
+
+  struct StaticInferenceOptions {
+    bool assume_valid_feeds;
+    bool aggressive_shape_inference;
+    bool include_input_tensor_values;
+    bool include_output_tensor_values;
+  };
+
   // Data members
   const GrapplerItem& item_;
   std::unordered_map<string, std::vector<OpInfo::TensorProperties>>
@@ -204,6 +238,14 @@ class GraphProperties {
   // Nodes with output shape incompatible between shape inference and
   // annotation.
   std::unordered_set<string> incompatible_shape_nodes_;
+
+  // Options of the last call to InferStatically, if any.
+  absl::optional<StaticInferenceOptions> static_inference_options_;
+  // State of the static shape inference, kept to allow incremental updates.
+  bool keep_inference_state_ = false;
+  std::unordered_map<string, std::unordered_set<int>> fed_ports_;
+  std::unique_ptr<GraphView> graph_view_;
+  std::unique_ptr<SymbolicShapeRefiner> symbolic_shape_refiner_;
 };
 
 }  // end namespace grappler
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/cc/framework/scope.h"
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/graph_def_util.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.pb.h"  // NOLINT
@@ -125,10 +126,62 @@ class GraphPropertiesTest : public ::testing::Test {
     }
   }
 
+  // Checks that `properties` of `item` match the ones of a fresh static
+  // inference.
+  void ExpectSameAsInferStatically(const GrapplerItem& item,
+                                   const GraphProperties& properties) {
+    GraphProperties expected(item);
+    TF_ASSERT_OK(expected.InferStatically(false));
+    for (const NodeDef& node : item.graph.node()) {
+      const auto& expected_inputs = expected.GetInputProperties(node.name());
+      const auto& inputs = properties.GetInputProperties(node.name());
+      ASSERT_EQ(expected_inputs.size(), inputs.size()) << node.name();
+      for (int i = 0; i < inputs.size(); ++i) {
+        EXPECT_EQ(expected_inputs[i].DebugString(), inputs[i].DebugString())
+            << node.name() << ":" << i;
+      }
+      const auto& expected_outputs = expected.GetOutputProperties(node.name());
+      const auto& outputs = properties.GetOutputProperties(node.name());
+      ASSERT_EQ(expected_outputs.size(), outputs.size()) << node.name();
+      for (int i = 0; i < outputs.size(); ++i) {
+        EXPECT_EQ(expected_outputs[i].DebugString(), outputs[i].DebugString())
+            << node.name() << ":" << i;
+      }
+    }
+  }
+
   std::unique_ptr<SingleMachine> cluster_;
   FunctionDefLibrary function_lib_;
 };
 
+NodeDef* GetNode(const string& name, GraphDef* graph) {
+  for (NodeDef& node : *graph->mutable_node()) {
+    if (node.name() == name) {
+      return &node;
+    }
+  }
+  return nullptr;
+}
+
+GrapplerItem MakeUpdatableItem() {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT,
+                              ops::Placeholder::Shape(
+                                  PartialTensorShape({-1, 10})));
+  Output b = ops::Variable(s.WithOpName("b"), {10, 20}, DT_FLOAT);
+  Output c = ops::MatMul(s.WithOpName("c"), a, b);
+  Output d = ops::Relu(s.WithOpName("d"), c);
+  Output e = ops::Shape(s.WithOpName("e"), d);
+  Output f = ops::Const(s.WithOpName("f"), 1.0f, {5, 7});
+  Output g = ops::Square(s.WithOpName("g"), f);
+  Output h = ops::Identity(s.WithOpName("h"), g);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"e", "h"};
+  return item;
+}
+
 TEST_F(GraphPropertiesTest, StaticProperties) {
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false,
                                           cluster_->GetDeviceNames());
@@ -1998,6 +2051,86 @@ TEST_F(GraphPropertiesTest, ShapeAnnotationWithoutInferenceFn) {
   EXPECT_EQ(2, prop.shape().dim_size());
   EXPECT_EQ("float: [10,100]", PropToString(prop));
 }
+
+TEST_F(GraphPropertiesTest, UpdateStaticallyRequiresInferStatically) {
+  GrapplerItem item = MakeUpdatableItem();
+  GraphProperties properties(item);
+  EXPECT_TRUE(
+      errors::IsFailedPrecondition(properties.UpdateStatically({"a"})));
+}
+
+TEST_F(GraphPropertiesTest, UpdateStaticallyAfterAttrChange) {
+  GrapplerItem item = MakeUpdatableItem();
+  GraphProperties properties(item);
+  properties.set_keep_inference_state(true);
+  TF_ASSERT_OK(properties.InferStatically(false));
+  EXPECT_EQ("float: [-1,20]",
+            PropToString(properties.GetOutputProperties("d")[0]));
+
+  SetAttrValue(PartialTensorShape({8, 10}),
+               &(*GetNode("a", &item.graph)->mutable_attr())["shape"]);
+  TF_ASSERT_OK(properties.UpdateStatically({"a"}));
+  EXPECT_EQ("float: [8,20]",
+            PropToString(properties.GetOutputProperties("d")[0]));
+  ExpectSameAsInferStatically(item, properties);
+}
+
+TEST_F(GraphPropertiesTest, UpdateStaticallyAfterRewiring) {
+  GrapplerItem item = MakeUpdatableItem();
+  GraphProperties properties(item);
+  properties.set_keep_inference_state(true);
+  TF_ASSERT_OK(properties.InferStatically(false));
+  EXPECT_EQ("float: [5,7]",
+            PropToString(properties.GetOutputProperties("h")[0]));
+
+  // Feed the output of the MatMul to the Square node instead of the constant.
+  GetNode("g", &item.graph)->set_input(0, "d");
+  TF_ASSERT_OK(properties.UpdateStatically({"g"}));
+  EXPECT_EQ("float: [-1,20]",
+            PropToString(properties.GetOutputProperties("h")[0]));
+  ExpectSameAsInferStatically(item, properties);
+}
+
+TEST_F(GraphPropertiesTest, UpdateStaticallyAfterAddingAndRemovingNodes) {
+  GrapplerItem item = MakeUpdatableItem();
+  GraphProperties properties(item);
+  properties.set_keep_inference_state(true);
+  TF_ASSERT_OK(properties.InferStatically(false));
+
+  // Remove the constant and replace it with a new one of a different shape.
+  // The NodeDef of the removed node is likely to be reused for the new one.
+  int f_index = 0;
+  while (item.graph.node(f_index).name() != "f") ++f_index;
+  item.graph.mutable_node()->SwapElements(f_index,
+                                          item.graph.node_size() - 1);
+  item.graph.mutable_node()->RemoveLast();
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output f2 = ops::Const(s.WithOpName("f2"), 1.0f, {3, 4});
+  GraphDef f2_graph;
+  TF_ASSERT_OK(s.ToGraphDef(&f2_graph));
+  *item.graph.add_node() = f2_graph.node(0);
+  GetNode("g", &item.graph)->set_input(0, "f2");
+
+  TF_ASSERT_OK(properties.UpdateStatically({"f2", "g"}));
+  EXPECT_FALSE(properties.HasOutputProperties("f"));
+  EXPECT_EQ("float: [3,4]",
+            PropToString(properties.GetOutputProperties("h")[0]));
+  ExpectSameAsInferStatically(item, properties);
+}
+
+TEST_F(GraphPropertiesTest, UpdateStaticallyWithoutInferenceState) {
+  GrapplerItem item = MakeUpdatableItem();
+  GraphProperties properties(item);
+  TF_ASSERT_OK(properties.InferStatically(false));
+
+  SetAttrValue(PartialTensorShape({8, 10}),
+               &(*GetNode("a", &item.graph)->mutable_attr())["shape"]);
+  TF_ASSERT_OK(properties.UpdateStatically({"a"}));
+  EXPECT_EQ("float: [8,20]",
+            PropToString(properties.GetOutputProperties("d")[0]));
+  ExpectSameAsInferStatically(item, properties);
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
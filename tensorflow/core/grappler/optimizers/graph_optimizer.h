@@ -61,6 +61,11 @@ class GraphOptimizer {
   virtual void Feedback(Cluster* cluster, const GrapplerItem& item,
                         const GraphDef& optimized_graph, double result) = 0;
 
+  // Returns optimizer-specific details about the last call to Optimize, e.g.
+  // estimated costs before and after the rewrite. The MetaOptimizer appends
+  // them to the optimization result it reports for this optimizer.
+  virtual string ResultSummary() const { return ""; }
+
   // Set deadline in microseconds since epoch. A value of zero means no
   // deadline.
   void set_deadline_usec(uint64 deadline_usec) {
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/core/common_runtime/function.h"
@@ -36,7 +38,9 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/implementation_selector.h"
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/meta_optimizer_cache.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
+#include "tensorflow/core/grappler/optimizers/peak_memory_scheduler.h"
 #include "tensorflow/core/grappler/optimizers/pin_to_host_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 #include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
@@ -47,8 +51,11 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/grappler/utils/tpu.h"
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/util/dump_graph.h"
 #include "tensorflow/core/util/ptr_util.h"
 
@@ -59,6 +66,7 @@ namespace {
 
 constexpr int kDefaultNumberOfIterations = 2;
 constexpr int kDefaultMinGraphNodes = 4;
+constexpr int kMaxDefaultFunctionOptimizationThreads = 8;
 
 int64 NumEdges(const GraphDef& graph) {
   int64 num_edges = 0;
@@ -84,7 +92,8 @@ int NumIterations(const RewriterConfig& cfg) {
 // Check if optimizer is allowed to run only once.
 bool IsRunOnceOptimizer(const string& name) {
   return name == "layout" || name == "memory_optimizer" ||
-         name == "loop_optimizer" || name == "auto_mixed_precision";
+         name == "loop_optimizer" || name == "auto_mixed_precision" ||
+         name == "peak_memory_scheduler";
 }
 
 // Creates a function library stub from a real function library: copy only
@@ -116,6 +125,84 @@ uint64 DeadlineMicroSeconds(const RewriterConfig& cfg) {
   }
 }
 
+int NumFunctionOptimizationThreads(const RewriterConfig& cfg) {
+  return cfg.function_optimization_threads() > 0
+             ? cfg.function_optimization_threads()
+             : std::min(port::MaxParallelism(),
+                        kMaxDefaultFunctionOptimizationThreads);
+}
+
+// Returns the names of the functions in `flib` called by the body of `func`,
+// either directly or through function attributes.
+absl::flat_hash_set<string> CalledFunctions(
+    const FunctionDef& func, const FunctionLibraryDefinition& flib) {
+  absl::flat_hash_set<string> called_funcs;
+  for (const NodeDef& node : func.node_def()) {
+    if (flib.Contains(node.op())) called_funcs.insert(node.op());
+    for (const auto& attr : node.attr()) {
+      if (attr.second.has_func()) {
+        called_funcs.insert(attr.second.func().name());
+      }
+      for (const NameAttrList& attr_func : attr.second.list().func()) {
+        called_funcs.insert(attr_func.name());
+      }
+    }
+  }
+  return called_funcs;
+}
+
+// Splits `funcs` into groups of functions that can be optimized concurrently.
+// A function comes in a later group than all the functions of `funcs` it
+// calls, so that it is optimized with the optimized bodies of its callees.
+// Functions that are part of a call cycle come in the last group. Functions
+// keep their relative order within a group.
+std::vector<std::vector<const FunctionDef*>> GroupIndependentFunctions(
+    const std::vector<const FunctionDef*>& funcs,
+    const FunctionLibraryDefinition& flib) {
+  absl::flat_hash_map<string, int> func_index;
+  for (int i = 0; i < funcs.size(); ++i) {
+    func_index[funcs[i]->signature().name()] = i;
+  }
+
+  std::vector<int> num_pending_callees(funcs.size(), 0);
+  std::vector<std::vector<int>> callers(funcs.size());
+  for (int i = 0; i < funcs.size(); ++i) {
+    for (const string& callee : CalledFunctions(*funcs[i], flib)) {
+      const int* callee_index = gtl::FindOrNull(func_index, callee);
+      if (callee_index == nullptr || *callee_index == i) continue;
+      ++num_pending_callees[i];
+      callers[*callee_index].push_back(i);
+    }
+  }
+
+  std::vector<std::vector<const FunctionDef*>> groups;
+  std::vector<bool> grouped(funcs.size(), false);
+  std::vector<int> ready;
+  for (int i = 0; i < funcs.size(); ++i) {
+    if (num_pending_callees[i] == 0) ready.push_back(i);
+  }
+  while (!ready.empty()) {
+    std::sort(ready.begin(), ready.end());
+    std::vector<int> next_ready;
+    groups.emplace_back();
+    for (int i : ready) {
+      groups.back().push_back(funcs[i]);
+      grouped[i] = true;
+      for (int caller : callers[i]) {
+        if (--num_pending_callees[caller] == 0) next_ready.push_back(caller);
+      }
+    }
+    ready.swap(next_ready);
+  }
+
+  std::vector<const FunctionDef*> recursive_funcs;
+  for (int i = 0; i < funcs.size(); ++i) {
+    if (!grouped[i]) recursive_funcs.push_back(funcs[i]);
+  }
+  if (!recursive_funcs.empty()) groups.push_back(std::move(recursive_funcs));
+  return groups;
+}
+
 // A helper function to decide whether to enable the automatic mixed precision
 // optimizer.
 bool AutoMixedPrecisionEnabled(RewriterConfig::Toggle opt_level) {
@@ -152,6 +239,10 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
                                       cfg_.scoped_allocator_opts()));
   MK_OPT("pin_to_host",
          new PinToHostOptimizer(cfg_.pin_to_host_optimization()));
+  MK_OPT("peak_memory_scheduler",
+         new PeakMemoryScheduler(
+             cfg_.peak_memory_scheduling(),
+             cfg_.peak_memory_scheduling_max_critical_path_ratio()));
 
   return std::unique_ptr<GraphOptimizer>();
 }
@@ -227,6 +318,11 @@ Status MetaOptimizer::InitializeOptimizers(
           cfg_.memory_optimizer_target_node_name_scope()));
     }
   }
+  if (cfg_.peak_memory_scheduling() == RewriterConfig::ON) {
+    optimizers->push_back(MakeUnique<PeakMemoryScheduler>(
+        cfg_.peak_memory_scheduling(),
+        cfg_.peak_memory_scheduling_max_critical_path_ratio()));
+  }
   if (cfg_.auto_parallel().enable()) {
     optimizers->push_back(
         MakeUnique<AutoParallel>(cfg_.auto_parallel().num_replicas()));
@@ -472,8 +568,11 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
                                      return result.status.ok();
                                    }) != optimization_result.results.end();
 
-  // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  // Record graph optimization result. Functions may be optimized concurrently.
+  {
+    mutex_lock l(optimization_results_mu_);
+    optimization_results_.push_back(optimization_result);
+  }
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -515,13 +614,15 @@ Status MetaOptimizer::RunOptimizer(
   const float duration_ms = (end_us - start_us) / 1000.0f;
 
   string message;
+  string summary = optimizer->ResultSummary();
+  if (!summary.empty()) summary = strings::StrCat(summary, ", ");
   if (!status.ok()) {
     optimized_graph->Swap(&optimized_item->graph);
     if (errors::IsAborted(status)) {
       // By convention we (ab-)use the Aborted error code to signal that the
       // optimizer returned without performing any changes to the graph.
-      message = strings::StrCat(optimizer->name(),
-                                " did nothing. time = ", duration_ms, "ms.");
+      message = strings::StrCat(optimizer->name(), " did nothing. ", summary,
+                                "time = ", duration_ms, "ms.");
       // Swallow the non-critical error.
       status = Status::OK();
     } else if (errors::IsDeadlineExceeded(status)) {
@@ -534,8 +635,8 @@ Status MetaOptimizer::RunOptimizer(
     }
   } else {
     message = strings::StrCat(
-        PrintSizesBeforeAfter(optimized_item->graph, *optimized_graph),
-        ", time = ", duration_ms, "ms.");
+        PrintSizesBeforeAfter(optimized_item->graph, *optimized_graph), ", ",
+        summary, "time = ", duration_ms, "ms.");
     VLOG(1) << optimizer->name() << ": " << message;
   }
 
@@ -552,11 +653,91 @@ Status MetaOptimizer::RunOptimizer(
   return Status::OK();
 }
 
+bool MetaOptimizer::UsesCustomOptimizers() const {
+  if (!cfg_.custom_optimizers().empty()) {
+    return true;
+  }
+  for (const string& optimizer_name : cfg_.optimizers()) {
+    if (!MakeNewOptimizer(optimizer_name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool MetaOptimizer::ResultsAreCacheable() const {
+  // Custom optimizers may depend on state that is not part of the cache key.
+  return !UsesCustomOptimizers();
+}
+
 Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                GraphDef* optimized_graph) {
   VLOG(1) << "Starting optimization for grappler item: " << item.id;
   optimization_results_.clear();
 
+  if (cfg_.meta_optimizer_cache_dir().empty() || !ResultsAreCacheable()) {
+    return OptimizeMainGraphAndFunctions(cluster, item, optimized_graph);
+  }
+
+  MetaOptimizerCache cache(Env::Default(), cfg_.meta_optimizer_cache_dir());
+  const Fprint128 cache_key = MetaOptimizerCache::Key(item, cfg_, cluster);
+  GraphOptimizationResult cache_result(item.id);
+
+  int64 optimization_time_us = 0;
+  Status status =
+      cache.Lookup(cache_key, optimized_graph, &optimization_time_us);
+  if (status.ok()) {
+    VLOG(1) << "Found grappler item " << item.id
+            << " in the MetaOptimizer cache.";
+    cache_result.results.push_back(
+        {"meta_optimizer_cache",
+         strings::StrCat("hit, time saved = ", optimization_time_us / 1000.0f,
+                         "ms."),
+         Status::OK()});
+    optimization_results_.push_back(cache_result);
+    return Status::OK();
+  }
+  if (!errors::IsNotFound(status)) {
+    LOG(WARNING) << "Ignoring MetaOptimizer cache entry: " << status;
+  }
+
+  const uint64 start_us = Env::Default()->NowMicros();
+  TF_RETURN_IF_ERROR(
+      OptimizeMainGraphAndFunctions(cluster, item, optimized_graph));
+  optimization_time_us = Env::Default()->NowMicros() - start_us;
+
+  // Optimizers that failed, e.g. because they ran out of time, might succeed
+  // when the graph is optimized again.
+  bool all_optimizers_succeeded = true;
+  for (const GraphOptimizationResult& graph_result : optimization_results_) {
+    for (const OptimizerResult& result : graph_result.results) {
+      all_optimizers_succeeded &= result.status.ok();
+    }
+  }
+
+  string message;
+  status = Status::OK();
+  if (!all_optimizers_succeeded) {
+    message = "miss, not cached since an optimizer failed.";
+  } else {
+    status = cache.Insert(cache_key, *optimized_graph, optimization_time_us);
+    if (status.ok()) {
+      message = strings::StrCat("miss, time = ", optimization_time_us / 1000.0f,
+                                "ms.");
+    } else {
+      message = strings::StrCat("miss, failed to cache the result: ",
+                                status.ToString());
+      LOG(WARNING) << "Failed to insert grappler item " << item.id
+                   << " into the MetaOptimizer cache: " << status;
+    }
+  }
+  cache_result.results.push_back({"meta_optimizer_cache", message, status});
+  optimization_results_.push_back(cache_result);
+  return Status::OK();
+}
+
+Status MetaOptimizer::OptimizeMainGraphAndFunctions(
+    Cluster* cluster, const GrapplerItem& item, GraphDef* optimized_graph) {
   // Constructs a FunctionLibraryDefinition with functions that are reachable
   // from the nodes of the graph.
   const auto minimized_flib =
@@ -635,6 +816,92 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     find_xla_compiled_functions(function.node_def());
   }
 
+  // Optimizes the body of a function into `optimized_func_graph`. Independent
+  // functions are optimized concurrently, so this must only read `flib`.
+  const auto optimize_function =
+      [&](const FunctionDef& func, GrapplerFunctionItem* func_item,
+          GraphDef* optimized_func_graph) -> Status {
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+
+    const string& func_name = func.signature().name();
+
+    // Make a GrapplerItem from a FunctionDef.
+    TF_RETURN_IF_ERROR(MakeGrapplerFunctionItem(
+        func, flib, trimmed_item.graph.versions().producer(), func_item));
+
+    // If we need to compute the gradient of optimized function at runtime, we
+    // can't perform non-differentiable rewrites.
+    func_item->optimization_options().allow_non_differentiable_rewrites =
+        !differentiable_functions.contains(func_name);
+
+    // Device set available to the function is defined only by the runtime,
+    // when we instantiate and execute the function. We can't use all devices
+    // available to the main graph, because after partitioning the function
+    // call node might execute on a remote worker.
+    if (!func_item->devices().empty()) {
+      return errors::Internal("GrapplerFunctionItem devices must be empty.");
+    }
+
+    // We are not allowed to prune certain types of ops from the graph
+    // instantiated by the function definition, because we must guarantee
+    // function execution semantics wrt side effects (see
+    // function_optimizer.cc).
+    func_item->optimization_options().allow_pruning_stateful_and_dataset_ops =
+        false;
+
+    // TODO(b/129545186): Shape inference in GraphProperties doesn't work well
+    // with _Arg nodes. Replace them with Placeholders with unknown shape.
+    absl::flat_hash_set<absl::string_view> input_nodes;
+    for (auto& input_arg : func_item->inputs()) {
+      input_nodes.insert(input_arg.node_name);
+    }
+    for (NodeDef& func_node : *func_item->graph.mutable_node()) {
+      if (input_nodes.contains(func_node.name())) {
+        func_node.set_op("Placeholder");
+        auto& attrs = *func_node.mutable_attr();
+        attrs["dtype"] = attrs["T"];
+        attrs.erase("index");
+        attrs.erase("T");
+        TensorShapeProto unknown_shape;
+        unknown_shape.set_unknown_rank(true);
+        *(attrs["shape"].mutable_shape()) = unknown_shape;
+      }
+    }
+
+    // Optimize function body graph.
+    if (IsTPUGraphDef(*optimized_graph)) {
+      // Skip optimizing functions if this is a TPU graph. Currently, Grappler
+      // passes do not handle TPU functions correctly in a variety of ways
+      // (Note that due to the pre-placement TPU graph rewriting passes, the
+      // TPU-related ops are encapsulated away into functions). For example,
+      // TPU graphs contain TPUReplicateMetadata node that carries relevant
+      // TPU metadata and Grappler passes could prune that away. Grappler
+      // passes could also cause issues around shape inference. Since the
+      // desired and existing behavior is to not optimize TPU functions with
+      // Grappler, this check preserves that. The only execption is
+      // implementation selector what is required to swap in some TPU specific
+      // lowering code and is verified the work correctly on TPUs.
+      ImplementationSelector implementation_selector;
+
+      // Implementation selector needs to have access to valid function
+      // signature and attributes, and it doesn't need actual function body.
+      FunctionDefLibrary func_item_function_library;
+      func_item_function_library.Swap(func_item->graph.mutable_library());
+      *func_item->graph.mutable_library() =
+          GetFunctionDefLibraryStub(func_item_function_library);
+
+      return implementation_selector.Optimize(cluster, *func_item,
+                                              optimized_func_graph);
+    }
+    return OptimizeGraph(cluster, *func_item, optimized_func_graph);
+  };
+
+  // Functions are optimized on a bounded thread pool, created on first use.
+  // Custom optimizers are not known to be safe to run concurrently.
+  const int num_threads =
+      UsesCustomOptimizers() ? 1 : NumFunctionOptimizationThreads(cfg_);
+  std::unique_ptr<thread::ThreadPool> thread_pool;
+
   // Optimize each function only once.
   absl::flat_hash_set<string> optimized_funcs;
   bool optimize_function_library =
@@ -643,10 +910,8 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   while (optimize_function_library) {
     optimize_function_library = false;
 
-    int function_idx = 0;
+    std::vector<const FunctionDef*> funcs_to_optimize;
     for (const FunctionDef& func : optimized_graph->library().function()) {
-      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
-
       const string& func_name = func.signature().name();
 
       // Skip functions that are not reachable from the optimized graph.
@@ -662,105 +927,72 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
       // the function optimizer, before we can optimize function body.
       if (IsParametrized(func)) continue;
 
-      VLOG(3) << "Optimize function: function=" << func_name << " ["
-              << function_idx++ << " of "
-              << optimized_graph->library().function_size() << "]";
-
-      // Function optimization might specialize nested function calls, so we
-      // have to reset the flag and do at least one more pass over the library.
-      optimize_function_library = true;
-      optimized_funcs.insert(func_name);
-
-      // Make a GrapplerItem from a FunctionDef.
-      GrapplerFunctionItem func_item;
-      TF_RETURN_IF_ERROR(MakeGrapplerFunctionItem(
-          func, flib, trimmed_item.graph.versions().producer(), &func_item));
-
-      // If we need to compute the gradient of optimized function at runtime, we
-      // can't perform non-differentiable rewrites.
-      func_item.optimization_options().allow_non_differentiable_rewrites =
-          !differentiable_functions.contains(func_name);
-
-      // Device set available to the function is defined only by the runtime,
-      // when we instantiate and execute the function. We can't use all devices
-      // available to the main graph, because after partitioning the function
-      // call node might execute on a remote worker.
-      if (!func_item.devices().empty()) {
-        return errors::Internal("GrapplerFunctionItem devices must be empty.");
-      }
+      funcs_to_optimize.push_back(&func);
+    }
 
-      // We are not allowed to prune certain types of ops from the graph
-      // instantiated by the function definition, because we must guarantee
-      // function execution semantics wrt side effects (see
-      // function_optimizer.cc).
-      func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
-          false;
-
-      // TODO(b/129545186): Shape inference in GraphProperties doesn't work well
-      // with _Arg nodes. Replace them with Placeholders with unknown shape.
-      absl::flat_hash_set<absl::string_view> input_nodes;
-      for (auto& input_arg : func_item.inputs()) {
-        input_nodes.insert(input_arg.node_name);
-      }
-      for (NodeDef& func_node : *func_item.graph.mutable_node()) {
-        if (input_nodes.contains(func_node.name())) {
-          func_node.set_op("Placeholder");
-          auto& attrs = *func_node.mutable_attr();
-          attrs["dtype"] = attrs["T"];
-          attrs.erase("index");
-          attrs.erase("T");
-          TensorShapeProto unknown_shape;
-          unknown_shape.set_unknown_rank(true);
-          *(attrs["shape"].mutable_shape()) = unknown_shape;
-        }
+    int function_idx = 0;
+    for (const std::vector<const FunctionDef*>& funcs :
+         GroupIndependentFunctions(funcs_to_optimize, flib)) {
+      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+
+      for (const FunctionDef* func : funcs) {
+        VLOG(3) << "Optimize function: function=" << func->signature().name()
+                << " [" << function_idx++ << " of "
+                << optimized_graph->library().function_size() << "]";
       }
 
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      if (IsTPUGraphDef(*optimized_graph)) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only execption is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-
-        // Implementation selector needs to have access to valid function
-        // signature and attributes, and it doesn't need actual function body.
-        FunctionDefLibrary func_item_function_library;
-        func_item_function_library.Swap(func_item.graph.mutable_library());
-        *func_item.graph.mutable_library() =
-            GetFunctionDefLibraryStub(func_item_function_library);
-
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
+      std::vector<GrapplerFunctionItem> func_items(funcs.size());
+      std::vector<GraphDef> optimized_func_graphs(funcs.size());
+      std::vector<Status> statuses(funcs.size());
+      if (num_threads <= 1 || funcs.size() <= 1) {
+        for (int i = 0; i < funcs.size(); ++i) {
+          statuses[i] = optimize_function(*funcs[i], &func_items[i],
+                                          &optimized_func_graphs[i]);
+        }
       } else {
-        TF_RETURN_IF_ERROR(
-            OptimizeGraph(cluster, func_item, &optimized_func_graph));
+        if (thread_pool == nullptr) {
+          thread_pool.reset(new thread::ThreadPool(
+              Env::Default(), "meta_optimizer_functions", num_threads));
+        }
+        BlockingCounter counter(funcs.size());
+        for (int i = 0; i < funcs.size(); ++i) {
+          thread_pool->Schedule([&, i]() {
+            statuses[i] = optimize_function(*funcs[i], &func_items[i],
+                                            &optimized_func_graphs[i]);
+            counter.DecrementCount();
+          });
+        }
+        counter.Wait();
       }
 
-      // Function body optimization might have created new specialized
-      // functions for each instantiation context. Add them to the library.
-      for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
-        if (flib.Find(func_def.signature().name()) == nullptr) {
-          TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+      // Merge the optimized functions back in a deterministic order.
+      for (int i = 0; i < funcs.size(); ++i) {
+        TF_RETURN_IF_ERROR(statuses[i]);
+        const string& func_name = funcs[i]->signature().name();
+
+        // Function optimization might specialize nested function calls, so we
+        // have to do at least one more pass over the library.
+        optimize_function_library = true;
+        optimized_funcs.insert(func_name);
+
+        // Function body optimization might have created new specialized
+        // functions for each instantiation context. Add them to the library.
+        for (const FunctionDef& func_def :
+             optimized_func_graphs[i].library().function()) {
+          if (flib.Find(func_def.signature().name()) == nullptr) {
+            TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+          }
         }
-      }
 
-      // Convert optimized graph back to FunctionDef.
-      FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
+        // Convert optimized graph back to FunctionDef.
+        FunctionDef optimized_func;
+        func_items[i].SwapFunctionBody(std::move(optimized_func_graphs[i]));
+        TF_RETURN_IF_ERROR(
+            MakeFunctionDef(func_items[i], flib, &optimized_func));
 
-      // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
+        // Replace optimized function with a new FunctionDef.
+        TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
+      }
     }
 
     // If optimized at least one function, update the graph library.
@@ -790,6 +1022,21 @@ void MetaOptimizer::PrintResult() {
   }
 }
 
+std::vector<string> MetaOptimizer::GetResultMessages(
+    const string& item_id, const string& optimizer_name) {
+  std::vector<string> messages;
+  mutex_lock l(optimization_results_mu_);
+  for (const GraphOptimizationResult& graph_result : optimization_results_) {
+    if (graph_result.id != item_id) continue;
+    for (const OptimizerResult& result : graph_result.results) {
+      if (result.optimizer_name == optimizer_name) {
+        messages.push_back(result.message);
+      }
+    }
+  }
+  return messages;
+}
+
 void MetaOptimizer::Feedback(Cluster* cluster, const GrapplerItem& item,
                              const GraphDef& optimized_graph, double result) {
   // Nothing to do for MetaOptimizer.
@@ -814,6 +1061,7 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
          rewrite_cfg.debug_stripper() == RewriterConfig::ON ||
          rewrite_cfg.scoped_allocator_optimization() == RewriterConfig::ON ||
          rewrite_cfg.pin_to_host_optimization() == RewriterConfig::ON ||
+         rewrite_cfg.peak_memory_scheduling() == RewriterConfig::ON ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision()) ||
          !rewrite_cfg.optimizers().empty() ||
          !rewrite_cfg.custom_optimizers().empty();
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/grappler/verifiers/graph_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/protobuf/verifier_config.pb.h"
@@ -46,6 +47,11 @@ class MetaOptimizer : public GraphOptimizer {
 
   void PrintResult();
 
+  // Returns the result messages recorded by `optimizer_name` for the grappler
+  // item with id `item_id`, in the order the optimizer ran.
+  std::vector<string> GetResultMessages(const string& item_id,
+                                        const string& optimizer_name);
+
   void Feedback(Cluster* cluster, const GrapplerItem& item,
                 const GraphDef& optimized_graph, double result) override;
 
@@ -78,6 +84,20 @@ class MetaOptimizer : public GraphOptimizer {
   Status OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
                        GraphDef* optimized_graph);
 
+  // Optimize the main graph of the item, and then all the functions reachable
+  // from the optimized graph. Functions that don't call each other are
+  // optimized concurrently. Results are not cached.
+  Status OptimizeMainGraphAndFunctions(Cluster* cluster,
+                                       const GrapplerItem& item,
+                                       GraphDef* optimized_graph);
+
+  // Returns true if any of the configured optimizers is a custom one.
+  bool UsesCustomOptimizers() const;
+
+  // Returns true if the results of optimizing a GrapplerItem can be stored in
+  // the MetaOptimizer cache.
+  bool ResultsAreCacheable() const;
+
   DeviceBase* const cpu_device_;  // may be NULL
   ConfigProto config_proto_;
   RewriterConfig& cfg_;
@@ -98,6 +118,9 @@ class MetaOptimizer : public GraphOptimizer {
                       GrapplerItem* optimized_item, GraphDef* optimized_graph,
                       GraphOptimizationResult* optimization_result);
 
+  // Guards the results recorded by OptimizeGraph while functions are
+  // optimized concurrently.
+  mutex optimization_results_mu_;
   std::vector<GraphOptimizationResult> optimization_results_;
 };
 
@@ -0,0 +1,187 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/meta_optimizer_cache.h"
+
+#include <algorithm>
+#include <map>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/protobuf/meta_optimizer_cache.pb.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Must be incremented whenever the format of the entries or the contents of
+// the key change.
+constexpr int kCacheEntryVersion = 1;
+
+// Appends a length-prefixed field to `key`, so that different sequences of
+// fields never produce the same key.
+void AppendField(StringPiece field, string* key) {
+  strings::StrAppend(key, field.size(), ":", field, ";");
+}
+
+void AppendProto(const protobuf::MessageLite& proto, string* key) {
+  string serialized;
+  SerializeToStringDeterministic(proto, &serialized);
+  AppendField(serialized, key);
+}
+
+void AppendStrings(const std::vector<string>& fields, string* key) {
+  AppendField(strings::StrCat(fields.size()), key);
+  for (const string& field : fields) {
+    AppendField(field, key);
+  }
+}
+
+void AppendBool(bool field, string* key) {
+  AppendField(field ? "1" : "0", key);
+}
+
+}  // namespace
+
+MetaOptimizerCache::MetaOptimizerCache(Env* env, const string& cache_dir)
+    : env_(env), cache_dir_(cache_dir) {}
+
+/*static*/ Fprint128 MetaOptimizerCache::Key(const GrapplerItem& item,
+                                             const RewriterConfig& cfg,
+                                             const Cluster* cluster) {
+  string key;
+  AppendField(strings::StrCat(kCacheEntryVersion), &key);
+  // Optimizers change between builds; never reuse results of another build.
+  AppendField(TF_VERSION_STRING, &key);
+  AppendField(tf_git_version(), &key);
+
+  AppendProto(item.graph, &key);
+  AppendField(strings::StrCat(item.feed.size()), &key);
+  for (const auto& feed : item.feed) {
+    AppendField(feed.first, &key);
+    AppendField(DataTypeString(feed.second.dtype()), &key);
+    AppendField(feed.second.shape().DebugString(), &key);
+  }
+  AppendStrings(item.fetch, &key);
+  AppendStrings(item.init_ops, &key);
+  AppendStrings(item.keep_ops, &key);
+  AppendField(item.save_op, &key);
+  AppendField(item.restore_op, &key);
+  AppendField(item.save_restore_loc_tensor, &key);
+  AppendField(strings::StrCat(item.queue_runners.size()), &key);
+  for (const QueueRunnerDef& queue_runner : item.queue_runners) {
+    AppendProto(queue_runner, &key);
+  }
+
+  std::vector<string> devices(item.devices().begin(), item.devices().end());
+  std::sort(devices.begin(), devices.end());
+  AppendStrings(devices, &key);
+
+  const GrapplerItem::OptimizationOptions& options =
+      item.optimization_options();
+  AppendBool(options.allow_non_differentiable_rewrites, &key);
+  AppendBool(options.allow_pruning_stateful_and_dataset_ops, &key);
+  AppendBool(options.optimize_function_library, &key);
+  AppendBool(options.is_eager_mode, &key);
+
+  // Neither the location of the cache, the deadline nor the number of threads
+  // change the optimized graph. Results of optimizations that missed the
+  // deadline aren't cached.
+  RewriterConfig key_cfg = cfg;
+  key_cfg.clear_meta_optimizer_cache_dir();
+  key_cfg.clear_meta_optimizer_timeout_ms();
+  key_cfg.clear_function_optimization_threads();
+  AppendProto(key_cfg, &key);
+
+  if (cluster != nullptr) {
+    const std::map<string, DeviceProperties> cluster_devices(
+        cluster->GetDevices().begin(), cluster->GetDevices().end());
+    AppendField(strings::StrCat(cluster_devices.size()), &key);
+    for (const auto& device : cluster_devices) {
+      AppendField(device.first, &key);
+      AppendProto(device.second, &key);
+    }
+  }
+
+  return Fingerprint128(key);
+}
+
+Status MetaOptimizerCache::Lookup(const Fprint128& key,
+                                  GraphDef* optimized_graph,
+                                  int64* optimization_time_us) const {
+  const string path = EntryPath(key);
+  TF_RETURN_IF_ERROR(env_->FileExists(path));
+
+  MetaOptimizerCacheEntry entry;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(env_, path, &entry));
+  if (entry.version() != kCacheEntryVersion) {
+    return errors::FailedPrecondition("MetaOptimizer cache entry ", path,
+                                      " has version ", entry.version(),
+                                      ", expected ", kCacheEntryVersion);
+  }
+  if (entry.fingerprint_low64() != key.low64 ||
+      entry.fingerprint_high64() != key.high64) {
+    return errors::DataLoss("MetaOptimizer cache entry ", path,
+                            " has a mismatching fingerprint");
+  }
+
+  optimized_graph->Swap(entry.mutable_optimized_graph());
+  *optimization_time_us = entry.optimization_time_us();
+  return Status::OK();
+}
+
+Status MetaOptimizerCache::Insert(const Fprint128& key,
+                                  const GraphDef& optimized_graph,
+                                  int64 optimization_time_us) const {
+  TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(cache_dir_));
+
+  MetaOptimizerCacheEntry entry;
+  entry.set_version(kCacheEntryVersion);
+  entry.set_fingerprint_low64(key.low64);
+  entry.set_fingerprint_high64(key.high64);
+  *entry.mutable_optimized_graph() = optimized_graph;
+  entry.set_optimization_time_us(optimization_time_us);
+
+  // Readers in other processes must never see a partially written entry.
+  // Processes inserting the same key write equivalent entries, so it doesn't
+  // matter which rename happens last.
+  const string path = EntryPath(key);
+  string tmp_path = path;
+  if (!env_->CreateUniqueFileName(&tmp_path, ".tmp")) {
+    return errors::Internal("Failed to create a temporary file name for ",
+                            path);
+  }
+  TF_RETURN_IF_ERROR(WriteBinaryProto(env_, tmp_path, entry));
+  Status s = env_->RenameFile(tmp_path, path);
+  if (!s.ok()) {
+    env_->DeleteFile(tmp_path).IgnoreError();
+  }
+  return s;
+}
+
+string MetaOptimizerCache::EntryPath(const Fprint128& key) const {
+  return io::JoinPath(
+      cache_dir_, strings::StrCat(strings::Hex(key.high64, strings::kZeroPad16),
+                                  strings::Hex(key.low64, strings::kZeroPad16),
+                                  ".pb"));
+}
+
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,67 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_CACHE_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_CACHE_H_
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// A persistent cache of MetaOptimizer results in a local directory.
+//
+// Entries are keyed by a fingerprint of everything the optimized graph depends
+// on: the GrapplerItem (graph, feeds, fetches, preserved nodes, devices and
+// optimization options), the RewriterConfig, the devices of the cluster and
+// the TensorFlow version. Each entry is a separate file that is written under a
+// temporary name and renamed into place, so that several processes can share
+// the same directory.
+class MetaOptimizerCache {
+ public:
+  MetaOptimizerCache(Env* env, const string& cache_dir);
+
+  // Returns the key of the result of optimizing `item` with `cfg` for
+  // `cluster`, which may be null.
+  static Fprint128 Key(const GrapplerItem& item, const RewriterConfig& cfg,
+                       const Cluster* cluster);
+
+  // Looks up the optimized graph of `key`, and the time it took to optimize
+  // it. Returns NotFound if there is no entry, and another error if the entry
+  // can't be used.
+  Status Lookup(const Fprint128& key, GraphDef* optimized_graph,
+                int64* optimization_time_us) const;
+
+  // Stores the optimized graph of `key`, replacing any existing entry.
+  Status Insert(const Fprint128& key, const GraphDef& optimized_graph,
+                int64 optimization_time_us) const;
+
+ private:
+  string EntryPath(const Fprint128& key) const;
+
+  Env* const env_;
+  const string cache_dir_;
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_CACHE_H_
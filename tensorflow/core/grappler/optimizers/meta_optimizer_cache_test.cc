@@ -0,0 +1,135 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/meta_optimizer_cache.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+GrapplerItem MakeItem() {
+  Scope s = Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a"), 1.0f, {});
+  Output b = ops::Const(s.WithOpName("b"), 2.0f, {});
+  Output c = ops::Add(s.WithOpName("c"), a, b);
+  (void)c;
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"c"};
+  return item;
+}
+
+string CacheDir(const string& name) {
+  return io::JoinPath(testing::TmpDir(), "meta_optimizer_cache", name);
+}
+
+TEST(MetaOptimizerCacheTest, KeyIsStable) {
+  RewriterConfig cfg;
+  EXPECT_EQ(MetaOptimizerCache::Key(MakeItem(), cfg, nullptr),
+            MetaOptimizerCache::Key(MakeItem(), cfg, nullptr));
+}
+
+TEST(MetaOptimizerCacheTest, KeyDependsOnItemAndConfig) {
+  RewriterConfig cfg;
+  const GrapplerItem item = MakeItem();
+  const Fprint128 key = MetaOptimizerCache::Key(item, cfg, nullptr);
+
+  GrapplerItem other_fetch = item;
+  other_fetch.fetch = {"a"};
+  EXPECT_FALSE(key == MetaOptimizerCache::Key(other_fetch, cfg, nullptr));
+
+  GrapplerItem other_graph = item;
+  other_graph.graph.mutable_node(0)->set_name("d");
+  EXPECT_FALSE(key == MetaOptimizerCache::Key(other_graph, cfg, nullptr));
+
+  GrapplerItem other_options = item;
+  other_options.optimization_options().optimize_function_library = false;
+  EXPECT_FALSE(key == MetaOptimizerCache::Key(other_options, cfg, nullptr));
+
+  RewriterConfig other_cfg;
+  other_cfg.set_constant_folding(RewriterConfig::OFF);
+  EXPECT_FALSE(key == MetaOptimizerCache::Key(item, other_cfg, nullptr));
+}
+
+TEST(MetaOptimizerCacheTest, KeyIgnoresCacheDirTimeoutAndThreads) {
+  RewriterConfig cfg;
+  const GrapplerItem item = MakeItem();
+  const Fprint128 key = MetaOptimizerCache::Key(item, cfg, nullptr);
+
+  cfg.set_meta_optimizer_cache_dir("/some/dir");
+  cfg.set_meta_optimizer_timeout_ms(1000);
+  cfg.set_function_optimization_threads(4);
+  EXPECT_EQ(key, MetaOptimizerCache::Key(item, cfg, nullptr));
+}
+
+TEST(MetaOptimizerCacheTest, LookupMissingEntry) {
+  MetaOptimizerCache cache(Env::Default(), CacheDir("missing"));
+  GraphDef graph;
+  int64 optimization_time_us = 0;
+  const Fprint128 key =
+      MetaOptimizerCache::Key(MakeItem(), RewriterConfig(), nullptr);
+  EXPECT_TRUE(errors::IsNotFound(
+      cache.Lookup(key, &graph, &optimization_time_us)));
+}
+
+TEST(MetaOptimizerCacheTest, InsertAndLookup) {
+  MetaOptimizerCache cache(Env::Default(), CacheDir("insert"));
+  const GrapplerItem item = MakeItem();
+  const Fprint128 key = MetaOptimizerCache::Key(item, RewriterConfig(), nullptr);
+  TF_ASSERT_OK(cache.Insert(key, item.graph, /*optimization_time_us=*/1234));
+
+  // A second instance sharing the directory sees the entry.
+  MetaOptimizerCache other_cache(Env::Default(), CacheDir("insert"));
+  GraphDef graph;
+  int64 optimization_time_us = 0;
+  TF_ASSERT_OK(other_cache.Lookup(key, &graph, &optimization_time_us));
+  EXPECT_EQ(graph.DebugString(), item.graph.DebugString());
+  EXPECT_EQ(optimization_time_us, 1234);
+
+  std::vector<string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(CacheDir("insert"), &children));
+  EXPECT_EQ(children.size(), 1);
+}
+
+TEST(MetaOptimizerCacheTest, LookupCorruptedEntry) {
+  MetaOptimizerCache cache(Env::Default(), CacheDir("corrupted"));
+  const GrapplerItem item = MakeItem();
+  const Fprint128 key = MetaOptimizerCache::Key(item, RewriterConfig(), nullptr);
+  TF_ASSERT_OK(cache.Insert(key, item.graph, /*optimization_time_us=*/0));
+
+  std::vector<string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(CacheDir("corrupted"), &children));
+  ASSERT_EQ(children.size(), 1);
+  TF_ASSERT_OK(WriteStringToFile(
+      Env::Default(), io::JoinPath(CacheDir("corrupted"), children[0]),
+      "not a cache entry"));
+
+  GraphDef graph;
+  int64 optimization_time_us = 0;
+  Status status = cache.Lookup(key, &graph, &optimization_time_us);
+  EXPECT_FALSE(status.ok());
+  EXPECT_FALSE(errors::IsNotFound(status));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -15,23 +15,31 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
+#include <unordered_map>
+
 #include "absl/strings/match.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/inputs/trivial_test_graph_input_yielder.h"
 #include "tensorflow/core/grappler/optimizers/custom_graph_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/optimizers/meta_optimizer_cache.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -134,6 +142,46 @@ REGISTER_GRAPH_OPTIMIZER(GrapplerItemPropertiesAccumulator);
 
 class MetaOptimizerTest : public GrapplerTest {};
 
+// Returns an item calling `num_funcs` functions. Every odd function calls the
+// previous function, so that the library has two levels of calls.
+GrapplerItem MakeItemWithFunctionLibrary(int num_funcs) {
+  using test::function::NDef;
+
+  std::vector<FunctionDef> funcs;
+  std::vector<NodeDef> nodes = {
+      NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice)};
+  for (int i = 0; i < num_funcs; ++i) {
+    std::vector<FunctionDefHelper::Node> body = {
+        {{"a"}, "Mul", {"x", "x"}, {{"T", DT_FLOAT}}},
+        {{"b"}, "Add", {"a:z:0", "x"}, {{"T", DT_FLOAT}}},
+        {{"c"}, "Mul", {"b:z:0", "b:z:0"}, {{"T", DT_FLOAT}}},
+        {{"d"}, "Identity", {"c:z:0"}, {{"T", DT_FLOAT}}}};
+    string ret = "d:output:0";
+    if (i % 2 == 1) {
+      body.push_back({{"call"}, strings::StrCat("MyFunc", i - 1), {ret}, {}});
+      ret = "call:z:0";
+    }
+    funcs.push_back(FunctionDefHelper::Create(
+        strings::StrCat("MyFunc", i), {"x:float"}, {"z:float"}, {}, body,
+        /*ret_def=*/{{"z", ret}}));
+    (*funcs.back().mutable_attr())["_noinline"].set_b(true);
+
+    const string call = strings::StrCat("call", i);
+    nodes.push_back(
+        NDef(call, strings::StrCat("MyFunc", i), {"x"}, {}, kDevice));
+    nodes.push_back(NDef(strings::StrCat("out", i), "Identity", {call},
+                         {{"T", DT_FLOAT}}, kDevice));
+  }
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.graph = test::function::GDef(nodes, funcs);
+  for (int i = 0; i < num_funcs; ++i) {
+    item.fetch.push_back(strings::StrCat("out", i));
+  }
+  return item;
+}
+
 TEST_F(MetaOptimizerTest, RunsCustomOptimizer) {
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
   GrapplerItem item;
@@ -1009,6 +1057,180 @@ TEST_F(MetaOptimizerTest, CompressConstants) {
   }
 }
 
+TEST_F(MetaOptimizerTest, ReusesCachedResult) {
+  TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
+  GrapplerItem item;
+  ASSERT_TRUE(fake_input.NextItem(&item));
+
+  const string cache_dir =
+      io::JoinPath(testing::TmpDir(), "meta_optimizer_reuses_cached_result");
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.add_optimizers("pruning");
+  rewriter_config.add_optimizers("constfold");
+  rewriter_config.set_min_graph_nodes(-1);
+  rewriter_config.set_meta_optimizer_cache_dir(cache_dir);
+
+  GraphDef output;
+  TF_ASSERT_OK(RunMetaOptimizer(item, config_proto, nullptr, nullptr, &output));
+  std::vector<string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(cache_dir, &children));
+  EXPECT_EQ(children.size(), 1);
+
+  // Replace the cached result, so that a hit is observable in the output.
+  MetaOptimizerCache cache(Env::Default(), cache_dir);
+  GraphDef cached_graph = item.graph;
+  cached_graph.add_node()->set_name("from_cache");
+  TF_ASSERT_OK(cache.Insert(
+      MetaOptimizerCache::Key(item, rewriter_config, nullptr), cached_graph,
+      /*optimization_time_us=*/0));
+
+  GraphDef cached_output;
+  TF_ASSERT_OK(
+      RunMetaOptimizer(item, config_proto, nullptr, nullptr, &cached_output));
+  CompareGraphs(cached_graph, cached_output);
+}
+
+TEST_F(MetaOptimizerTest, DoesNotCacheCustomOptimizerResults) {
+  TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
+  GrapplerItem item;
+  ASSERT_TRUE(fake_input.NextItem(&item));
+
+  const string cache_dir = io::JoinPath(
+      testing::TmpDir(), "meta_optimizer_does_not_cache_custom_optimizers");
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.add_optimizers("TestOptimizer");
+  rewriter_config.set_min_graph_nodes(-1);
+  rewriter_config.set_meta_optimizer_cache_dir(cache_dir);
+
+  for (int i = 0; i < 2; ++i) {
+    TestOptimizer::SetOptimized(false);
+    MetaOptimizer optimizer(nullptr, config_proto);
+    GraphDef output;
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+    EXPECT_TRUE(TestOptimizer::IsOptimized());
+  }
+  EXPECT_TRUE(errors::IsNotFound(Env::Default()->FileExists(cache_dir)));
+}
+
+TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryConcurrently) {
+  GrapplerItem item = MakeItemWithFunctionLibrary(/*num_funcs=*/8);
+
+  std::vector<GraphDef> outputs;
+  for (int num_threads : {1, 4}) {
+    ConfigProto config_proto;
+    auto& rewriter_config =
+        *config_proto.mutable_graph_options()->mutable_rewrite_options();
+    rewriter_config.set_min_graph_nodes(-1);
+    rewriter_config.set_function_optimization_threads(num_threads);
+
+    MetaOptimizer optimizer(nullptr, config_proto);
+    outputs.emplace_back();
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &outputs.back()));
+  }
+
+  // Functions are merged back in the same order regardless of the number of
+  // threads.
+  CompareGraphs(outputs[0], outputs[1]);
+  ASSERT_EQ(outputs[0].library().function_size(),
+            outputs[1].library().function_size());
+  for (int i = 0; i < outputs[0].library().function_size(); ++i) {
+    CompareFunctions(outputs[0].library().function(i),
+                     outputs[1].library().function(i));
+  }
+
+  item.feed.emplace_back("x", test::AsScalar<float>(2.0f));
+  auto tensors_expected = EvaluateFetchNodes(item);
+  GrapplerItem optimized = item.WithGraph(std::move(outputs[1]));
+  auto tensors = EvaluateFetchNodes(optimized);
+  ASSERT_EQ(tensors_expected.size(), tensors.size());
+  for (int i = 0; i < tensors.size(); ++i) {
+    test::ExpectTensorEqual<float>(tensors_expected[i], tensors[i]);
+  }
+}
+
+TEST_F(MetaOptimizerTest, ReportsPeakMemoryScheduling) {
+  // Independent branches that each materialize a 4MB tensor, which the
+  // peak_memory_scheduler serializes.
+  constexpr char kCpuDevice[] = "/job:localhost/replica:0/task:0/cpu:0";
+  constexpr int kNumBranches = 4;
+  Scope s = Scope::NewRootScope().WithDevice(kCpuDevice);
+  Output dims = ops::Const(s.WithOpName("dims"), {1024, 1024}, {2});
+  Output value = ops::Const(s.WithOpName("value"), 1.0f, {});
+  Output axes = ops::Const(s.WithOpName("axes"), {0, 1}, {2});
+  std::vector<Output> sums;
+  for (int i = 0; i < kNumBranches; ++i) {
+    Output fill =
+        ops::Fill(s.WithOpName(strings::StrCat("fill", i)), dims, value);
+    Output sqrt = ops::Sqrt(s.WithOpName(strings::StrCat("sqrt", i)), fill);
+    sums.push_back(
+        ops::Sum(s.WithOpName(strings::StrCat("sum", i)), sqrt, axes));
+  }
+  Output total = ops::AddN(s.WithOpName("total"), sums);
+  (void)total;
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"total"};
+
+  DeviceProperties cpu_device;
+  cpu_device.set_type("CPU");
+  cpu_device.set_frequency(1000);
+  cpu_device.set_num_cores(4);
+  cpu_device.set_bandwidth(32);
+  cpu_device.set_memory_size(1024 * 1024 * 1024);
+  std::unordered_map<string, DeviceProperties> devices;
+  devices[kCpuDevice] = cpu_device;
+  VirtualCluster cluster(devices);
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.add_optimizers("peak_memory_scheduler");
+  rewriter_config.set_peak_memory_scheduling_max_critical_path_ratio(
+      kNumBranches + 1);
+  rewriter_config.set_min_graph_nodes(-1);
+
+  MetaOptimizer optimizer(nullptr, config_proto);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(&cluster, item, &output));
+
+  const std::vector<string> messages =
+      optimizer.GetResultMessages(item.id, "peak_memory_scheduler");
+  ASSERT_EQ(messages.size(), 1);
+  EXPECT_TRUE(absl::StrContains(messages[0], "estimated peak memory = "))
+      << messages[0];
+  EXPECT_TRUE(absl::StrContains(messages[0], " -> ")) << messages[0];
+}
+
+static void BM_OptimizeFunctionLibrary(int iters, int num_funcs,
+                                       int num_threads) {
+  testing::StopTiming();
+  GrapplerItem item = MakeItemWithFunctionLibrary(num_funcs);
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.set_min_graph_nodes(-1);
+  rewriter_config.set_function_optimization_threads(num_threads);
+
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    MetaOptimizer optimizer(nullptr, config_proto);
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+  }
+  testing::StopTiming();
+}
+BENCHMARK(BM_OptimizeFunctionLibrary)
+    ->ArgPair(16, 1)
+    ->ArgPair(16, 8)
+    ->ArgPair(256, 1)
+    ->ArgPair(256, 8);
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -0,0 +1,441 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/peak_memory_scheduler.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/costs/analytical_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/grappler/costs/virtual_scheduler.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+constexpr float kDefaultMaxCriticalPathRatio = 1.1f;
+
+// Execution of a graph as simulated by the VirtualScheduler.
+struct ExecutionEstimate {
+  // Highest peak memory usage of the devices, in bytes.
+  int64 peak_memory = 0;
+  // Run time of the whole graph.
+  Costs::Duration execution_time;
+  // Run time of each node of the graph, keyed by node name.
+  std::unordered_map<string, Costs::Duration> node_run_times;
+};
+
+Status EstimateExecution(Cluster* cluster, const GrapplerItem& item,
+                         ExecutionEstimate* estimate) {
+  AnalyticalCostEstimator estimator(cluster, /*use_static_shapes=*/true,
+                                    /*use_aggressive_shape_inference=*/false);
+  TF_RETURN_IF_ERROR(estimator.Initialize(item));
+  Costs costs;
+  TF_RETURN_IF_ERROR(
+      estimator.PredictCosts(item.graph, /*run_metadata=*/nullptr, &costs));
+  estimate->execution_time = costs.execution_time;
+
+  const VirtualScheduler* scheduler = estimator.GetScheduler();
+  for (const auto& device : scheduler->GetPeakMemoryUsage()) {
+    estimate->peak_memory = std::max(estimate->peak_memory, device.second);
+  }
+  for (const auto& node_state : *scheduler->GetNodeStates()) {
+    const NodeState& state = node_state.second;
+    if (state.time_finished == Costs::Duration::max()) continue;
+    estimate->node_run_times[node_state.first->name()] =
+        state.time_finished - state.time_scheduled;
+  }
+  return Status::OK();
+}
+
+// A tensor read by a node, possibly several times.
+struct TensorRead {
+  int node;
+  int port;
+  int num_reads;
+};
+
+// Connectivity of a graph, with the nodes identified by their index in the
+// GraphDef, and the sizes of the tensors they produce.
+struct ScheduleGraph {
+  // Inputs and outputs of each node, including control dependencies.
+  std::vector<std::vector<int>> fanins;
+  std::vector<std::vector<int>> fanouts;
+  // Tensors read by each node.
+  std::vector<std::vector<TensorRead>> reads;
+  // Size in bytes of each output of each node. Persistent tensors (constants
+  // and variables) don't count.
+  std::vector<std::vector<int64>> output_bytes;
+  // Number of times each output of each node is read.
+  std::vector<std::vector<int>> num_reads;
+};
+
+Status BuildScheduleGraph(const GraphDef& graph,
+                          const GraphProperties& properties,
+                          ScheduleGraph* schedule_graph) {
+  const int num_nodes = graph.node_size();
+  std::unordered_map<string, int> node_index;
+  node_index.reserve(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    node_index[graph.node(i).name()] = i;
+  }
+
+  schedule_graph->fanins.resize(num_nodes);
+  schedule_graph->fanouts.resize(num_nodes);
+  schedule_graph->reads.resize(num_nodes);
+  schedule_graph->output_bytes.resize(num_nodes);
+  schedule_graph->num_reads.resize(num_nodes);
+
+  for (int i = 0; i < num_nodes; ++i) {
+    const NodeDef& node = graph.node(i);
+    const std::vector<OpInfo::TensorProperties>& outputs =
+        properties.GetOutputProperties(node.name());
+    for (const OpInfo::TensorProperties& output : outputs) {
+      schedule_graph->output_bytes[i].push_back(
+          IsPersistent(node) ? 0 : CalculateTensorSize(output));
+    }
+    schedule_graph->num_reads[i].resize(outputs.size(), 0);
+  }
+
+  for (int i = 0; i < num_nodes; ++i) {
+    const NodeDef& node = graph.node(i);
+    for (const string& input : node.input()) {
+      int port;
+      const string input_name = ParseNodeName(input, &port);
+      auto it = node_index.find(input_name);
+      if (it == node_index.end()) {
+        return errors::InvalidArgument("Input ", input, " of node ",
+                                       node.name(), " is not in the graph");
+      }
+      const int fanin = it->second;
+      schedule_graph->fanins[i].push_back(fanin);
+      schedule_graph->fanouts[fanin].push_back(i);
+      if (port < 0) continue;
+
+      // Outputs without properties are assumed to be empty.
+      std::vector<int>& num_reads = schedule_graph->num_reads[fanin];
+      if (port >= num_reads.size()) {
+        num_reads.resize(port + 1, 0);
+        schedule_graph->output_bytes[fanin].resize(port + 1, 0);
+      }
+      ++num_reads[port];
+
+      std::vector<TensorRead>& reads = schedule_graph->reads[i];
+      auto read = std::find_if(reads.begin(), reads.end(),
+                               [&](const TensorRead& read) {
+                                 return read.node == fanin && read.port == port;
+                               });
+      if (read == reads.end()) {
+        reads.push_back({fanin, port, 1});
+      } else {
+        ++read->num_reads;
+      }
+    }
+  }
+  return Status::OK();
+}
+
+// Memory allocated for the outputs of `node`, ignoring outputs that are never
+// read.
+int64 AllocatedBytes(const ScheduleGraph& graph, int node) {
+  int64 allocated_bytes = 0;
+  for (int port = 0; port < graph.output_bytes[node].size(); ++port) {
+    if (graph.num_reads[node][port] > 0) {
+      allocated_bytes += graph.output_bytes[node][port];
+    }
+  }
+  return allocated_bytes;
+}
+
+// Returns a topological order of the graph that greedily minimizes the memory
+// held by live tensors: the next node is the ready node that increases it the
+// least, with ties broken by position in the graph. The order is incomplete if
+// the graph has a cycle.
+std::vector<int> ComputeMemoryMinimizingOrder(const ScheduleGraph& graph) {
+  const int num_nodes = graph.fanins.size();
+  std::vector<int> num_pending_fanins(num_nodes);
+  std::vector<std::vector<int>> num_pending_reads = graph.num_reads;
+  std::vector<int> ready;
+  for (int i = 0; i < num_nodes; ++i) {
+    num_pending_fanins[i] = graph.fanins[i].size();
+    if (num_pending_fanins[i] == 0) ready.push_back(i);
+  }
+
+  std::vector<int> order;
+  order.reserve(num_nodes);
+  while (!ready.empty()) {
+    int best = -1;
+    int64 best_delta = 0;
+    for (int pos = 0; pos < ready.size(); ++pos) {
+      const int node = ready[pos];
+      int64 delta = AllocatedBytes(graph, node);
+      // Tensors read for the last time are freed.
+      for (const TensorRead& read : graph.reads[node]) {
+        if (num_pending_reads[read.node][read.port] == read.num_reads) {
+          delta -= graph.output_bytes[read.node][read.port];
+        }
+      }
+      if (best < 0 || delta < best_delta ||
+          (delta == best_delta && node < ready[best])) {
+        best = pos;
+        best_delta = delta;
+      }
+    }
+
+    const int node = ready[best];
+    ready[best] = ready.back();
+    ready.pop_back();
+    order.push_back(node);
+    for (const TensorRead& read : graph.reads[node]) {
+      num_pending_reads[read.node][read.port] -= read.num_reads;
+    }
+    for (int fanout : graph.fanouts[node]) {
+      if (--num_pending_fanins[fanout] == 0) ready.push_back(fanout);
+    }
+  }
+  return order;
+}
+
+// Computes the length of the longest path ending with each node (`finish`),
+// and of the longest path starting with each node (`tail`), given the run time
+// of each node and a topological order of the graph.
+void ComputePathLengths(const ScheduleGraph& graph,
+                        const std::vector<int>& order,
+                        const std::vector<int64>& run_times,
+                        std::vector<int64>* finish, std::vector<int64>* tail) {
+  finish->assign(order.size(), 0);
+  tail->assign(order.size(), 0);
+  for (int node : order) {
+    int64 start = 0;
+    for (int fanin : graph.fanins[node]) {
+      start = std::max(start, (*finish)[fanin]);
+    }
+    (*finish)[node] = start + run_times[node];
+  }
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    int64 rest = 0;
+    for (int fanout : graph.fanouts[*it]) {
+      rest = std::max(rest, (*tail)[fanout]);
+    }
+    (*tail)[*it] = rest + run_times[*it];
+  }
+}
+
+// Updates the path lengths computed by `ComputePathLengths` after an edge from
+// `from` to `to` was added to the graph. Only the nodes downstream of `to` can
+// finish later, and only the nodes upstream of `from` can have a longer tail,
+// so the update walks these two cones in order, and stops wherever the path
+// lengths don't change. `position` is the position of each node in `order`,
+// in which `from` must come before `to`.
+void UpdatePathLengths(const ScheduleGraph& graph,
+                       const std::vector<int>& order,
+                       const std::vector<int>& position,
+                       const std::vector<int64>& run_times, int from, int to,
+                       std::vector<int64>* finish, std::vector<int64>* tail) {
+  // Nodes are visited by increasing position, so all the fanins of a node are
+  // final by the time it is visited. A node may be queued several times, but
+  // its copies are visited one after the other.
+  std::priority_queue<int, std::vector<int>, std::greater<int>> downstream;
+  if ((*finish)[from] + run_times[to] > (*finish)[to]) {
+    (*finish)[to] = (*finish)[from] + run_times[to];
+    downstream.push(position[to]);
+  }
+  int last = -1;
+  while (!downstream.empty()) {
+    const int pos = downstream.top();
+    downstream.pop();
+    if (pos == last) continue;
+    last = pos;
+    const int node = order[pos];
+    for (int fanout : graph.fanouts[node]) {
+      const int64 fanout_finish = (*finish)[node] + run_times[fanout];
+      if (fanout_finish > (*finish)[fanout]) {
+        (*finish)[fanout] = fanout_finish;
+        downstream.push(position[fanout]);
+      }
+    }
+  }
+
+  // Same for the tails, by decreasing position.
+  std::priority_queue<int> upstream;
+  if ((*tail)[to] + run_times[from] > (*tail)[from]) {
+    (*tail)[from] = (*tail)[to] + run_times[from];
+    upstream.push(position[from]);
+  }
+  last = -1;
+  while (!upstream.empty()) {
+    const int pos = upstream.top();
+    upstream.pop();
+    if (pos == last) continue;
+    last = pos;
+    const int node = order[pos];
+    for (int fanin : graph.fanins[node]) {
+      const int64 fanin_tail = (*tail)[node] + run_times[fanin];
+      if (fanin_tail > (*tail)[fanin]) {
+        (*tail)[fanin] = fanin_tail;
+        upstream.push(position[fanin]);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+PeakMemoryScheduler::PeakMemoryScheduler(RewriterConfig::Toggle opt_level,
+                                         float max_critical_path_ratio)
+    : max_critical_path_ratio_(max_critical_path_ratio > 0
+                                   ? max_critical_path_ratio
+                                   : kDefaultMaxCriticalPathRatio) {}
+
+Status PeakMemoryScheduler::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                     GraphDef* optimized_graph) {
+  peak_memory_before_ = -1;
+  peak_memory_after_ = -1;
+
+  // The VirtualScheduler needs the devices of the cluster and the fetch nodes
+  // to simulate the execution of the graph.
+  if (cluster == nullptr || item.fetch.empty()) {
+    return errors::Aborted("Nothing to do.");
+  }
+  for (const NodeDef& node : item.graph.node()) {
+    if (IsControlFlow(node)) {
+      return errors::Aborted("Graphs with control flow are not supported.");
+    }
+  }
+
+  ExecutionEstimate before;
+  TF_RETURN_IF_ERROR(EstimateExecution(cluster, item, &before));
+  peak_memory_before_ = before.peak_memory;
+
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(/*assume_valid_feeds=*/false));
+  ScheduleGraph graph;
+  TF_RETURN_IF_ERROR(BuildScheduleGraph(item.graph, properties, &graph));
+
+  const int num_nodes = item.graph.node_size();
+  const std::vector<int> order = ComputeMemoryMinimizingOrder(graph);
+  if (order.size() != num_nodes) {
+    return errors::InvalidArgument("The graph has a cycle.");
+  }
+  GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+
+  std::vector<int64> run_times(num_nodes, 0);
+  for (int i = 0; i < num_nodes; ++i) {
+    auto it = before.node_run_times.find(item.graph.node(i).name());
+    if (it != before.node_run_times.end()) run_times[i] = it->second.count();
+  }
+  std::vector<int> position(num_nodes);
+  for (int pos = 0; pos < num_nodes; ++pos) {
+    position[order[pos]] = pos;
+  }
+  std::vector<int64> finish;
+  std::vector<int64> tail;
+  ComputePathLengths(graph, order, run_times, &finish, &tail);
+  const int64 critical_path = *std::max_element(finish.begin(), finish.end());
+  const int64 max_critical_path = critical_path * max_critical_path_ratio_;
+
+  // Candidate control dependencies between consecutive nodes of the order.
+  // Source nodes, such as placeholders and constants, are left alone: they
+  // don't hold back or get held back by the rest of the graph.
+  struct Candidate {
+    int from;
+    int to;
+    int64 allocated_bytes;
+  };
+  std::vector<Candidate> candidates;
+  for (int pos = 1; pos < order.size(); ++pos) {
+    const int from = order[pos - 1];
+    const int to = order[pos];
+    const NodeDef& from_node = item.graph.node(from);
+    const NodeDef& to_node = item.graph.node(to);
+    if (!HasRegularInputs(from_node) || !HasRegularInputs(to_node) ||
+        from_node.device() != to_node.device()) {
+      continue;
+    }
+    if (std::find(graph.fanins[to].begin(), graph.fanins[to].end(), from) !=
+        graph.fanins[to].end()) {
+      continue;
+    }
+    const int64 allocated_bytes = AllocatedBytes(graph, to);
+    if (allocated_bytes > 0) {
+      candidates.push_back({from, to, allocated_bytes});
+    }
+  }
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const Candidate& a, const Candidate& b) {
+                     return a.allocated_bytes > b.allocated_bytes;
+                   });
+
+  // Constrain the largest allocations first. All the dependencies follow the
+  // order, so they never create a cycle and the order stays topological.
+  *optimized_graph = item.graph;
+  int num_dependencies = 0;
+  for (const Candidate& candidate : candidates) {
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    if (finish[candidate.from] + tail[candidate.to] > max_critical_path) {
+      continue;
+    }
+    graph.fanins[candidate.to].push_back(candidate.from);
+    graph.fanouts[candidate.from].push_back(candidate.to);
+    UpdatePathLengths(graph, order, position, run_times, candidate.from,
+                      candidate.to, &finish, &tail);
+    optimized_graph->mutable_node(candidate.to)
+        ->add_input(AsControlDependency(item.graph.node(candidate.from)));
+    ++num_dependencies;
+  }
+  if (num_dependencies == 0) {
+    return errors::Aborted("Nothing to do.");
+  }
+
+  GrapplerItem optimized_item = item.WithGraph(GraphDef(*optimized_graph));
+  ExecutionEstimate after;
+  TF_RETURN_IF_ERROR(EstimateExecution(cluster, optimized_item, &after));
+  peak_memory_after_ = after.peak_memory;
+
+  VLOG(1) << "Added " << num_dependencies
+          << " control dependencies: estimated peak memory usage "
+          << before.peak_memory << " -> " << after.peak_memory
+          << " bytes, estimated run time " << before.execution_time.count()
+          << " -> " << after.execution_time.count() << " ns.";
+
+  if (after.peak_memory >= before.peak_memory) {
+    return errors::Aborted("The estimated peak memory usage didn't decrease.");
+  }
+  return Status::OK();
+}
+
+string PeakMemoryScheduler::ResultSummary() const {
+  if (peak_memory_before_ < 0) return "";
+  if (peak_memory_after_ < 0) {
+    return strings::StrCat("estimated peak memory = ", peak_memory_before_,
+                           " bytes");
+  }
+  return strings::StrCat("estimated peak memory = ", peak_memory_before_,
+                         " -> ", peak_memory_after_, " bytes");
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,73 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_PEAK_MEMORY_SCHEDULER_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_PEAK_MEMORY_SCHEDULER_H_
+
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Reduce the peak memory usage of inference graphs by constraining the order in
+// which the executor runs independent ops.
+//
+// The optimizer computes a topological order of the graph that greedily
+// minimizes the memory held by live tensors, and enforces it with control
+// dependencies between ops that are consecutive in that order. The ops that
+// allocate the most memory are constrained first, as long as the critical path
+// of the graph, estimated with the AnalyticalCostEstimator, doesn't grow beyond
+// `max_critical_path_ratio` times its original length. The graph is left
+// unchanged unless the peak memory usage estimated by the VirtualScheduler
+// decreases.
+class PeakMemoryScheduler : public GraphOptimizer {
+ public:
+  PeakMemoryScheduler() : PeakMemoryScheduler(RewriterConfig::ON, 0.0f) {}
+  // max_critical_path_ratio: See
+  //   RewriterConfig::peak_memory_scheduling_max_critical_path_ratio.
+  PeakMemoryScheduler(RewriterConfig::Toggle opt_level,
+                      float max_critical_path_ratio);
+  ~PeakMemoryScheduler() override {}
+
+  string name() const override { return "peak_memory_scheduler"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override {}
+
+  string ResultSummary() const override;
+
+  // Estimated peak memory usage in bytes of the last graph passed to Optimize,
+  // before and after the optimization. -1 if unknown.
+  int64 peak_memory_before() const { return peak_memory_before_; }
+  int64 peak_memory_after() const { return peak_memory_after_; }
+
+ private:
+  const float max_critical_path_ratio_;
+  int64 peak_memory_before_ = -1;
+  int64 peak_memory_after_ = -1;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_PEAK_MEMORY_SCHEDULER_H_
@@ -0,0 +1,180 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/peak_memory_scheduler.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kDevice[] = "/job:localhost/replica:0/task:0/cpu:0";
+
+class PeakMemorySchedulerTest : public GrapplerTest {
+ protected:
+  static std::unique_ptr<VirtualCluster> CreateVirtualCluster() {
+    DeviceProperties cpu_device;
+    cpu_device.set_type("CPU");
+    cpu_device.set_frequency(1000);
+    cpu_device.set_num_cores(4);
+    cpu_device.set_bandwidth(32);
+    cpu_device.set_memory_size(1024 * 1024 * 1024);
+    std::unordered_map<string, DeviceProperties> devices;
+    devices[kDevice] = cpu_device;
+    return std::unique_ptr<VirtualCluster>(new VirtualCluster(devices));
+  }
+
+  // Independent branches that each materialize a large tensor and reduce it to
+  // a scalar. Running the branches one after the other needs far less memory
+  // than running the large ops first, as the executor is free to do.
+  static GrapplerItem MakeBranchesItem(int num_branches) {
+    Scope s = Scope::NewRootScope().WithDevice(kDevice);
+    Output dims = ops::Const(s.WithOpName("dims"), {1024, 1024}, {2});
+    Output value = ops::Const(s.WithOpName("value"), 1.0f, {});
+    Output axes = ops::Const(s.WithOpName("axes"), {0, 1}, {2});
+    std::vector<Output> sums;
+    for (int i = 0; i < num_branches; ++i) {
+      Output fill = ops::Fill(s.WithOpName(strings::StrCat("fill", i)), dims,
+                              value);
+      Output sqrt = ops::Sqrt(s.WithOpName(strings::StrCat("sqrt", i)), fill);
+      sums.push_back(
+          ops::Sum(s.WithOpName(strings::StrCat("sum", i)), sqrt, axes));
+    }
+    Output total = ops::AddN(s.WithOpName("total"), sums);
+    (void)total;
+
+    GrapplerItem item;
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    item.fetch = {"total"};
+    return item;
+  }
+};
+
+TEST_F(PeakMemorySchedulerTest, NoCluster) {
+  GrapplerItem item = MakeBranchesItem(4);
+  PeakMemoryScheduler optimizer;
+  GraphDef output;
+  Status status = optimizer.Optimize(nullptr, item, &output);
+  EXPECT_TRUE(errors::IsAborted(status));
+}
+
+TEST_F(PeakMemorySchedulerTest, ControlFlow) {
+  Scope s = Scope::NewRootScope().WithDevice(kDevice);
+  Output x = ops::Const(s.WithOpName("x"), 1.0f, {});
+  Output pred = ops::Const(s.WithOpName("pred"), true, {});
+  ops::Switch sw(s.WithOpName("switch"), x, pred);
+  ops::Merge merge(s.WithOpName("merge"), {sw.output_false, sw.output_true});
+  (void)merge;
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"merge"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  PeakMemoryScheduler optimizer;
+  GraphDef output;
+  Status status = optimizer.Optimize(cluster.get(), item, &output);
+  EXPECT_TRUE(errors::IsAborted(status));
+}
+
+TEST_F(PeakMemorySchedulerTest, SerializesIndependentBranches) {
+  const int kNumBranches = 4;
+  GrapplerItem item = MakeBranchesItem(kNumBranches);
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  // Running the branches sequentially multiplies the critical path by the
+  // number of branches.
+  PeakMemoryScheduler optimizer(RewriterConfig::ON,
+                                /*max_critical_path_ratio=*/kNumBranches + 1);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+  EXPECT_GT(optimizer.peak_memory_before(), 0);
+  EXPECT_LT(optimizer.peak_memory_after(), optimizer.peak_memory_before());
+
+  // Each branch but the first waits for the previous one to finish.
+  ASSERT_EQ(output.node_size(), item.graph.node_size());
+  int num_dependencies = 0;
+  for (const NodeDef& node : output.node()) {
+    for (const string& input : node.input()) {
+      if (!IsControlInput(input)) continue;
+      EXPECT_EQ(node.op(), "Fill");
+      EXPECT_EQ(NodeName(input).substr(0, 3), "sum");
+      ++num_dependencies;
+    }
+  }
+  EXPECT_EQ(num_dependencies, kNumBranches - 1);
+
+  // Control dependencies don't change the results.
+  auto expected = EvaluateNodes(item.graph, item.fetch);
+  auto actual = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(expected.size(), 1);
+  ASSERT_EQ(actual.size(), 1);
+  test::ExpectTensorNear<float>(expected[0], actual[0], 1e-6);
+}
+
+TEST_F(PeakMemorySchedulerTest, BoundsChainedBranches) {
+  GrapplerItem item = MakeBranchesItem(4);
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  // Chaining two branches fits in the bound but chaining three doesn't. Once
+  // the first branch waits for the second, the third one can't wait for the
+  // second one too, but the fourth one can still wait for the third.
+  PeakMemoryScheduler optimizer(RewriterConfig::ON,
+                                /*max_critical_path_ratio=*/2.5f);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  std::vector<string> dependencies;
+  for (const NodeDef& node : output.node()) {
+    for (const string& input : node.input()) {
+      if (IsControlInput(input)) {
+        dependencies.push_back(strings::StrCat(NodeName(input), "->",
+                                               node.name()));
+      }
+    }
+  }
+  EXPECT_EQ(dependencies,
+            std::vector<string>({"sum0->fill1", "sum2->fill3"}));
+}
+
+TEST_F(PeakMemorySchedulerTest, RespectsCriticalPathBound) {
+  GrapplerItem item = MakeBranchesItem(4);
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  // Serializing any two branches makes the critical path longer.
+  PeakMemoryScheduler optimizer(RewriterConfig::ON,
+                                /*max_critical_path_ratio=*/1.0f);
+  GraphDef output;
+  Status status = optimizer.Optimize(cluster.get(), item, &output);
+  EXPECT_TRUE(errors::IsAborted(status));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
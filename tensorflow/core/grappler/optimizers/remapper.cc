@@ -43,9 +43,11 @@ namespace grappler {
 //   (1) Conv2D + BiasAdd + <Activation>
 //   (2) Conv2D + FusedBatchNorm + <Activation>
 //   (3) Conv2D + Squeeze + BiasAdd
+//   (4) Conv2D + BiasAdd + Mul(scalar) + <Activation>
 //
 // MatMul + ... -> _FusedMatMul:
 //   (1) MatMul + BiasAdd + <Activation>
+//   (2) MatMul + BiasAdd + Mul(scalar) + <Activation>
 //
 // FusedBatchNorm[$is_training] + ... -> _FusedBatchNormEx[$is_training]
 //   (1) FusedBatchNorm + <Activation>
@@ -124,6 +126,26 @@ struct ContractionWithBiasAddAndActivation {
   int activation = kMissingIndex;
 };
 
+// Contraction node followed by a BiasAdd, a Mul by a scalar constant, and an
+// optional Activation.
+struct ContractionWithBiasAddAndMul {
+  ContractionWithBiasAddAndMul() = default;
+  ContractionWithBiasAddAndMul(int contraction, int bias_add, int mul,
+                               int scale_port, int activation)
+      : contraction(contraction),
+        bias_add(bias_add),
+        mul(mul),
+        scale_port(scale_port),
+        activation(activation) {}
+
+  int contraction = kMissingIndex;
+  int bias_add = kMissingIndex;
+  int mul = kMissingIndex;
+  // Input port of the Mul that reads the scalar constant.
+  int scale_port = kMissingIndex;
+  int activation = kMissingIndex;
+};
+
 // Contraction node followed by a Squeeze and BiasAdd.
 struct ContractionWithSqueezeAndBiasAdd {
   ContractionWithSqueezeAndBiasAdd() = default;
@@ -370,7 +392,12 @@ bool IsDmlCompatible(const RemapperContext& ctx,
   const NodeDef& contraction_node = graph->node(matched.contraction);
 
   if (IsConv2D(contraction_node)) {
-    return IsDmlCompatibleConv2D(&contraction_node);
+    // DML's _FusedConv2D kernel does not support tanh and sigmoid.
+    const NodeDef& activation_node = graph->node(matched.activation);
+    bool is_relu_relu6_or_elu = IsRelu(activation_node) ||
+                                IsRelu6(activation_node) ||
+                                IsElu(activation_node);
+    return is_relu_relu6_or_elu && IsDmlCompatibleConv2D(&contraction_node);
   } else if (IsMatMul(contraction_node)) {
     // DML's _FusedMatMul kernel does not support relu6.
     const NodeDef& activation_node = graph->node(matched.activation);
@@ -404,6 +431,11 @@ bool IsDeviceCompatible(const RemapperContext& ctx, Pattern& matched) {
 }
 
 bool IsSupportedActivation(const NodeDef& node) {
+#ifndef INTEL_MKL
+  // Tanh and Sigmoid are fused only by the Eigen output kernels on CPU (see
+  // kernels/fused_eigen_output_kernels.h), MKL kernels don't support them.
+  if (IsTanh(node) || IsSigmoid(node)) return true;
+#endif  // !INTEL_MKL
   return IsRelu(node) || IsRelu6(node) || IsElu(node);
 }
 
@@ -491,6 +523,75 @@ bool FindContractionWithBiasAndActivation(
   return true;
 }
 
+// Returns true if `node` is a Const holding a scalar.
+bool IsScalarConstant(const NodeDef& node) {
+  if (!IsConstant(node)) return false;
+  const auto value = node.attr().find("value");
+  if (value == node.attr().end()) return false;
+  const TensorShapeProto& shape = value->second.tensor().tensor_shape();
+  return !shape.unknown_rank() && shape.dim_size() == 0;
+}
+
+bool FindContractionWithBiasAddAndMul(const RemapperContext& ctx,
+                                      int node_index,
+                                      ContractionWithBiasAddAndMul* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  // Root of the pattern must be a Mul, or an activation node following it.
+  // TODO(lyandy): Forward controls for patterns with control dependencies.
+  if (HasControlFaninOrFanout(*node_view)) return false;
+
+  int activation = kMissingIndex;
+  const auto* mul_node_view = node_view;
+  if (IsSupportedActivation(*node_view->node())) {
+    if (node_view->NumRegularFanins() < 1) return false;
+    activation = node_index;
+    mul_node_view = node_view->GetRegularFanin(0).node_view();
+    if (HasControlFaninOrFanout(*mul_node_view) ||
+        !HasAtMostOneFanoutAtPort0(*mul_node_view) ||
+        !HaveSameDataType(node_view->node(), mul_node_view->node()) ||
+        IsInPreserveSet(ctx, mul_node_view->node()))
+      return false;
+  }
+
+  const auto* mul_node_def = mul_node_view->node();
+  if (!IsMul(*mul_node_def) || mul_node_view->NumRegularFanins() != 2)
+    return false;
+
+  // One input of the Mul must be a scalar constant, and the other one must
+  // match ContractionWithBiasAdd pattern.
+  for (int scale_port = 0; scale_port < 2; ++scale_port) {
+    const auto* scale_node_view =
+        mul_node_view->GetRegularFanin(scale_port).node_view();
+    const auto* bias_add_node_view =
+        mul_node_view->GetRegularFanin(1 - scale_port).node_view();
+    const auto* bias_add_node_def = bias_add_node_view->node();
+
+    ContractionWithBiasAdd base;
+    if (!IsScalarConstant(*scale_node_view->node()) ||
+        !FindContractionWithBias(ctx, bias_add_node_view->node_index(), &base,
+                                 /*check_device_compatible=*/false) ||
+        !HasAtMostOneFanoutAtPort0(*bias_add_node_view) ||
+        !HaveSameDataType(mul_node_def, bias_add_node_def) ||
+        IsInPreserveSet(ctx, bias_add_node_def))
+      continue;
+
+    // Only the Eigen output kernels on CPU support this fusion (see
+    // kernels/fused_eigen_output_kernels.h).
+    const ContractionWithBiasAddAndMul pattern{
+        base.contraction, base.bias_add, mul_node_view->node_index(),
+        scale_port, activation};
+    if (!IsCpuCompatible(ctx, pattern)) return false;
+
+    // We successfully found a {Conv2D, MatMul}+BiasAdd+Mul+<Activation>
+    // pattern.
+    *matched = pattern;
+
+    return true;
+  }
+
+  return false;
+}
+
 bool FindConv2DWithSqueezeAndBias(const RemapperContext& ctx, int node_index,
                                   ContractionWithSqueezeAndBiasAdd* matched) {
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -1306,6 +1407,63 @@ Status AddFusedContractionNode(
   return Status::OK();
 }
 
+Status AddFusedContractionNode(RemapperContext* ctx,
+                               const ContractionWithBiasAddAndMul& matched,
+                               std::vector<bool>* invalidated_nodes,
+                               std::vector<bool>* nodes_to_delete) {
+  DCHECK(IsCpuCompatible(*ctx, matched)) << "Unsupported fusion pattern";
+
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& contraction = graph->node(matched.contraction);
+  const NodeDef& bias_add = graph->node(matched.bias_add);
+  const NodeDef& mul = graph->node(matched.mul);
+  const bool has_activation = matched.activation != kMissingIndex;
+  const NodeDef& root = has_activation ? graph->node(matched.activation) : mul;
+  VLOG(2) << "Fuse " << contraction.op() << " with BiasAdd and Mul"
+          << (has_activation ? " and " + root.op() : "") << ":"
+          << " root=" << root.name() << " mul=" << mul.name()
+          << " bias_add=" << bias_add.name()
+          << " contraction=" << contraction.name();
+
+  NodeDef fused_op;
+  fused_op.set_name(root.name());
+  fused_op.set_device(contraction.device());
+  fused_op.add_input(contraction.input(0));  // 0: input
+
+  if (IsConv2D(contraction)) {
+    fused_op.set_op(kFusedConv2D);
+    CopyConv2DAttributes(contraction, &fused_op);
+  } else if (IsMatMul(contraction)) {
+    fused_op.set_op(kFusedMatMul);
+    CopyMatMulAttributes(contraction, &fused_op);
+  }
+
+  fused_op.add_input(contraction.input(1));           // 1: filter
+  fused_op.add_input(bias_add.input(1));              // 2: bias
+  fused_op.add_input(mul.input(matched.scale_port));  // 3: scale
+
+  std::vector<absl::string_view> fused_ops = {"BiasAdd", "Mul"};
+  if (has_activation) fused_ops.push_back(root.op());
+  SetFusedOpAttributes(&fused_op, fused_ops, /*num_args=*/2);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*nodes_to_delete)[matched.contraction] = true;
+  (*nodes_to_delete)[matched.bias_add] = true;
+  if (has_activation) {
+    (*nodes_to_delete)[matched.mul] = true;
+    (*invalidated_nodes)[matched.activation] = true;
+  } else {
+    (*invalidated_nodes)[matched.mul] = true;
+  }
+
+  return Status::OK();
+}
+
 Status AddFusedContractionNode(RemapperContext* ctx,
                                const PadWithConv2D& matched,
                                std::vector<bool>* invalidated_nodes,
@@ -1984,6 +2142,20 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+#ifndef INTEL_MKL
+    // Remap {Conv2D,MatMul}+BiasAdd+Mul+<Activation> into the
+    // _Fused{Conv2D,MatMul}.
+    ContractionWithBiasAddAndMul contract_with_bias_and_mul;
+    if (allow_non_differentiable_rewrites &&
+        FindContractionWithBiasAddAndMul(ctx, i,
+                                         &contract_with_bias_and_mul)) {
+      TF_RETURN_IF_ERROR(
+          AddFusedContractionNode(&ctx, contract_with_bias_and_mul,
+                                  &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+#endif  // !INTEL_MKL
+
 // NOTE: We can only fuse BatchNorm into Conv2D nodes. In theory we can do
 // it for MatMul as well, but in practice this pattern does not appear in
 // real Tensorflow graphs.
@@ -577,7 +577,8 @@ TEST_F(RemapperTest, FuseMatMulWithBias) {
 TEST_F(RemapperTest, FuseConv2DWithBiasAndActivation) {
   using ::tensorflow::ops::Placeholder;
 
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
     tensorflow::Scope s = tensorflow::Scope::NewRootScope();
 
     auto input_shape = Placeholder::Shape({8, 32, 32, 3});
@@ -603,6 +604,10 @@ TEST_F(RemapperTest, FuseConv2DWithBiasAndActivation) {
         return ops::Identity(fetch, ops::Relu6(activate, bias_add));
       } else if (activation == "Elu") {
         return ops::Identity(fetch, ops::Elu(activate, bias_add));
+      } else if (activation == "Tanh") {
+        return ops::Identity(fetch, ops::Tanh(activate, bias_add));
+      } else if (activation == "Sigmoid") {
+        return ops::Identity(fetch, ops::Sigmoid(activate, bias_add));
       }
 
       return ops::Identity(fetch, bias);
@@ -659,7 +664,8 @@ TEST_F(RemapperTest, FuseConv2DWithBiasAndActivation) {
 TEST_F(RemapperTest, FuseMatMulWithBiasAndActivation) {
   using ::tensorflow::ops::Placeholder;
 
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
     tensorflow::Scope s = tensorflow::Scope::NewRootScope();
 
     auto lhs_shape = ops::Placeholder::Shape({8, 32});
@@ -683,6 +689,10 @@ TEST_F(RemapperTest, FuseMatMulWithBiasAndActivation) {
         return ops::Identity(fetch, ops::Relu6(activate, bias_add));
       } else if (activation == "Elu") {
         return ops::Identity(fetch, ops::Elu(activate, bias_add));
+      } else if (activation == "Tanh") {
+        return ops::Identity(fetch, ops::Tanh(activate, bias_add));
+      } else if (activation == "Sigmoid") {
+        return ops::Identity(fetch, ops::Sigmoid(activate, bias_add));
       }
 
       return ops::Identity(fetch, bias);
@@ -698,8 +708,9 @@ TEST_F(RemapperTest, FuseMatMulWithBiasAndActivation) {
     TF_ASSERT_OK(s.ToGraphDef(&item.graph));
 
     for (const string& device : {"/device:CPU:0", "/device:DML:0"}) {
-      // DML doesn't support fusing relu6
-      if (device == "/device:DML:0" && activation == "Relu6") {
+      // DML supports fusing only relu and elu
+      if (device == "/device:DML:0" && activation != "Relu" &&
+          activation != "Elu") {
         continue;
       }
 
@@ -740,6 +751,188 @@ TEST_F(RemapperTest, FuseMatMulWithBiasAndActivation) {
   }
 }
 
+TEST_F(RemapperTest, FuseConv2DWithBiasMulAndActivation) {
+  using ::tensorflow::ops::Placeholder;
+
+  for (const string& activation :
+       {"None", "Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto input_shape = Placeholder::Shape({8, 32, 32, 3});
+    auto filter_shape = Placeholder::Shape({1, 1, 3, 128});
+    auto bias_shape = Placeholder::Shape({128});
+
+    auto input = Placeholder(s.WithOpName("input"), DT_FLOAT, input_shape);
+    auto filter = Placeholder(s.WithOpName("filter"), DT_FLOAT, filter_shape);
+    auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+    auto scale = ops::Const(s.WithOpName("scale"), 0.5f);
+
+    std::vector<int> strides = {1, 1, 1, 1};
+    auto conv =
+        ops::Conv2D(s.WithOpName("conv"), input, filter, strides, "SAME");
+    auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), conv, bias);
+    // The scale is the first input of the Mul.
+    auto mul = ops::Mul(s.WithOpName("mul"), scale, bias_add);
+
+    ops::Identity fetch = [&]() -> ops::Identity {
+      auto activate = s.WithOpName("activation");
+      auto fetch = s.WithOpName("fetch");
+
+      if (activation == "Relu") {
+        return ops::Identity(fetch, ops::Relu(activate, mul));
+      } else if (activation == "Relu6") {
+        return ops::Identity(fetch, ops::Relu6(activate, mul));
+      } else if (activation == "Elu") {
+        return ops::Identity(fetch, ops::Elu(activate, mul));
+      } else if (activation == "Tanh") {
+        return ops::Identity(fetch, ops::Tanh(activate, mul));
+      } else if (activation == "Sigmoid") {
+        return ops::Identity(fetch, ops::Sigmoid(activate, mul));
+      }
+
+      return ops::Identity(fetch, mul);
+    }();
+
+    auto input_t = GenerateRandomTensor<DT_FLOAT>({8, 32, 32, 3});
+    auto filter_t = GenerateRandomTensor<DT_FLOAT>({1, 1, 3, 128});
+    auto bias_t = GenerateRandomTensor<DT_FLOAT>({128});
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"input", input_t}, {"filter", filter_t}, {"bias", bias_t}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+    // Place all nodes on CPU.
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    const string fused_name = activation == "None" ? "mul" : "activation";
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE(node.name(), "bias_add");
+      if (node.name() == fused_name) {
+        EXPECT_EQ(node.op(), "_FusedConv2D");
+        ASSERT_GE(node.input_size(), 4);
+        EXPECT_EQ(node.input(0), "input");
+        EXPECT_EQ(node.input(1), "filter");
+
+        EXPECT_EQ(node.attr().at("num_args").i(), 2);
+        EXPECT_EQ(node.input(2), "bias");
+        EXPECT_EQ(node.input(3), "scale");
+
+        const auto fused_ops = node.attr().at("fused_ops").list().s();
+        ASSERT_EQ(fused_ops.size(), activation == "None" ? 2 : 3);
+        EXPECT_EQ(fused_ops[0], "BiasAdd");
+        EXPECT_EQ(fused_ops[1], "Mul");
+        if (activation != "None") EXPECT_EQ(fused_ops[2], activation);
+        found++;
+      }
+    }
+    EXPECT_EQ(found, 1);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+  }
+}
+
+TEST_F(RemapperTest, FuseMatMulWithBiasMulAndActivation) {
+  using ::tensorflow::ops::Placeholder;
+
+  for (const string& activation :
+       {"None", "Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto lhs_shape = ops::Placeholder::Shape({8, 32});
+    auto rhs_shape = ops::Placeholder::Shape({32, 64});
+    auto bias_shape = ops::Placeholder::Shape({64});
+
+    auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT, lhs_shape);
+    auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT, rhs_shape);
+    auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+    auto scale = ops::Const(s.WithOpName("scale"), 1.5f);
+
+    auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+    auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+    // The scale is the second input of the Mul.
+    auto mul = ops::Mul(s.WithOpName("mul"), bias_add, scale);
+
+    ops::Identity fetch = [&]() -> ops::Identity {
+      auto activate = s.WithOpName("activation");
+      auto fetch = s.WithOpName("fetch");
+
+      if (activation == "Relu") {
+        return ops::Identity(fetch, ops::Relu(activate, mul));
+      } else if (activation == "Relu6") {
+        return ops::Identity(fetch, ops::Relu6(activate, mul));
+      } else if (activation == "Elu") {
+        return ops::Identity(fetch, ops::Elu(activate, mul));
+      } else if (activation == "Tanh") {
+        return ops::Identity(fetch, ops::Tanh(activate, mul));
+      } else if (activation == "Sigmoid") {
+        return ops::Identity(fetch, ops::Sigmoid(activate, mul));
+      }
+
+      return ops::Identity(fetch, mul);
+    }();
+
+    auto lhs_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+    auto rhs_t = GenerateRandomTensor<DT_FLOAT>({32, 64});
+    auto bias_t = GenerateRandomTensor<DT_FLOAT>({64});
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"lhs", lhs_t}, {"rhs", rhs_t}, {"bias", bias_t}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+    // Place all nodes on CPU.
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    const string fused_name = activation == "None" ? "mul" : "activation";
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE(node.name(), "bias_add");
+      if (node.name() == fused_name) {
+        EXPECT_EQ(node.op(), "_FusedMatMul");
+        ASSERT_GE(node.input_size(), 4);
+        EXPECT_EQ(node.input(0), "lhs");
+        EXPECT_EQ(node.input(1), "rhs");
+
+        EXPECT_EQ(node.attr().at("num_args").i(), 2);
+        EXPECT_EQ(node.input(2), "bias");
+        EXPECT_EQ(node.input(3), "scale");
+
+        const auto fused_ops = node.attr().at("fused_ops").list().s();
+        ASSERT_EQ(fused_ops.size(), activation == "None" ? 2 : 3);
+        EXPECT_EQ(fused_ops[0], "BiasAdd");
+        EXPECT_EQ(fused_ops[1], "Mul");
+        if (activation != "None") EXPECT_EQ(fused_ops[2], activation);
+        found++;
+      }
+    }
+    EXPECT_EQ(1, found);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+  }
+}
+
 TEST_F(RemapperTest, FuseConv2DWithBatchNorm) {
   using ops::Placeholder;
 
@@ -823,7 +1016,8 @@ TEST_F(RemapperTest, FuseConv2DWithBatchNorm) {
 TEST_F(RemapperTest, FuseConv2DWithBatchNormAndActivation) {
   using ops::Placeholder;
 
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
     tensorflow::Scope s = tensorflow::Scope::NewRootScope();
 
     auto input_shape = ops::Placeholder::Shape({8, 32, 32, 3});
@@ -856,6 +1050,10 @@ TEST_F(RemapperTest, FuseConv2DWithBatchNormAndActivation) {
         return ops::Identity(fetch, ops::Relu6(activate, batch_norm.y));
       } else if (activation == "Elu") {
         return ops::Identity(fetch, ops::Elu(activate, batch_norm.y));
+      } else if (activation == "Tanh") {
+        return ops::Identity(fetch, ops::Tanh(activate, batch_norm.y));
+      } else if (activation == "Sigmoid") {
+        return ops::Identity(fetch, ops::Sigmoid(activate, batch_norm.y));
       }
 
       return ops::Identity(fetch, batch_norm.y);
@@ -366,6 +366,30 @@ static Graph* FusedConv2DWithBatchNorm(
   BENCHMARK(                                                                   \
       BM_NAME(BM_FusedConv2DWithBiasAndRelu, type, N, H, W, C, FW, FH, FC));
 
+#define BM_Conv2DWithBiasAndActivation(N, H, W, C, FW, FH, FC, ACT, type,     \
+                                       LABEL)                                 \
+  static void BM_NAME(BM_Conv2DWithBiasAnd##ACT, type, N, H, W, C, FW, FH,    \
+                      FC)(int iters) {                                        \
+    BM_SETUP(N, H, W, C, type, LABEL, Conv2D);                                \
+    test::Benchmark(#type, Conv2DWithBiasAndActivation<float>(N, H, W, C, FW, \
+                                                              FH, FC, #ACT)   \
+                               .graph)                                        \
+        .Run(iters);                                                          \
+  }                                                                           \
+  BENCHMARK(BM_NAME(BM_Conv2DWithBiasAnd##ACT, type, N, H, W, C, FW, FH, FC));
+
+#define BM_FusedConv2DWithBiasAndActivation(N, H, W, C, FW, FH, FC, ACT, type, \
+                                            LABEL)                             \
+  static void BM_NAME(BM_FusedConv2DWithBiasAnd##ACT, type, N, H, W, C, FW,    \
+                      FH, FC)(int iters) {                                     \
+    BM_SETUP(N, H, W, C, type, LABEL, Conv2D);                                 \
+    test::Benchmark(#type, FusedConv2DWithBias<float>(N, H, W, C, FW, FH, FC,  \
+                                                      {"BiasAdd", #ACT}))      \
+        .Run(iters);                                                           \
+  }                                                                            \
+  BENCHMARK(BM_NAME(BM_FusedConv2DWithBiasAnd##ACT, type, N, H, W, C, FW, FH,  \
+                    FC));
+
 #define BM_Conv2DWithBatchNorm(N, H, W, C, FW, FH, FC, type, LABEL)           \
   static void BM_NAME(BM_Conv2DWithBatchNorm, type, N, H, W, C, FW, FH,       \
                       FC)(int iters) {                                        \
@@ -439,7 +463,37 @@ BM_FusedConv2DWithBiasAndRelu(8, 32, 32, 128, 1, 1, 1024, cpu, "1x1 /b 8");
 BM_FusedConv2DWithBiasAndRelu(16, 32, 32, 128, 1, 1, 1024, cpu, "1x1 /b 16");
 BM_FusedConv2DWithBiasAndRelu(32, 32, 32, 128, 1, 1, 1024, cpu, "1x1 /b 32");
 
-// 2) FusedBatchNorm {+ Relu}
+// 2) BiasAdd + {Tanh, Sigmoid}
+
+BM_Conv2DWithBiasAndActivation(8, 32, 32, 128, 1, 1, 1024, Tanh, cpu,
+                               "1x1 /b 8");
+BM_Conv2DWithBiasAndActivation(16, 32, 32, 128, 1, 1, 1024, Tanh, cpu,
+                               "1x1 /b 16");
+BM_Conv2DWithBiasAndActivation(32, 32, 32, 128, 1, 1, 1024, Tanh, cpu,
+                               "1x1 /b 32");
+
+BM_FusedConv2DWithBiasAndActivation(8, 32, 32, 128, 1, 1, 1024, Tanh, cpu,
+                                    "1x1 /b 8");
+BM_FusedConv2DWithBiasAndActivation(16, 32, 32, 128, 1, 1, 1024, Tanh, cpu,
+                                    "1x1 /b 16");
+BM_FusedConv2DWithBiasAndActivation(32, 32, 32, 128, 1, 1, 1024, Tanh, cpu,
+                                    "1x1 /b 32");
+
+BM_Conv2DWithBiasAndActivation(8, 32, 32, 128, 1, 1, 1024, Sigmoid, cpu,
+                               "1x1 /b 8");
+BM_Conv2DWithBiasAndActivation(16, 32, 32, 128, 1, 1, 1024, Sigmoid, cpu,
+                               "1x1 /b 16");
+BM_Conv2DWithBiasAndActivation(32, 32, 32, 128, 1, 1, 1024, Sigmoid, cpu,
+                               "1x1 /b 32");
+
+BM_FusedConv2DWithBiasAndActivation(8, 32, 32, 128, 1, 1, 1024, Sigmoid, cpu,
+                                    "1x1 /b 8");
+BM_FusedConv2DWithBiasAndActivation(16, 32, 32, 128, 1, 1, 1024, Sigmoid, cpu,
+                                    "1x1 /b 16");
+BM_FusedConv2DWithBiasAndActivation(32, 32, 32, 128, 1, 1, 1024, Sigmoid, cpu,
+                                    "1x1 /b 32");
+
+// 3) FusedBatchNorm {+ Relu}
 
 BM_Conv2DWithBatchNorm(8, 32, 32, 128, 1, 1, 1024, cpu, "1x1 /b 8");
 BM_Conv2DWithBatchNorm(16, 32, 32, 128, 1, 1, 1024, cpu, "1x1 /b 16");
@@ -16,9 +16,10 @@ limitations under the License.
 // Implements convolution operations with other kernels baked into the
 // processing, to optimize latency and memory usage:
 //  - Conv2D + BiasAdd + <Activation>
+//  - Conv2D + BiasAdd + Mul(scalar) + <Activation>
 //  - Conv2D + FusedBatchNorm + <Activation>
 //
-// Activation: Relu, Relu6, Elu, etc...
+// Activation: Relu, Relu6, Elu, Tanh, Sigmoid, etc...
 //
 // Kernels for convolutions fused with image transformations (resize and mirror
 // padding) defined in `conv_ops_fused_image_transform.cc`.
@@ -188,6 +189,12 @@ struct LaunchFusedConv2DOp<CPUDevice, T> {
       OP_REQUIRES_OK(context, InitBiasAddArgs(context, &bias_add_args));
     }
 
+    BiasAddWithMulArgs<T> bias_add_with_mul_args;
+    if (BiasAddWithMulArgs<T>::IsSupported(fusion)) {
+      OP_REQUIRES_OK(context,
+                     InitBiasAddWithMulArgs(context, &bias_add_with_mul_args));
+    }
+
     FusedBatchNormArgs<T> fused_batch_norm_args;
     if (FusedBatchNormArgs<T>::IsSupported(fusion)) {
       OP_REQUIRES_OK(context,
@@ -219,6 +226,38 @@ struct LaunchFusedConv2DOp<CPUDevice, T> {
         conv2d(WithBiasAddAndElu<T>(bias_add_args), context, input, filter,
                output);
         break;
+      case FusedComputationType::kBiasAddWithTanh:
+        conv2d(WithBiasAddAndTanh<T>(bias_add_args), context, input, filter,
+               output);
+        break;
+      case FusedComputationType::kBiasAddWithSigmoid:
+        conv2d(WithBiasAddAndSigmoid<T>(bias_add_args), context, input,
+               filter, output);
+        break;
+      case FusedComputationType::kBiasAddWithMul:
+        conv2d(WithBiasAddAndMul<T>(bias_add_with_mul_args), context, input,
+               filter, output);
+        break;
+      case FusedComputationType::kBiasAddWithMulAndRelu:
+        conv2d(WithBiasAddMulAndRelu<T>(bias_add_with_mul_args), context,
+               input, filter, output);
+        break;
+      case FusedComputationType::kBiasAddWithMulAndRelu6:
+        conv2d(WithBiasAddMulAndRelu6<T>(bias_add_with_mul_args), context,
+               input, filter, output);
+        break;
+      case FusedComputationType::kBiasAddWithMulAndElu:
+        conv2d(WithBiasAddMulAndElu<T>(bias_add_with_mul_args), context,
+               input, filter, output);
+        break;
+      case FusedComputationType::kBiasAddWithMulAndTanh:
+        conv2d(WithBiasAddMulAndTanh<T>(bias_add_with_mul_args), context,
+               input, filter, output);
+        break;
+      case FusedComputationType::kBiasAddWithMulAndSigmoid:
+        conv2d(WithBiasAddMulAndSigmoid<T>(bias_add_with_mul_args), context,
+               input, filter, output);
+        break;
       case FusedComputationType::kFusedBatchNorm:
         conv2d(
             WithFusedBatchNorm<T>(fusion_args.epsilon, fused_batch_norm_args),
@@ -239,6 +278,16 @@ struct LaunchFusedConv2DOp<CPUDevice, T> {
                                            fused_batch_norm_args),
                context, input, filter, output);
         break;
+      case FusedComputationType::kFusedBatchNormWithTanh:
+        conv2d(WithFusedBatchNormAndTanh<T>(fusion_args.epsilon,
+                                            fused_batch_norm_args),
+               context, input, filter, output);
+        break;
+      case FusedComputationType::kFusedBatchNormWithSigmoid:
+        conv2d(WithFusedBatchNormAndSigmoid<T>(fusion_args.epsilon,
+                                               fused_batch_norm_args),
+               context, input, filter, output);
+        break;
     }
   }
 };
@@ -682,10 +731,20 @@ class FusedConv2DOp : public OpKernel {
           {FCT::kBiasAddWithRelu, {"BiasAdd", "Relu"}},
           {FCT::kBiasAddWithRelu6, {"BiasAdd", "Relu6"}},
           {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}},
+          {FCT::kBiasAddWithTanh, {"BiasAdd", "Tanh"}},
+          {FCT::kBiasAddWithSigmoid, {"BiasAdd", "Sigmoid"}},
+          {FCT::kBiasAddWithMul, {"BiasAdd", "Mul"}},
+          {FCT::kBiasAddWithMulAndRelu, {"BiasAdd", "Mul", "Relu"}},
+          {FCT::kBiasAddWithMulAndRelu6, {"BiasAdd", "Mul", "Relu6"}},
+          {FCT::kBiasAddWithMulAndElu, {"BiasAdd", "Mul", "Elu"}},
+          {FCT::kBiasAddWithMulAndTanh, {"BiasAdd", "Mul", "Tanh"}},
+          {FCT::kBiasAddWithMulAndSigmoid, {"BiasAdd", "Mul", "Sigmoid"}},
           {FCT::kFusedBatchNorm, {"FusedBatchNorm"}},
           {FCT::kFusedBatchNormWithRelu, {"FusedBatchNorm", "Relu"}},
           {FCT::kFusedBatchNormWithRelu6, {"FusedBatchNorm", "Relu6"}},
           {FCT::kFusedBatchNormWithElu, {"FusedBatchNorm", "Elu"}},
+          {FCT::kFusedBatchNormWithTanh, {"FusedBatchNorm", "Tanh"}},
+          {FCT::kFusedBatchNormWithSigmoid, {"FusedBatchNorm", "Sigmoid"}},
       };
     }
 
@@ -661,6 +661,10 @@ class FusedConv2DOpTest : public OpsTestBase {
       ops::Relu6(root.WithOpName("with_activation"), with_bias);
     } else if (activation_type == "Elu") {
       ops::Elu(root.WithOpName("with_activation"), with_bias);
+    } else if (activation_type == "Tanh") {
+      ops::Tanh(root.WithOpName("with_activation"), with_bias);
+    } else if (activation_type == "Sigmoid") {
+      ops::Sigmoid(root.WithOpName("with_activation"), with_bias);
     } else {
       ops::Identity(root.WithOpName("with_activation"), with_bias);
     }
@@ -668,6 +672,46 @@ class FusedConv2DOpTest : public OpsTestBase {
     RunAndFetch(root, "with_activation", output, allow_gpu_device);
   }
 
+  void RunConv2DWithBiasMulAndActivation(
+      const Tensor& input_data, const Tensor& filter_data,
+      const Tensor& bias_data, const Tensor& scale_data,
+      const string& activation_type, const std::string& padding,
+      const std::vector<int>& explicit_paddings, Tensor* output,
+      bool allow_gpu_device = false, int stride = 1) {
+    Scope root = tensorflow::Scope::NewRootScope();
+
+    ops::Conv2D conv = ops::Conv2D(
+        root.WithOpName("conv"),
+        ops::Const(root.WithOpName("input"), Input::Initializer(input_data)),
+        ops::Const(root.WithOpName("filter"), Input::Initializer(filter_data)),
+        {1, stride, stride, 1}, padding,
+        ops::Conv2D::Attrs().ExplicitPaddings(explicit_paddings));
+
+    ops::BiasAdd with_bias = ops::BiasAdd(
+        root.WithOpName("with_bias"), conv,
+        ops::Const(root.WithOpName("bias"), Input::Initializer(bias_data)));
+
+    ops::Mul with_mul = ops::Mul(
+        root.WithOpName("with_mul"), with_bias,
+        ops::Const(root.WithOpName("scale"), Input::Initializer(scale_data)));
+
+    if (activation_type == "Relu") {
+      ops::Relu(root.WithOpName("with_activation"), with_mul);
+    } else if (activation_type == "Relu6") {
+      ops::Relu6(root.WithOpName("with_activation"), with_mul);
+    } else if (activation_type == "Elu") {
+      ops::Elu(root.WithOpName("with_activation"), with_mul);
+    } else if (activation_type == "Tanh") {
+      ops::Tanh(root.WithOpName("with_activation"), with_mul);
+    } else if (activation_type == "Sigmoid") {
+      ops::Sigmoid(root.WithOpName("with_activation"), with_mul);
+    } else {
+      ops::Identity(root.WithOpName("with_activation"), with_mul);
+    }
+
+    RunAndFetch(root, "with_activation", output, allow_gpu_device);
+  }
+
   void RunConv2DWithBatchNorm(
       const Tensor& input_data, const Tensor& filter_data,
       const Tensor& scale_data, const Tensor& offset_data,
@@ -730,6 +774,10 @@ class FusedConv2DOpTest : public OpsTestBase {
       ops::Relu6(root.WithOpName("with_activation"), with_fused_batch_norm.y);
     } else if (activation_type == "Elu") {
       ops::Elu(root.WithOpName("with_activation"), with_fused_batch_norm.y);
+    } else if (activation_type == "Tanh") {
+      ops::Tanh(root.WithOpName("with_activation"), with_fused_batch_norm.y);
+    } else if (activation_type == "Sigmoid") {
+      ops::Sigmoid(root.WithOpName("with_activation"), with_fused_batch_norm.y);
     } else {
       ops::Identity(root.WithOpName("with_activation"),
                     with_fused_batch_norm.y);
@@ -931,6 +979,44 @@ class FusedConv2DOpTest : public OpsTestBase {
                              run_default, run_fused);
   }
 
+  // Verifies that computing Conv2D+BiasAdd+Mul+{Activation} in a graph, with a
+  // scalar constant Mul operand, is identical to FusedConv2D. This fusion is
+  // only implemented on CPU.
+  void VerifyConv2DWithBiasMulAndActivation(
+      const string& activation, int filter_size, int filter_count,
+      const std::vector<int>& explicit_paddings = {}, int depth = kDepth,
+      int image_width = kImageWidth, int image_height = kImageHeight,
+      int image_batch_count = kImageBatchCount) {
+    std::string padding = explicit_paddings.empty() ? "SAME" : "EXPLICIT";
+
+    Tensor scale(DataTypeToEnum<T>::v(), TensorShape({}));
+    scale.scalar<T>()() = static_cast<T>(0.5f);
+
+    std::vector<string> fused_ops = {"BiasAdd", "Mul"};
+    if (activation != "Identity") fused_ops.push_back(activation);
+
+    const BiasAddGraphRunner run_default =
+        [this, &activation, &explicit_paddings, &padding, &scale](
+            const Tensor& input_data, const Tensor& filter_data,
+            const Tensor& bias_data, Tensor* out) {
+          RunConv2DWithBiasMulAndActivation(input_data, filter_data, bias_data,
+                                            scale, activation, padding,
+                                            explicit_paddings, out);
+        };
+
+    const BiasAddGraphRunner run_fused =
+        [this, &fused_ops, &explicit_paddings, &padding, &scale](
+            const Tensor& input_data, const Tensor& filter_data,
+            const Tensor& bias_data, Tensor* out) {
+          RunFusedConv2DOp(input_data, filter_data, {bias_data, scale},
+                           fused_ops, padding, explicit_paddings, out);
+        };
+
+    VerifyBiasAddTensorsNear(depth, image_width, image_height,
+                             image_batch_count, filter_size, filter_count,
+                             run_default, run_fused);
+  }
+
   // Verifies that computing Conv2D+FusedBatchNorm in a graph is identical to
   // FusedConv2D.
   void VerifyConv2DWithBatchNorm(int filter_size, int filter_count,
@@ -1047,7 +1133,8 @@ TYPED_TEST_P(FusedConv2DWithBiasOpTest, ExplicitPaddingConvolution) {
 TYPED_TEST_P(FusedConv2DWithBiasOpTest, OneByOneConvolutionAndActivation) {
   const int filter_size = 1;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
     this->VerifyConv2DWithBiasAndActivation(activation, filter_size,
                                             filter_count);
   }
@@ -1056,7 +1143,8 @@ TYPED_TEST_P(FusedConv2DWithBiasOpTest, OneByOneConvolutionAndActivation) {
 TYPED_TEST_P(FusedConv2DWithBiasOpTest, ImageSizeConvolutionAndActivation) {
   const int filter_size = TestFixture::kImageWidth;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
     this->VerifyConv2DWithBiasAndActivation(activation, filter_size,
                                             filter_count);
   }
@@ -1065,7 +1153,8 @@ TYPED_TEST_P(FusedConv2DWithBiasOpTest, ImageSizeConvolutionAndActivation) {
 TYPED_TEST_P(FusedConv2DWithBiasOpTest, SpatialConvolutionAndActivation) {
   const int filter_size = 3;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
     this->VerifyConv2DWithBiasAndActivation(activation, filter_size,
                                             filter_count);
   }
@@ -1075,13 +1164,38 @@ TYPED_TEST_P(FusedConv2DWithBiasOpTest,
              ExplicitPaddingConvolutionAndActivation) {
   const int filter_size = 3;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
     this->VerifyConv2DWithBiasAndActivation(
         activation, filter_size, filter_count,
         /*explicit_paddings=*/{0, 0, 1, 2, 3, 4, 0, 0});
   }
 }
 
+// -------------------------------------------------------------------------- //
+// Conv2D + BiasAdd + Mul + {Activation}                                      //
+// -------------------------------------------------------------------------- //
+
+TYPED_TEST_P(FusedConv2DWithBiasOpTest, OneByOneConvolutionAndMul) {
+  const int filter_size = 1;
+  const int filter_count = 12;
+  for (const string& activation :
+       {"Identity", "Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
+    this->VerifyConv2DWithBiasMulAndActivation(activation, filter_size,
+                                               filter_count);
+  }
+}
+
+TYPED_TEST_P(FusedConv2DWithBiasOpTest, SpatialConvolutionAndMul) {
+  const int filter_size = 3;
+  const int filter_count = 12;
+  for (const string& activation :
+       {"Identity", "Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
+    this->VerifyConv2DWithBiasMulAndActivation(activation, filter_size,
+                                               filter_count);
+  }
+}
+
 // -------------------------------------------------------------------------- //
 // Conv2D + FusedBatchNorm + {Activation}                                     //
 // -------------------------------------------------------------------------- //
@@ -1115,7 +1229,8 @@ TYPED_TEST_P(FusedConv2DWithBatchNormOpTest, ExplicitPaddingConvolution) {
 TYPED_TEST_P(FusedConv2DWithBatchNormOpTest, OneByOneConvolutionAndActivation) {
   const int filter_size = 1;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
     this->VerifyConv2DWithBatchNormAndActivation(activation, filter_size,
                                                  filter_count);
   }
@@ -1125,7 +1240,8 @@ TYPED_TEST_P(FusedConv2DWithBatchNormOpTest,
              ImageSizeConvolutionAndActivation) {
   const int filter_size = TestFixture::kImageWidth;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
     this->VerifyConv2DWithBatchNormAndActivation(activation, filter_size,
                                                  filter_count);
   }
@@ -1134,7 +1250,8 @@ TYPED_TEST_P(FusedConv2DWithBatchNormOpTest,
 TYPED_TEST_P(FusedConv2DWithBatchNormOpTest, SpatialConvolutionAndActivation) {
   const int filter_size = 3;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
     this->VerifyConv2DWithBatchNormAndActivation(activation, filter_size,
                                                  filter_count);
   }
@@ -1144,22 +1261,25 @@ TYPED_TEST_P(FusedConv2DWithBatchNormOpTest,
              ExplicitPaddingConvolutionAndActivation) {
   const int filter_size = 3;
   const int filter_count = 12;
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
     this->VerifyConv2DWithBatchNormAndActivation(
         activation, filter_size, filter_count,
         /*explicit_paddings=*/{0, 0, 1, 2, 3, 4, 0, 0});
   }
 }
 
-REGISTER_TYPED_TEST_SUITE_P(FusedConv2DWithBiasOpTest,          //
-                            OneByOneConvolution,                //
-                            ImageSizeConvolution,               //
-                            SpatialConvolution,                 //
-                            ExplicitPaddingConvolution,         //
-                            OneByOneConvolutionAndActivation,   //
-                            ImageSizeConvolutionAndActivation,  //
-                            SpatialConvolutionAndActivation,    //
-                            ExplicitPaddingConvolutionAndActivation);
+REGISTER_TYPED_TEST_SUITE_P(FusedConv2DWithBiasOpTest,                //
+                            OneByOneConvolution,                      //
+                            ImageSizeConvolution,                     //
+                            SpatialConvolution,                       //
+                            ExplicitPaddingConvolution,               //
+                            OneByOneConvolutionAndActivation,         //
+                            ImageSizeConvolutionAndActivation,        //
+                            SpatialConvolutionAndActivation,          //
+                            ExplicitPaddingConvolutionAndActivation,  //
+                            OneByOneConvolutionAndMul,                //
+                            SpatialConvolutionAndMul);
 
 REGISTER_TYPED_TEST_SUITE_P(FusedConv2DWithBatchNormOpTest,     //
                             OneByOneConvolution,                //
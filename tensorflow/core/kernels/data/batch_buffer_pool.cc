@@ -0,0 +1,125 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/data/batch_buffer_pool.h"
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace data {
+
+/* static */ constexpr int64 BatchBufferPool::kDefaultMaxFreeBuffers;
+/* static */ constexpr int64 BatchBufferPool::kDefaultMaxFreeBytes;
+
+// A buffer that is returned to the pool, instead of being deallocated, when
+// the last reference to it is dropped.
+class BatchBufferPool::Buffer : public TensorBuffer {
+ public:
+  Buffer(BatchBufferPool* pool, Allocator* allocator, void* data, size_t size)
+      : TensorBuffer(data), pool_(pool), allocator_(allocator), size_(size) {
+    pool_->Ref();
+  }
+
+  ~Buffer() override {
+    pool_->Release(allocator_, data(), size_);
+    pool_->Unref();
+  }
+
+  size_t size() const override { return size_; }
+
+  TensorBuffer* root_buffer() override { return this; }
+
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name(allocator_->Name());
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+
+ private:
+  BatchBufferPool* const pool_;
+  Allocator* const allocator_;
+  const size_t size_;
+};
+
+BatchBufferPool::~BatchBufferPool() {
+  for (const FreeBuffer& buffer : free_buffers_) {
+    buffer.allocator->DeallocateRaw(buffer.data);
+  }
+}
+
+Status BatchBufferPool::Allocate(Allocator* allocator, DataType dtype,
+                                 const TensorShape& shape, Tensor* tensor) {
+  if (!DataTypeCanUseMemcpy(dtype) || shape.num_elements() == 0) {
+    *tensor = Tensor(allocator, dtype, shape);
+    if (!tensor->IsInitialized()) {
+      return errors::ResourceExhausted(
+          "Failed to allocate memory for a batch of shape ",
+          shape.DebugString());
+    }
+    return Status::OK();
+  }
+  const size_t size = shape.num_elements() * DataTypeSize(dtype);
+  void* data = nullptr;
+  {
+    mutex_lock l(mu_);
+    // Prefer the most recently released buffer, which is the most likely to
+    // still be in cache.
+    for (auto it = free_buffers_.rbegin(); it != free_buffers_.rend(); ++it) {
+      if (it->allocator == allocator && it->size == size) {
+        data = it->data;
+        free_bytes_ -= size;
+        free_buffers_.erase(std::next(it).base());
+        ++num_reused_;
+        break;
+      }
+    }
+  }
+  if (data == nullptr) {
+    data = allocator->AllocateRaw(Allocator::kAllocatorAlignment, size);
+    if (data == nullptr) {
+      return errors::ResourceExhausted(
+          "Failed to allocate memory for a batch of shape ",
+          shape.DebugString());
+    }
+  }
+  Buffer* buffer = new Buffer(this, allocator, data, size);
+  *tensor = Tensor(dtype, shape, buffer);
+  buffer->Unref();
+  return Status::OK();
+}
+
+int64 BatchBufferPool::num_reused() const {
+  tf_shared_lock l(mu_);
+  return num_reused_;
+}
+
+void BatchBufferPool::Release(Allocator* allocator, void* data, size_t size) {
+  mutex_lock l(mu_);
+  free_buffers_.push_back({allocator, data, size});
+  free_bytes_ += size;
+  // Evict the least recently released buffers, until the free buffers fit
+  // within the limits.
+  while (static_cast<int64>(free_buffers_.size()) > max_free_buffers_ ||
+         free_bytes_ > max_free_bytes_) {
+    const FreeBuffer& buffer = free_buffers_.front();
+    buffer.allocator->DeallocateRaw(buffer.data);
+    free_bytes_ -= buffer.size;
+    free_buffers_.pop_front();
+  }
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,100 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_BATCH_BUFFER_POOL_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_BATCH_BUFFER_POOL_H_
+
+#include <deque>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace data {
+
+// A `BatchBufferPool` recycles the buffers of the batches produced by a
+// batching iterator across `GetNext()` calls.
+//
+// Batching allocates a new tensor per component for every batch, which is
+// freed once the consumer of the batch releases it. For pipelines with small
+// elements, this allocation churn is a significant part of the cost of
+// batching. The buffer of a tensor allocated from the pool is instead returned
+// to the pool when the last reference to the tensor is dropped, and reused for
+// the next batch of the same allocator and size.
+//
+// The pool holds no references to the tensors it hands out, so consumers can
+// still forward or move their buffers when they hold the only reference. Only
+// types that can be copied with memcpy are pooled; tensors of other types are
+// allocated as usual.
+//
+// The pool is thread-safe and reference-counted. Each outstanding tensor holds
+// a reference to it, so it can be released by its owner while batches it
+// produced are still in use.
+class BatchBufferPool : public core::RefCounted {
+ public:
+  // Limits on the buffers the pool keeps while they are not in use.
+  static constexpr int64 kDefaultMaxFreeBuffers = 8;
+  static constexpr int64 kDefaultMaxFreeBytes = 64 * 1024 * 1024;
+
+  explicit BatchBufferPool(int64 max_free_buffers = kDefaultMaxFreeBuffers,
+                           int64 max_free_bytes = kDefaultMaxFreeBytes)
+      : max_free_buffers_(max_free_buffers), max_free_bytes_(max_free_bytes) {}
+
+  ~BatchBufferPool() override;
+
+  // Sets `*tensor` to a tensor of the given type and shape, reusing a free
+  // buffer of `allocator` if the pool has one of the right size. The contents
+  // of the tensor are undefined.
+  Status Allocate(Allocator* allocator, DataType dtype,
+                  const TensorShape& shape, Tensor* tensor) LOCKS_EXCLUDED(mu_);
+
+  // Returns the number of tensors whose buffer was reused.
+  int64 num_reused() const LOCKS_EXCLUDED(mu_);
+
+ private:
+  class Buffer;
+
+  struct FreeBuffer {
+    Allocator* allocator;
+    void* data;
+    size_t size;
+  };
+
+  // Called by `Buffer` when the last reference to it is dropped.
+  void Release(Allocator* allocator, void* data, size_t size)
+      LOCKS_EXCLUDED(mu_);
+
+  const int64 max_free_buffers_;
+  const int64 max_free_bytes_;
+
+  mutable mutex mu_;
+  // Ordered from the least to the most recently released.
+  std::deque<FreeBuffer> free_buffers_ GUARDED_BY(mu_);
+  int64 free_bytes_ GUARDED_BY(mu_) = 0;
+  int64 num_reused_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BatchBufferPool);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_BATCH_BUFFER_POOL_H_
@@ -0,0 +1,128 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/data/batch_buffer_pool.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+TEST(BatchBufferPool, ReusesReleasedBuffers) {
+  core::RefCountPtr<BatchBufferPool> pool(new BatchBufferPool());
+  Tensor tensor;
+  TF_ASSERT_OK(
+      pool->Allocate(cpu_allocator(), DT_INT64, TensorShape({8, 2}), &tensor));
+  const void* data = tensor.tensor_data().data();
+  tensor.flat<int64>().setConstant(42);
+  tensor = Tensor();
+  EXPECT_EQ(pool->num_reused(), 0);
+
+  TF_ASSERT_OK(
+      pool->Allocate(cpu_allocator(), DT_INT64, TensorShape({8, 2}), &tensor));
+  EXPECT_EQ(pool->num_reused(), 1);
+  EXPECT_EQ(tensor.tensor_data().data(), data);
+  EXPECT_EQ(tensor.shape(), TensorShape({8, 2}));
+
+  // A buffer of the same size is reused regardless of type and shape.
+  tensor = Tensor();
+  TF_ASSERT_OK(
+      pool->Allocate(cpu_allocator(), DT_DOUBLE, TensorShape({16}), &tensor));
+  EXPECT_EQ(pool->num_reused(), 2);
+  EXPECT_EQ(tensor.tensor_data().data(), data);
+  EXPECT_EQ(tensor.dtype(), DT_DOUBLE);
+}
+
+TEST(BatchBufferPool, DoesNotReuseBuffersInUse) {
+  core::RefCountPtr<BatchBufferPool> pool(new BatchBufferPool());
+  Tensor tensor1;
+  TF_ASSERT_OK(
+      pool->Allocate(cpu_allocator(), DT_FLOAT, TensorShape({4}), &tensor1));
+  // Slices share the buffer of the tensor they were taken from.
+  Tensor slice = tensor1.Slice(1, 2);
+  tensor1 = Tensor();
+  Tensor tensor2;
+  TF_ASSERT_OK(
+      pool->Allocate(cpu_allocator(), DT_FLOAT, TensorShape({4}), &tensor2));
+  EXPECT_EQ(pool->num_reused(), 0);
+  EXPECT_NE(tensor2.tensor_data().data(), slice.tensor_data().data());
+
+  // Buffers of a different size are not reused.
+  slice = Tensor();
+  Tensor tensor3;
+  TF_ASSERT_OK(
+      pool->Allocate(cpu_allocator(), DT_FLOAT, TensorShape({3}), &tensor3));
+  EXPECT_EQ(pool->num_reused(), 0);
+}
+
+TEST(BatchBufferPool, DoesNotPoolStrings) {
+  core::RefCountPtr<BatchBufferPool> pool(new BatchBufferPool());
+  for (int i = 0; i < 2; ++i) {
+    Tensor tensor;
+    TF_ASSERT_OK(
+        pool->Allocate(cpu_allocator(), DT_STRING, TensorShape({2}), &tensor));
+    tensor.flat<tstring>()(0) = "a";
+    tensor.flat<tstring>()(1) = "b";
+    test::ExpectTensorEqual<tstring>(
+        tensor, test::AsTensor<tstring>({"a", "b"}, TensorShape({2})));
+  }
+  EXPECT_EQ(pool->num_reused(), 0);
+}
+
+TEST(BatchBufferPool, LimitsFreeBuffers) {
+  core::RefCountPtr<BatchBufferPool> pool(
+      new BatchBufferPool(/*max_free_buffers=*/1, /*max_free_bytes=*/1024));
+  std::vector<Tensor> tensors(3);
+  for (Tensor& tensor : tensors) {
+    TF_ASSERT_OK(
+        pool->Allocate(cpu_allocator(), DT_INT8, TensorShape({16}), &tensor));
+  }
+  tensors.clear();
+  tensors.resize(3);
+  for (Tensor& tensor : tensors) {
+    TF_ASSERT_OK(
+        pool->Allocate(cpu_allocator(), DT_INT8, TensorShape({16}), &tensor));
+  }
+  EXPECT_EQ(pool->num_reused(), 1);
+
+  // Buffers larger than the byte limit are never kept.
+  tensors.clear();
+  Tensor tensor;
+  TF_ASSERT_OK(
+      pool->Allocate(cpu_allocator(), DT_INT8, TensorShape({2048}), &tensor));
+  tensor = Tensor();
+  TF_ASSERT_OK(
+      pool->Allocate(cpu_allocator(), DT_INT8, TensorShape({2048}), &tensor));
+  EXPECT_EQ(pool->num_reused(), 1);
+}
+
+TEST(BatchBufferPool, TensorsOutliveOwner) {
+  Tensor tensor;
+  {
+    core::RefCountPtr<BatchBufferPool> pool(new BatchBufferPool());
+    TF_ASSERT_OK(
+        pool->Allocate(cpu_allocator(), DT_INT32, TensorShape({2}), &tensor));
+  }
+  tensor.flat<int32>().setConstant(7);
+  test::ExpectTensorEqual<int32>(
+      tensor, test::AsTensor<int32>({7, 7}, TensorShape({2})));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
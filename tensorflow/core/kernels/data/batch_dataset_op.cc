@@ -17,9 +17,11 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/batch_buffer_pool.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/util/batch_util.h"
 
@@ -127,7 +129,8 @@ class BatchDatasetOp::Dataset : public DatasetBase {
   class Iterator : public DatasetIterator<Dataset> {
    public:
     explicit Iterator(const Params& params)
-        : DatasetIterator<Dataset>(params) {}
+        : DatasetIterator<Dataset>(params),
+          batch_buffer_pool_(new BatchBufferPool()) {}
 
     Status Initialize(IteratorContext* ctx) override {
       return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
@@ -189,12 +192,16 @@ class BatchDatasetOp::Dataset : public DatasetBase {
         // element is moved into the output batch.
         TensorShape first_element_shape(first_element.shape());
         batch_component_shape.AppendShape(first_element_shape);
-        out_tensors->emplace_back(ctx->allocator({}), first_element.dtype(),
-                                  batch_component_shape);
-        if (!out_tensors->back().IsInitialized()) {
-          return errors::ResourceExhausted(
-              "Failed to allocate memory for the batch of component ",
-              component_index);
+        out_tensors->emplace_back();
+        Status s = batch_buffer_pool_->Allocate(
+            ctx->allocator({}), first_element.dtype(), batch_component_shape,
+            &out_tensors->back());
+        if (!s.ok()) {
+          return Status(
+              s.code(),
+              strings::StrCat(
+                  "Failed to allocate memory for the batch of component ",
+                  component_index, ": ", s.error_message()));
         }
         Tensor& batch_component = out_tensors->back();
         // Build the output tuple component by copying one slice
@@ -272,6 +279,8 @@ class BatchDatasetOp::Dataset : public DatasetBase {
    private:
     mutex mu_;
     std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+    // Recycles the buffers of the batches once they are released.
+    const core::RefCountPtr<BatchBufferPool> batch_buffer_pool_;
   };
 
   const int64 batch_size_;
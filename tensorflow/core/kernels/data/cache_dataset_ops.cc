@@ -16,10 +16,13 @@ limitations under the License.
 
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/stats_aggregator.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/cache_ops.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/kernels/data/stats_utils.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
@@ -35,6 +38,9 @@ namespace data {
 /* static */ constexpr const char* const CacheDatasetOp::kFileName;
 /* static */ constexpr const char* const CacheDatasetOp::kOutputTypes;
 /* static */ constexpr const char* const CacheDatasetOp::kOutputShapes;
+/* static */ constexpr const char* const CacheDatasetOp::kMemoryLimit;
+/* static */ constexpr const char* const CacheDatasetOp::kCompression;
+/* static */ constexpr const char* const CacheDatasetOp::kSpillDirectory;
 
 constexpr char kKeyStrFormat[] = "%%%zuzu_%%%zuzu";
 constexpr char kPaddingSizeStrFormat[] = "%zu";
@@ -291,6 +297,11 @@ class CacheDatasetOp::FileDataset : public DatasetBase {
           TF_RETURN_IF_ERROR(Finish());
         }
         cur_index_++;
+        auto stats_aggregator = ctx->stats_aggregator();
+        if (stats_aggregator) {
+          stats_aggregator->IncrementCounter(dataset()->node_name(),
+                                             stats_utils::kCacheMisses, 1);
+        }
         return Status::OK();
       }
 
@@ -520,6 +531,11 @@ class CacheDatasetOp::FileDataset : public DatasetBase {
           TF_RETURN_IF_ERROR(reader_.status());
         }
         cur_index_++;
+        auto stats_aggregator = ctx->stats_aggregator();
+        if (stats_aggregator) {
+          stats_aggregator->IncrementCounter(dataset()->node_name(),
+                                             stats_utils::kCacheHits, 1);
+        }
         return Status::OK();
       }
 
@@ -633,8 +649,11 @@ class CacheDatasetOp::FileDatasetV2 : public CacheDatasetOp::FileDataset {
 class CacheDatasetOp::MemoryDataset : public DatasetBase {
  public:
   explicit MemoryDataset(OpKernelContext* ctx, const DatasetBase* input,
-                         MemoryCache* cache)
-      : DatasetBase(DatasetContext(ctx)), input_(input), cache_(cache) {
+                         MemoryCache* cache, const MemoryCacheOptions& options)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        cache_(cache),
+        options_(options) {
     input_->Ref();
   }
 
@@ -683,11 +702,28 @@ class CacheDatasetOp::MemoryDataset : public DatasetBase {
     TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_node));
     Node* filename_node = nullptr;
     TF_RETURN_IF_ERROR(b->AddScalar(tstring(""), &filename_node));
-    TF_RETURN_IF_ERROR(
-        b->AddDataset(this, {input_node, filename_node}, output));
+    TF_RETURN_IF_ERROR(b->AddDataset(this, {input_node, filename_node},
+                                     OptionsAttrs(b), output));
     return Status::OK();
   }
 
+  // Returns the attrs holding `options_`.
+  std::vector<std::pair<StringPiece, AttrValue>> OptionsAttrs(
+      DatasetGraphDefBuilder* b) const {
+    AttrValue memory_limit;
+    b->BuildAttrValue(options_.memory_limit, &memory_limit);
+    AttrValue compression;
+    b->BuildAttrValue(
+        string(options_.compress ? io::compression::kSnappy
+                                 : io::compression::kNone),
+        &compression);
+    AttrValue spill_directory;
+    b->BuildAttrValue(options_.spill_directory, &spill_directory);
+    return {std::make_pair(kMemoryLimit, memory_limit),
+            std::make_pair(kCompression, compression),
+            std::make_pair(kSpillDirectory, spill_directory)};
+  }
+
   class MemoryIterator : public DatasetIterator<MemoryDataset> {
    public:
     explicit MemoryIterator(const Params& params, MemoryCache* cache)
@@ -715,6 +751,9 @@ class CacheDatasetOp::MemoryDataset : public DatasetBase {
             }));
       }
       mode_ = cache_->MaybeClaim() ? Mode::write : Mode::read;
+      if (mode_ == Mode::write) {
+        TF_RETURN_IF_ERROR(cache_->Configure(ctx->env(), dataset()->options_));
+      }
       InitializeIterator();
       if (mode_ == Mode::read && !cache_->IsCompleted()) {
         return errors::Internal(
@@ -746,7 +785,8 @@ class CacheDatasetOp::MemoryDataset : public DatasetBase {
         TF_RETURN_IF_ERROR(
             writer->WriteScalar(full_name(kCacheSize), cache_size));
         for (size_t i = 0; i < cache_size; i++) {
-          auto& element = cache_->at(i);
+          std::vector<Tensor> element;
+          TF_RETURN_IF_ERROR(cache_->at(i, &element));
           TF_RETURN_IF_ERROR(writer->WriteScalar(
               full_name(strings::StrCat(kCache, "[", i, "]", kSizeSuffix)),
               element.size()));
@@ -776,6 +816,7 @@ class CacheDatasetOp::MemoryDataset : public DatasetBase {
       }
       if (reader->Contains(full_name(kCacheClaimed))) {
         CHECK(cache_->MaybeClaim());
+        TF_RETURN_IF_ERROR(cache_->Configure(ctx->env(), dataset()->options_));
         size_t cache_size;
         {
           int64 temp;
@@ -799,7 +840,7 @@ class CacheDatasetOp::MemoryDataset : public DatasetBase {
                 full_name(strings::StrCat(kCache, "[", i, "][", j, "]")),
                 &element.back()));
           }
-          cache_->emplace_back(std::move(element));
+          TF_RETURN_IF_ERROR(cache_->emplace_back(std::move(element)));
         }
         if (reader->Contains(full_name(kCacheCompleted))) {
           cache_->Complete();
@@ -847,7 +888,19 @@ class CacheDatasetOp::MemoryDataset : public DatasetBase {
           return Status::OK();
         }
         RecordBufferEnqueue(ctx, *out_tensors);
-        cache_->emplace_back(*out_tensors);
+        TF_RETURN_IF_ERROR(cache_->emplace_back(*out_tensors));
+        auto stats_aggregator = ctx->stats_aggregator();
+        if (stats_aggregator) {
+          const string& node_name = dataset()->node_name();
+          stats_aggregator->IncrementCounter(node_name,
+                                             stats_utils::kCacheMisses, 1);
+          stats_aggregator->AddScalar(
+              stats_utils::CacheBytesInMemoryScalarName(node_name),
+              static_cast<float>(cache_->bytes_in_memory()), cache_->size());
+          stats_aggregator->AddScalar(
+              stats_utils::CacheBytesSpilledScalarName(node_name),
+              static_cast<float>(cache_->bytes_spilled()), cache_->size());
+        }
         return Status::OK();
       }
 
@@ -889,9 +942,7 @@ class CacheDatasetOp::MemoryDataset : public DatasetBase {
         // is that this is incorrect if there are concurrent instances of this
         // iterator.
         tf_shared_lock l(mu_);
-        for (size_t i = 0; i < cache_->size(); ++i) {
-          RecordBufferEnqueue(ctx, cache_->at(i));
-        }
+        RecordBufferEnqueue(ctx, cache_->bytes_in_memory(), cache_->size());
         return Status::OK();
       }
 
@@ -900,11 +951,18 @@ class CacheDatasetOp::MemoryDataset : public DatasetBase {
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
         if (index_ < cache_->size()) {
-          const std::vector<Tensor>& cache_tensors = cache_->at(index_);
-          out_tensors->insert(out_tensors->begin(), cache_tensors.begin(),
-                              cache_tensors.end());
+          std::vector<Tensor> cache_tensors;
+          TF_RETURN_IF_ERROR(cache_->at(index_, &cache_tensors));
+          out_tensors->insert(out_tensors->begin(),
+                              std::make_move_iterator(cache_tensors.begin()),
+                              std::make_move_iterator(cache_tensors.end()));
           index_++;
           *end_of_sequence = false;
+          auto stats_aggregator = ctx->stats_aggregator();
+          if (stats_aggregator) {
+            stats_aggregator->IncrementCounter(dataset()->node_name(),
+                                               stats_utils::kCacheHits, 1);
+          }
           return Status::OK();
         } else {
           *end_of_sequence = true;
@@ -967,13 +1025,17 @@ class CacheDatasetOp::MemoryDataset : public DatasetBase {
 
   const DatasetBase* const input_;
   MemoryCache* cache_ = nullptr;
+  const MemoryCacheOptions options_;
 };  // MemoryDataset
 
 class CacheDatasetOp::MemoryDatasetV2 : public CacheDatasetOp::MemoryDataset {
  public:
   explicit MemoryDatasetV2(OpKernelContext* ctx, const DatasetBase* input,
-                           MemoryCache* cache, const Tensor& resource_handle)
-      : MemoryDataset(ctx, input, cache), resource_handle_(resource_handle) {}
+                           MemoryCache* cache,
+                           const MemoryCacheOptions& options,
+                           const Tensor& resource_handle)
+      : MemoryDataset(ctx, input, cache, options),
+        resource_handle_(resource_handle) {}
 
   Status CheckExternalState() const override {
     return errors::FailedPrecondition(DebugString(),
@@ -990,8 +1052,9 @@ class CacheDatasetOp::MemoryDatasetV2 : public CacheDatasetOp::MemoryDataset {
     TF_RETURN_IF_ERROR(b->AddScalar(tstring(""), &filename_node));
     Node* resource_handle_node = nullptr;
     TF_RETURN_IF_ERROR(b->AddTensor(resource_handle_, &resource_handle_node));
-    TF_RETURN_IF_ERROR(b->AddDataset(
-        this, {input_node, filename_node, resource_handle_node}, output));
+    TF_RETURN_IF_ERROR(
+        b->AddDataset(this, {input_node, filename_node, resource_handle_node},
+                      OptionsAttrs(b), output));
     return Status::OK();
   }
 
@@ -1001,7 +1064,25 @@ class CacheDatasetOp::MemoryDatasetV2 : public CacheDatasetOp::MemoryDataset {
 
 CacheDatasetOp::CacheDatasetOp(OpKernelConstruction* ctx)
     : UnaryDatasetOpKernel(ctx),
-      op_version_(ctx->def().op() == kCacheDataset ? 1 : 2) {}
+      op_version_(ctx->def().op() == kCacheDataset ? 1 : 2) {
+  if (ctx->HasAttr(kMemoryLimit)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kMemoryLimit, &memory_limit_));
+    OP_REQUIRES(ctx, memory_limit_ >= 0,
+                errors::InvalidArgument(
+                    "memory_limit must be greater than or equal to 0."));
+  }
+  if (ctx->HasAttr(kCompression)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kCompression, &compression_));
+    OP_REQUIRES(ctx,
+                compression_ == io::compression::kNone ||
+                    compression_ == io::compression::kSnappy,
+                errors::InvalidArgument("Unsupported compression: ",
+                                        compression_));
+  }
+  if (ctx->HasAttr(kSpillDirectory)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kSpillDirectory, &spill_directory_));
+  }
+}
 
 void CacheDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                                  DatasetBase** output) {
@@ -1010,13 +1091,17 @@ void CacheDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
   OP_REQUIRES_OK(ctx, ParseScalarArgument<tstring>(ctx, kFileName, &filename));
 
   if (filename.empty()) {
+    MemoryCacheOptions options;
+    options.memory_limit = memory_limit_;
+    options.compress = compression_ == io::compression::kSnappy;
+    options.spill_directory = spill_directory_;
     if (op_version_ == 2) {
       MemoryCache* cache = nullptr;
       OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 2), &cache));
       // Transferring cache reference ownership onto `MemoryDatasetV2`.
-      *output = new MemoryDatasetV2(ctx, input, cache, ctx->input(2));
+      *output = new MemoryDatasetV2(ctx, input, cache, options, ctx->input(2));
     } else {
-      *output = new MemoryDataset(ctx, input, /*cache=*/nullptr);
+      *output = new MemoryDataset(ctx, input, /*cache=*/nullptr, options);
     }
   } else {
     if (op_version_ == 2) {
@@ -30,6 +30,9 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
   static constexpr const char* const kFileName = "filename";
   static constexpr const char* const kOutputTypes = "output_types";
   static constexpr const char* const kOutputShapes = "output_shapes";
+  static constexpr const char* const kMemoryLimit = "memory_limit";
+  static constexpr const char* const kCompression = "compression";
+  static constexpr const char* const kSpillDirectory = "spill_directory";
 
   explicit CacheDatasetOp(OpKernelConstruction* ctx);
 
@@ -42,6 +45,10 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
   class MemoryDatasetV2;
 
   int op_version_;
+  // How the in-memory cache stores its elements. See `MemoryCacheOptions`.
+  int64 memory_limit_ = 0;
+  string compression_;
+  string spill_directory_;
 };
 
 }  // namespace data
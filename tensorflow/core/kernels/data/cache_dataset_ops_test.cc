@@ -12,6 +12,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/cache_dataset_ops.h"
 
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/lib/io/path.h"
 
 namespace tensorflow {
 namespace data {
@@ -58,13 +59,18 @@ class CacheDatasetOpTest : public DatasetOpsTestBase {
   // Create a new `CacheDataset` op kernel.
   Status CreateCacheDatasetOpKernel(
       const DataTypeVector& output_types,
-      const std::vector<PartialTensorShape>& output_shapes,
+      const std::vector<PartialTensorShape>& output_shapes, int64 memory_limit,
+      const string& compression,
       std::unique_ptr<OpKernel>* cache_dataset_op_kernel) {
     NodeDef node_def = test::function::NDef(
         kNodeName, name_utils::OpName(CacheDatasetOp::kDatasetType),
         {CacheDatasetOp::kInputDataset, CacheDatasetOp::kFileName},
         {{CacheDatasetOp::kOutputTypes, output_types},
-         {CacheDatasetOp::kOutputShapes, output_shapes}});
+         {CacheDatasetOp::kOutputShapes, output_shapes},
+         {CacheDatasetOp::kMemoryLimit, memory_limit},
+         {CacheDatasetOp::kCompression, compression},
+         {CacheDatasetOp::kSpillDirectory,
+          io::JoinPath(testing::TmpDir(), "cache_spill")}});
     TF_RETURN_IF_ERROR(CreateOpKernel(node_def, cache_dataset_op_kernel));
     return Status::OK();
   }
@@ -93,6 +99,8 @@ struct TestCase {
   std::vector<PartialTensorShape> expected_output_shapes;
   int64 expected_cardinality;
   std::vector<int> breakpoints;
+  int64 memory_limit = 0;
+  string compression;
 };
 
 // Test case 1: cache data in file.
@@ -147,6 +155,41 @@ TestCase TestCase4() {
           /*breakpoints*/ {0, 2, 4, 11}};
 }
 
+// Test case 5: cache compressed data in memory.
+TestCase TestCase5() {
+  return {/*input_tensors*/ {CreateTensor<int64>(TensorShape{3, 3, 1},
+                                                 {0, 1, 2, 3, 4, 5, 6, 7, 8})},
+          /*file_name*/ "",
+          /*expected_outputs*/
+          {CreateTensor<int64>(TensorShape{3, 1}, {0, 1, 2}),
+           CreateTensor<int64>(TensorShape{3, 1}, {3, 4, 5}),
+           CreateTensor<int64>(TensorShape{3, 1}, {6, 7, 8})},
+          /*expected_output_dtypes*/ {DT_INT64},
+          /*expected_output_shapes*/ {PartialTensorShape({3, 1})},
+          /*expected_cardinality*/ 3,
+          /*breakpoints*/ {0, 2, 4, 11},
+          /*memory_limit*/ 0,
+          /*compression*/ "SNAPPY"};
+}
+
+// Test case 6: cache data in memory, spilling the elements that exceed the
+// memory limit to disk.
+TestCase TestCase6() {
+  return {/*input_tensors*/ {CreateTensor<int64>(TensorShape{3, 3, 1},
+                                                 {0, 1, 2, 3, 4, 5, 6, 7, 8})},
+          /*file_name*/ "",
+          /*expected_outputs*/
+          {CreateTensor<int64>(TensorShape{3, 1}, {0, 1, 2}),
+           CreateTensor<int64>(TensorShape{3, 1}, {3, 4, 5}),
+           CreateTensor<int64>(TensorShape{3, 1}, {6, 7, 8})},
+          /*expected_output_dtypes*/ {DT_INT64},
+          /*expected_output_shapes*/ {PartialTensorShape({3, 1})},
+          /*expected_cardinality*/ 3,
+          /*breakpoints*/ {0, 2, 4, 11},
+          /*memory_limit*/ 64,
+          /*compression*/ ""};
+}
+
 class ParameterizedCacheDatasetOpTest
     : public CacheDatasetOpTest,
       public ::testing::WithParamInterface<TestCase> {};
@@ -158,9 +201,9 @@ TEST_P(ParameterizedCacheDatasetOpTest, GetNext) {
   TF_ASSERT_OK(InitFunctionLibraryRuntime({}, cpu_num));
 
   std::unique_ptr<OpKernel> cache_dataset_kernel;
-  TF_ASSERT_OK(CreateCacheDatasetOpKernel(test_case.expected_output_dtypes,
-                                          test_case.expected_output_shapes,
-                                          &cache_dataset_kernel));
+  TF_ASSERT_OK(CreateCacheDatasetOpKernel(
+      test_case.expected_output_dtypes, test_case.expected_output_shapes,
+      test_case.memory_limit, test_case.compression, &cache_dataset_kernel));
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
   TF_ASSERT_OK(CreateTensorSliceDatasetTensor(&inputs_for_tensor_slice_dataset,
@@ -218,9 +261,9 @@ TEST_F(CacheDatasetOpTest, DatasetNodeName) {
   TF_ASSERT_OK(InitFunctionLibraryRuntime({}, cpu_num));
 
   std::unique_ptr<OpKernel> cache_dataset_kernel;
-  TF_ASSERT_OK(CreateCacheDatasetOpKernel(test_case.expected_output_dtypes,
-                                          test_case.expected_output_shapes,
-                                          &cache_dataset_kernel));
+  TF_ASSERT_OK(CreateCacheDatasetOpKernel(
+      test_case.expected_output_dtypes, test_case.expected_output_shapes,
+      test_case.memory_limit, test_case.compression, &cache_dataset_kernel));
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
   TF_ASSERT_OK(CreateTensorSliceDatasetTensor(&inputs_for_tensor_slice_dataset,
@@ -247,9 +290,9 @@ TEST_P(ParameterizedCacheDatasetOpTest, DatasetTypeString) {
   TF_ASSERT_OK(InitFunctionLibraryRuntime({}, cpu_num));
 
   std::unique_ptr<OpKernel> cache_dataset_kernel;
-  TF_ASSERT_OK(CreateCacheDatasetOpKernel(test_case.expected_output_dtypes,
-                                          test_case.expected_output_shapes,
-                                          &cache_dataset_kernel));
+  TF_ASSERT_OK(CreateCacheDatasetOpKernel(
+      test_case.expected_output_dtypes, test_case.expected_output_shapes,
+      test_case.memory_limit, test_case.compression, &cache_dataset_kernel));
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
   TF_ASSERT_OK(CreateTensorSliceDatasetTensor(&inputs_for_tensor_slice_dataset,
@@ -277,9 +320,9 @@ TEST_P(ParameterizedCacheDatasetOpTest, DatasetOutputDtypes) {
   TF_ASSERT_OK(InitFunctionLibraryRuntime({}, cpu_num));
 
   std::unique_ptr<OpKernel> cache_dataset_kernel;
-  TF_ASSERT_OK(CreateCacheDatasetOpKernel(test_case.expected_output_dtypes,
-                                          test_case.expected_output_shapes,
-                                          &cache_dataset_kernel));
+  TF_ASSERT_OK(CreateCacheDatasetOpKernel(
+      test_case.expected_output_dtypes, test_case.expected_output_shapes,
+      test_case.memory_limit, test_case.compression, &cache_dataset_kernel));
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
   TF_ASSERT_OK(CreateTensorSliceDatasetTensor(&inputs_for_tensor_slice_dataset,
@@ -307,9 +350,9 @@ TEST_P(ParameterizedCacheDatasetOpTest, DatasetOutputShapes) {
   TF_ASSERT_OK(InitFunctionLibraryRuntime({}, cpu_num));
 
   std::unique_ptr<OpKernel> cache_dataset_kernel;
-  TF_ASSERT_OK(CreateCacheDatasetOpKernel(test_case.expected_output_dtypes,
-                                          test_case.expected_output_shapes,
-                                          &cache_dataset_kernel));
+  TF_ASSERT_OK(CreateCacheDatasetOpKernel(
+      test_case.expected_output_dtypes, test_case.expected_output_shapes,
+      test_case.memory_limit, test_case.compression, &cache_dataset_kernel));
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
   TF_ASSERT_OK(CreateTensorSliceDatasetTensor(&inputs_for_tensor_slice_dataset,
@@ -337,9 +380,9 @@ TEST_P(ParameterizedCacheDatasetOpTest, Cardinality) {
   TF_ASSERT_OK(InitFunctionLibraryRuntime({}, cpu_num));
 
   std::unique_ptr<OpKernel> cache_dataset_kernel;
-  TF_ASSERT_OK(CreateCacheDatasetOpKernel(test_case.expected_output_dtypes,
-                                          test_case.expected_output_shapes,
-                                          &cache_dataset_kernel));
+  TF_ASSERT_OK(CreateCacheDatasetOpKernel(
+      test_case.expected_output_dtypes, test_case.expected_output_shapes,
+      test_case.memory_limit, test_case.compression, &cache_dataset_kernel));
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
   TF_ASSERT_OK(CreateTensorSliceDatasetTensor(&inputs_for_tensor_slice_dataset,
@@ -366,9 +409,9 @@ TEST_P(ParameterizedCacheDatasetOpTest, IteratorOutputShapes) {
   TF_ASSERT_OK(InitFunctionLibraryRuntime({}, cpu_num));
 
   std::unique_ptr<OpKernel> cache_dataset_kernel;
-  TF_ASSERT_OK(CreateCacheDatasetOpKernel(test_case.expected_output_dtypes,
-                                          test_case.expected_output_shapes,
-                                          &cache_dataset_kernel));
+  TF_ASSERT_OK(CreateCacheDatasetOpKernel(
+      test_case.expected_output_dtypes, test_case.expected_output_shapes,
+      test_case.memory_limit, test_case.compression, &cache_dataset_kernel));
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
   TF_ASSERT_OK(CreateTensorSliceDatasetTensor(&inputs_for_tensor_slice_dataset,
@@ -403,9 +446,9 @@ TEST_P(ParameterizedCacheDatasetOpTest, IteratorOutputPrefix) {
   TF_ASSERT_OK(InitFunctionLibraryRuntime({}, cpu_num));
 
   std::unique_ptr<OpKernel> cache_dataset_kernel;
-  TF_ASSERT_OK(CreateCacheDatasetOpKernel(test_case.expected_output_dtypes,
-                                          test_case.expected_output_shapes,
-                                          &cache_dataset_kernel));
+  TF_ASSERT_OK(CreateCacheDatasetOpKernel(
+      test_case.expected_output_dtypes, test_case.expected_output_shapes,
+      test_case.memory_limit, test_case.compression, &cache_dataset_kernel));
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
   TF_ASSERT_OK(CreateTensorSliceDatasetTensor(&inputs_for_tensor_slice_dataset,
@@ -444,9 +487,9 @@ TEST_P(ParameterizedCacheDatasetOpTest, Roundtrip) {
   TF_ASSERT_OK(InitFunctionLibraryRuntime({}, cpu_num));
 
   std::unique_ptr<OpKernel> cache_dataset_kernel;
-  TF_ASSERT_OK(CreateCacheDatasetOpKernel(test_case.expected_output_dtypes,
-                                          test_case.expected_output_shapes,
-                                          &cache_dataset_kernel));
+  TF_ASSERT_OK(CreateCacheDatasetOpKernel(
+      test_case.expected_output_dtypes, test_case.expected_output_shapes,
+      test_case.memory_limit, test_case.compression, &cache_dataset_kernel));
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
   TF_ASSERT_OK(CreateTensorSliceDatasetTensor(&inputs_for_tensor_slice_dataset,
@@ -522,7 +565,8 @@ TEST_P(ParameterizedCacheDatasetOpTest, Roundtrip) {
 INSTANTIATE_TEST_SUITE_P(
     CacheDatasetOpTest, ParameterizedCacheDatasetOpTest,
     ::testing::ValuesIn(std::vector<TestCase>({TestCase1(), TestCase2(),
-                                               TestCase3(), TestCase4()})));
+                                               TestCase3(), TestCase4(),
+                                               TestCase5(), TestCase6()})));
 
 }  // namespace
 }  // namespace data
@@ -18,20 +18,80 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/snappy.h"
 
 namespace tensorflow {
 namespace data {
 namespace {
 
 const char kMemoryCache[] = "MemoryCache";
+// Serialized elements are copied into arena blocks of this size. Larger
+// elements get a block of their own.
+const size_t kArenaBlockBytes = 1 << 20;  // 1 MB.
+
+// Serializes `element`, snappy-compressing it if `compress` is set and that
+// makes it smaller.
+Status SerializeCachedElement(const std::vector<Tensor>& element, bool compress,
+                              string* bytes, bool* compressed) {
+  TF_RETURN_IF_ERROR(SerializeElement(element, bytes));
+  *compressed = false;
+  if (compress) {
+    // Elements that do not shrink, or that cannot be compressed because
+    // snappy is unavailable, are kept uncompressed.
+    string output;
+    if (port::Snappy_Compress(bytes->data(), bytes->size(), &output) &&
+        output.size() < bytes->size()) {
+      bytes->swap(output);
+      *compressed = true;
+    }
+  }
+  return Status::OK();
+}
+
+Status DeserializeCachedElement(const char* data, size_t size, bool compressed,
+                                std::vector<Tensor>* element) {
+  string uncompressed;
+  if (compressed) {
+    size_t uncompressed_size;
+    if (!port::Snappy_GetUncompressedLength(data, size, &uncompressed_size)) {
+      return errors::DataLoss("Failed to decompress a cached element.");
+    }
+    uncompressed.resize(uncompressed_size);
+    if (!port::Snappy_Uncompress(data, size, &uncompressed[0])) {
+      return errors::DataLoss("Failed to decompress a cached element.");
+    }
+    data = uncompressed.data();
+    size = uncompressed.size();
+  }
+  return DeserializeElement(data, size, element);
+}
 
 }  // namespace
 
+MemoryCache::~MemoryCache() {
+  mutex_lock l(mu_);
+  DeleteSpillFile();
+}
+
 string MemoryCache::DebugString() const { return kMemoryCache; }
 
+Status MemoryCache::Configure(Env* env, const MemoryCacheOptions& options) {
+  mutex_lock l(mu_);
+  if (!cache_.empty()) {
+    return errors::FailedPrecondition(
+        "A memory cache can only be configured while it is empty.");
+  }
+  env_ = env;
+  options_ = options;
+  return Status::OK();
+}
+
 void MemoryCache::Complete() {
   mutex_lock l(mu_);
   completed_ = true;
@@ -61,17 +121,57 @@ void MemoryCache::Reset() {
   claimed_ = false;
   completed_ = false;
   cache_.clear();
+  arena_.clear();
+  arena_next_ = nullptr;
+  arena_remaining_ = 0;
+  bytes_in_memory_ = 0;
+  DeleteSpillFile();
 }
 
-const std::vector<Tensor>& MemoryCache::at(int64 index) {
+Status MemoryCache::at(int64 index, std::vector<Tensor>* element) {
   tf_shared_lock l(mu_);
   DCHECK(index < cache_.size());
-  return cache_[index];
+  const Entry& entry = cache_[index];
+  if (entry.tier == Entry::kTensors) {
+    *element = entry.tensors;
+    return Status::OK();
+  }
+  if (entry.tier == Entry::kArena) {
+    return DeserializeCachedElement(entry.data, entry.size, entry.compressed,
+                                    element);
+  }
+  string bytes;
+  TF_RETURN_IF_ERROR(ReadFromSpillFile(entry, &bytes));
+  return DeserializeCachedElement(bytes.data(), bytes.size(),
+                                  entry.compressed, element);
 }
 
-void MemoryCache::emplace_back(std::vector<Tensor> element) {
+Status MemoryCache::emplace_back(std::vector<Tensor> element) {
   mutex_lock l(mu_);
-  cache_.emplace_back(std::move(element));
+  Entry entry;
+  if ((options_.memory_limit <= 0 && !options_.compress) ||
+      !IsSerializable(element)) {
+    bytes_in_memory_ += GetAllocatedBytes(element);
+    entry.tensors = std::move(element);
+    cache_.push_back(std::move(entry));
+    return Status::OK();
+  }
+  string bytes;
+  TF_RETURN_IF_ERROR(SerializeCachedElement(element, options_.compress,
+                                            &bytes, &entry.compressed));
+  entry.size = bytes.size();
+  if (options_.memory_limit > 0 &&
+      bytes_in_memory_ + static_cast<int64>(bytes.size()) >
+          options_.memory_limit) {
+    entry.tier = Entry::kSpillFile;
+    TF_RETURN_IF_ERROR(AppendToSpillFile(bytes, &entry.offset));
+  } else {
+    entry.tier = Entry::kArena;
+    entry.data = AllocateInArena(bytes);
+    bytes_in_memory_ += bytes.size();
+  }
+  cache_.push_back(std::move(entry));
+  return Status::OK();
 }
 
 size_t MemoryCache::size() {
@@ -79,6 +179,100 @@ size_t MemoryCache::size() {
   return cache_.size();
 }
 
+int64 MemoryCache::bytes_in_memory() {
+  tf_shared_lock l(mu_);
+  return bytes_in_memory_;
+}
+
+int64 MemoryCache::bytes_spilled() {
+  tf_shared_lock l(mu_);
+  return bytes_spilled_;
+}
+
+const char* MemoryCache::AllocateInArena(const string& bytes) {
+  if (bytes.size() > kArenaBlockBytes) {
+    arena_.emplace_back(new char[bytes.size()]);
+    memcpy(arena_.back().get(), bytes.data(), bytes.size());
+    return arena_.back().get();
+  }
+  if (bytes.size() > arena_remaining_) {
+    arena_.emplace_back(new char[kArenaBlockBytes]);
+    arena_next_ = arena_.back().get();
+    arena_remaining_ = kArenaBlockBytes;
+  }
+  char* data = arena_next_;
+  memcpy(data, bytes.data(), bytes.size());
+  arena_next_ += bytes.size();
+  arena_remaining_ -= bytes.size();
+  return data;
+}
+
+Status MemoryCache::AppendToSpillFile(const string& bytes, uint64* offset) {
+  if (!spill_writer_) {
+    string directory = options_.spill_directory;
+    TF_RETURN_IF_ERROR(CreateSpillDirectory(env_, &directory));
+    spill_filename_ = io::JoinPath(
+        directory, strings::StrCat("tf_data_cache_",
+                                   strings::Hex(random::New64()), ".spill"));
+    TF_RETURN_IF_ERROR(env_->NewWritableFile(spill_filename_, &spill_writer_));
+    VLOG(1) << "Spilling cached elements beyond " << options_.memory_limit
+            << " bytes to " << spill_filename_;
+  }
+  TF_RETURN_IF_ERROR(spill_writer_->Append(bytes));
+  *offset = bytes_spilled_;
+  bytes_spilled_ += bytes.size();
+  mutex_lock l(spill_mu_);
+  spill_needs_flush_ = true;
+  return Status::OK();
+}
+
+Status MemoryCache::ReadFromSpillFile(const Entry& entry, string* bytes) {
+  RandomAccessFile* file;
+  {
+    mutex_lock l(spill_mu_);
+    if (spill_needs_flush_) {
+      TF_RETURN_IF_ERROR(spill_writer_->Flush());
+      spill_needs_flush_ = false;
+    }
+    if (!spill_reader_) {
+      TF_RETURN_IF_ERROR(
+          env_->NewRandomAccessFile(spill_filename_, &spill_reader_));
+    }
+    file = spill_reader_.get();
+  }
+  bytes->resize(entry.size);
+  StringPiece result;
+  TF_RETURN_IF_ERROR(
+      file->Read(entry.offset, entry.size, &result, &(*bytes)[0]));
+  if (result.size() != entry.size) {
+    return errors::DataLoss("Cache spill file ", spill_filename_,
+                            " is truncated.");
+  }
+  if (result.data() != bytes->data()) {
+    bytes->assign(result.data(), result.size());
+  }
+  return Status::OK();
+}
+
+void MemoryCache::DeleteSpillFile() {
+  if (!spill_writer_) {
+    return;
+  }
+  {
+    mutex_lock l(spill_mu_);
+    spill_reader_.reset();
+    spill_needs_flush_ = false;
+  }
+  spill_writer_.reset();
+  Status s = env_->DeleteFile(spill_filename_);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to delete cache spill file " << spill_filename_
+                 << ": " << s;
+  }
+  spill_filename_.clear();
+  bytes_spilled_ = 0;
+}
+
 AnonymousMemoryCacheHandleOp::AnonymousMemoryCacheHandleOp(
     OpKernelConstruction* ctx)
     : AnonymousResourceOp<MemoryCache>(ctx) {}
@@ -16,23 +16,47 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_DATA_CACHE_OPS_H_
 #define TENSORFLOW_CORE_KERNELS_DATA_CACHE_OPS_H_
 
+#include <memory>
+
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
 namespace data {
 
+// Options for how a `MemoryCache` stores its elements. By default, elements
+// are kept as the tensors they were produced as.
+struct MemoryCacheOptions {
+  // If positive, the number of bytes of elements kept in memory. Further
+  // elements are written to a file in `spill_directory`.
+  int64 memory_limit = 0;
+  // If true, elements are snappy-compressed.
+  bool compress = false;
+  // The directory to write elements beyond `memory_limit` to. If empty, a
+  // local temporary directory is used.
+  string spill_directory;
+};
+
 // A thread-safe data structure for caching dataset elements.
 //
 // The expected use is that a single `MemoryWriterIterator` populates the
 // cache with dataset elements. Once all elements are cached, the cache can
 // be used by one or more `MemoryReaderIterator`s.
+//
+// With non-default options, elements are serialized into a contiguous arena,
+// and possibly compressed, instead of being kept as individual tensors.
+// Elements with variant or resource tensors are always kept as tensors.
 class MemoryCache : public ResourceBase {
  public:
   MemoryCache() = default;
+  ~MemoryCache() override;
 
   string DebugString() const override;
 
+  // Sets how elements are stored. Must be called while the cache is empty.
+  Status Configure(Env* env, const MemoryCacheOptions& options);
+
   // Marks the cache as completed.
   void Complete();
 
@@ -48,22 +72,70 @@ class MemoryCache : public ResourceBase {
   // Resets the cache.
   void Reset();
 
-  // Returns the element at the given index.
-  const std::vector<Tensor>& at(int64 index);
+  // Copies the element at the given index into `*element`.
+  Status at(int64 index, std::vector<Tensor>* element);
 
   // Adds the element to the cache.
-  void emplace_back(std::vector<Tensor> element);
+  Status emplace_back(std::vector<Tensor> element);
 
   // Returns the size of the cache.
   size_t size();
 
+  // Returns the number of bytes of elements held in memory.
+  int64 bytes_in_memory();
+
+  // Returns the number of bytes of elements written to the spill file.
+  int64 bytes_spilled();
+
  private:
+  // Where a cached element is stored.
+  struct Entry {
+    enum Tier { kTensors, kArena, kSpillFile };
+    Tier tier = kTensors;
+    // The element, if `tier` is `kTensors`.
+    std::vector<Tensor> tensors;
+    // The serialized element, at `data` in the arena, or at `offset` in the
+    // spill file.
+    const char* data = nullptr;
+    uint64 offset = 0;
+    size_t size = 0;
+    bool compressed = false;
+  };
+
+  // Copies `bytes` into the arena, and returns where they were copied to.
+  const char* AllocateInArena(const string& bytes)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status AppendToSpillFile(const string& bytes, uint64* offset)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status ReadFromSpillFile(const Entry& entry, string* bytes)
+      SHARED_LOCKS_REQUIRED(mu_);
+  void DeleteSpillFile() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   mutex mu_;
   // Determines whether a writer has claimed the cache.
   bool claimed_ GUARDED_BY(mu_) = false;
   // Determines whether all elements of the dataset have been cached.
   bool completed_ GUARDED_BY(mu_) = false;
-  std::vector<std::vector<Tensor>> cache_ GUARDED_BY(mu_);
+  std::vector<Entry> cache_ GUARDED_BY(mu_);
+
+  Env* env_ GUARDED_BY(mu_) = nullptr;
+  MemoryCacheOptions options_ GUARDED_BY(mu_);
+  int64 bytes_in_memory_ GUARDED_BY(mu_) = 0;
+  int64 bytes_spilled_ GUARDED_BY(mu_) = 0;
+  // Blocks of serialized elements. Blocks are never reallocated, so entries
+  // can point into them.
+  std::vector<std::unique_ptr<char[]>> arena_ GUARDED_BY(mu_);
+  // The unused part of the last regular-sized block.
+  char* arena_next_ GUARDED_BY(mu_) = nullptr;
+  size_t arena_remaining_ GUARDED_BY(mu_) = 0;
+
+  string spill_filename_ GUARDED_BY(mu_);
+  std::unique_ptr<WritableFile> spill_writer_ GUARDED_BY(mu_);
+  // Serializes flushing `spill_writer_` and opening `spill_reader_`, which
+  // readers may need to do while holding `mu_` shared.
+  mutex spill_mu_ ACQUIRED_AFTER(mu_);
+  std::unique_ptr<RandomAccessFile> spill_reader_ GUARDED_BY(spill_mu_);
+  bool spill_needs_flush_ GUARDED_BY(spill_mu_) = false;
 };
 
 // Creates an instance of cache resource and transfers ownership to the caller.
@@ -34,6 +34,8 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/data/experimental/snapshot.pb.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/util/work_sharder.h"
 
@@ -648,5 +650,55 @@ std::function<void(std::function<void()>)> RunnerWithMaxParallelism(
       std::move(runner), std::placeholders::_1);
 }
 
+bool IsSerializable(const std::vector<Tensor>& element) {
+  for (const Tensor& t : element) {
+    if (t.dtype() == DT_VARIANT || t.dtype() == DT_RESOURCE) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Status SerializeElement(const std::vector<Tensor>& element, string* bytes) {
+  experimental::SnapshotRecord record;
+  for (const Tensor& t : element) {
+    t.AsProtoTensorContent(record.add_tensor());
+  }
+  if (!record.SerializeToString(bytes)) {
+    return errors::Internal("Failed to serialize a dataset element.");
+  }
+  return Status::OK();
+}
+
+Status DeserializeElement(const char* data, size_t size,
+                          std::vector<Tensor>* element) {
+  experimental::SnapshotRecord record;
+  if (!record.ParseFromArray(data, size)) {
+    return errors::DataLoss("Failed to parse a serialized dataset element.");
+  }
+  element->clear();
+  element->reserve(record.tensor_size());
+  for (const TensorProto& proto : record.tensor()) {
+    element->emplace_back();
+    if (!element->back().FromProto(proto)) {
+      return errors::DataLoss("Failed to parse a serialized dataset element.");
+    }
+  }
+  return Status::OK();
+}
+
+Status CreateSpillDirectory(Env* env, string* directory) {
+  if (directory->empty()) {
+    std::vector<string> directories;
+    env->GetLocalTempDirectories(&directories);
+    if (directories.empty()) {
+      return errors::NotFound(
+          "No local temporary directory to spill dataset elements to.");
+    }
+    *directory = directories[0];
+  }
+  return env->RecursivelyCreateDir(*directory);
+}
+
 }  // namespace data
 }  // namespace tensorflow
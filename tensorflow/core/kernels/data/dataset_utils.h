@@ -181,6 +181,21 @@ Status AddToFunctionLibrary(FunctionLibraryDefinition* base,
 std::function<void(std::function<void()>)> RunnerWithMaxParallelism(
     std::function<void(std::function<void()>)> runner, int max_parallelism);
 
+// Returns true if `element` can be serialized by `SerializeElement`. Tensors
+// holding variants or resources may not be serializable.
+bool IsSerializable(const std::vector<Tensor>& element);
+
+// Serializes `element` into `bytes` as an `experimental::SnapshotRecord`.
+Status SerializeElement(const std::vector<Tensor>& element, string* bytes);
+
+// Parses an element written by `SerializeElement` from `data`.
+Status DeserializeElement(const char* data, size_t size,
+                          std::vector<Tensor>* element);
+
+// Creates the directory that elements are spilled to. If `*directory` is
+// empty, it is set to a local temporary directory first.
+Status CreateSpillDirectory(Env* env, string* directory);
+
 }  // namespace data
 }  // namespace tensorflow
 
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/stats_aggregator.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/batch_buffer_pool.h"
 #include "tensorflow/core/kernels/data/captured_function.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/kernels/data/stats_utils.h"
@@ -199,7 +200,8 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
             max_batch_results_(std::min(kMaxBatchResults,
                                         (params.dataset->num_parallel_calls_ +
                                          params.dataset->batch_size_ - 1) /
-                                            params.dataset->batch_size_)) {}
+                                            params.dataset->batch_size_)),
+            batch_buffer_pool_(new BatchBufferPool()) {}
 
       ~Iterator() override {
         mutex_lock l(*mu_);
@@ -477,12 +479,16 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
           component_shape.AppendShape(return_values->at(i).shape());
           AllocatorAttributes attr;
           attr.set_gpu_compatible(true);
-          result->output.emplace_back(ctx->allocator(attr),
-                                      return_values->at(i).dtype(),
-                                      component_shape);
-          if (!result->output.back().IsInitialized()) {
-            return errors::ResourceExhausted(
-                "Failed to allocate memory for the batch of component ", i);
+          result->output.emplace_back();
+          Status s = batch_buffer_pool_->Allocate(
+              ctx->allocator(attr), return_values->at(i).dtype(),
+              component_shape, &result->output.back());
+          if (!s.ok()) {
+            return Status(
+                s.code(),
+                strings::StrCat(
+                    "Failed to allocate memory for the batch of component ", i,
+                    ": ", s.error_message()));
           }
         }
         result->output_allocated = true;
@@ -522,8 +528,10 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
             component_shape.set_dim(0, result->num_elements);
             AllocatorAttributes attr;
             attr.set_gpu_compatible(true);
-            out_tensors->emplace_back(ctx->allocator(attr), output[i].dtype(),
-                                      component_shape);
+            out_tensors->emplace_back();
+            TF_RETURN_IF_ERROR(batch_buffer_pool_->Allocate(
+                ctx->allocator(attr), output[i].dtype(), component_shape,
+                &out_tensors->back()));
             TF_RETURN_IF_ERROR(CopyPartialBatch(&out_tensors->back(), output[i],
                                                 result->num_elements));
           }
@@ -748,6 +756,8 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
       // Identifies the maximum number of batch results to store.
       int64 max_batch_results_ GUARDED_BY(*mu_);
       std::unique_ptr<InstantiatedCapturedFunction> instantiated_captured_func_;
+      // Recycles the buffers of the batches once they are released.
+      const core::RefCountPtr<BatchBufferPool> batch_buffer_pool_;
     };
 
     const DatasetBase* const input_;
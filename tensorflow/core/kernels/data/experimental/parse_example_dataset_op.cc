@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/framework/stats_aggregator.h"
 #include "tensorflow/core/kernels/data/parallel_map_dataset_op.h"
 #include "tensorflow/core/kernels/data/stats_utils.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
 namespace tensorflow {
@@ -287,8 +288,12 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
             config.collect_feature_stats = true;
           }
           example::Result example_result;
-          Status s = FastParseExample(config, slice_vec, {}, device_threadpool,
-                                      &example_result);
+          std::unique_ptr<example::ColumnarParseScratch> scratch =
+              GetScratch();
+          Status s = FastParseExampleColumnar(config, slice_vec, {},
+                                              device_threadpool, scratch.get(),
+                                              &example_result);
+          ReturnScratch(std::move(scratch));
           if (s.ok()) {
             (*output).resize(dataset_->key_to_output_index_.size());
             for (int d = 0; d < dataset_->dense_keys_.size(); ++d) {
@@ -369,7 +374,30 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
       }
 
      private:
+      // Parsing buffers are kept between calls, one set for each call in
+      // flight.
+      std::unique_ptr<example::ColumnarParseScratch> GetScratch()
+          LOCKS_EXCLUDED(mu_) {
+        mutex_lock l(mu_);
+        if (scratch_.empty()) {
+          return absl::make_unique<example::ColumnarParseScratch>();
+        }
+        std::unique_ptr<example::ColumnarParseScratch> scratch =
+            std::move(scratch_.back());
+        scratch_.pop_back();
+        return scratch;
+      }
+
+      void ReturnScratch(std::unique_ptr<example::ColumnarParseScratch> scratch)
+          LOCKS_EXCLUDED(mu_) {
+        mutex_lock l(mu_);
+        scratch_.push_back(std::move(scratch));
+      }
+
       const Dataset* dataset_;
+      mutex mu_;
+      std::vector<std::unique_ptr<example::ColumnarParseScratch>> scratch_
+          GUARDED_BY(mu_);
     };
 
     const DatasetBase* const input_;
@@ -55,6 +55,9 @@ const int64 kDefaultShardSizeBytes = 10LL * 1024 * 1024 * 1024;
 
 const size_t kHeaderSize = sizeof(uint64);
 
+// Size of the buffer uncompressed snapshot files are read ahead into.
+const size_t kReadAheadBufferBytes = 256 * 1024;
+
 constexpr char kSnapshotFilename[] = "snapshot.metadata";
 constexpr char kSnapshotReaderWorkerPool[] = "snapshot_reader_worker_pool";
 constexpr char kSnapshotWriterWorkerPool[] = "snapshot_writer_worker_pool";
@@ -160,6 +163,14 @@ class SnapshotReader {
           zlib_options.output_buffer_size, zlib_options, true));
 #endif  // IS_SLIM_BUILD
     }
+#if !defined(PLATFORM_GOOGLE)
+    // Read ahead, so that each record doesn't cost two reads from the file.
+    // Compressed files are already read through the zlib input buffer.
+    if (compression_type_ == io::compression::kNone) {
+      input_stream_.reset(new io::BufferedInputStream(
+          input_stream_.release(), kReadAheadBufferBytes, true));
+    }
+#endif  // PLATFORM_GOOGLE
   }
 
   Status ReadRecord(string* record) {
@@ -547,18 +558,32 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
 
         Status Initialize(IteratorContext* ctx) override {
           mutex_lock l(mu_);
-          thread_pool_ = ctx->CreateThreadPool(kSnapshotReaderWorkerPool,
-                                               dataset()->num_reader_threads_);
           run_id_ = metadata_.run_id();
           run_dir_ = absl::StrCat(hash_dir_, "/", run_id_);
-          // Get all the files in the run_dir.
-          TF_RETURN_IF_ERROR(ctx->env()->GetMatchingPaths(
-              absl::StrCat(run_dir_, "/*"), &filenames_));
+          if (metadata_.shard_filenames_size() > 0) {
+            // The snapshot records its own layout and compression, which need
+            // not match how this dataset would have written it.
+            for (const string& filename : metadata_.shard_filenames()) {
+              filenames_.push_back(absl::StrCat(run_dir_, "/", filename));
+            }
+            compression_ = metadata_.compression();
+          } else {
+            // Get all the files in the run_dir.
+            TF_RETURN_IF_ERROR(ctx->env()->GetMatchingPaths(
+                absl::StrCat(run_dir_, "/*"), &filenames_));
+            compression_ = dataset()->compression_;
+          }
           if (filenames_.empty()) {
             return errors::InvalidArgument("Could not find any files in dir: ",
                                            run_dir_);
           }
           std::sort(filenames_.begin(), filenames_.end());
+          // Each thread reads one file at a time, so there is no use in more
+          // threads than files.
+          num_threads_ = std::min<int64>(dataset()->num_reader_threads_,
+                                         filenames_.size());
+          thread_pool_ = ctx->CreateThreadPool(kSnapshotReaderWorkerPool,
+                                               num_threads_);
           return Status::OK();
         }
 
@@ -568,7 +593,7 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
           absl::Time start = absl::Now();
           mutex_lock l(mu_);
           if (!background_threads_started_) {
-            for (int i = 0; i < dataset()->num_reader_threads_; ++i) {
+            for (int i = 0; i < num_threads_; ++i) {
               ++num_active_threads_;
               thread_pool_->Schedule([this]() { ReadingFilesLoop(); });
             }
@@ -630,9 +655,10 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
         // Reads one file end to end.
         Status ReadFile(const string& filename) {
           std::unique_ptr<RandomAccessFile> file;
-          TF_CHECK_OK(Env::Default()->NewRandomAccessFile(filename, &file));
+          TF_RETURN_IF_ERROR(
+              Env::Default()->NewRandomAccessFile(filename, &file));
           std::unique_ptr<SnapshotReader> reader(
-              new SnapshotReader(file.get(), dataset()->compression_));
+              new SnapshotReader(file.get(), compression_));
 
           while (true) {
             // Wait for a slot in the buffer.
@@ -747,7 +773,10 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
         const experimental::SnapshotMetadataRecord metadata_;
         string run_id_ GUARDED_BY(mu_);
         string run_dir_ GUARDED_BY(mu_);
+        // Set in Initialize(), and only read once the reader threads start.
         std::vector<string> filenames_;
+        string compression_;
+        int64 num_threads_ = 0;
 
         uint64 elements_produced_ GUARDED_BY(mu_) = 0;
         int64 time_spent_micros_ GUARDED_BY(mu_) = 0;
@@ -795,6 +824,8 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
           metadata.set_creation_timestamp(Env::Default()->NowMicros());
           metadata.set_graph_hash(dataset()->graph_hash_);
           metadata.set_run_id(run_id_);
+          metadata.set_compression(dataset()->compression_);
+          metadata.set_num_writer_threads(dataset()->num_writer_threads_);
           metadata.set_finalized(false);
           TF_RETURN_IF_ERROR(WriteMetadataFile(hash_dir_, metadata));
 
@@ -811,6 +842,7 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
             mutex_lock l(mu_);
             first_call = first_call_;
             if (first_call_) {
+              num_unfinished_writers_ = dataset()->num_writer_threads_;
               for (int i = 0; i < dataset()->num_writer_threads_; ++i) {
                 ++num_active_threads_;
                 thread_pool_->Schedule([this]() { WriterThread(); });
@@ -875,11 +907,11 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
 
         string GetSnapshotFilename() {
           mutex_lock l(mu_);
-          string snapshot_data_filename = absl::StrCat(
-              run_dir_, "/", strings::Printf("%08llu", next_file_index_),
-              ".snapshot");
+          string filename = absl::StrCat(
+              strings::Printf("%08llu", next_file_index_), ".snapshot");
           next_file_index_++;
-          return snapshot_data_filename;
+          shard_filenames_.push_back(filename);
+          return absl::StrCat(run_dir_, "/", filename);
         }
 
         Status FillBuffer(IteratorContext* ctx) LOCKS_EXCLUDED(mu_) {
@@ -999,11 +1031,19 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
             TF_RETURN_IF_ERROR((*writer)->Close());
             TF_RETURN_IF_ERROR((*file)->Close());
             mutex_lock l(mu_);
-            if (!written_final_metadata_file_) {
+            // Only the last writer thread to finish finalizes the snapshot,
+            // so that readers never see a file that is still being written.
+            --num_unfinished_writers_;
+            if (num_unfinished_writers_ == 0 &&
+                !written_final_metadata_file_) {
               experimental::SnapshotMetadataRecord metadata;
               TF_RETURN_IF_ERROR(ReadMetadataFile(hash_dir_, &metadata));
 
               if (metadata.run_id() == run_id_) {
+                std::sort(shard_filenames_.begin(), shard_filenames_.end());
+                for (const string& filename : shard_filenames_) {
+                  metadata.add_shard_filenames(filename);
+                }
                 metadata.set_finalized(true);
                 TF_RETURN_IF_ERROR(WriteMetadataFile(hash_dir_, metadata));
               } else {
@@ -1085,8 +1125,11 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
         bool end_of_sequence_ GUARDED_BY(mu_) = false;
         bool written_final_metadata_file_ GUARDED_BY(mu_) = false;
         uint64 next_file_index_ GUARDED_BY(mu_) = 0;
+        // Names of the files created so far, relative to run_dir_.
+        std::vector<string> shard_filenames_ GUARDED_BY(mu_);
         std::unique_ptr<thread::ThreadPool> thread_pool_;
         int64 num_active_threads_ GUARDED_BY(mu_) = 0;
+        int64 num_unfinished_writers_ GUARDED_BY(mu_) = 0;
       };
 
       class SnapshotPassthroughIterator : public DatasetIterator<Dataset> {
@@ -12,28 +12,84 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/threadpool_dataset_op.h"
+
 #include <memory>
 
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/kernels/data/unbounded_thread_pool.h"
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace data {
 namespace experimental {
+
+NUMAPlacement::NUMAPlacement(Env* env, const string& name, int numa_node)
+    : numa_node_(numa_node) {
+  if (numa_node_ != port::kNUMANoAffinity) {
+    unbounded_thread_pool_ = absl::make_unique<UnboundedThreadPool>(
+        env, strings::StrCat(name, "_unbounded"), numa_node_);
+    thread_factory_ = unbounded_thread_pool_->get_thread_factory();
+  }
+}
+
+void NUMAPlacement::Apply(IteratorContext::Params* params) const {
+  if (numa_node_ == port::kNUMANoAffinity) {
+    return;
+  }
+  const int numa_node = numa_node_;
+  auto allocator_getter = std::move(params->allocator_getter);
+  params->allocator_getter = [numa_node, allocator_getter](
+                                 AllocatorAttributes attrs) {
+    // The input pipeline runs on the host, so allocations without attributes
+    // are host allocations. Pinned, NIC-compatible and scoped allocations
+    // need the device's own allocators.
+    if (attrs.gpu_compatible() || attrs.nic_compatible() ||
+        attrs.scope_id > 0) {
+      return allocator_getter(attrs);
+    }
+    return cpu_allocator(numa_node);
+  };
+  params->thread_factory = thread_factory_;
+  params->thread_pool = unbounded_thread_pool_.get();
+}
+
 namespace {
 
+// Validates the `numa_node` attr of the thread pool ops.
+Status ValidateNUMANode(int64 numa_node) {
+  if (numa_node != port::kNUMANoAffinity &&
+      (numa_node < 0 || numa_node >= port::NUMANumNodes())) {
+    return errors::InvalidArgument("`numa_node` must be -1 or in [0, ",
+                                   port::NUMANumNodes(), ") but is ",
+                                   numa_node, ".");
+  }
+  return Status::OK();
+}
+
+// Returns the options for the threads of a thread pool with affinity to the
+// given NUMA node.
+ThreadOptions NUMAThreadOptions(int numa_node) {
+  ThreadOptions thread_options;
+  thread_options.numa_node = numa_node;
+  return thread_options;
+}
+
 class ThreadPoolResource : public ResourceBase {
  public:
   ThreadPoolResource(Env* env, const ThreadOptions& thread_options,
                      const string& name, int num_threads, bool low_latency_hint,
                      int max_intra_op_parallelism)
       : thread_pool_(env, thread_options, name, num_threads, low_latency_hint),
-        max_intra_op_parallelism_(max_intra_op_parallelism) {}
+        max_intra_op_parallelism_(max_intra_op_parallelism),
+        numa_placement_(env, name, thread_options.numa_node) {}
 
   // Schedules fn() for execution in the pool of threads.
   void Schedule(std::function<void()> fn) {
@@ -53,11 +109,14 @@ class ThreadPoolResource : public ResourceBase {
 
   int32 NumThreads() { return thread_pool_.NumThreads(); }
 
+  const NUMAPlacement& numa_placement() const { return numa_placement_; }
+
   string DebugString() const override { return "ThreadPoolResource"; }
 
  private:
   thread::ThreadPool thread_pool_;
   const int max_intra_op_parallelism_;
+  const NUMAPlacement numa_placement_;
 };
 
 // Creates a handle to a ThreadPool resource. Note that we don't use
@@ -71,9 +130,13 @@ class ThreadPoolHandleOp : public OpKernel {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("num_threads", &num_threads_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("max_intra_op_parallelism",
                                      &max_intra_op_parallelism_));
+    if (ctx->HasAttr("numa_node")) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("numa_node", &numa_node_));
+    }
     OP_REQUIRES(
         ctx, num_threads_ > 0,
         errors::InvalidArgument("`num_threads` must be greater than zero."));
+    OP_REQUIRES_OK(ctx, ValidateNUMANode(numa_node_));
   }
 
   // The resource is deleted from the resource manager only when it is private
@@ -100,7 +163,9 @@ class ThreadPoolHandleOp : public OpKernel {
                               [this, ctx](ThreadPoolResource** ret)
                                   EXCLUSIVE_LOCKS_REQUIRED(mu_) {
                                     *ret = new ThreadPoolResource(
-                                        ctx->env(), {}, display_name_,
+                                        ctx->env(),
+                                        NUMAThreadOptions(numa_node_),
+                                        display_name_,
                                         num_threads_,
                                         /*low_latency_hint=*/false,
                                         max_intra_op_parallelism_);
@@ -120,6 +185,7 @@ class ThreadPoolHandleOp : public OpKernel {
   string display_name_;
   int num_threads_;
   int max_intra_op_parallelism_;
+  int numa_node_ = port::kNUMANoAffinity;
 };
 
 class ThreadPoolDatasetOp : public UnaryDatasetOpKernel {
@@ -222,6 +288,7 @@ class ThreadPoolDatasetOp : public UnaryDatasetOpKernel {
           pool->Schedule(std::move(c));
         };
         params.runner_threadpool_size = pool->NumThreads();
+        pool->numa_placement().Apply(&params);
         return params;
       }
 
@@ -341,28 +408,41 @@ class MaxIntraOpParallelismDatasetOp : public UnaryDatasetOpKernel {
 class PrivateThreadPoolDatasetOp : public UnaryDatasetOpKernel {
  public:
   explicit PrivateThreadPoolDatasetOp(OpKernelConstruction* ctx)
-      : UnaryDatasetOpKernel(ctx) {}
+      : UnaryDatasetOpKernel(ctx) {
+    if (ctx->HasAttr("numa_node")) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("numa_node", &numa_node_));
+    }
+    OP_REQUIRES_OK(ctx, ValidateNUMANode(numa_node_));
+  }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                    DatasetBase** output) override {
     int64 num_threads = 0;
     OP_REQUIRES_OK(
         ctx, ParseScalarArgument<int64>(ctx, "num_threads", &num_threads));
+    // With NUMA affinity, zero threads stands for one thread per CPU core of
+    // the NUMA node.
+    if (num_threads == 0 && numa_node_ != port::kNUMANoAffinity) {
+      num_threads = port::MaxParallelism(numa_node_);
+    }
     OP_REQUIRES(ctx, num_threads >= 1,
                 errors::InvalidArgument("`num_threads` must be >= 1"));
-    *output = new Dataset(ctx, input, num_threads);
+    *output = new Dataset(ctx, input, num_threads, numa_node_);
   }
 
  private:
   class Dataset : public DatasetBase {
    public:
-    Dataset(OpKernelContext* ctx, const DatasetBase* input, int num_threads)
+    Dataset(OpKernelContext* ctx, const DatasetBase* input, int num_threads,
+            int numa_node)
         : DatasetBase(DatasetContext(ctx)),
           input_(input),
-          num_threads_(num_threads) {
+          num_threads_(num_threads),
+          numa_node_(numa_node),
+          numa_placement_(ctx->env(), "data_private_threadpool", numa_node) {
       thread_pool_ = absl::make_unique<thread::ThreadPool>(
-          ctx->env(), ThreadOptions{}, "data_private_threadpool", num_threads,
-          /*low_latency_hint=*/false);
+          ctx->env(), NUMAThreadOptions(numa_node), "data_private_threadpool",
+          num_threads, /*low_latency_hint=*/false);
       input_->Ref();
     }
 
@@ -399,8 +479,11 @@ class PrivateThreadPoolDatasetOp : public UnaryDatasetOpKernel {
       TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
       Node* num_threads_node = nullptr;
       TF_RETURN_IF_ERROR(b->AddScalar(num_threads_, &num_threads_node));
+      AttrValue numa_node_attr;
+      b->BuildAttrValue(numa_node_, &numa_node_attr);
       TF_RETURN_IF_ERROR(
-          b->AddDataset(this, {input_graph_node, num_threads_node}, output));
+          b->AddDataset(this, {input_graph_node, num_threads_node},
+                        {std::make_pair("numa_node", numa_node_attr)}, output));
       return Status::OK();
     }
 
@@ -411,7 +494,10 @@ class PrivateThreadPoolDatasetOp : public UnaryDatasetOpKernel {
           : DatasetIterator<Dataset>(params) {}
 
       Status Initialize(IteratorContext* ctx) override {
-        return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
+        IteratorContext::Params params(ctx);
+        dataset()->numa_placement_.Apply(&params);
+        return dataset()->input_->MakeIterator(
+            IteratorContext(std::move(params)), prefix(), &input_impl_);
       }
 
       Status GetNextInternal(IteratorContext* ctx,
@@ -423,6 +509,7 @@ class PrivateThreadPoolDatasetOp : public UnaryDatasetOpKernel {
           pool->Schedule(std::move(c));
         };
         params.runner_threadpool_size = dataset()->num_threads_;
+        dataset()->numa_placement_.Apply(&params);
         return input_impl_->GetNext(IteratorContext{std::move(params)},
                                     out_tensors, end_of_sequence);
       }
@@ -440,8 +527,12 @@ class PrivateThreadPoolDatasetOp : public UnaryDatasetOpKernel {
 
     const DatasetBase* const input_;
     const int64 num_threads_;
+    const int numa_node_;
     std::unique_ptr<thread::ThreadPool> thread_pool_;
+    const NUMAPlacement numa_placement_;
   };
+
+  int numa_node_ = port::kNUMANoAffinity;
 };
 
 REGISTER_KERNEL_BUILDER(Name("MaxIntraOpParallelismDataset").Device(DEVICE_CPU),
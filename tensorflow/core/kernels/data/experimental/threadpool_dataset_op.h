@@ -0,0 +1,56 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_THREADPOOL_DATASET_OP_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_THREADPOOL_DATASET_OP_H_
+
+#include <memory>
+
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/kernels/data/unbounded_thread_pool.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+// Placement of the work of an input pipeline on a NUMA node.
+//
+// Besides the functions scheduled through the runner, whose threads are set
+// up by the owner, an input pipeline starts long-running threads (e.g. the
+// workers of `parallel_interleave` and the runner threads of
+// `parallel_map`) and allocates its elements through the iterator context.
+// `Apply()` makes those threads and allocations use the NUMA node too.
+class NUMAPlacement {
+ public:
+  NUMAPlacement(Env* env, const string& name, int numa_node);
+
+  // Updates `params` to place the threads and allocations of the input
+  // pipeline on the NUMA node. Does nothing if there is no NUMA node.
+  //
+  // Only plain host allocations are placed on the NUMA node. Allocations with
+  // other attributes, e.g. the GPU-compatible (pinned) buffers of
+  // `map_and_batch`, are still served by the previous allocator getter.
+  void Apply(IteratorContext::Params* params) const;
+
+ private:
+  const int numa_node_;
+  std::unique_ptr<UnboundedThreadPool> unbounded_thread_pool_;
+  std::shared_ptr<ThreadFactory> thread_factory_;
+};
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_THREADPOOL_DATASET_OP_H_
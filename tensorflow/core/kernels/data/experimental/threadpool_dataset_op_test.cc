@@ -0,0 +1,120 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/threadpool_dataset_op.h"
+
+#include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/platform/numa.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "range_dataset";
+
+// An allocator that is never used to allocate, only compared by address.
+class FakeAllocator : public Allocator {
+ public:
+  string Name() override { return "fake"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return nullptr;
+  }
+  void DeallocateRaw(void* ptr) override {}
+};
+
+class NUMAPlacementTest : public DatasetOpsTestBase {
+ protected:
+  // Creates the parameters of an iterator context whose allocator getter
+  // always returns `allocator`.
+  Status CreateIteratorContextParams(
+      Allocator* allocator, std::unique_ptr<IteratorContext::Params>* params) {
+    TF_RETURN_IF_ERROR(InitThreadPool(/*thread_num=*/2));
+    TF_RETURN_IF_ERROR(InitFunctionLibraryRuntime({}, /*cpu_num=*/2));
+    TF_RETURN_IF_ERROR(
+        CreateRangeDatasetOpKernel<int64>(kNodeName, &range_kernel_));
+    for (int64 value : {0, 10, 1}) {
+      TF_RETURN_IF_ERROR(AddDatasetInputFromArray<int64>(
+          &range_inputs_, range_kernel_->input_types(), TensorShape({}),
+          {value}));
+    }
+    TF_RETURN_IF_ERROR(CreateOpKernelContext(range_kernel_.get(),
+                                             &range_inputs_, &range_context_));
+    TF_RETURN_IF_ERROR(
+        CreateIteratorContext(range_context_.get(), &iterator_ctx_));
+    params->reset(new IteratorContext::Params(iterator_ctx_.get()));
+    (*params)->allocator_getter = [allocator](AllocatorAttributes) {
+      return allocator;
+    };
+    return Status::OK();
+  }
+
+ private:
+  std::unique_ptr<OpKernel> range_kernel_;
+  gtl::InlinedVector<TensorValue, 4> range_inputs_;
+  std::unique_ptr<OpKernelContext> range_context_;
+  std::unique_ptr<IteratorContext> iterator_ctx_;
+};
+
+TEST_F(NUMAPlacementTest, NoAffinity) {
+  FakeAllocator allocator;
+  std::unique_ptr<IteratorContext::Params> params;
+  TF_ASSERT_OK(CreateIteratorContextParams(&allocator, &params));
+  std::shared_ptr<ThreadFactory> thread_factory = params->thread_factory;
+
+  NUMAPlacement placement(Env::Default(), "test_pool",
+                          port::kNUMANoAffinity);
+  placement.Apply(params.get());
+
+  EXPECT_EQ(params->allocator_getter(AllocatorAttributes()), &allocator);
+  EXPECT_EQ(params->thread_factory, thread_factory);
+}
+
+TEST_F(NUMAPlacementTest, HostAllocationsUseNUMANode) {
+  FakeAllocator allocator;
+  std::unique_ptr<IteratorContext::Params> params;
+  TF_ASSERT_OK(CreateIteratorContextParams(&allocator, &params));
+
+  NUMAPlacement placement(Env::Default(), "test_pool", /*numa_node=*/0);
+  placement.Apply(params.get());
+
+  EXPECT_EQ(params->allocator_getter(AllocatorAttributes()),
+            cpu_allocator(/*numa_node=*/0));
+  AllocatorAttributes host_attrs;
+  host_attrs.set_on_host(true);
+  EXPECT_EQ(params->allocator_getter(host_attrs),
+            cpu_allocator(/*numa_node=*/0));
+  EXPECT_NE(params->thread_factory, nullptr);
+  EXPECT_NE(params->thread_pool, nullptr);
+}
+
+TEST_F(NUMAPlacementTest, PinnedAllocationsUsePreviousAllocator) {
+  FakeAllocator allocator;
+  std::unique_ptr<IteratorContext::Params> params;
+  TF_ASSERT_OK(CreateIteratorContextParams(&allocator, &params));
+
+  NUMAPlacement placement(Env::Default(), "test_pool", /*numa_node=*/0);
+  placement.Apply(params.get());
+
+  AllocatorAttributes gpu_attrs;
+  gpu_attrs.set_on_host(true);
+  gpu_attrs.set_gpu_compatible(true);
+  EXPECT_EQ(params->allocator_getter(gpu_attrs), &allocator);
+  AllocatorAttributes nic_attrs;
+  nic_attrs.set_on_host(true);
+  nic_attrs.set_nic_compatible(true);
+  EXPECT_EQ(params->allocator_getter(nic_attrs), &allocator);
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
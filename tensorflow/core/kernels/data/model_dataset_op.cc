@@ -51,11 +51,15 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
                 errors::InvalidArgument("CPU budget must be positive but is ",
                                         cpu_budget_, "."));
     ram_budget_ = kRamBudgetShare * port::AvailableRam();
+    if (ctx->HasAttr("profile")) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("profile", &profile_));
+    }
   }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                    DatasetBase** output) override {
-    *output = new Dataset(ctx, input, algorithm_, cpu_budget_, ram_budget_);
+    *output = new Dataset(ctx, input, algorithm_, cpu_budget_, ram_budget_,
+                          profile_);
   }
 
  private:
@@ -63,12 +67,13 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
    public:
     Dataset(OpKernelContext* ctx, const DatasetBase* input,
             model::AutotuneAlgorithm algorithm, int64 cpu_budget,
-            int64 ram_budget)
+            int64 ram_budget, bool profile)
         : DatasetBase(DatasetContext(ctx)),
           input_(input),
           algorithm_(algorithm),
           cpu_budget_(cpu_budget),
-          ram_budget_(ram_budget) {
+          ram_budget_(ram_budget),
+          profile_(profile) {
       input_->Ref();
     }
 
@@ -101,7 +106,11 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
                               Node** output) const override {
       Node* input_graph_node = nullptr;
       TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
-      TF_RETURN_IF_ERROR(b->AddDataset(this, {input_graph_node}, output));
+      AttrValue profile_attr;
+      b->BuildAttrValue(profile_, &profile_attr);
+      TF_RETURN_IF_ERROR(
+          b->AddDataset(this, {input_graph_node},
+                        {std::make_pair("profile", profile_attr)}, output));
       return Status::OK();
     }
 
@@ -114,9 +123,16 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
           metrics::RecordTFDataElements(node->name(), node->num_elements());
         };
         model_ = std::make_shared<model::Model>(std::move(remove_node_hook));
+        if (dataset()->profile_) {
+          model_->EnableProfiling();
+        }
       }
 
       ~Iterator() override {
+        if (dataset()->profile_) {
+          LOG(INFO) << "Profile of input pipeline " << prefix() << ":\n"
+                    << model_->ProfileReport();
+        }
         // Signal the optimize thread to terminate it. We will then join that
         // thread when we delete `this->optimize_thread_`.
         mutex_lock l(mu_);
@@ -221,11 +237,13 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
     const model::AutotuneAlgorithm algorithm_;
     const int64 cpu_budget_;
     const int64 ram_budget_;
+    const bool profile_;
   };
 
   model::AutotuneAlgorithm algorithm_;
   int64 cpu_budget_;
   int64 ram_budget_;
+  bool profile_ = false;
 };
 
 REGISTER_KERNEL_BUILDER(Name("ModelDataset").Device(DEVICE_CPU),
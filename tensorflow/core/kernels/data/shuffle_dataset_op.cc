@@ -15,18 +15,26 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/shuffle_dataset_op.h"
 
 #include <deque>
+#include <map>
 #include <tuple>
 #include <vector>
 
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
 #include "tensorflow/core/kernels/data/random_seed_ops.h"
+#include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
 namespace data {
@@ -40,6 +48,9 @@ namespace data {
 /* static */ constexpr const char* const ShuffleDatasetOpBase::kSeed2;
 /* static */ constexpr const char* const ShuffleDatasetOpBase::kOutputTypes;
 /* static */ constexpr const char* const ShuffleDatasetOpBase::kOutputShapes;
+/* static */ constexpr const char* const
+    ShuffleDatasetOpBase::kBufferMemoryLimit;
+/* static */ constexpr const char* const ShuffleDatasetOpBase::kSpillDirectory;
 
 /* static */ constexpr const char* const ShuffleDatasetOp::kDatasetType;
 /* static */ constexpr const char* const
@@ -51,6 +62,9 @@ namespace data {
 
 const int64 kLogIntervalMicros = 10 * 1000000;  // 10 seconds.
 const int64 kMaxEpochsInBuffer = 3;
+// Spill files are rotated once they grow past this size, so that the space
+// held by elements that have been read back is eventually reclaimed.
+const uint64 kSpillFileBytes = 64 << 20;  // 64 MB.
 
 constexpr char kNumRandomSamples[] = "num_random_samples";
 constexpr char kEndOfInputSequence[] = "end_of_input_sequence";
@@ -69,17 +83,196 @@ constexpr char kReshufflingDatasetPrefix[] = "Reshuffling";
 constexpr char kShuffleDataset[] = "ShuffleDataset";
 
 ShuffleDatasetOpBase::ShuffleDatasetOpBase(OpKernelConstruction* ctx)
-    : UnaryDatasetOpKernel(ctx) {}
+    : UnaryDatasetOpKernel(ctx) {
+  if (ctx->HasAttr(kBufferMemoryLimit)) {
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr(kBufferMemoryLimit, &buffer_memory_limit_));
+    OP_REQUIRES(ctx, buffer_memory_limit_ >= 0,
+                errors::InvalidArgument(
+                    "buffer_memory_limit must be greater than or equal to 0."));
+  }
+  if (ctx->HasAttr(kSpillDirectory)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kSpillDirectory, &spill_directory_));
+  }
+}
+
+namespace {
+
+// Append-only files holding the shuffle buffer elements that do not fit in
+// its memory budget. Each element is written as a `SnapshotRecord` to an
+// uncompressed TFRecord file, and is read back with a single positioned read
+// of the record at its offset. A file is
+// deleted once it has been rotated and all of its elements have been
+// released, and the remaining files are deleted with this object.
+//
+// Note: this class is not thread safe; external synchronization required.
+class ShuffleSpillFiles {
+ public:
+  // Where an element is stored. `file` is -1 for elements kept in memory.
+  // `length` is the size of the serialized element, excluding the record's
+  // header and footer.
+  struct Location {
+    int64 file = -1;
+    uint64 offset = 0;
+    uint64 length = 0;
+  };
+
+  ShuffleSpillFiles(Env* env, string directory)
+      : env_(env),
+        directory_(std::move(directory)),
+        prefix_(strings::StrCat("tf_data_shuffle_",
+                                strings::Hex(random::New64()))) {}
+
+  ~ShuffleSpillFiles() {
+    for (auto& file : files_) {
+      DeleteFile(file.second.get());
+    }
+  }
+
+  // Writes `element` to the current file, and sets `*location` to where it
+  // was written.
+  Status Append(const std::vector<Tensor>& element, Location* location) {
+    if (!current_ || current_->size >= kSpillFileBytes) {
+      TF_RETURN_IF_ERROR(Rotate());
+    }
+    string serialized;
+    TF_RETURN_IF_ERROR(SerializeElement(element, &serialized));
+    TF_RETURN_IF_ERROR(current_->writer->WriteRecord(serialized));
+    location->file = current_id_;
+    location->offset = current_->size;
+    location->length = serialized.size();
+    current_->size += io::RecordReader::kHeaderSize + serialized.size() +
+                      io::RecordReader::kFooterSize;
+    current_->num_live++;
+    current_->needs_flush = true;
+    return Status::OK();
+  }
+
+  // Reads the element at `location` into `*element`. If `release` is true,
+  // the element will not be read again.
+  Status Read(const Location& location, bool release,
+              std::vector<Tensor>* element) {
+    auto it = files_.find(location.file);
+    if (it == files_.end()) {
+      return errors::Internal("Shuffle spill file ", location.file,
+                              " no longer exists.");
+    }
+    File* file = it->second.get();
+    if (file->needs_flush) {
+      TF_RETURN_IF_ERROR(file->writer->Flush());
+      file->needs_flush = false;
+    }
+    if (!file->readable) {
+      TF_RETURN_IF_ERROR(
+          env_->NewRandomAccessFile(file->filename, &file->readable));
+    }
+    // Elements are read in random order, so the record is read directly
+    // rather than through an io::RecordReader, whose input stream would
+    // discard its buffer on every seek.
+    const size_t record_size = io::RecordReader::kHeaderSize +
+                               location.length + io::RecordReader::kFooterSize;
+    if (scratch_.size() < record_size) {
+      scratch_.resize(record_size);
+    }
+    StringPiece result;
+    TF_RETURN_IF_ERROR(file->readable->Read(location.offset, record_size,
+                                            &result, scratch_.data()));
+    if (result.size() != record_size) {
+      return errors::DataLoss("Truncated shuffle buffer element in ",
+                              file->filename, " at ", location.offset);
+    }
+    const char* header = result.data();
+    const char* data = header + io::RecordReader::kHeaderSize;
+    const char* footer = data + location.length;
+    if (core::DecodeFixed64(header) != location.length ||
+        crc32c::Unmask(core::DecodeFixed32(header + sizeof(uint64))) !=
+            crc32c::Value(header, sizeof(uint64)) ||
+        crc32c::Unmask(core::DecodeFixed32(footer)) !=
+            crc32c::Value(data, location.length)) {
+      return errors::DataLoss("Corrupted shuffle buffer element in ",
+                              file->filename, " at ", location.offset);
+    }
+    TF_RETURN_IF_ERROR(DeserializeElement(data, location.length, element));
+    if (release && --file->num_live == 0 && file != current_) {
+      DeleteFile(file);
+      files_.erase(it);
+    }
+    return Status::OK();
+  }
+
+ private:
+  struct File {
+    string filename;
+    std::unique_ptr<WritableFile> writable;
+    std::unique_ptr<io::RecordWriter> writer;
+    std::unique_ptr<RandomAccessFile> readable;
+    uint64 size = 0;
+    int64 num_live = 0;
+    bool needs_flush = false;
+  };
+
+  // Starts a new current file, and deletes the old one if none of its
+  // elements are live.
+  Status Rotate() {
+    if (!created_directory_) {
+      TF_RETURN_IF_ERROR(CreateSpillDirectory(env_, &directory_));
+      created_directory_ = true;
+    }
+    if (current_ && current_->num_live == 0) {
+      DeleteFile(current_);
+      files_.erase(current_id_);
+    }
+    current_ = nullptr;
+    auto file = absl::make_unique<File>();
+    file->filename = io::JoinPath(
+        directory_, strings::StrCat(prefix_, "_", next_id_, ".spill"));
+    TF_RETURN_IF_ERROR(env_->NewWritableFile(file->filename, &file->writable));
+    file->writer = absl::make_unique<io::RecordWriter>(file->writable.get());
+    current_id_ = next_id_++;
+    current_ = file.get();
+    files_[current_id_] = std::move(file);
+    return Status::OK();
+  }
+
+  void DeleteFile(File* file) {
+    file->readable.reset();
+    file->writer.reset();
+    file->writable.reset();
+    Status s = env_->DeleteFile(file->filename);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to delete shuffle spill file " << file->filename
+                   << ": " << s;
+    }
+  }
+
+  Env* const env_;
+  string directory_;
+  bool created_directory_ = false;
+  const string prefix_;
+  std::map<int64, std::unique_ptr<File>> files_;
+  File* current_ = nullptr;
+  int64 current_id_ = -1;
+  int64 next_id_ = 0;
+  // Holds the record being read, so that reads don't allocate.
+  std::vector<char> scratch_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShuffleSpillFiles);
+};
+
+}  // namespace
 
 // Abstract base dataset that implements a shuffling iterator.
 class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
  public:
   ShuffleDatasetBase(OpKernelContext* ctx, const DatasetBase* input,
-                     int64 buffer_size, int64 count)
+                     int64 buffer_size, int64 count, int64 buffer_memory_limit,
+                     const string& spill_directory)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
         buffer_size_(buffer_size),
-        count_(count) {
+        count_(count),
+        buffer_memory_limit_(buffer_memory_limit),
+        spill_directory_(spill_directory) {
     input_->Ref();
   }
 
@@ -108,6 +301,18 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
   }
 
  protected:
+  // Appends the attrs controlling the memory used by the shuffle buffer.
+  void AddBufferMemoryAttrs(
+      DatasetGraphDefBuilder* b,
+      std::vector<std::pair<StringPiece, AttrValue>>* attrs) const {
+    AttrValue buffer_memory_limit;
+    b->BuildAttrValue(buffer_memory_limit_, &buffer_memory_limit);
+    attrs->emplace_back(kBufferMemoryLimit, buffer_memory_limit);
+    AttrValue spill_directory;
+    b->BuildAttrValue(spill_directory_, &spill_directory);
+    attrs->emplace_back(kSpillDirectory, spill_directory);
+  }
+
   template <class T>
   class Iterator : public DatasetIterator<T> {
    public:
@@ -123,6 +328,8 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
           generator_(&parent_generator_) {
       buffer_ = absl::make_unique<std::vector<Tensor>[]>(
           params.dataset->buffer_size_);
+      locations_ = absl::make_unique<ShuffleSpillFiles::Location[]>(
+          params.dataset->buffer_size_);
       slices_.push_back(absl::make_unique<Slice>(0, 0));
     }
 
@@ -174,9 +381,10 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             VLOG(1) << "Starting to fill up shuffle buffer of size: "
                     << this->dataset()->buffer_size_;
           }
-          this->RecordBufferEnqueue(ctx, input_element);
-          buffer_[slices_.back()->end % this->dataset()->buffer_size_] =
-              std::move(input_element);
+          TF_RETURN_IF_ERROR(AddToBuffer(
+              ctx->env(),
+              slices_.back()->end % this->dataset()->buffer_size_,
+              std::move(input_element), ctx));
           num_elements_++;
           slices_.back()->end++;
         } else {
@@ -209,11 +417,19 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             Random() % (slices_.front()->end - slices_.front()->start);
         int64 index =
             (slices_.front()->start + offset) % this->dataset()->buffer_size_;
-        *out_tensors = std::move(buffer_[index]);
-        this->RecordBufferDequeue(ctx, *out_tensors);
-        std::swap(
-            buffer_[index],
-            buffer_[slices_.front()->start % this->dataset()->buffer_size_]);
+        if (locations_[index].file >= 0) {
+          TF_RETURN_IF_ERROR(spill_files_->Read(locations_[index],
+                                                /*release=*/true, out_tensors));
+        } else {
+          *out_tensors = std::move(buffer_[index]);
+          bytes_in_memory_ -= GetAllocatedBytes(*out_tensors);
+          this->RecordBufferDequeue(ctx, *out_tensors);
+        }
+        int64 start_index =
+            slices_.front()->start % this->dataset()->buffer_size_;
+        std::swap(buffer_[index], buffer_[start_index]);
+        locations_[index] = locations_[start_index];
+        locations_[start_index] = ShuffleSpillFiles::Location();
         slices_.front()->start++;
         num_elements_--;
       } else {
@@ -271,15 +487,23 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             slices_[i]->end));
         for (size_t j = slices_[i]->start; j < slices_[i]->end; ++j) {
           size_t index = j % this->dataset()->buffer_size_;
+          // Spilled elements are saved the same way as the ones in memory.
+          std::vector<Tensor> spilled;
+          const std::vector<Tensor>* element = &buffer_[index];
+          if (locations_[index].file >= 0) {
+            TF_RETURN_IF_ERROR(spill_files_->Read(
+                locations_[index], /*release=*/false, &spilled));
+            element = &spilled;
+          }
           TF_RETURN_IF_ERROR(writer->WriteScalar(
               this->full_name(
                   absl::StrJoin(std::make_tuple(kBuffer, index, kSize), "_")),
-              buffer_[index].size()));
-          for (size_t k = 0; k < buffer_[index].size(); ++k) {
+              element->size()));
+          for (size_t k = 0; k < element->size(); ++k) {
             TF_RETURN_IF_ERROR(writer->WriteTensor(
                 this->full_name(
                     absl::StrJoin(std::make_tuple(kBuffer, index, k), "_")),
-                buffer_[index][k]));
+                (*element)[k]));
           }
         }
       }
@@ -319,6 +543,10 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       }
       buffer_ = absl::make_unique<std::vector<Tensor>[]>(
           this->dataset()->buffer_size_);
+      locations_ = absl::make_unique<ShuffleSpillFiles::Location[]>(
+          this->dataset()->buffer_size_);
+      spill_files_.reset();
+      bytes_in_memory_ = 0;
       for (size_t i = 0; i < slices_size; ++i) {
         int64 start;
         TF_RETURN_IF_ERROR(
@@ -337,13 +565,15 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
               this->full_name(
                   absl::StrJoin(std::make_tuple(kBuffer, index, kSize), "_")),
               &list_size));
-          buffer_[index] = std::vector<Tensor>(list_size);
+          std::vector<Tensor> element(list_size);
           for (int k = 0; k < list_size; ++k) {
             TF_RETURN_IF_ERROR(reader->ReadTensor(
                 this->full_name(
                     absl::StrJoin(std::make_tuple(kBuffer, index, k), "_")),
-                &buffer_[index][k]));
+                &element[k]));
           }
+          TF_RETURN_IF_ERROR(AddToBuffer(ctx->env(), index, std::move(element),
+                                         /*ctx=*/nullptr));
         }
       }
 
@@ -374,7 +604,39 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       return out;
     }
 
+    // Stores `element` at `index` of the buffer, spilling it to disk if
+    // keeping it in memory would exceed the buffer memory limit. If `ctx` is
+    // non-null, elements kept in memory are recorded as buffered in it.
+    Status AddToBuffer(Env* env, int64 index, std::vector<Tensor> element,
+                       IteratorContext* ctx) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const int64 limit = this->dataset()->buffer_memory_limit_;
+      const int64 bytes = GetAllocatedBytes(element);
+      if (limit > 0 && bytes_in_memory_ + bytes > limit &&
+          IsSerializable(element)) {
+        if (!spill_files_) {
+          VLOG(1) << "Spilling shuffle buffer elements beyond " << limit
+                  << " bytes to disk.";
+          spill_files_ = absl::make_unique<ShuffleSpillFiles>(
+              env, this->dataset()->spill_directory_);
+        }
+        buffer_[index].clear();
+        return spill_files_->Append(element, &locations_[index]);
+      }
+      if (ctx) {
+        this->RecordBufferEnqueue(ctx, element);
+      }
+      bytes_in_memory_ += bytes;
+      buffer_[index] = std::move(element);
+      locations_[index] = ShuffleSpillFiles::Location();
+      return Status::OK();
+    }
+
     std::unique_ptr<std::vector<Tensor>[]> buffer_ GUARDED_BY(mu_);
+    // Where each element of `buffer_` is stored. Spilled elements are empty in
+    // `buffer_`.
+    std::unique_ptr<ShuffleSpillFiles::Location[]> locations_ GUARDED_BY(mu_);
+    std::unique_ptr<ShuffleSpillFiles> spill_files_ GUARDED_BY(mu_);
+    int64 bytes_in_memory_ GUARDED_BY(mu_) = 0;
     std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
     int64 epoch_ GUARDED_BY(mu_);
     int64 num_elements_ GUARDED_BY(mu_);
@@ -388,6 +650,8 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
   const DatasetBase* const input_;
   const int64 buffer_size_;
   const int64 count_;
+  const int64 buffer_memory_limit_;
+  const string spill_directory_;
 };
 
 // A dataset that uses a pseudorandom sequence of seeds for the iterators
@@ -395,8 +659,10 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
 class ShuffleDatasetOp::ReshufflingDataset : public ShuffleDatasetBase {
  public:
   ReshufflingDataset(OpKernelContext* ctx, const DatasetBase* input,
-                     int64 buffer_size, int64 seed, int64 seed2, int64 count)
-      : ShuffleDatasetBase(ctx, input, buffer_size, count),
+                     int64 buffer_size, int64 seed, int64 seed2, int64 count,
+                     int64 buffer_memory_limit, const string& spill_directory)
+      : ShuffleDatasetBase(ctx, input, buffer_size, count, buffer_memory_limit,
+                           spill_directory),
         seed_(seed),
         seed2_(seed2) {}
 
@@ -508,10 +774,12 @@ class ShuffleDatasetOp::ReshufflingDataset : public ShuffleDatasetBase {
     TF_RETURN_IF_ERROR(b->AddScalar(seed_, &seed));
     TF_RETURN_IF_ERROR(b->AddScalar(seed2_, &seed2));
     b->BuildAttrValue(true, &reshuffle_each_iteration);
+    std::vector<std::pair<StringPiece, AttrValue>> attrs = {
+        std::make_pair(kReshuffleEachIteration, reshuffle_each_iteration)};
+    AddBufferMemoryAttrs(b, &attrs);
     TF_RETURN_IF_ERROR(b->AddDataset(
         this, {input_graph_node, buffer_size, seed, seed2},  // Inputs
-        {std::make_pair(kReshuffleEachIteration,
-                        reshuffle_each_iteration)},  // Attrs
+        attrs,                                               // Attrs
         output));
     return Status::OK();
   }
@@ -527,9 +795,11 @@ class ShuffleDatasetOp::ReshufflingDatasetV2 : public ShuffleDatasetBase {
  public:
   ReshufflingDatasetV2(OpKernelContext* ctx, const DatasetBase* input,
                        int64 buffer_size, int64 count,
+                       int64 buffer_memory_limit, const string& spill_directory,
                        const Tensor& resource_handle,
                        RandomSeedGenerator* seed_generator)
-      : ShuffleDatasetBase(ctx, input, buffer_size, count),
+      : ShuffleDatasetBase(ctx, input, buffer_size, count, buffer_memory_limit,
+                           spill_directory),
         resource_handle_(resource_handle),
         seed_generator_(seed_generator) {}
 
@@ -613,10 +883,12 @@ class ShuffleDatasetOp::ReshufflingDatasetV2 : public ShuffleDatasetBase {
     TF_RETURN_IF_ERROR(b->AddScalar(buffer_size_, &buffer_size_node));
     Node* resource_handle_node = nullptr;
     TF_RETURN_IF_ERROR(b->AddTensor(resource_handle_, &resource_handle_node));
+    std::vector<std::pair<StringPiece, AttrValue>> attrs;
+    AddBufferMemoryAttrs(b, &attrs);
     TF_RETURN_IF_ERROR(b->AddDataset(
         this,
         {input_graph_node, buffer_size_node, resource_handle_node},  // Inputs
-        {},                                                          // Attrs
+        attrs,                                                       // Attrs
         output));
     return Status::OK();
   }
@@ -631,8 +903,10 @@ class ShuffleDatasetOp::ReshufflingDatasetV2 : public ShuffleDatasetBase {
 class ShuffleDatasetOp::FixedSeedDataset : public ShuffleDatasetBase {
  public:
   FixedSeedDataset(OpKernelContext* ctx, const DatasetBase* input,
-                   int64 buffer_size, int64 seed, int64 seed2, int64 count)
-      : ShuffleDatasetBase(ctx, input, buffer_size, count),
+                   int64 buffer_size, int64 seed, int64 seed2, int64 count,
+                   int64 buffer_memory_limit, const string& spill_directory)
+      : ShuffleDatasetBase(ctx, input, buffer_size, count, buffer_memory_limit,
+                           spill_directory),
         seed_(seed),
         seed2_(seed2) {}
 
@@ -666,10 +940,12 @@ class ShuffleDatasetOp::FixedSeedDataset : public ShuffleDatasetBase {
     TF_RETURN_IF_ERROR(b->AddScalar(seed_, &seed));
     TF_RETURN_IF_ERROR(b->AddScalar(seed2_, &seed2));
     b->BuildAttrValue(false, &reshuffle_each_iteration);
+    std::vector<std::pair<StringPiece, AttrValue>> attrs = {
+        std::make_pair(kReshuffleEachIteration, reshuffle_each_iteration)};
+    AddBufferMemoryAttrs(b, &attrs);
     TF_RETURN_IF_ERROR(b->AddDataset(
         this, {input_graph_node, buffer_size, seed, seed2},  // Inputs
-        {std::make_pair(kReshuffleEachIteration,
-                        reshuffle_each_iteration)},  // Attrs
+        attrs,                                               // Attrs
         output));
     return Status::OK();
   }
@@ -705,6 +981,7 @@ void ShuffleDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
     // Transferring ownership of seed generator reference onto
     // `ReshufflingDatasetV2`.
     *output = new ReshufflingDatasetV2(ctx, input, buffer_size, count,
+                                       buffer_memory_limit_, spill_directory_,
                                        ctx->input(2), seed_generator);
     return;
   }
@@ -723,18 +1000,22 @@ void ShuffleDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
   }
 
   if (reshuffle_each_iteration_) {
-    *output =
-        new ReshufflingDataset(ctx, input, buffer_size, seed, seed2, count);
+    *output = new ReshufflingDataset(ctx, input, buffer_size, seed, seed2,
+                                     count, buffer_memory_limit_,
+                                     spill_directory_);
   } else {
-    *output = new FixedSeedDataset(ctx, input, buffer_size, seed, seed2, count);
+    *output = new FixedSeedDataset(ctx, input, buffer_size, seed, seed2, count,
+                                   buffer_memory_limit_, spill_directory_);
   }
 }
 
 class ShuffleAndRepeatDatasetOp::Dataset : public ShuffleDatasetBase {
  public:
   Dataset(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
-          int64 seed, int64 seed2, int64 count)
-      : ShuffleDatasetBase(ctx, input, buffer_size, count),
+          int64 seed, int64 seed2, int64 count, int64 buffer_memory_limit,
+          const string& spill_directory)
+      : ShuffleDatasetBase(ctx, input, buffer_size, count, buffer_memory_limit,
+                           spill_directory),
         seed_(seed),
         seed2_(seed2) {}
 
@@ -767,9 +1048,11 @@ class ShuffleAndRepeatDatasetOp::Dataset : public ShuffleDatasetBase {
     TF_RETURN_IF_ERROR(b->AddScalar(seed_, &seed));
     TF_RETURN_IF_ERROR(b->AddScalar(seed2_, &seed2));
     TF_RETURN_IF_ERROR(b->AddScalar(count_, &count));
+    std::vector<std::pair<StringPiece, AttrValue>> attrs;
+    AddBufferMemoryAttrs(b, &attrs);
     TF_RETURN_IF_ERROR(b->AddDataset(
         this, {input_graph_node, buffer_size, seed, seed2, count},  // Inputs
-        {},                                                         // Attrs
+        attrs,                                                      // Attrs
         output));
     return Status::OK();
   }
@@ -812,7 +1095,8 @@ void ShuffleAndRepeatDatasetOp::MakeDataset(OpKernelContext* ctx,
     seed2 = random::New64();
   }
 
-  *output = new Dataset(ctx, input, buffer_size, seed, seed2, count);
+  *output = new Dataset(ctx, input, buffer_size, seed, seed2, count,
+                        buffer_memory_limit_, spill_directory_);
 }
 
 namespace {
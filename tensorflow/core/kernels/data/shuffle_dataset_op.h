@@ -28,11 +28,19 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
   static constexpr const char* const kSeed2 = "seed2";
   static constexpr const char* const kOutputTypes = "output_types";
   static constexpr const char* const kOutputShapes = "output_shapes";
+  static constexpr const char* const kBufferMemoryLimit =
+      "buffer_memory_limit";
+  static constexpr const char* const kSpillDirectory = "spill_directory";
 
   explicit ShuffleDatasetOpBase(OpKernelConstruction* ctx);
 
  protected:
   class ShuffleDatasetBase;
+
+  // If positive, the number of bytes of buffered elements each iterator keeps
+  // in memory. Elements beyond it are spilled to files in `spill_directory_`.
+  int64 buffer_memory_limit_ = 0;
+  string spill_directory_;
 };
 
 class ShuffleDatasetOp : public ShuffleDatasetOpBase {
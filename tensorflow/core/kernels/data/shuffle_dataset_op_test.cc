@@ -12,6 +12,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/shuffle_dataset_op.h"
 
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/lib/io/path.h"
 
 namespace tensorflow {
 namespace data {
@@ -24,10 +25,12 @@ class ShuffleDatasetOpTest : public DatasetOpsTestBase {
  protected:
   // Creates a new `ShuffleDataset`/`ShuffleAndRepeatDataset` op kernel
   Status CreateDatasetOpKernel(
-      int64 count, bool reshuffle_each_iteration,
+      int64 count, bool reshuffle_each_iteration, int64 buffer_memory_limit,
       const DataTypeVector& output_types,
       const std::vector<PartialTensorShape>& output_shapes,
       std::unique_ptr<OpKernel>* shuffle_dataset_kernel) {
+    const string spill_directory =
+        io::JoinPath(testing::TmpDir(), "shuffle_spill");
     NodeDef node_def;
     if (count == 1) {
       node_def = test::function::NDef(
@@ -37,7 +40,9 @@ class ShuffleDatasetOpTest : public DatasetOpsTestBase {
           {{ShuffleDatasetOp::kReshuffleEachIteration,
             reshuffle_each_iteration},
            {ShuffleDatasetOp::kOutputTypes, output_types},
-           {ShuffleDatasetOp::kOutputShapes, output_shapes}});
+           {ShuffleDatasetOp::kOutputShapes, output_shapes},
+           {ShuffleDatasetOp::kBufferMemoryLimit, buffer_memory_limit},
+           {ShuffleDatasetOp::kSpillDirectory, spill_directory}});
     } else {
       node_def = test::function::NDef(
           kShuffleAndRepeatNodeName,
@@ -47,7 +52,9 @@ class ShuffleDatasetOpTest : public DatasetOpsTestBase {
            ShuffleAndRepeatDatasetOp::kSeed, ShuffleAndRepeatDatasetOp::kSeed2,
            ShuffleAndRepeatDatasetOp::kCount},
           {{ShuffleAndRepeatDatasetOp::kOutputTypes, output_types},
-           {ShuffleAndRepeatDatasetOp::kOutputShapes, output_shapes}});
+           {ShuffleAndRepeatDatasetOp::kOutputShapes, output_shapes},
+           {ShuffleAndRepeatDatasetOp::kBufferMemoryLimit, buffer_memory_limit},
+           {ShuffleAndRepeatDatasetOp::kSpillDirectory, spill_directory}});
     }
     TF_RETURN_IF_ERROR(CreateOpKernel(node_def, shuffle_dataset_kernel));
     return Status::OK();
@@ -82,6 +89,7 @@ struct TestCase {
   std::vector<PartialTensorShape> expected_output_shapes;
   int64 expected_cardinality;
   std::vector<int> breakpoints;
+  int64 buffer_memory_limit = 0;
 };
 
 template <typename T>
@@ -254,6 +262,22 @@ TestCase TestCase8() {
           /*breakpoints*/ {0, 5, 20}};
 }
 
+// Test case 9: same as test case 2, but the shuffle buffer keeps only three
+// elements in memory and spills the others to disk.
+TestCase TestCase9() {
+  TestCase test_case = TestCase2();
+  test_case.buffer_memory_limit = 3 * sizeof(int64);
+  return test_case;
+}
+
+// Test case 10: same as test case 7, but the shuffle buffer spills all the
+// elements to disk.
+TestCase TestCase10() {
+  TestCase test_case = TestCase7();
+  test_case.buffer_memory_limit = 1;
+  return test_case;
+}
+
 TestCase InvalidBufferSizeTestCaseForShuffleDataset() {
   return {/*range_data_param*/ {0, 10, 1},
           /*buffer_size*/
@@ -317,10 +341,10 @@ TEST_P(ParameterizedShuffleDatasetOpTest, GetNext) {
   Tensor count = test_case.count;
   int64 count_value = count.flat<int64>()(0);
   std::unique_ptr<OpKernel> dataset_kernel;
-  TF_ASSERT_OK(
-      CreateDatasetOpKernel(count_value, test_case.reshuffle_each_iteration,
-                            test_case.expected_output_dtypes,
-                            test_case.expected_output_shapes, &dataset_kernel));
+  TF_ASSERT_OK(CreateDatasetOpKernel(
+      count_value, test_case.reshuffle_each_iteration,
+      test_case.buffer_memory_limit, test_case.expected_output_dtypes,
+      test_case.expected_output_shapes, &dataset_kernel));
 
   DatasetBase* range_dataset;
   TF_ASSERT_OK(CreateRangeDataset<int64>(
@@ -403,10 +427,10 @@ TEST_P(ParameterizedShuffleDatasetOpTest, DatasetNodeName) {
   Tensor count = test_case.count;
   int64 count_value = count.flat<int64>()(0);
   std::unique_ptr<OpKernel> dataset_kernel;
-  TF_ASSERT_OK(
-      CreateDatasetOpKernel(count_value, test_case.reshuffle_each_iteration,
-                            test_case.expected_output_dtypes,
-                            test_case.expected_output_shapes, &dataset_kernel));
+  TF_ASSERT_OK(CreateDatasetOpKernel(
+      count_value, test_case.reshuffle_each_iteration,
+      test_case.buffer_memory_limit, test_case.expected_output_dtypes,
+      test_case.expected_output_shapes, &dataset_kernel));
 
   DatasetBase* range_dataset;
   TF_ASSERT_OK(CreateRangeDataset<int64>(
@@ -447,10 +471,10 @@ TEST_P(ParameterizedShuffleDatasetOpTest, DatasetTypeString) {
   Tensor count = test_case.count;
   int64 count_value = count.flat<int64>()(0);
   std::unique_ptr<OpKernel> dataset_kernel;
-  TF_ASSERT_OK(
-      CreateDatasetOpKernel(count_value, test_case.reshuffle_each_iteration,
-                            test_case.expected_output_dtypes,
-                            test_case.expected_output_shapes, &dataset_kernel));
+  TF_ASSERT_OK(CreateDatasetOpKernel(
+      count_value, test_case.reshuffle_each_iteration,
+      test_case.buffer_memory_limit, test_case.expected_output_dtypes,
+      test_case.expected_output_shapes, &dataset_kernel));
 
   DatasetBase* range_dataset;
   TF_ASSERT_OK(CreateRangeDataset<int64>(
@@ -493,10 +517,10 @@ TEST_P(ParameterizedShuffleDatasetOpTest, DatasetOutputDtypes) {
   Tensor count = test_case.count;
   int64 count_value = count.flat<int64>()(0);
   std::unique_ptr<OpKernel> dataset_kernel;
-  TF_ASSERT_OK(
-      CreateDatasetOpKernel(count_value, test_case.reshuffle_each_iteration,
-                            test_case.expected_output_dtypes,
-                            test_case.expected_output_shapes, &dataset_kernel));
+  TF_ASSERT_OK(CreateDatasetOpKernel(
+      count_value, test_case.reshuffle_each_iteration,
+      test_case.buffer_memory_limit, test_case.expected_output_dtypes,
+      test_case.expected_output_shapes, &dataset_kernel));
 
   DatasetBase* range_dataset;
   TF_ASSERT_OK(CreateRangeDataset<int64>(
@@ -534,10 +558,10 @@ TEST_P(ParameterizedShuffleDatasetOpTest, DatasetOutputShapes) {
   Tensor count = test_case.count;
   int64 count_value = count.flat<int64>()(0);
   std::unique_ptr<OpKernel> dataset_kernel;
-  TF_ASSERT_OK(
-      CreateDatasetOpKernel(count_value, test_case.reshuffle_each_iteration,
-                            test_case.expected_output_dtypes,
-                            test_case.expected_output_shapes, &dataset_kernel));
+  TF_ASSERT_OK(CreateDatasetOpKernel(
+      count_value, test_case.reshuffle_each_iteration,
+      test_case.buffer_memory_limit, test_case.expected_output_dtypes,
+      test_case.expected_output_shapes, &dataset_kernel));
 
   DatasetBase* range_dataset;
   TF_ASSERT_OK(CreateRangeDataset<int64>(
@@ -575,10 +599,10 @@ TEST_P(ParameterizedShuffleDatasetOpTest, Cardinality) {
   Tensor count = test_case.count;
   int64 count_value = count.flat<int64>()(0);
   std::unique_ptr<OpKernel> dataset_kernel;
-  TF_ASSERT_OK(
-      CreateDatasetOpKernel(count_value, test_case.reshuffle_each_iteration,
-                            test_case.expected_output_dtypes,
-                            test_case.expected_output_shapes, &dataset_kernel));
+  TF_ASSERT_OK(CreateDatasetOpKernel(
+      count_value, test_case.reshuffle_each_iteration,
+      test_case.buffer_memory_limit, test_case.expected_output_dtypes,
+      test_case.expected_output_shapes, &dataset_kernel));
 
   DatasetBase* range_dataset;
   TF_ASSERT_OK(CreateRangeDataset<int64>(
@@ -615,10 +639,10 @@ TEST_P(ParameterizedShuffleDatasetOpTest, IteratorOutputDtypes) {
   Tensor count = test_case.count;
   int64 count_value = count.flat<int64>()(0);
   std::unique_ptr<OpKernel> dataset_kernel;
-  TF_ASSERT_OK(
-      CreateDatasetOpKernel(count_value, test_case.reshuffle_each_iteration,
-                            test_case.expected_output_dtypes,
-                            test_case.expected_output_shapes, &dataset_kernel));
+  TF_ASSERT_OK(CreateDatasetOpKernel(
+      count_value, test_case.reshuffle_each_iteration,
+      test_case.buffer_memory_limit, test_case.expected_output_dtypes,
+      test_case.expected_output_shapes, &dataset_kernel));
 
   DatasetBase* range_dataset;
   TF_ASSERT_OK(CreateRangeDataset<int64>(
@@ -662,10 +686,10 @@ TEST_P(ParameterizedShuffleDatasetOpTest, IteratorOutputShapes) {
   Tensor count = test_case.count;
   int64 count_value = count.flat<int64>()(0);
   std::unique_ptr<OpKernel> dataset_kernel;
-  TF_ASSERT_OK(
-      CreateDatasetOpKernel(count_value, test_case.reshuffle_each_iteration,
-                            test_case.expected_output_dtypes,
-                            test_case.expected_output_shapes, &dataset_kernel));
+  TF_ASSERT_OK(CreateDatasetOpKernel(
+      count_value, test_case.reshuffle_each_iteration,
+      test_case.buffer_memory_limit, test_case.expected_output_dtypes,
+      test_case.expected_output_shapes, &dataset_kernel));
 
   DatasetBase* range_dataset;
   TF_ASSERT_OK(CreateRangeDataset<int64>(
@@ -709,10 +733,10 @@ TEST_P(ParameterizedShuffleDatasetOpTest, IteratorOutputPrefix) {
   Tensor count = test_case.count;
   int64 count_value = count.flat<int64>()(0);
   std::unique_ptr<OpKernel> dataset_kernel;
-  TF_ASSERT_OK(
-      CreateDatasetOpKernel(count_value, test_case.reshuffle_each_iteration,
-                            test_case.expected_output_dtypes,
-                            test_case.expected_output_shapes, &dataset_kernel));
+  TF_ASSERT_OK(CreateDatasetOpKernel(
+      count_value, test_case.reshuffle_each_iteration,
+      test_case.buffer_memory_limit, test_case.expected_output_dtypes,
+      test_case.expected_output_shapes, &dataset_kernel));
 
   DatasetBase* range_dataset;
   TF_ASSERT_OK(CreateRangeDataset<int64>(
@@ -763,10 +787,10 @@ TEST_P(ParameterizedShuffleDatasetOpTest, Roundtrip) {
   Tensor count = test_case.count;
   int64 count_value = count.flat<int64>()(0);
   std::unique_ptr<OpKernel> dataset_kernel;
-  TF_ASSERT_OK(
-      CreateDatasetOpKernel(count_value, test_case.reshuffle_each_iteration,
-                            test_case.expected_output_dtypes,
-                            test_case.expected_output_shapes, &dataset_kernel));
+  TF_ASSERT_OK(CreateDatasetOpKernel(
+      count_value, test_case.reshuffle_each_iteration,
+      test_case.buffer_memory_limit, test_case.expected_output_dtypes,
+      test_case.expected_output_shapes, &dataset_kernel));
 
   DatasetBase* range_dataset;
   TF_ASSERT_OK(CreateRangeDataset<int64>(
@@ -831,7 +855,8 @@ INSTANTIATE_TEST_SUITE_P(ShuffleDatasetOpTest,
                          ::testing::ValuesIn(std::vector<TestCase>(
                              {TestCase1(), TestCase2(), TestCase3(),
                               TestCase4(), TestCase5(), TestCase6(),
-                              TestCase7(), TestCase8()})));
+                              TestCase7(), TestCase8(), TestCase9(),
+                              TestCase10()})));
 
 TEST_F(ShuffleDatasetOpTest, InvalidArguments) {
   int thread_num = 2, cpu_num = 2;
@@ -848,8 +873,8 @@ TEST_F(ShuffleDatasetOpTest, InvalidArguments) {
     std::unique_ptr<OpKernel> dataset_kernel;
     TF_ASSERT_OK(CreateDatasetOpKernel(
         count_value, test_case.reshuffle_each_iteration,
-        test_case.expected_output_dtypes, test_case.expected_output_shapes,
-        &dataset_kernel));
+        test_case.buffer_memory_limit, test_case.expected_output_dtypes,
+        test_case.expected_output_shapes, &dataset_kernel));
 
     DatasetBase* range_dataset;
     TF_ASSERT_OK(CreateRangeDataset<int64>(
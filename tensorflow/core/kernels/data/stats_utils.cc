@@ -32,6 +32,10 @@ ABSL_CONST_INIT const char kDroppedElements[] = "dropped_elements";
 ABSL_CONST_INIT const char kFeaturesCount[] = "features_count";
 ABSL_CONST_INIT const char kFeatureValuesCount[] = "feature_values_count";
 ABSL_CONST_INIT const char kExamplesCount[] = "examples_count";
+ABSL_CONST_INIT const char kCacheHits[] = "cache_hits";
+ABSL_CONST_INIT const char kCacheMisses[] = "cache_misses";
+ABSL_CONST_INIT const char kCacheBytesInMemory[] = "cache_bytes_in_memory";
+ABSL_CONST_INIT const char kCacheBytesSpilled[] = "cache_bytes_spilled";
 
 string ExecutionTimeHistogramName(const string& prefix) {
   return strings::StrCat(prefix, kDelimiter, kExecutionTime);
@@ -69,6 +73,14 @@ string FeatureValueHistogramName(const string& prefix) {
   return strings::StrCat(prefix, kDelimiter, kFeatureValuesCount);
 }
 
+string CacheBytesInMemoryScalarName(const string& prefix) {
+  return strings::StrCat(prefix, kDelimiter, kCacheBytesInMemory);
+}
+
+string CacheBytesSpilledScalarName(const string& prefix) {
+  return strings::StrCat(prefix, kDelimiter, kCacheBytesSpilled);
+}
+
 }  // namespace stats_utils
 }  // namespace data
 }  // namespace tensorflow
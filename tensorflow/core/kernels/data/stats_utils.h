@@ -31,6 +31,10 @@ extern const char kDroppedElements[];
 extern const char kFeaturesCount[];
 extern const char kFeatureValuesCount[];
 extern const char kExamplesCount[];
+extern const char kCacheHits[];
+extern const char kCacheMisses[];
+extern const char kCacheBytesInMemory[];
+extern const char kCacheBytesSpilled[];
 
 // Name for tf.data function execution time (in ns) histogram metrics.
 string ExecutionTimeHistogramName(const string& prefix);
@@ -61,6 +65,12 @@ string FeatureHistogramName(const string& prefix);
 // Name for feature-values count histogram metrics.
 string FeatureValueHistogramName(const string& prefix);
 
+// Name for the bytes of cached elements held in memory scalar metrics.
+string CacheBytesInMemoryScalarName(const string& prefix);
+
+// Name for the bytes of cached elements spilled to disk scalar metrics.
+string CacheBytesSpilledScalarName(const string& prefix);
+
 }  // namespace stats_utils
 }  // namespace data
 }  // namespace tensorflow
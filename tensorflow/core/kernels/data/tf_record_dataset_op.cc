@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/tf_record_dataset_op.h"
 
+#include <algorithm>
+#include <deque>
+
 #include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -24,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
 namespace data {
@@ -35,19 +39,192 @@ namespace data {
 /* static */ constexpr const char* const TFRecordDatasetOp::kFileNames;
 /* static */ constexpr const char* const TFRecordDatasetOp::kCompressionType;
 /* static */ constexpr const char* const TFRecordDatasetOp::kBufferSize;
+/* static */ constexpr const char* const TFRecordDatasetOp::kReadMode;
+/* static */ constexpr const char* const TFRecordDatasetOp::kReadAheadBytes;
 
 constexpr char kCurrentFileIndex[] = "current_file_index";
 constexpr char kOffset[] = "offset";
+constexpr char kMmap[] = "mmap";
+constexpr char kReadAhead[] = "read_ahead";
+constexpr int64 kDefaultReadAheadBytes = 256 << 20;
+
+namespace {
+
+// A RandomAccessFile over the contents of a file held in memory, so that
+// compressed files that were mapped or read ahead can be decompressed from
+// memory too.
+class InMemoryFile : public RandomAccessFile {
+ public:
+  explicit InMemoryFile(StringPiece contents) : contents_(contents) {}
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    const uint64 start = std::min<uint64>(offset, contents_.size());
+    *result = StringPiece(contents_.data() + start,
+                          std::min<uint64>(n, contents_.size() - start));
+    if (result->size() < n) {
+      return errors::OutOfRange("Read fewer bytes than requested");
+    }
+    return Status::OK();
+  }
+
+ private:
+  const StringPiece contents_;
+};
+
+// Reads whole files ahead of a TFRecordDataset iterator on a background
+// thread, holding at most `budget_bytes` of file contents at once. The file
+// the iterator is reading counts against the budget until it moves on.
+class FileReadAhead {
+ public:
+  FileReadAhead(IteratorContext* ctx, const std::vector<string>* filenames,
+                int64 budget_bytes)
+      : env_(ctx->env()), filenames_(filenames), budget_bytes_(budget_bytes) {
+    thread_ = ctx->StartThread("tf_data_tf_record_read_ahead",
+                               [this]() { ReadAheadThread(); });
+  }
+
+  ~FileReadAhead() {
+    {
+      mutex_lock l(mu_);
+      cancelled_ = true;
+      cond_var_.notify_all();
+    }
+    // Joins the read-ahead thread.
+    thread_.reset();
+  }
+
+  // Blocks until the file at `index` has been read and sets `*contents` to
+  // its contents, or to nullptr if the caller should stream the file instead,
+  // because it is larger than the budget or reading it failed. Releases the
+  // contents of earlier files, and restarts reading ahead from `index` if it
+  // isn't the file being read next, e.g. after a restore.
+  Status GetFile(size_t index, std::shared_ptr<const string>* contents)
+      LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    while (first_index_ < index && !files_.empty()) {
+      if (files_.front()) {
+        bytes_ -= files_.front()->size();
+      }
+      files_.pop_front();
+      ++first_index_;
+    }
+    if (first_index_ != index) {
+      ++generation_;
+      files_.clear();
+      bytes_ = 0;
+      first_index_ = index;
+      next_index_ = index;
+    }
+    cond_var_.notify_all();
+    while (!cancelled_ && files_.empty()) {
+      cond_var_.wait(l);
+    }
+    if (cancelled_) {
+      return errors::Cancelled("TFRecordDataset read-ahead was cancelled");
+    }
+    *contents = files_.front();
+    return Status::OK();
+  }
+
+ private:
+  void ReadAheadThread() LOCKS_EXCLUDED(mu_) {
+    while (true) {
+      size_t index;
+      int64 generation;
+      {
+        mutex_lock l(mu_);
+        while (!cancelled_ && next_index_ >= filenames_->size()) {
+          cond_var_.wait(l);
+        }
+        if (cancelled_) {
+          return;
+        }
+        index = next_index_;
+        generation = generation_;
+      }
+
+      const string& filename = (*filenames_)[index];
+      uint64 file_size = 0;
+      Status s = env_->GetFileSize(filename, &file_size);
+      const bool fits = s.ok() && file_size <= budget_bytes_;
+      {
+        mutex_lock l(mu_);
+        while (fits && !cancelled_ && generation == generation_ &&
+               bytes_ + file_size > budget_bytes_) {
+          cond_var_.wait(l);
+        }
+        if (cancelled_) {
+          return;
+        }
+        if (generation != generation_) {
+          continue;
+        }
+        if (fits) {
+          bytes_ += file_size;
+        }
+      }
+
+      std::shared_ptr<string> contents;
+      if (fits) {
+        contents = std::make_shared<string>();
+        s = ReadFileToString(env_, filename, contents.get());
+      }
+
+      mutex_lock l(mu_);
+      if (generation != generation_) {
+        // The budget was reset when reading ahead restarted.
+        continue;
+      }
+      if (fits) {
+        bytes_ -= file_size;
+        if (s.ok()) {
+          bytes_ += contents->size();
+        } else {
+          // Streaming the file will report the error.
+          contents.reset();
+        }
+      }
+      files_.push_back(std::move(contents));
+      ++next_index_;
+      cond_var_.notify_all();
+    }
+  }
+
+  Env* const env_;
+  const std::vector<string>* const filenames_;
+  const uint64 budget_bytes_;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  bool cancelled_ GUARDED_BY(mu_) = false;
+  // Incremented whenever reading ahead restarts, to discard the file being
+  // read at the time.
+  int64 generation_ GUARDED_BY(mu_) = 0;
+  // The contents of the files from `first_index_` up to `next_index_`, or
+  // nullptr for the files to stream.
+  std::deque<std::shared_ptr<const string>> files_ GUARDED_BY(mu_);
+  size_t first_index_ GUARDED_BY(mu_) = 0;
+  size_t next_index_ GUARDED_BY(mu_) = 0;
+  // Total size of `files_`.
+  uint64 bytes_ GUARDED_BY(mu_) = 0;
+  std::unique_ptr<Thread> thread_;
+};
+
+}  // namespace
 
 class TFRecordDatasetOp::Dataset : public DatasetBase {
  public:
   explicit Dataset(OpKernelContext* ctx, std::vector<string> filenames,
-                   const string& compression_type, int64 buffer_size)
+                   const string& compression_type, int64 buffer_size,
+                   const string& read_mode, int64 read_ahead_bytes)
       : DatasetBase(DatasetContext(ctx)),
         filenames_(std::move(filenames)),
         compression_type_(compression_type),
         options_(io::RecordReaderOptions::CreateRecordReaderOptions(
-            compression_type)) {
+            compression_type)),
+        read_mode_(read_mode),
+        read_ahead_bytes_(read_ahead_bytes) {
     if (buffer_size > 0) {
       options_.buffer_size = buffer_size;
     }
@@ -86,8 +263,14 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     TF_RETURN_IF_ERROR(b->AddScalar(compression_type_, &compression_type));
     Node* buffer_size = nullptr;
     TF_RETURN_IF_ERROR(b->AddScalar(options_.buffer_size, &buffer_size));
+    AttrValue read_mode;
+    b->BuildAttrValue(read_mode_, &read_mode);
+    AttrValue read_ahead_bytes;
+    b->BuildAttrValue(read_ahead_bytes_, &read_ahead_bytes);
     TF_RETURN_IF_ERROR(b->AddDataset(
-        this, {filenames, compression_type, buffer_size}, output));
+        this, {filenames, compression_type, buffer_size},
+        {{kReadMode, read_mode}, {kReadAheadBytes, read_ahead_bytes}},
+        output));
     return Status::OK();
   }
 
@@ -97,17 +280,27 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     explicit Iterator(const Params& params)
         : DatasetIterator<Dataset>(params) {}
 
+    Status Initialize(IteratorContext* ctx) override {
+      if (dataset()->read_mode_ == kReadAhead) {
+        mutex_lock l(mu_);
+        read_ahead_ = absl::make_unique<FileReadAhead>(
+            ctx, &dataset()->filenames_,
+            dataset()->read_ahead_bytes_ > 0 ? dataset()->read_ahead_bytes_
+                                             : kDefaultReadAheadBytes);
+      }
+      return Status::OK();
+    }
+
     Status GetNextInternal(IteratorContext* ctx,
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
       mutex_lock l(mu_);
       do {
         // We are currently processing a file, so try to read the next record.
-        if (reader_) {
+        if (reader_ || buffer_reader_) {
           out_tensors->emplace_back(ctx->allocator({}), DT_STRING,
                                     TensorShape({}));
-          Status s =
-              reader_->ReadRecord(&out_tensors->back().scalar<string>()());
+          Status s = ReadRecordLocked(&out_tensors->back());
           if (s.ok()) {
             metrics::RecordTFDataBytesRead(
                 kDatasetType, out_tensors->back().scalar<tstring>()().size());
@@ -151,9 +344,9 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
       TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kCurrentFileIndex),
                                              current_file_index_));
 
-      if (reader_) {
+      if (reader_ || buffer_reader_) {
         TF_RETURN_IF_ERROR(
-            writer->WriteScalar(full_name(kOffset), reader_->TellOffset()));
+            writer->WriteScalar(full_name(kOffset), TellOffsetLocked()));
       }
       return Status::OK();
     }
@@ -170,7 +363,7 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
         int64 offset;
         TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kOffset), &offset));
         TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
-        TF_RETURN_IF_ERROR(reader_->SeekOffset(offset));
+        TF_RETURN_IF_ERROR(SeekOffsetLocked(offset));
       }
       return Status::OK();
     }
@@ -186,34 +379,122 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
 
       // Actually move on to next file.
       const string& next_filename = dataset()->filenames_[current_file_index_];
-      TF_RETURN_IF_ERROR(env->NewRandomAccessFile(next_filename, &file_));
+      StringPiece contents;
+      bool in_memory = false;
+      if (dataset()->read_mode_ == kMmap) {
+        TF_RETURN_IF_ERROR(
+            MapFileLocked(env, next_filename, &contents, &in_memory));
+      } else if (read_ahead_) {
+        TF_RETURN_IF_ERROR(
+            read_ahead_->GetFile(current_file_index_, &file_contents_));
+        if (file_contents_) {
+          contents = *file_contents_;
+          in_memory = true;
+        }
+      }
+
+      if (!in_memory) {
+        TF_RETURN_IF_ERROR(env->NewRandomAccessFile(next_filename, &file_));
+      } else if (dataset()->options_.compression_type ==
+                 io::RecordReaderOptions::NONE) {
+        // Uncompressed records are read straight out of memory.
+        buffer_reader_ = absl::make_unique<io::RecordBufferReader>(contents);
+        return Status::OK();
+      } else {
+        file_ = absl::make_unique<InMemoryFile>(contents);
+      }
       reader_ = absl::make_unique<io::SequentialRecordReader>(
           file_.get(), dataset()->options_);
       return Status::OK();
     }
 
+    // Maps `filename` into memory, or sets `*mapped` to false if its file
+    // system doesn't support that.
+    Status MapFileLocked(Env* env, const string& filename,
+                         StringPiece* contents, bool* mapped)
+        EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      uint64 file_size;
+      TF_RETURN_IF_ERROR(env->GetFileSize(filename, &file_size));
+      *mapped = true;
+      if (file_size == 0) {
+        // Empty files can't be mapped, but have no records anyway.
+        *contents = StringPiece();
+        return Status::OK();
+      }
+      Status s = env->NewReadOnlyMemoryRegionFromFile(filename, &region_);
+      if (errors::IsUnimplemented(s)) {
+        *mapped = false;
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(s);
+      *contents = StringPiece(static_cast<const char*>(region_->data()),
+                              region_->length());
+      return Status::OK();
+    }
+
+    // Reads the next record of the current file into the scalar `record`.
+    Status ReadRecordLocked(Tensor* record) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (buffer_reader_) {
+        StringPiece view;
+        TF_RETURN_IF_ERROR(buffer_reader_->ReadRecord(&view));
+        record->scalar<tstring>()().assign(view.data(), view.size());
+        return Status::OK();
+      }
+      return reader_->ReadRecord(&record->scalar<string>()());
+    }
+
+    uint64 TellOffsetLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      return buffer_reader_ ? buffer_reader_->TellOffset()
+                            : reader_->TellOffset();
+    }
+
+    Status SeekOffsetLocked(uint64 offset) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      return buffer_reader_ ? buffer_reader_->SeekOffset(offset)
+                            : reader_->SeekOffset(offset);
+    }
+
     // Resets all reader streams.
     void ResetStreamsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       reader_.reset();
+      buffer_reader_.reset();
       file_.reset();
+      region_.reset();
+      file_contents_.reset();
     }
 
     mutex mu_;
     size_t current_file_index_ GUARDED_BY(mu_) = 0;
 
-    // `reader_` will borrow the object that `file_` points to, so
-    // we must destroy `reader_` before `file_`.
+    // Set in "read_ahead" mode.
+    std::unique_ptr<FileReadAhead> read_ahead_ GUARDED_BY(mu_);
+
+    // The contents of the current file, when it is mapped or was read ahead.
+    std::unique_ptr<ReadOnlyMemoryRegion> region_ GUARDED_BY(mu_);
+    std::shared_ptr<const string> file_contents_ GUARDED_BY(mu_);
+    // `reader_` will borrow the object that `file_` points to, and `file_`
+    // and `buffer_reader_` will borrow the contents above, so we must
+    // destroy them first.
     std::unique_ptr<RandomAccessFile> file_ GUARDED_BY(mu_);
+    // Reads the current file, unless it is uncompressed and in memory.
     std::unique_ptr<io::SequentialRecordReader> reader_ GUARDED_BY(mu_);
+    std::unique_ptr<io::RecordBufferReader> buffer_reader_ GUARDED_BY(mu_);
   };
 
   const std::vector<string> filenames_;
   const string compression_type_;
   io::RecordReaderOptions options_;
+  const string read_mode_;
+  const int64 read_ahead_bytes_;
 };
 
 TFRecordDatasetOp::TFRecordDatasetOp(OpKernelConstruction* ctx)
-    : DatasetOpKernel(ctx) {}
+    : DatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kReadMode, &read_mode_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kReadAheadBytes, &read_ahead_bytes_));
+  OP_REQUIRES(ctx, read_ahead_bytes_ >= 0,
+              errors::InvalidArgument(
+                  "`read_ahead_bytes` must be >= 0 (0 == default budget)"));
+}
 
 void TFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
                                     DatasetBase** output) {
@@ -241,8 +522,8 @@ void TFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
               errors::InvalidArgument(
                   "`buffer_size` must be >= 0 (0 == no buffering)"));
 
-  *output =
-      new Dataset(ctx, std::move(filenames), compression_type, buffer_size);
+  *output = new Dataset(ctx, std::move(filenames), compression_type,
+                        buffer_size, read_mode_, read_ahead_bytes_);
 }
 
 namespace {
@@ -24,12 +24,14 @@ class TFRecordDatasetOpTest : public DatasetOpsTestBase {
  protected:
   // Create a new `TFRecordDataset` op kernel.
   Status CreateTFRecordDatasetOpKernel(
+      const string& read_mode, int64 read_ahead_bytes,
       std::unique_ptr<OpKernel>* tf_record_dataset_op_kernel) {
     NodeDef node_def = test::function::NDef(
         kNodeName, name_utils::OpName(TFRecordDatasetOp::kDatasetType),
         {TFRecordDatasetOp::kFileNames, TFRecordDatasetOp::kCompressionType,
          TFRecordDatasetOp::kBufferSize},
-        {});
+        {{TFRecordDatasetOp::kReadMode, read_mode},
+         {TFRecordDatasetOp::kReadAheadBytes, read_ahead_bytes}});
     TF_RETURN_IF_ERROR(CreateOpKernel(node_def, tf_record_dataset_op_kernel));
     return Status::OK();
   }
@@ -50,6 +52,8 @@ struct TestCase {
   std::vector<std::vector<string>> contents;
   CompressionType compression_type;
   int64 buffer_size;
+  string read_mode;
+  int64 read_ahead_bytes;
   std::vector<Tensor> expected_outputs;
   DataTypeVector expected_output_dtypes;
   std::vector<PartialTensorShape> expected_output_shapes;
@@ -83,6 +87,8 @@ TestCase TestCase1() {
           {{"1", "22", "333"}, {"a", "bb", "ccc"}},
           /*compression_type*/ CompressionType::ZLIB,
           /*buffer_size*/ 10,
+          /*read_mode*/ "stream",
+          /*read_ahead_bytes*/ 0,
           /*expected_outputs*/
           {CreateTensor<string>(TensorShape({}), {"1"}),
            CreateTensor<string>(TensorShape({}), {"22"}),
@@ -104,6 +110,8 @@ TestCase TestCase2() {
           {{"1", "22", "333"}, {"a", "bb", "ccc"}},
           /*compression_type*/ CompressionType::GZIP,
           /*buffer_size*/ 10,
+          /*read_mode*/ "stream",
+          /*read_ahead_bytes*/ 0,
           /*expected_outputs*/
           {CreateTensor<string>(TensorShape({}), {"1"}),
            CreateTensor<string>(TensorShape({}), {"22"}),
@@ -126,6 +134,8 @@ TestCase TestCase3() {
           {{"1", "22", "333"}, {"a", "bb", "ccc"}},
           /*compression_type*/ CompressionType::UNCOMPRESSED,
           /*buffer_size*/ 10,
+          /*read_mode*/ "stream",
+          /*read_ahead_bytes*/ 0,
           /*expected_outputs*/
           {CreateTensor<string>(TensorShape({}), {"1"}),
            CreateTensor<string>(TensorShape({}), {"22"}),
@@ -139,6 +149,77 @@ TestCase TestCase3() {
           /*breakpoints*/ {0, 2, 7}};
 }
 
+// Test case 4: memory-mapped files without compression, one of them empty.
+TestCase TestCase4() {
+  return {/*filenames*/ {absl::StrCat(testing::TmpDir(), "/tf_record_MMAP_1"),
+                         absl::StrCat(testing::TmpDir(), "/tf_record_MMAP_2"),
+                         absl::StrCat(testing::TmpDir(), "/tf_record_MMAP_3")},
+          /*contents*/
+          {{"1", "22", "333"}, {}, {"a", "bb", "ccc"}},
+          /*compression_type*/ CompressionType::UNCOMPRESSED,
+          /*buffer_size*/ 10,
+          /*read_mode*/ "mmap",
+          /*read_ahead_bytes*/ 0,
+          /*expected_outputs*/
+          {CreateTensor<string>(TensorShape({}), {"1"}),
+           CreateTensor<string>(TensorShape({}), {"22"}),
+           CreateTensor<string>(TensorShape({}), {"333"}),
+           CreateTensor<string>(TensorShape({}), {"a"}),
+           CreateTensor<string>(TensorShape({}), {"bb"}),
+           CreateTensor<string>(TensorShape({}), {"ccc"})},
+          /*expected_output_dtypes*/ {DT_STRING},
+          /*expected_output_shapes*/ {PartialTensorShape({})},
+          /*expected_cardinality*/ kUnknownCardinality,
+          /*breakpoints*/ {0, 2, 7}};
+}
+
+// Test case 5: files read ahead with ZLIB compression.
+TestCase TestCase5() {
+  return {/*filenames*/ {
+              absl::StrCat(testing::TmpDir(), "/tf_record_READ_AHEAD_ZLIB_1"),
+              absl::StrCat(testing::TmpDir(), "/tf_record_READ_AHEAD_ZLIB_2")},
+          /*contents*/
+          {{"1", "22", "333"}, {"a", "bb", "ccc"}},
+          /*compression_type*/ CompressionType::ZLIB,
+          /*buffer_size*/ 10,
+          /*read_mode*/ "read_ahead",
+          /*read_ahead_bytes*/ 0,
+          /*expected_outputs*/
+          {CreateTensor<string>(TensorShape({}), {"1"}),
+           CreateTensor<string>(TensorShape({}), {"22"}),
+           CreateTensor<string>(TensorShape({}), {"333"}),
+           CreateTensor<string>(TensorShape({}), {"a"}),
+           CreateTensor<string>(TensorShape({}), {"bb"}),
+           CreateTensor<string>(TensorShape({}), {"ccc"})},
+          /*expected_output_dtypes*/ {DT_STRING},
+          /*expected_output_shapes*/ {PartialTensorShape({})},
+          /*expected_cardinality*/ kUnknownCardinality,
+          /*breakpoints*/ {0, 2, 7}};
+}
+
+// Test case 6: files read ahead without compression, with a budget that
+// only fits the second file (17 bytes), so the first (54 bytes) is streamed.
+TestCase TestCase6() {
+  return {/*filenames*/ {
+              absl::StrCat(testing::TmpDir(), "/tf_record_READ_AHEAD_1"),
+              absl::StrCat(testing::TmpDir(), "/tf_record_READ_AHEAD_2")},
+          /*contents*/
+          {{"1", "22", "333"}, {"a"}},
+          /*compression_type*/ CompressionType::UNCOMPRESSED,
+          /*buffer_size*/ 10,
+          /*read_mode*/ "read_ahead",
+          /*read_ahead_bytes*/ 40,
+          /*expected_outputs*/
+          {CreateTensor<string>(TensorShape({}), {"1"}),
+           CreateTensor<string>(TensorShape({}), {"22"}),
+           CreateTensor<string>(TensorShape({}), {"333"}),
+           CreateTensor<string>(TensorShape({}), {"a"})},
+          /*expected_output_dtypes*/ {DT_STRING},
+          /*expected_output_shapes*/ {PartialTensorShape({})},
+          /*expected_cardinality*/ kUnknownCardinality,
+          /*breakpoints*/ {0, 2, 5}};
+}
+
 class ParameterizedTFRecordDatasetOpTest
     : public TFRecordDatasetOpTest,
       public ::testing::WithParamInterface<TestCase> {};
@@ -152,7 +233,9 @@ TEST_P(ParameterizedTFRecordDatasetOpTest, GetNext) {
   TF_ASSERT_OK(CreateTestFiles(test_case));
 
   std::unique_ptr<OpKernel> tf_record_dataset_kernel;
-  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(&tf_record_dataset_kernel));
+  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(
+      test_case.read_mode, test_case.read_ahead_bytes,
+      &tf_record_dataset_kernel));
 
   int64 num_files = test_case.filenames.size();
   Tensor filenames =
@@ -202,7 +285,9 @@ TEST_F(TFRecordDatasetOpTest, DatasetNodeName) {
   TF_ASSERT_OK(CreateTestFiles(test_case));
 
   std::unique_ptr<OpKernel> tf_record_dataset_kernel;
-  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(&tf_record_dataset_kernel));
+  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(
+      test_case.read_mode, test_case.read_ahead_bytes,
+      &tf_record_dataset_kernel));
 
   int64 num_files = test_case.filenames.size();
   Tensor filenames =
@@ -235,7 +320,9 @@ TEST_F(TFRecordDatasetOpTest, DatasetTypeString) {
   TF_ASSERT_OK(CreateTestFiles(test_case));
 
   std::unique_ptr<OpKernel> tf_record_dataset_kernel;
-  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(&tf_record_dataset_kernel));
+  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(
+      test_case.read_mode, test_case.read_ahead_bytes,
+      &tf_record_dataset_kernel));
 
   int64 num_files = test_case.filenames.size();
   Tensor filenames =
@@ -269,7 +356,9 @@ TEST_P(ParameterizedTFRecordDatasetOpTest, DatasetOutputDtypes) {
   TF_ASSERT_OK(CreateTestFiles(test_case));
 
   std::unique_ptr<OpKernel> tf_record_dataset_kernel;
-  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(&tf_record_dataset_kernel));
+  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(
+      test_case.read_mode, test_case.read_ahead_bytes,
+      &tf_record_dataset_kernel));
 
   int64 num_files = test_case.filenames.size();
   Tensor filenames =
@@ -303,7 +392,9 @@ TEST_P(ParameterizedTFRecordDatasetOpTest, DatasetOutputShapes) {
   TF_ASSERT_OK(CreateTestFiles(test_case));
 
   std::unique_ptr<OpKernel> tf_record_dataset_kernel;
-  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(&tf_record_dataset_kernel));
+  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(
+      test_case.read_mode, test_case.read_ahead_bytes,
+      &tf_record_dataset_kernel));
 
   int64 num_files = test_case.filenames.size();
   Tensor filenames =
@@ -337,7 +428,9 @@ TEST_P(ParameterizedTFRecordDatasetOpTest, Cardinality) {
   TF_ASSERT_OK(CreateTestFiles(test_case));
 
   std::unique_ptr<OpKernel> tf_record_dataset_kernel;
-  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(&tf_record_dataset_kernel));
+  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(
+      test_case.read_mode, test_case.read_ahead_bytes,
+      &tf_record_dataset_kernel));
 
   int64 num_files = test_case.filenames.size();
   Tensor filenames =
@@ -370,7 +463,9 @@ TEST_P(ParameterizedTFRecordDatasetOpTest, IteratorOutputDtypes) {
   TF_ASSERT_OK(CreateTestFiles(test_case));
 
   std::unique_ptr<OpKernel> tf_record_dataset_kernel;
-  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(&tf_record_dataset_kernel));
+  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(
+      test_case.read_mode, test_case.read_ahead_bytes,
+      &tf_record_dataset_kernel));
 
   int64 num_files = test_case.filenames.size();
   Tensor filenames =
@@ -412,7 +507,9 @@ TEST_P(ParameterizedTFRecordDatasetOpTest, IteratorOutputShapes) {
   TF_ASSERT_OK(CreateTestFiles(test_case));
 
   std::unique_ptr<OpKernel> tf_record_dataset_kernel;
-  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(&tf_record_dataset_kernel));
+  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(
+      test_case.read_mode, test_case.read_ahead_bytes,
+      &tf_record_dataset_kernel));
 
   int64 num_files = test_case.filenames.size();
   Tensor filenames =
@@ -454,7 +551,9 @@ TEST_P(ParameterizedTFRecordDatasetOpTest, IteratorOutputPrefix) {
   TF_ASSERT_OK(CreateTestFiles(test_case));
 
   std::unique_ptr<OpKernel> tf_record_dataset_kernel;
-  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(&tf_record_dataset_kernel));
+  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(
+      test_case.read_mode, test_case.read_ahead_bytes,
+      &tf_record_dataset_kernel));
 
   int64 num_files = test_case.filenames.size();
   Tensor filenames =
@@ -497,7 +596,9 @@ TEST_P(ParameterizedTFRecordDatasetOpTest, Roundtrip) {
   TF_ASSERT_OK(CreateTestFiles(test_case));
 
   std::unique_ptr<OpKernel> tf_record_dataset_kernel;
-  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(&tf_record_dataset_kernel));
+  TF_ASSERT_OK(CreateTFRecordDatasetOpKernel(
+      test_case.read_mode, test_case.read_ahead_bytes,
+      &tf_record_dataset_kernel));
 
   int64 num_files = test_case.filenames.size();
   Tensor filenames =
@@ -558,7 +659,8 @@ TEST_P(ParameterizedTFRecordDatasetOpTest, Roundtrip) {
 INSTANTIATE_TEST_SUITE_P(TFRecordDatasetOpTest,
                          ParameterizedTFRecordDatasetOpTest,
                          ::testing::ValuesIn(std::vector<TestCase>(
-                             {TestCase1(), TestCase2(), TestCase3()})));
+                             {TestCase1(), TestCase2(), TestCase3(),
+                              TestCase4(), TestCase5(), TestCase6()})));
 
 }  // namespace
 }  // namespace data
@@ -76,8 +76,14 @@ int UnboundedThreadPool::NumThreads() const { return -1; }
 int UnboundedThreadPool::CurrentThreadId() const { return -1; }
 
 namespace {
-void WorkQueueFunc(const std::function<void()>& fn,
+void WorkQueueFunc(const std::function<void()>& fn, int numa_node,
                    std::shared_ptr<Notification> done) {
+  // The physical threads are owned by the pool, so the affinity does not need
+  // to be restored.
+  if (numa_node != port::kNUMANoAffinity &&
+      port::NUMAGetThreadNodeAffinity() != numa_node) {
+    port::NUMASetThreadNodeAffinity(numa_node);
+  }
   fn();
   if (done) {
     done->Notify();
@@ -88,7 +94,7 @@ void WorkQueueFunc(const std::function<void()>& fn,
 void UnboundedThreadPool::ScheduleOnWorkQueue(
     std::function<void()> fn, std::shared_ptr<Notification> done) {
   unbounded_work_queue_.Schedule(
-      std::bind(&WorkQueueFunc, std::move(fn), std::move(done)));
+      std::bind(&WorkQueueFunc, std::move(fn), numa_node_, std::move(done)));
 }
 
 }  // namespace data
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/threadpool_interface.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/unbounded_work_queue.h"
 
 namespace tensorflow {
@@ -32,10 +33,14 @@ namespace data {
 // potentially large number of "logical" threads onto a smaller number of
 // "physical" threads. The multiplexing is achieved by using an
 // `UnboundedWorkQueue`.
+//
+// If `numa_node` is not `port::kNUMANoAffinity`, the physical threads of the
+// pool have affinity to the given NUMA node.
 class UnboundedThreadPool : public thread::ThreadPoolInterface {
  public:
-  UnboundedThreadPool(Env* env, const string& thread_name)
-      : unbounded_work_queue_(env, thread_name) {}
+  UnboundedThreadPool(Env* env, const string& thread_name,
+                      int numa_node = port::kNUMANoAffinity)
+      : unbounded_work_queue_(env, thread_name), numa_node_(numa_node) {}
   ~UnboundedThreadPool() = default;
 
   // Returns an implementation of `ThreadFactory` that can be used to create
@@ -54,6 +59,7 @@ class UnboundedThreadPool : public thread::ThreadPoolInterface {
                            std::shared_ptr<Notification> done);
 
   UnboundedWorkQueue unbounded_work_queue_;
+  const int numa_node_;
 };
 
 }  // namespace data
@@ -78,6 +78,39 @@ TEST(UnboundedThreadPool, MultipleBlockingThreads) {
   }
 }
 
+TEST(UnboundedThreadPool, NUMAAffinity) {
+  // Every host has a NUMA node 0, which is used when NUMA is not supported.
+  UnboundedThreadPool pool(Env::Default(), "test", /*numa_node=*/0);
+  auto thread_factory = pool.get_thread_factory();
+
+  std::vector<std::unique_ptr<Thread>> threads;
+  const int kNumThreadsToCreate = 10;
+  std::atomic<int> i(0);
+  std::atomic<int> num_pinned(0);
+  for (int j = 0; j < kNumThreadsToCreate; ++j) {
+    threads.push_back(thread_factory->StartThread("", [&i, &num_pinned]() {
+      ++i;
+      if (port::NUMAGetThreadNodeAffinity() == 0) {
+        ++num_pinned;
+      }
+    }));
+  }
+  BlockingCounter bc(kNumThreadsToCreate);
+  for (int j = 0; j < kNumThreadsToCreate; ++j) {
+    pool.Schedule([&i, &bc]() {
+      ++i;
+      bc.DecrementCount();
+    });
+  }
+  bc.Wait();
+  threads.clear();
+
+  EXPECT_EQ(i, 2 * kNumThreadsToCreate);
+  if (port::NUMAEnabled()) {
+    EXPECT_EQ(num_pinned, kNumThreadsToCreate);
+  }
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -26,7 +26,8 @@ DmlKernelWrapperBase::DmlKernelWrapperBase(OpKernelConstruction* ctx,
                                            DmlKernelCachePolicy cache_policy)
     : OpKernel(ctx),
       cache_policy_(cache_policy),
-      node_def_(std::make_shared<NodeDef>(ctx->def())) {}
+      node_def_(std::make_shared<NodeDef>(ctx->def())),
+      attributes_hash_(DmlKernelAttributesHash(type_string(), *node_def_)) {}
 
 void DmlKernelWrapperBase::Compute(OpKernelContext* ctx) {
   DmlTracing::Instance().LogKernelCompute(ctx->op_kernel().type_string(),
@@ -41,7 +42,7 @@ void DmlKernelWrapperBase::Compute(OpKernelContext* ctx) {
   std::shared_ptr<DmlKernel> kernel;
   std::vector<TensorShape> output_shapes;
   const InitializationHelper* init_helper = nullptr;
-  DmlKernelKey key;
+  DmlKernelKeyView key;
 
   if (cache_policy_ != DmlKernelCachePolicy::Never) {
     // Construct a kernel key which uniquely identifies the kernel instance we
@@ -50,7 +51,7 @@ void DmlKernelWrapperBase::Compute(OpKernelContext* ctx) {
 
     // Retrieve an appropriate DmlKernel from the cache. If the kernel hasn't
     // been cached yet, it will be null
-    kernel = TryGetCachedKernel(kernel_manager, key);
+    kernel = GetCachedKernel(kernel_manager, key);
   }
 
   // If we found a cached kernel, simply retrieve its initialization helper
@@ -161,8 +162,13 @@ void DmlKernelWrapperBase::Compute(OpKernelContext* ctx) {
       // directly
       kernel = CreateKernel(&dml_construction, init_helper);
     } else {
+      std::shared_ptr<const DmlCachedKernel> entry;
       kernel = CreateCachedKernel(&dml_construction, kernel_manager, key,
-                                  init_helper);
+                                  init_helper, &entry);
+
+      if (ctx->status().ok()) {
+        UpdateLastHit(std::move(entry));
+      }
     }
 
     // Check for validation done during kernel construction
@@ -191,10 +197,90 @@ void DmlKernelWrapperBase::Compute(OpKernelContext* ctx) {
   kernel_manager.QueueReference(kernel, status_or_event.ConsumeValueOrDie());
 }
 
-DmlKernelKey DmlKernelWrapperBase::CreateKernelKey(OpKernelContext* ctx) const {
-  DmlKernelKey key = {};
+Status DmlKernelWrapperBase::WarmKernelCache(OpKernelContext* ctx) {
+  if (cache_policy_ == DmlKernelCachePolicy::Never) {
+    return Status::OK();
+  }
+
+  const DmlDevice* dml_device = static_cast<const DmlDevice*>(ctx->device());
+  const DmlKernelManager& kernel_manager = *dml_device->GetKernelManager();
+
+  DmlKernelKeyView key = CreateKernelKey(ctx);
+  if (TryGetCacheEntry(kernel_manager, key)) {
+    return Status::OK();  // Already cached
+  }
+
+  auto shared_helper = CreateInitializationHelper(ctx);
+  TF_RETURN_IF_ERROR(ctx->status());
+
+  std::vector<TensorShape> output_shapes =
+      GetShapeHelper()->GetOutputShapes(ctx, shared_helper.get());
+  TF_RETURN_IF_ERROR(ctx->status());
+
+  if (ctx->num_outputs() != output_shapes.size()) {
+    return errors::InvalidArgument(
+        "The shape helper supplied an incorrect number of output shapes. ",
+        ctx->num_outputs(), " were expected, but ", output_shapes.size(),
+        " were provided.");
+  }
+
+  // No-op kernels are never constructed by Compute, so there's nothing to
+  // cache. Kernels whose outputs are forwarded never reach the kernel manager
+  // either, so they can't appear in a manifest in the first place.
+  if (shared_helper->IsNoOpKernel(ctx, output_shapes)) {
+    return Status::OK();
+  }
+
+  DmlKernelConstruction dml_construction(dml_device, ctx, node_def_.get(),
+                                         output_shapes, shared_helper);
+  CreateCachedKernel(&dml_construction, kernel_manager, key,
+                     shared_helper.get(), /*entry=*/nullptr);
+
+  return ctx->status();
+}
+
+std::shared_ptr<DmlKernel> DmlKernelWrapperBase::GetCachedKernel(
+    const DmlKernelManager& kernel_manager,
+    const DmlKernelKeyView& key) const {
+  std::shared_ptr<const DmlCachedKernel> entry;
+  {
+    std::unique_lock<std::mutex> lock(last_hit_mutex_);
+    entry = last_hit_;
+  }
+
+  // Entries are immutable, so the key can be compared without the lock
+  if (entry && entry->hash() == DmlKernelKeyHash(key) && entry->key() == key) {
+    entry->Touch();
+    return entry->kernel();
+  }
+
+  entry = TryGetCacheEntry(kernel_manager, key);
+  if (!entry) {
+    return nullptr;
+  }
+
+  std::shared_ptr<DmlKernel> kernel = entry->kernel();
+  UpdateLastHit(std::move(entry));
+  return kernel;
+}
+
+void DmlKernelWrapperBase::UpdateLastHit(
+    std::shared_ptr<const DmlCachedKernel> entry) const {
+  std::unique_lock<std::mutex> lock(last_hit_mutex_);
+  last_hit_ = std::move(entry);
+}
+
+DmlKernelKeyView DmlKernelWrapperBase::CreateEmptyKernelKey() const {
+  DmlKernelKeyView key = {};
   key.op_type_name = this->type_string();
-  key.node_def = node_def_;
+  key.node_def = &node_def_;
+  key.attributes_hash = attributes_hash_;
+  return key;
+}
+
+DmlKernelKeyView DmlKernelWrapperBase::CreateKernelKey(
+    OpKernelContext* ctx) const {
+  DmlKernelKeyView key = CreateEmptyKernelKey();
 
   for (int i = 0; i < ctx->num_inputs(); ++i) {
     MemoryType memory_type = ctx->input_memory_type(i);
@@ -207,17 +293,14 @@ DmlKernelKey DmlKernelWrapperBase::CreateKernelKey(OpKernelContext* ctx) const {
     const bool is_resource_type =
         (BaseType(ctx->input_dtype(i)) == DT_RESOURCE);
 
-    Tensor tensor =
-        ctx->input_is_ref(i) ? ctx->mutable_input(i, false) : ctx->input(i);
-
-    DmlInputTensorKey tensor_key = {};
+    DmlInputTensorKeyView tensor_key = {};
     tensor_key.is_constant_cpu_input =
         (memory_type == HOST_MEMORY && !is_resource_type);
 
-    if (tensor_key.is_constant_cpu_input) {
-      tensor_key.tensor = std::move(tensor);
+    if (ctx->input_is_ref(i)) {
+      tensor_key.tensor = ctx->mutable_input(i, false);
     } else {
-      tensor_key.tensor = TensorShapeAndType{tensor.shape(), tensor.dtype()};
+      tensor_key.tensor = &ctx->input(i);
     }
 
     key.input_tensors.push_back(std::move(tensor_key));
@@ -226,4 +309,4 @@ DmlKernelKey DmlKernelWrapperBase::CreateKernelKey(OpKernelContext* ctx) const {
   return key;
 }
 
-}  // namespace tensorflow
\ No newline at end of file
+}  // namespace tensorflow
@@ -37,13 +37,16 @@ enum class DmlKernelCachePolicy {
 // wrapper forms the boundary between the DML kernel implementations and
 // tensorflow's kernel interfaces, and presents a simpler abstraction to the
 // wrapped DmlKernel than what is supplied in the full OpKernel.
-class DmlKernelWrapperBase : public OpKernel {
+class DmlKernelWrapperBase : public OpKernel, public DmlCacheableKernel {
  public:
   explicit DmlKernelWrapperBase(OpKernelConstruction* ctx,
                                 DmlKernelCachePolicy cache_policy);
 
   void Compute(OpKernelContext* ctx) override;
 
+  // DmlCacheableKernel
+  Status WarmKernelCache(OpKernelContext* ctx) override;
+
  protected:
   virtual const ShapeHelper* GetShapeHelper() const = 0;
   virtual std::shared_ptr<const InitializationHelper>
@@ -51,12 +54,13 @@ class DmlKernelWrapperBase : public OpKernel {
 
   virtual std::shared_ptr<DmlKernel> CreateCachedKernel(
       DmlKernelConstruction* ctx, const DmlKernelManager& kernel_manager,
-      const DmlKernelKey& key,
-      const InitializationHelper* initialized_helper) const = 0;
+      const DmlKernelKeyView& key,
+      const InitializationHelper* initialized_helper,
+      std::shared_ptr<const DmlCachedKernel>* entry) const = 0;
 
-  virtual std::shared_ptr<DmlKernel> TryGetCachedKernel(
+  virtual std::shared_ptr<const DmlCachedKernel> TryGetCacheEntry(
       const DmlKernelManager& kernel_manager,
-      const DmlKernelKey& key) const = 0;
+      const DmlKernelKeyView& key) const = 0;
 
   virtual std::shared_ptr<DmlKernel> CreateKernel(
       DmlKernelConstruction* ctx,
@@ -68,11 +72,38 @@ class DmlKernelWrapperBase : public OpKernel {
  protected:
   // Creates a key which uniquely identifies the kernel instance we need. The
   // returned key can be used to retrieve an appropriate DML kernel from the
-  // cache.
-  virtual DmlKernelKey CreateKernelKey(OpKernelContext* ctx) const;
+  // cache. The key borrows from `ctx` and this wrapper, so it must not outlive
+  // either.
+  virtual DmlKernelKeyView CreateKernelKey(OpKernelContext* ctx) const;
+
+  // Creates an empty key for this kernel, with the op type and attributes
+  // filled in but no input tensors.
+  DmlKernelKeyView CreateEmptyKernelKey() const;
 
   DmlKernelCachePolicy cache_policy_;
   std::shared_ptr<const NodeDef> node_def_;
+
+ private:
+  // Retrieves the kernel for `key` from the last-hit cache, or from the kernel
+  // manager on a miss. Returns null if the kernel hasn't been created yet.
+  std::shared_ptr<DmlKernel> GetCachedKernel(
+      const DmlKernelManager& kernel_manager,
+      const DmlKernelKeyView& key) const;
+
+  // Records `entry` as the most recent kernel executed by this wrapper.
+  void UpdateLastHit(std::shared_ptr<const DmlCachedKernel> entry) const;
+
+  // DmlKernelAttributesHash of node_def_, which never changes
+  uint64 attributes_hash_;
+
+  // The kernel manager's cache entry for this wrapper's most recent execution.
+  // Most ops see the same input shapes on every step, so checking this first
+  // lets them skip the kernel manager's shard lookup. The entry shares its key
+  // with the kernel manager, so recording a hit never copies the key. Hits
+  // here also touch the entry, so that kernels which are only ever found here
+  // still look recently used to the kernel manager.
+  mutable std::mutex last_hit_mutex_;
+  mutable std::shared_ptr<const DmlCachedKernel> last_hit_;
 };
 
 // Implements a (templated) GetOrCreateKernel and output shape computation for
@@ -107,8 +138,9 @@ class DmlKernelWrapper : public DmlKernelWrapperBase {
 
   std::shared_ptr<DmlKernel> CreateCachedKernel(
       DmlKernelConstruction* ctx, const DmlKernelManager& kernel_manager,
-      const DmlKernelKey& key,
-      const InitializationHelper* initialized_helper) const final {
+      const DmlKernelKeyView& key,
+      const InitializationHelper* initialized_helper,
+      std::shared_ptr<const DmlCachedKernel>* entry) const final {
     // If the cache policy is "Never", the kernel wrapper should simply create
     // the kernel directly instead of delegating to the kernel manager
     assert(cache_policy != DmlKernelCachePolicy::Never);
@@ -116,18 +148,19 @@ class DmlKernelWrapper : public DmlKernelWrapperBase {
     // Create the kernel and cache it
     return kernel_manager.CreateCachedKernel<TKernel>(
         ctx, key,
-        static_cast<const typename TKernel::InitHelper*>(initialized_helper));
+        static_cast<const typename TKernel::InitHelper*>(initialized_helper),
+        entry);
   }
 
-  std::shared_ptr<DmlKernel> TryGetCachedKernel(
+  std::shared_ptr<const DmlCachedKernel> TryGetCacheEntry(
       const DmlKernelManager& kernel_manager,
-      const DmlKernelKey& key) const final {
+      const DmlKernelKeyView& key) const final {
     // If the cache policy is "Never", the kernel wrapper should never try to
     // retrieved a cached kernel
     assert(cache_policy != DmlKernelCachePolicy::Never);
 
     // Retrieve the kernel from the cache
-    return kernel_manager.TryGetCachedKernel<TKernel>(key);
+    return kernel_manager.TryGetCacheEntry(key);
   }
 
   std::shared_ptr<DmlKernel> CreateKernel(
@@ -505,28 +505,24 @@ class DmlAdamKernelWrapper
       : DmlKernelWrapper<DmlApplyAdamKernel, ShapeHelper>(ctx) {}
 
  protected:
-  DmlKernelKey CreateKernelKey(OpKernelContext* ctx) const override {
-    DmlKernelKey key = {};
-    key.op_type_name = this->type_string();
-    key.node_def = DmlKernelWrapperBase::node_def_;
+  DmlKernelKeyView CreateKernelKey(OpKernelContext* ctx) const override {
+    DmlKernelKeyView key = DmlKernelWrapperBase::CreateEmptyKernelKey();
 
     using TensorIndices = DmlApplyAdamKernel::TensorIndices;
 
     // Add constant CPU input tensors. Note that this doesn't include
     // beta1_power/beta2_power, since those are handled dynamically by the
     // kernel.
-    key.input_tensors.push_back({ctx->input(TensorIndices::kLR), true});
-    key.input_tensors.push_back({ctx->input(TensorIndices::kBeta1), true});
-    key.input_tensors.push_back({ctx->input(TensorIndices::kBeta2), true});
-    key.input_tensors.push_back({ctx->input(TensorIndices::kEpsilon), true});
+    key.input_tensors.push_back({&ctx->input(TensorIndices::kLR), true});
+    key.input_tensors.push_back({&ctx->input(TensorIndices::kBeta1), true});
+    key.input_tensors.push_back({&ctx->input(TensorIndices::kBeta2), true});
+    key.input_tensors.push_back({&ctx->input(TensorIndices::kEpsilon), true});
 
     // For ApplyAdam/ResourceApplyAdam, the only non-constant tensor we need to
     // consider for the purposes of caching is the 'grad' tensor. This is
     // because we know the other tensors (var, m, and v) all must match the
     // shape and datatype of grad.
-    const Tensor& grad = ctx->input(TensorIndices::kGrad);
-    key.input_tensors.push_back(
-        {TensorShapeAndType{grad.shape(), grad.dtype()}, false});
+    key.input_tensors.push_back({&ctx->input(TensorIndices::kGrad), false});
 
     return key;
   }
@@ -57,10 +57,7 @@ Status InitializeFusedComputation(
   }
 
   // Depending on a picked fusion type validate fusion-specific arguments.
-  if (*fused_computation == FusedComputationType::kBiasAdd ||
-      *fused_computation == FusedComputationType::kBiasAddWithRelu ||
-      *fused_computation == FusedComputationType::kBiasAddWithRelu6 ||
-      *fused_computation == FusedComputationType::kBiasAddWithElu) {
+  if (BiasAddArgs<float>::IsSupported(*fused_computation)) {
     if (num_args != 1) {
       return errors::InvalidArgument(
           "Fused ", kernel_name,
@@ -68,10 +65,15 @@ Status InitializeFusedComputation(
     }
   }
 
-  if (*fused_computation == FusedComputationType::kFusedBatchNorm ||
-      *fused_computation == FusedComputationType::kFusedBatchNormWithRelu ||
-      *fused_computation == FusedComputationType::kFusedBatchNormWithRelu6 ||
-      *fused_computation == FusedComputationType::kFusedBatchNormWithElu) {
+  if (BiasAddWithMulArgs<float>::IsSupported(*fused_computation)) {
+    if (num_args != 2) {
+      return errors::InvalidArgument(
+          "Fused ", kernel_name,
+          " with BiasAdd and Mul must have two extra arguments: bias, scale.");
+    }
+  }
+
+  if (FusedBatchNormArgs<float>::IsSupported(*fused_computation)) {
     if (num_args != 4) {
       return errors::InvalidArgument(
           "Fused ", kernel_name,
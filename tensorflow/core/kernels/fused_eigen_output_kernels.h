@@ -19,7 +19,8 @@ limitations under the License.
 //
 // Supported fused computations:
 //   (1) {Conv2D/MatMul} + BiasAdd + <Activation>
-//   (2) {Conv2D/MatMul} + FusedBatchNorm + <Activation>
+//   (2) {Conv2D/MatMul} + BiasAdd + Mul(scalar) + <Activation>
+//   (3) {Conv2D/MatMul} + FusedBatchNorm + <Activation>
 //
 // Activation: Relu, Relu6, Elu, etc...
 
@@ -39,10 +40,20 @@ enum class FusedComputationType {
   kBiasAddWithRelu,
   kBiasAddWithRelu6,
   kBiasAddWithElu,
+  kBiasAddWithTanh,
+  kBiasAddWithSigmoid,
+  kBiasAddWithMul,
+  kBiasAddWithMulAndRelu,
+  kBiasAddWithMulAndRelu6,
+  kBiasAddWithMulAndElu,
+  kBiasAddWithMulAndTanh,
+  kBiasAddWithMulAndSigmoid,
   kFusedBatchNorm,
   kFusedBatchNormWithRelu,
   kFusedBatchNormWithRelu6,
-  kFusedBatchNormWithElu
+  kFusedBatchNormWithElu,
+  kFusedBatchNormWithTanh,
+  kFusedBatchNormWithSigmoid
 };
 
 // We have to pass around additional arguments for all possible fusion types.
@@ -111,6 +122,22 @@ struct Elu {
   };
 };
 
+// Applies `Tanh` to the passed input expression.
+struct Tanh {
+  template <typename XprType>
+  static auto apply(XprType expr) -> decltype(expr.tanh()) {
+    return expr.tanh();
+  };
+};
+
+// Applies `Sigmoid` to the passed input expression.
+struct Sigmoid {
+  template <typename XprType>
+  static auto apply(XprType expr) -> decltype(expr.sigmoid()) {
+    return expr.sigmoid();
+  };
+};
+
 template <typename T>
 struct BiasAddArgs {
   const T* bias_add_data = nullptr;
@@ -119,7 +146,24 @@ struct BiasAddArgs {
     return fusion == FusedComputationType::kBiasAdd ||
            fusion == FusedComputationType::kBiasAddWithRelu ||
            fusion == FusedComputationType::kBiasAddWithRelu6 ||
-           fusion == FusedComputationType::kBiasAddWithElu;
+           fusion == FusedComputationType::kBiasAddWithElu ||
+           fusion == FusedComputationType::kBiasAddWithTanh ||
+           fusion == FusedComputationType::kBiasAddWithSigmoid;
+  }
+};
+
+template <typename T>
+struct BiasAddWithMulArgs {
+  const T* bias_add_data = nullptr;
+  T scale = T(1);
+
+  static bool IsSupported(FusedComputationType fusion) {
+    return fusion == FusedComputationType::kBiasAddWithMul ||
+           fusion == FusedComputationType::kBiasAddWithMulAndRelu ||
+           fusion == FusedComputationType::kBiasAddWithMulAndRelu6 ||
+           fusion == FusedComputationType::kBiasAddWithMulAndElu ||
+           fusion == FusedComputationType::kBiasAddWithMulAndTanh ||
+           fusion == FusedComputationType::kBiasAddWithMulAndSigmoid;
   }
 };
 
@@ -138,7 +182,9 @@ struct FusedBatchNormArgs {
     return fusion == FusedComputationType::kFusedBatchNorm ||
            fusion == FusedComputationType::kFusedBatchNormWithRelu ||
            fusion == FusedComputationType::kFusedBatchNormWithRelu6 ||
-           fusion == FusedComputationType::kFusedBatchNormWithElu;
+           fusion == FusedComputationType::kFusedBatchNormWithElu ||
+           fusion == FusedComputationType::kFusedBatchNormWithTanh ||
+           fusion == FusedComputationType::kFusedBatchNormWithSigmoid;
   }
 };
 
@@ -203,6 +249,36 @@ struct BiasAddOutputKernel {
   const T* bias_data;
 };
 
+// Output kernel that fuses BiasAdd and multiplication by a scalar into the
+// output of tensor contraction + activation function defined by Activation.
+template <typename T, typename Activation = Identity>
+struct BiasAddWithMulOutputKernel {
+  explicit BiasAddWithMulOutputKernel(const BiasAddWithMulArgs<T>& args)
+      : bias_data(args.bias_add_data), scale(args.scale) {}
+
+  template <typename StorageIndex, typename Scalar>
+  EIGEN_ALWAYS_INLINE void operator()(
+      const ContractionOutputMapper<Scalar, StorageIndex>& output_mapper,
+      const Eigen::TensorContractionParams& params, StorageIndex i,
+      StorageIndex j, StorageIndex num_rows, StorageIndex num_cols) const {
+    DCHECK(params.swapped_arguments);
+
+    const T* bias_base = bias_data + i;
+    typename TTypes<T>::UnalignedConstTensor bias(bias_base, num_rows);
+
+    for (int col = 0; col < num_cols; ++col) {
+      T* output_base = &output_mapper(0, col);
+      typename TTypes<T>::UnalignedTensor output(output_base, num_rows);
+      const auto expr = (output + bias) * scale;
+      output = Activation::template apply<decltype(expr)>(expr);
+    }
+  }
+
+ private:
+  const T* bias_data;
+  T scale;
+};
+
 // Output kernel that fuses FusedBatchNorm operation into the output of tensor
 // contraction + activation function defined by Activation.
 template <typename T, typename Activation = Identity>
@@ -258,6 +334,22 @@ using WithBiasAddAndRelu6 = BiasAddOutputKernel<T, Relu6>;
 template <typename T>
 using WithBiasAddAndElu = BiasAddOutputKernel<T, Elu>;
 template <typename T>
+using WithBiasAddAndTanh = BiasAddOutputKernel<T, Tanh>;
+template <typename T>
+using WithBiasAddAndSigmoid = BiasAddOutputKernel<T, Sigmoid>;
+template <typename T>
+using WithBiasAddAndMul = BiasAddWithMulOutputKernel<T>;
+template <typename T>
+using WithBiasAddMulAndRelu = BiasAddWithMulOutputKernel<T, Relu>;
+template <typename T>
+using WithBiasAddMulAndRelu6 = BiasAddWithMulOutputKernel<T, Relu6>;
+template <typename T>
+using WithBiasAddMulAndElu = BiasAddWithMulOutputKernel<T, Elu>;
+template <typename T>
+using WithBiasAddMulAndTanh = BiasAddWithMulOutputKernel<T, Tanh>;
+template <typename T>
+using WithBiasAddMulAndSigmoid = BiasAddWithMulOutputKernel<T, Sigmoid>;
+template <typename T>
 using WithFusedBatchNorm = FusedBatchNormOutputKernel<T>;
 template <typename T>
 using WithFusedBatchNormAndRelu = FusedBatchNormOutputKernel<T, Relu>;
@@ -265,6 +357,10 @@ template <typename T>
 using WithFusedBatchNormAndRelu6 = FusedBatchNormOutputKernel<T, Relu6>;
 template <typename T>
 using WithFusedBatchNormAndElu = FusedBatchNormOutputKernel<T, Elu>;
+template <typename T>
+using WithFusedBatchNormAndTanh = FusedBatchNormOutputKernel<T, Tanh>;
+template <typename T>
+using WithFusedBatchNormAndSigmoid = FusedBatchNormOutputKernel<T, Sigmoid>;
 
 template <typename T>
 Status InitBiasAddArgs(OpKernelContext* context, BiasAddArgs<T>* args) {
@@ -284,6 +380,27 @@ Status InitBiasAddArgs(OpKernelContext* context, BiasAddArgs<T>* args) {
   return Status::OK();
 }
 
+template <typename T>
+Status InitBiasAddWithMulArgs(OpKernelContext* context,
+                              BiasAddWithMulArgs<T>* args) {
+  // Bias of the following dimensions: [ output_depth ]
+  const Tensor& bias = context->input(2);
+  // Scale is a scalar multiplied with the biased output.
+  const Tensor& scale = context->input(3);
+
+  if (bias.dims() != 1)
+    return errors::InvalidArgument("bias must be 1-dimensional",
+                                   bias.shape().DebugString());
+  if (scale.dims() != 0)
+    return errors::InvalidArgument("scale must be a scalar",
+                                   scale.shape().DebugString());
+
+  args->bias_add_data = reinterpret_cast<const T*>(bias.tensor_data().data());
+  args->scale = scale.scalar<T>()();
+
+  return Status::OK();
+}
+
 template <typename T>
 Status InitFusedBatchNormArgs(OpKernelContext* context, float epsilon,
                               FusedBatchNormArgs<T>* args) {
@@ -16,9 +16,10 @@ limitations under the License.
 // Implements matmul operations with other kernels baked into the
 // processing, to optimize latency and memory usage:
 //  - MatMul + BiasAdd + <Activation>
+//  - MatMul + BiasAdd + Mul(scalar) + <Activation>
 //  - MatMul + FusedBatchNorm + <Activation>
 //
-// Activation: Relu, Relu6, Elu, etc...
+// Activation: Relu, Relu6, Elu, Tanh, Sigmoid, etc...
 //
 // Currently supported only on CPU device.
 
@@ -75,6 +76,12 @@ struct LaunchFusedMatMulOp<CPUDevice, T> {
       OP_REQUIRES_OK(context, InitBiasAddArgs(context, &bias_add_args));
     }
 
+    BiasAddWithMulArgs<T> bias_add_with_mul_args;
+    if (BiasAddWithMulArgs<T>::IsSupported(fusion)) {
+      OP_REQUIRES_OK(context,
+                     InitBiasAddWithMulArgs(context, &bias_add_with_mul_args));
+    }
+
     switch (fusion) {
       case FusedComputationType::kBiasAdd:
         out.device(d) =
@@ -92,6 +99,38 @@ struct LaunchFusedMatMulOp<CPUDevice, T> {
         out.device(d) =
             lhs.contract(rhs, dim_pair, WithBiasAddAndElu<T>(bias_add_args));
         break;
+      case FusedComputationType::kBiasAddWithTanh:
+        out.device(d) =
+            lhs.contract(rhs, dim_pair, WithBiasAddAndTanh<T>(bias_add_args));
+        break;
+      case FusedComputationType::kBiasAddWithSigmoid:
+        out.device(d) = lhs.contract(rhs, dim_pair,
+                                     WithBiasAddAndSigmoid<T>(bias_add_args));
+        break;
+      case FusedComputationType::kBiasAddWithMul:
+        out.device(d) = lhs.contract(
+            rhs, dim_pair, WithBiasAddAndMul<T>(bias_add_with_mul_args));
+        break;
+      case FusedComputationType::kBiasAddWithMulAndRelu:
+        out.device(d) = lhs.contract(
+            rhs, dim_pair, WithBiasAddMulAndRelu<T>(bias_add_with_mul_args));
+        break;
+      case FusedComputationType::kBiasAddWithMulAndRelu6:
+        out.device(d) = lhs.contract(
+            rhs, dim_pair, WithBiasAddMulAndRelu6<T>(bias_add_with_mul_args));
+        break;
+      case FusedComputationType::kBiasAddWithMulAndElu:
+        out.device(d) = lhs.contract(
+            rhs, dim_pair, WithBiasAddMulAndElu<T>(bias_add_with_mul_args));
+        break;
+      case FusedComputationType::kBiasAddWithMulAndTanh:
+        out.device(d) = lhs.contract(
+            rhs, dim_pair, WithBiasAddMulAndTanh<T>(bias_add_with_mul_args));
+        break;
+      case FusedComputationType::kBiasAddWithMulAndSigmoid:
+        out.device(d) = lhs.contract(
+            rhs, dim_pair, WithBiasAddMulAndSigmoid<T>(bias_add_with_mul_args));
+        break;
       case FusedComputationType::kUndefined:
         OP_REQUIRES_OK(context, errors::Internal("Fusion type is undefined"));
         break;
@@ -116,7 +155,16 @@ class FusedMatMulOp : public OpKernel {
       patterns = {{FCT::kBiasAdd, {"BiasAdd"}},
                   {FCT::kBiasAddWithRelu, {"BiasAdd", "Relu"}},
                   {FCT::kBiasAddWithRelu6, {"BiasAdd", "Relu6"}},
-                  {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}}};
+                  {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}},
+                  {FCT::kBiasAddWithTanh, {"BiasAdd", "Tanh"}},
+                  {FCT::kBiasAddWithSigmoid, {"BiasAdd", "Sigmoid"}},
+                  {FCT::kBiasAddWithMul, {"BiasAdd", "Mul"}},
+                  {FCT::kBiasAddWithMulAndRelu, {"BiasAdd", "Mul", "Relu"}},
+                  {FCT::kBiasAddWithMulAndRelu6, {"BiasAdd", "Mul", "Relu6"}},
+                  {FCT::kBiasAddWithMulAndElu, {"BiasAdd", "Mul", "Elu"}},
+                  {FCT::kBiasAddWithMulAndTanh, {"BiasAdd", "Mul", "Tanh"}},
+                  {FCT::kBiasAddWithMulAndSigmoid,
+                   {"BiasAdd", "Mul", "Sigmoid"}}};
     }
 
     OP_REQUIRES_OK(context, InitializeFusedComputation(
@@ -17,6 +17,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/platform/test.h"
@@ -135,6 +136,10 @@ class FusedMatMulOpTest : public OpsTestBase {
       ops::Relu6(root.WithOpName("with_activation"), with_bias);
     } else if (activation_type == "Elu") {
       ops::Elu(root.WithOpName("with_activation"), with_bias);
+    } else if (activation_type == "Tanh") {
+      ops::Tanh(root.WithOpName("with_activation"), with_bias);
+    } else if (activation_type == "Sigmoid") {
+      ops::Sigmoid(root.WithOpName("with_activation"), with_bias);
     } else {
       ops::Identity(root.WithOpName("with_activation"), with_bias);
     }
@@ -142,6 +147,44 @@ class FusedMatMulOpTest : public OpsTestBase {
     RunAndFetch(root, "with_activation", output, allow_gpu_device);
   }
 
+  void RunMatMulWithBiasMulAndActivation(
+      const Tensor& lhs_data, const Tensor& rhs_data, const Tensor& bias_data,
+      const Tensor& scale_data, bool transpose_a, bool transpose_b,
+      const string& activation_type, Tensor* output,
+      bool allow_gpu_device = false) {
+    Scope root = tensorflow::Scope::NewRootScope();
+
+    ops::MatMul matmul = ops::MatMul(
+        root.WithOpName("matmul"),
+        ops::Const(root.WithOpName("lhs"), Input::Initializer(lhs_data)),
+        ops::Const(root.WithOpName("rhs"), Input::Initializer(rhs_data)),
+        ops::MatMul::Attrs().TransposeA(transpose_a).TransposeB(transpose_b));
+
+    ops::BiasAdd with_bias = ops::BiasAdd(
+        root.WithOpName("with_bias"), matmul,
+        ops::Const(root.WithOpName("bias"), Input::Initializer(bias_data)));
+
+    ops::Mul with_mul = ops::Mul(
+        root.WithOpName("with_mul"), with_bias,
+        ops::Const(root.WithOpName("scale"), Input::Initializer(scale_data)));
+
+    if (activation_type == "Relu") {
+      ops::Relu(root.WithOpName("with_activation"), with_mul);
+    } else if (activation_type == "Relu6") {
+      ops::Relu6(root.WithOpName("with_activation"), with_mul);
+    } else if (activation_type == "Elu") {
+      ops::Elu(root.WithOpName("with_activation"), with_mul);
+    } else if (activation_type == "Tanh") {
+      ops::Tanh(root.WithOpName("with_activation"), with_mul);
+    } else if (activation_type == "Sigmoid") {
+      ops::Sigmoid(root.WithOpName("with_activation"), with_mul);
+    } else {
+      ops::Identity(root.WithOpName("with_activation"), with_mul);
+    }
+
+    RunAndFetch(root, "with_activation", output, allow_gpu_device);
+  }
+
   void RunFusedMatMulOp(const Tensor& lhs_data, const Tensor& rhs_data,
                         const std::vector<Tensor>& args_data,
                         const std::vector<string>& fused_ops, bool transpose_a,
@@ -255,6 +298,37 @@ class FusedMatMulOpTest : public OpsTestBase {
 
     VerifyBiasAddTensorsNear(m, k, n, run_default, run_fused);
   }
+
+  // Verifies that computing MatMul+BiasAdd+Mul+{Activation} in a graph, with a
+  // scalar constant Mul operand, is identical to FusedMatMul.
+  void VerifyMatMulWithBiasMulAndActivation(int m, int k, int n,
+                                            bool transpose_a, bool transpose_b,
+                                            const string& activation) {
+    Tensor scale(DataTypeToEnum<T>::v(), TensorShape({}));
+    scale.scalar<T>()() = static_cast<T>(1.5f);
+
+    std::vector<string> fused_ops = {"BiasAdd", "Mul"};
+    if (activation != "Identity") fused_ops.push_back(activation);
+
+    const BiasAddGraphRunner run_default = [&](const Tensor& input_data,
+                                               const Tensor& filter_data,
+                                               const Tensor& bias_data,
+                                               Tensor* out) {
+      RunMatMulWithBiasMulAndActivation(input_data, filter_data, bias_data,
+                                        scale, transpose_a, transpose_b,
+                                        activation, out);
+    };
+
+    const BiasAddGraphRunner run_fused = [&](const Tensor& input_data,
+                                             const Tensor& filter_data,
+                                             const Tensor& bias_data,
+                                             Tensor* out) {
+      RunFusedMatMulOp(input_data, filter_data, {bias_data, scale}, fused_ops,
+                       transpose_a, transpose_b, out);
+    };
+
+    VerifyBiasAddTensorsNear(m, k, n, run_default, run_fused);
+  }
 };
 
 // MatMul with BatchNorm can be tested only with `T=float`, because default
@@ -289,7 +363,8 @@ TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x1) {
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x256WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
     this->VerifyConv2DWithBiasAndActivation(256, 256, 256, false, false,
                                             activation);
     this->VerifyConv2DWithBiasAndActivation(256, 256, 256, true, false,
@@ -302,26 +377,51 @@ TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x256WithActivation) {
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x256WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
     this->VerifyConv2DWithBiasAndActivation(1, 256, 256, false, false,
                                             activation);
   }
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x1WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
     this->VerifyConv2DWithBiasAndActivation(256, 256, 1, false, false,
                                             activation);
   }
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x1WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
     this->VerifyConv2DWithBiasAndActivation(1, 256, 1, false, false,
                                             activation);
   }
 }
 
+// -------------------------------------------------------------------------- //
+// MatMul + BiasAdd + Mul + {Activation}                                      //
+// -------------------------------------------------------------------------- //
+
+TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x256WithMul) {
+  for (const string& activation :
+       {"Identity", "Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
+    this->VerifyMatMulWithBiasMulAndActivation(256, 256, 256, false, false,
+                                               activation);
+    this->VerifyMatMulWithBiasMulAndActivation(256, 256, 256, true, true,
+                                               activation);
+  }
+}
+
+TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x256WithMul) {
+  for (const string& activation :
+       {"Identity", "Relu", "Relu6", "Elu", "Tanh", "Sigmoid"}) {
+    this->VerifyMatMulWithBiasMulAndActivation(1, 256, 256, false, false,
+                                               activation);
+  }
+}
+
 REGISTER_TYPED_TEST_SUITE_P(FusedMatMulWithBiasOpTest,        //
                             MatMul256x256x256,                //
                             MatMul1x256x256,                  //
@@ -330,7 +430,9 @@ REGISTER_TYPED_TEST_SUITE_P(FusedMatMulWithBiasOpTest,        //
                             MatMul256x256x256WithActivation,  //
                             MatMul1x256x256WithActivation,    //
                             MatMul256x256x1WithActivation,    //
-                            MatMul1x256x1WithActivation);
+                            MatMul1x256x1WithActivation,      //
+                            MatMul256x256x256WithMul,         //
+                            MatMul1x256x256WithMul);
 
 // TODO(ezhulenev): Add support for more data types.
 using FusedBiasAddDataTypes = ::testing::Types<float>;
@@ -363,6 +465,90 @@ static Graph* Matmul(int m, int k, int n, bool transpose_a, bool transpose_b,
   }                                                                            \
   BENCHMARK(BM_Matmul##_##M##_##K##_##N##_##TA##_##TB##_##TFTYPE##_##DEVICE);
 
+// Creates a graph with a MatMul followed by a BiasAdd, a Mul by a scalar if
+// `with_mul` is true, and an activation, or with a single _FusedMatMul
+// computing the same if `fused` is true.
+template <typename T>
+static Graph* MatmulWithBiasAndActivation(int m, int k, int n,
+                                          const string& activation,
+                                          bool with_mul, bool fused) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const DataType type = DataTypeToEnum<T>::value;
+  Tensor in0(type, TensorShape({m, k}));
+  in0.flat<T>().setRandom();
+  Tensor in1(type, TensorShape({k, n}));
+  in1.flat<T>().setRandom();
+  Tensor bias_t(type, TensorShape({n}));
+  bias_t.flat<T>().setRandom();
+  Tensor scale_t(type, TensorShape({}));
+  scale_t.scalar<T>()() = static_cast<T>(0.5f);
+
+  Node* lhs = test::graph::Constant(g, in0);
+  Node* rhs = test::graph::Constant(g, in1);
+  Node* bias = test::graph::Constant(g, bias_t);
+  Node* scale = test::graph::Constant(g, scale_t);
+
+  if (fused) {
+    std::vector<NodeBuilder::NodeOut> args = {bias};
+    std::vector<string> fused_ops = {"BiasAdd"};
+    if (with_mul) {
+      args.emplace_back(scale);
+      fused_ops.push_back("Mul");
+    }
+    fused_ops.push_back(activation);
+    TF_CHECK_OK(NodeBuilder(g->NewName("fused_matmul"), "_FusedMatMul")
+                    .Input(lhs)
+                    .Input(rhs)
+                    .Input(args)
+                    .Attr("num_args", static_cast<int>(args.size()))
+                    .Attr("T", type)
+                    .Attr("fused_ops", fused_ops)
+                    .Finalize(g, nullptr));
+    return g;
+  }
+
+  Node* matmul = test::graph::Matmul(g, lhs, rhs, false, false);
+  Node* bias_add;
+  TF_CHECK_OK(NodeBuilder(g->NewName("bias_add"), "BiasAdd")
+                  .Input(matmul)
+                  .Input(bias)
+                  .Attr("T", type)
+                  .Finalize(g, &bias_add));
+  Node* epilogue_input = bias_add;
+  if (with_mul) {
+    epilogue_input = test::graph::Binary(g, "Mul", bias_add, scale);
+  }
+  TF_CHECK_OK(NodeBuilder(g->NewName("activation"), activation)
+                  .Input(epilogue_input)
+                  .Attr("T", type)
+                  .Finalize(g, nullptr));
+  return g;
+}
+
+#define BM_MatmulWithBiasAndActivationImpl(M, K, N, ACT, MUL, NAME)            \
+  static void BM_Matmul##NAME##ACT##_##M##_##K##_##N(int iters) {              \
+    testing::UseRealTime();                                                    \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2);        \
+    test::Benchmark("cpu", MatmulWithBiasAndActivation<float>(M, K, N, #ACT,   \
+                                                              MUL, false))     \
+        .Run(iters);                                                           \
+  }                                                                            \
+  BENCHMARK(BM_Matmul##NAME##ACT##_##M##_##K##_##N);                           \
+  static void BM_FusedMatmul##NAME##ACT##_##M##_##K##_##N(int iters) {         \
+    testing::UseRealTime();                                                    \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2);        \
+    test::Benchmark("cpu", MatmulWithBiasAndActivation<float>(M, K, N, #ACT,   \
+                                                              MUL, true))      \
+        .Run(iters);                                                           \
+  }                                                                            \
+  BENCHMARK(BM_FusedMatmul##NAME##ACT##_##M##_##K##_##N);
+
+#define BM_MatmulWithBiasAndActivation(M, K, N, ACT) \
+  BM_MatmulWithBiasAndActivationImpl(M, K, N, ACT, false, WithBiasAnd)
+
+#define BM_MatmulWithBiasMulAndActivation(M, K, N, ACT) \
+  BM_MatmulWithBiasAndActivationImpl(M, K, N, ACT, true, WithBiasMulAnd)
+
 #ifdef GOOGLE_CUDA
 
 #define BM_Matmul(M, K, N, TA, TB)                                       \
@@ -458,4 +644,14 @@ BM_Matmul(2000, 1, 2000, true, false);
 BM_Matmul(2000, 1, 2000, false, true);
 BM_Matmul(2000, 1, 2000, true, true);
 
+// Fully connected layers with an elementwise epilogue, unfused and fused.
+BM_MatmulWithBiasAndActivation(8, 1024, 1024, Relu);
+BM_MatmulWithBiasAndActivation(128, 1024, 1024, Relu);
+BM_MatmulWithBiasAndActivation(8, 1024, 1024, Tanh);
+BM_MatmulWithBiasAndActivation(128, 1024, 1024, Tanh);
+BM_MatmulWithBiasAndActivation(8, 1024, 1024, Sigmoid);
+BM_MatmulWithBiasAndActivation(128, 1024, 1024, Sigmoid);
+BM_MatmulWithBiasMulAndActivation(8, 1024, 1024, Relu6);
+BM_MatmulWithBiasMulAndActivation(128, 1024, 1024, Relu6);
+
 }  // end namespace tensorflow
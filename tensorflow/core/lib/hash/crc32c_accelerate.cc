@@ -15,8 +15,10 @@ limitations under the License.
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
-// SSE4.2 accelerated CRC32c.
+// Hardware accelerated CRC32c, used when the CPU supports it: the SSE4.2
+// crc32 instruction on x86-64, or the CRC32 extension on ARMv8.
 
 // See if the SSE4.2 crc32c instruction is available.
 #undef USE_SSE_CRC32C
@@ -31,6 +33,18 @@ limitations under the License.
 #endif
 #endif /* __SSE4_2__ */
 
+// MSVC provides the intrinsics regardless of the target architecture.
+#if defined(_MSC_VER) && defined(_M_X64) && !defined(__clang__)
+#define USE_SSE_CRC32C 1
+#endif
+
+// See if the ARMv8 crc32c instructions are available.
+#undef USE_ARM_CRC32C
+#if defined(__aarch64__) && defined(__linux__) && \
+    defined(__ARM_FEATURE_CRC32)
+#define USE_ARM_CRC32C 1
+#endif
+
 // This version of Apple clang has a bug:
 // https://llvm.org/bugs/show_bug.cgi?id=25510
 #if defined(__APPLE__) && (__clang_major__ <= 8)
@@ -38,13 +52,22 @@ limitations under the License.
 #endif
 
 #ifdef USE_SSE_CRC32C
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 #include <nmmintrin.h>
 #endif
 
+#ifdef USE_ARM_CRC32C
+#include <arm_acle.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
 namespace tensorflow {
 namespace crc32c {
 
-#ifndef USE_SSE_CRC32C
+#if !defined(USE_SSE_CRC32C) && !defined(USE_ARM_CRC32C)
 
 bool CanAccelerate() { return false; }
 uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
@@ -54,39 +77,149 @@ uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
 
 #else
 
-// SSE4.2 optimized crc32c computation.
-bool CanAccelerate() { return __builtin_cpu_supports("sse4.2"); }
+namespace {
+
+#ifdef USE_SSE_CRC32C
+inline uint32_t Crc8(uint32_t crc, uint8_t v) { return _mm_crc32_u8(crc, v); }
+inline uint64_t Crc64(uint64_t crc, uint64_t v) {
+  return _mm_crc32_u64(crc, v);
+}
+#else
+inline uint32_t Crc8(uint32_t crc, uint8_t v) { return __crc32cb(crc, v); }
+inline uint64_t Crc64(uint64_t crc, uint64_t v) { return __crc32cd(crc, v); }
+#endif
+
+inline uint64_t Crc64At(uint64_t crc, const uint8_t *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return Crc64(crc, v);
+}
+
+// The crc32 instruction has a latency of several cycles but a throughput of
+// one per cycle, so large buffers are processed as three interleaved
+// streams whose crcs are then combined. Combining crcs means appending a
+// block's worth of zero bits to one of them, which is a linear operator
+// over GF(2); ShiftTables holds that operator for one block length, split
+// into one lookup table per byte of the crc.
+constexpr size_t kLongBlock = 8192;
+constexpr size_t kShortBlock = 256;
+
+// The reflected CRC32c polynomial.
+constexpr uint32_t kPolynomial = 0x82f63b78;
+
+// Multiplies a 32x32 bit matrix over GF(2) with a vector.
+uint32_t MatrixTimes(const uint32_t *matrix, uint32_t vec) {
+  uint32_t sum = 0;
+  for (; vec != 0; vec >>= 1, ++matrix) {
+    if (vec & 1) sum ^= *matrix;
+  }
+  return sum;
+}
+
+void MatrixSquare(uint32_t *square, const uint32_t *matrix) {
+  for (int n = 0; n < 32; n++) {
+    square[n] = MatrixTimes(matrix, matrix[n]);
+  }
+}
+
+struct ShiftTables {
+  uint32_t table[4][256];
+
+  // Builds the operator that appends `len` zero bytes, where `len` is a
+  // power of two, by repeated squaring of the one that appends a zero bit.
+  explicit ShiftTables(size_t len) {
+    uint32_t odd[32];
+    uint32_t even[32];
+    odd[0] = kPolynomial;
+    for (int n = 1; n < 32; n++) {
+      odd[n] = 1u << (n - 1);
+    }
+    MatrixSquare(even, odd);  // 2 zero bits.
+    MatrixSquare(odd, even);  // 4 zero bits.
+    uint32_t *op = odd;
+    do {
+      MatrixSquare(op == odd ? even : odd, op);
+      op = op == odd ? even : odd;
+      len >>= 1;
+    } while (len != 0);
+    for (uint32_t n = 0; n < 256; n++) {
+      table[0][n] = MatrixTimes(op, n);
+      table[1][n] = MatrixTimes(op, n << 8);
+      table[2][n] = MatrixTimes(op, n << 16);
+      table[3][n] = MatrixTimes(op, n << 24);
+    }
+  }
+
+  uint32_t Shift(uint32_t crc) const {
+    return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^
+           table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+  }
+};
+
+// Processes as many blocks of 3 * `block` bytes as fit in [*p, e).
+inline uint64_t ExtendBlocks(uint64_t crc0, size_t block,
+                             const ShiftTables &shift, const uint8_t **p,
+                             const uint8_t *e) {
+  while (static_cast<size_t>(e - *p) >= 3 * block) {
+    uint64_t crc1 = 0;
+    uint64_t crc2 = 0;
+    const uint8_t *a = *p;
+    const uint8_t *end = a + block;
+    do {
+      crc0 = Crc64At(crc0, a);
+      crc1 = Crc64At(crc1, a + block);
+      crc2 = Crc64At(crc2, a + 2 * block);
+      a += 8;
+    } while (a < end);
+    crc0 = shift.Shift(static_cast<uint32_t>(crc0)) ^ crc1;
+    crc0 = shift.Shift(static_cast<uint32_t>(crc0)) ^ crc2;
+    *p += 3 * block;
+  }
+  return crc0;
+}
+
+}  // namespace
+
+#ifdef USE_SSE_CRC32C
+bool CanAccelerate() {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 1);
+  return (info[2] & (1 << 20)) != 0;
+#else
+  return __builtin_cpu_supports("sse4.2");
+#endif
+}
+#else
+bool CanAccelerate() { return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0; }
+#endif
 
 uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
+  static const ShiftTables *long_shift = new ShiftTables(kLongBlock);
+  static const ShiftTables *short_shift = new ShiftTables(kShortBlock);
+
   const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
   const uint8_t *e = p + size;
   uint32_t l = crc ^ 0xffffffffu;
 
-  // Advance p until aligned to 8-bytes..
-  // Point x at first 7-byte aligned byte in string.  This might be
-  // just past the end of the string.
-  const uintptr_t pval = reinterpret_cast<uintptr_t>(p);
-  const uint8_t *x = reinterpret_cast<const uint8_t *>(((pval + 7) >> 3) << 3);
-  if (x <= e) {
-    // Process bytes until finished or p is 8-byte aligned
-    while (p != x) {
-      l = _mm_crc32_u8(l, *p);
-      p++;
-    }
+  // Process bytes until finished or p is 8-byte aligned.
+  while (p != e && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+    l = Crc8(l, *p);
+    p++;
   }
 
-  // Process bytes 16 at a time
   uint64_t l64 = l;
-  while ((e - p) >= 16) {
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p));
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p + 8));
-    p += 16;
-  }
+  l64 = ExtendBlocks(l64, kLongBlock, *long_shift, &p, e);
+  l64 = ExtendBlocks(l64, kShortBlock, *short_shift, &p, e);
 
-  // Process remaining bytes one at a time.
-  l = l64;
+  // Process the remaining bytes 8 at a time, then one at a time.
+  while ((e - p) >= 8) {
+    l64 = Crc64At(l64, p);
+    p += 8;
+  }
+  l = static_cast<uint32_t>(l64);
   while (p < e) {
-    l = _mm_crc32_u8(l, *p);
+    l = Crc8(l, *p);
     p++;
   }
 
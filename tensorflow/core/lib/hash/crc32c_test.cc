@@ -56,6 +56,40 @@ TEST(CRC, StandardResults) {
             Value(reinterpret_cast<char*>(data) + 1, sizeof(data) - 4));
 }
 
+// Bit-at-a-time reference implementation.
+uint32 ReferenceValue(const char* data, size_t n) {
+  uint32 crc = 0xffffffffu;
+  for (size_t i = 0; i < n; i++) {
+    crc ^= static_cast<uint8>(data[i]);
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0x82f63b78u & (0u - (crc & 1)));
+    }
+  }
+  return crc ^ 0xffffffffu;
+}
+
+TEST(CRC, MatchesReference) {
+  // Covers the lengths at which the accelerated code switches between
+  // interleaved blocks of 3 * 8192 and 3 * 256 bytes, and single bytes.
+  std::string input(3 * 3 * 8192 + 100, '\0');
+  uint32 state = 301;
+  for (char& c : input) {
+    state = state * 1103515245 + 12345;
+    c = static_cast<char>(state >> 16);
+  }
+  for (size_t n : {0, 1, 7, 8, 9, 15, 16, 17, 767, 768, 769, 1000, 24575,
+                   24576, 24577, 3 * 8192 + 768, 50000, 3 * 3 * 8192 + 92}) {
+    for (size_t offset = 0; offset < 8; offset++) {
+      ASSERT_EQ(ReferenceValue(input.data() + offset, n),
+                Value(input.data() + offset, n))
+          << "n=" << n << " offset=" << offset;
+    }
+  }
+  ASSERT_EQ(Value(input.data(), input.size()),
+            Extend(Value(input.data(), 30000), input.data() + 30000,
+                   input.size() - 30000));
+}
+
 TEST(CRC, Values) { ASSERT_NE(Value("a", 1), Value("foo", 3)); }
 
 TEST(CRC, Extend) {
@@ -90,7 +124,7 @@ static void BM_CRC(int iters, int len) {
   testing::BytesProcessed(static_cast<int64>(iters) * len);
   VLOG(1) << h;
 }
-BENCHMARK(BM_CRC)->Range(1, 256 * 1024);
+BENCHMARK(BM_CRC)->Range(1, 16 * 1024 * 1024);
 
 }  // namespace crc32c
 }  // namespace tensorflow
@@ -17,8 +17,13 @@ limitations under the License.
 
 #include <limits.h>
 
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/compression.h"
@@ -81,10 +86,13 @@ RecordReader::RecordReader(RandomAccessFile* file,
 
 // Read n+4 bytes from file, verify that checksum of first n bytes is
 // stored in the last 4 bytes and store the first n bytes in *result.
+// If masked_crc is non-null, the checksum is stored there instead of
+// being verified.
 //
 // offset corresponds to the user-provided value to ReadRecord()
 // and is used only in error messages.
-Status RecordReader::ReadChecksummed(uint64 offset, size_t n, string* result) {
+Status RecordReader::ReadChecksummed(uint64 offset, size_t n, string* result,
+                                     uint32* masked_crc) {
   if (n >= SIZE_MAX - sizeof(uint32)) {
     return errors::DataLoss("record size too large");
   }
@@ -100,8 +108,10 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n, string* result) {
     }
   }
 
-  const uint32 masked_crc = core::DecodeFixed32(result->data() + n);
-  if (crc32c::Unmask(masked_crc) != crc32c::Value(result->data(), n)) {
+  const uint32 stored_crc = core::DecodeFixed32(result->data() + n);
+  if (masked_crc != nullptr) {
+    *masked_crc = stored_crc;
+  } else if (crc32c::Unmask(stored_crc) != crc32c::Value(result->data(), n)) {
     return errors::DataLoss("corrupted record at ", offset);
   }
   result->resize(n);
@@ -128,7 +138,7 @@ Status RecordReader::GetMetadata(Metadata* md) {
     string record;
     while (true) {
       // Read header, containing size of data.
-      Status s = ReadChecksummed(offset, sizeof(uint64), &record);
+      Status s = ReadChecksummed(offset, sizeof(uint64), &record, nullptr);
       if (!s.ok()) {
         if (errors::IsOutOfRange(s)) {
           // We should reach out of range when the record file is complete.
@@ -162,6 +172,26 @@ Status RecordReader::GetMetadata(Metadata* md) {
 }
 
 Status RecordReader::ReadRecord(uint64* offset, string* record) {
+  bool verify = true;
+  if (options_.checksum_mode == RecordReaderOptions::VERIFY_SAMPLED) {
+    verify = num_records_read_ %
+                 std::max<int64>(options_.checksum_sample_interval, 1) ==
+             0;
+  }
+  uint32 masked_crc;
+  TF_RETURN_IF_ERROR(
+      ReadRecordInternal(offset, record, verify ? nullptr : &masked_crc));
+  ++num_records_read_;
+  return Status::OK();
+}
+
+Status RecordReader::ReadRecordUnverified(uint64* offset, string* record,
+                                          uint32* masked_crc) {
+  return ReadRecordInternal(offset, record, masked_crc);
+}
+
+Status RecordReader::ReadRecordInternal(uint64* offset, string* record,
+                                        uint32* masked_crc) {
   // Position the input stream.
   int64 curr_pos = input_stream_->Tell();
   int64 desired_pos = static_cast<int64>(*offset);
@@ -176,7 +206,7 @@ Status RecordReader::ReadRecord(uint64* offset, string* record) {
   DCHECK_EQ(desired_pos, input_stream_->Tell());
 
   // Read header data.
-  Status s = ReadChecksummed(*offset, sizeof(uint64), record);
+  Status s = ReadChecksummed(*offset, sizeof(uint64), record, nullptr);
   if (!s.ok()) {
     last_read_failed_ = true;
     return s;
@@ -184,7 +214,7 @@ Status RecordReader::ReadRecord(uint64* offset, string* record) {
   const uint64 length = core::DecodeFixed64(record->data());
 
   // Read data
-  s = ReadChecksummed(*offset + kHeaderSize, length, record);
+  s = ReadChecksummed(*offset + kHeaderSize, length, record, masked_crc);
   if (!s.ok()) {
     last_read_failed_ = true;
     if (errors::IsOutOfRange(s)) {
@@ -198,9 +228,157 @@ Status RecordReader::ReadRecord(uint64* offset, string* record) {
   return Status::OK();
 }
 
+struct SequentialRecordReader::Batch {
+  ~Batch() {
+    if (pending != nullptr) {
+      pending->Wait();
+    }
+  }
+
+  std::vector<string> records;
+  std::vector<uint32> masked_crcs;
+  // The offset of each record, followed by the offset after the last one.
+  std::vector<uint64> offsets;
+  // The error that ended the batch early, e.g. OUT_OF_RANGE at the end of
+  // the file, to return after its records.
+  Status status;
+  // Index of the next record to return.
+  size_t next = 0;
+
+  // Set by verification, which is done once `pending` reaches zero.
+  std::unique_ptr<char[]> corrupted;
+  std::unique_ptr<BlockingCounter> pending;
+};
+
 SequentialRecordReader::SequentialRecordReader(
     RandomAccessFile* file, const RecordReaderOptions& options)
-    : underlying_(file, options), offset_(0) {}
+    : underlying_(file, options),
+      offset_(0),
+      batched_(options.checksum_mode == RecordReaderOptions::VERIFY_BATCHED),
+      batch_size_(std::max<int64>(options.checksum_batch_size, 1)),
+      thread_pool_(options.checksum_thread_pool) {}
+
+SequentialRecordReader::~SequentialRecordReader() = default;
+
+Status SequentialRecordReader::ReadBatchedRecord(string* record) {
+  if (batch_ == nullptr ||
+      (batch_->next == batch_->records.size() && batch_->status.ok())) {
+    // Move on to the next batch, and start on the one after it.
+    batch_ = next_batch_ != nullptr ? std::move(next_batch_) : ReadBatch();
+    if (batch_->status.ok()) {
+      next_batch_ = ReadBatch();
+    }
+  }
+
+  Batch* batch = batch_.get();
+  if (batch->next == batch->records.size()) {
+    // Reading resumes where it failed on the next call, like in the other
+    // modes.
+    Status s = batch->status;
+    ResetBatches();
+    return s;
+  }
+  if (batch->pending != nullptr) {
+    batch->pending->Wait();
+  }
+  const size_t i = batch->next++;
+  if (batch->corrupted[i]) {
+    Status s = errors::DataLoss("corrupted record at ", batch->offsets[i]);
+    ResetBatches();
+    return s;
+  }
+  record->swap(batch->records[i]);
+  offset_ = batch->offsets[i + 1];
+  return Status::OK();
+}
+
+std::unique_ptr<SequentialRecordReader::Batch>
+SequentialRecordReader::ReadBatch() {
+  std::unique_ptr<Batch> batch(new Batch);
+  batch->offsets.push_back(read_offset_);
+  while (batch->records.size() < static_cast<size_t>(batch_size_)) {
+    string record;
+    uint32 masked_crc;
+    Status s =
+        underlying_.ReadRecordUnverified(&read_offset_, &record, &masked_crc);
+    if (!s.ok()) {
+      batch->status = s;
+      break;
+    }
+    batch->records.push_back(std::move(record));
+    batch->masked_crcs.push_back(masked_crc);
+    batch->offsets.push_back(read_offset_);
+  }
+
+  const size_t num_records = batch->records.size();
+  batch->corrupted.reset(new char[num_records]);
+  Batch* b = batch.get();
+  auto verify = [b](size_t start, size_t limit) {
+    for (size_t i = start; i < limit; ++i) {
+      const string& record = b->records[i];
+      b->corrupted[i] = crc32c::Unmask(b->masked_crcs[i]) !=
+                        crc32c::Value(record.data(), record.size());
+    }
+  };
+  const size_t num_shards =
+      thread_pool_ == nullptr
+          ? 0
+          : std::min<size_t>(thread_pool_->NumThreads(), num_records);
+  if (num_shards == 0) {
+    verify(0, num_records);
+    return batch;
+  }
+  batch->pending.reset(new BlockingCounter(num_shards));
+  for (size_t shard = 0; shard < num_shards; ++shard) {
+    const size_t start = num_records * shard / num_shards;
+    const size_t limit = num_records * (shard + 1) / num_shards;
+    thread_pool_->Schedule([b, verify, start, limit]() {
+      verify(start, limit);
+      b->pending->DecrementCount();
+    });
+  }
+  return batch;
+}
+
+void SequentialRecordReader::ResetBatches() {
+  batch_.reset();
+  next_batch_.reset();
+  read_offset_ = offset_;
+}
+
+Status RecordBufferReader::ReadRecord(StringPiece* record) {
+  const uint64 remaining = buffer_.size() - offset_;
+  if (remaining == 0) {
+    return errors::OutOfRange("eof");
+  }
+  if (remaining < RecordReader::kHeaderSize + RecordReader::kFooterSize) {
+    return errors::DataLoss("truncated record at ", offset_);
+  }
+
+  // Check the header.
+  const char* header = buffer_.data() + offset_;
+  const uint32 masked_length_crc = core::DecodeFixed32(header + sizeof(uint64));
+  if (crc32c::Unmask(masked_length_crc) !=
+      crc32c::Value(header, sizeof(uint64))) {
+    return errors::DataLoss("corrupted record at ", offset_);
+  }
+  const uint64 length = core::DecodeFixed64(header);
+  if (length >
+      remaining - RecordReader::kHeaderSize - RecordReader::kFooterSize) {
+    return errors::DataLoss("truncated record at ", offset_);
+  }
+
+  // Check the data.
+  const char* data = header + RecordReader::kHeaderSize;
+  const uint32 masked_data_crc = core::DecodeFixed32(data + length);
+  if (crc32c::Unmask(masked_data_crc) != crc32c::Value(data, length)) {
+    return errors::DataLoss("corrupted record at ", offset_);
+  }
+
+  *record = StringPiece(data, length);
+  offset_ += RecordReader::kHeaderSize + length + RecordReader::kFooterSize;
+  return Status::OK();
+}
 
 }  // namespace io
 }  // namespace tensorflow
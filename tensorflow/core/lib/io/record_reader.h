@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_LIB_IO_RECORD_READER_H_
 #define TENSORFLOW_CORE_LIB_IO_RECORD_READER_H_
 
+#include <memory>
+
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/io/inputstream_interface.h"
@@ -30,6 +32,10 @@ namespace tensorflow {
 
 class RandomAccessFile;
 
+namespace thread {
+class ThreadPool;
+}  // namespace thread
+
 namespace io {
 
 class RecordReaderOptions {
@@ -42,6 +48,29 @@ class RecordReaderOptions {
   // compressed files.) Consider using SequentialRecordReader.
   int64 buffer_size = 0;
 
+  // How the checksum of each record's data is verified. Record headers are
+  // always verified, since the length they hold is needed to find the next
+  // record.
+  enum ChecksumMode {
+    // Every record is verified before it is returned.
+    VERIFY_ALL = 0,
+    // Only one in every `checksum_sample_interval` records is verified.
+    // Corruption in the other records goes undetected.
+    VERIFY_SAMPLED = 1,
+    // SequentialRecordReader reads records ahead in batches of
+    // `checksum_batch_size`, and verifies each batch on
+    // `checksum_thread_pool` while the previous one is being returned. A
+    // corrupted record is still reported when it is reached. Other readers
+    // verify every record.
+    VERIFY_BATCHED = 2,
+  };
+  ChecksumMode checksum_mode = VERIFY_ALL;
+  int64 checksum_sample_interval = 100;
+  int64 checksum_batch_size = 256;
+  // Not owned, and must outlive the reader. If null, batches are verified
+  // on the reading thread.
+  thread::ThreadPool* checksum_thread_pool = nullptr;
+
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
@@ -91,6 +120,11 @@ class RecordReader {
   // OUT_OF_RANGE for end of file, or something else for an error.
   Status ReadRecord(uint64* offset, string* record);
 
+  // Like ReadRecord(), but doesn't verify the checksum of the record's data,
+  // and sets *masked_crc to the checksum stored for it instead.
+  Status ReadRecordUnverified(uint64* offset, string* record,
+                              uint32* masked_crc);
+
   // Return the metadata of the Record file.
   //
   // The current implementation scans the file to completion,
@@ -103,11 +137,16 @@ class RecordReader {
   Status GetMetadata(Metadata* md);
 
  private:
-  Status ReadChecksummed(uint64 offset, size_t n, string* result);
+  Status ReadRecordInternal(uint64* offset, string* record,
+                            uint32* masked_crc);
+  Status ReadChecksummed(uint64 offset, size_t n, string* result,
+                         uint32* masked_crc);
 
   RecordReaderOptions options_;
   std::unique_ptr<InputStreamInterface> input_stream_;
   bool last_read_failed_;
+  // Number of records read, for VERIFY_SAMPLED.
+  int64 num_records_read_ = 0;
 
   std::unique_ptr<Metadata> cached_metadata_;
 
@@ -125,11 +164,14 @@ class SequentialRecordReader {
       RandomAccessFile* file,
       const RecordReaderOptions& options = RecordReaderOptions());
 
-  virtual ~SequentialRecordReader() = default;
+  virtual ~SequentialRecordReader();
 
   // Reads the next record in the file into *record. Returns OK on success,
   // OUT_OF_RANGE for end of file, or something else for an error.
   Status ReadRecord(string* record) {
+    if (batched_) {
+      return ReadBatchedRecord(record);
+    }
     return underlying_.ReadRecord(&offset_, record);
   }
 
@@ -144,12 +186,70 @@ class SequentialRecordReader {
           "Trying to seek offset: ", offset,
           " which is less than the current offset: ", offset_);
     offset_ = offset;
+    if (batched_) {
+      ResetBatches();
+    }
     return Status::OK();
   }
 
  private:
+  // Records read ahead in VERIFY_BATCHED mode, and their verification.
+  struct Batch;
+
+  Status ReadBatchedRecord(string* record);
+  // Reads the batch of records at `read_offset_`, and starts verifying it.
+  std::unique_ptr<Batch> ReadBatch();
+  // Drops the batches read ahead, so reading resumes at `offset_`.
+  void ResetBatches();
+
   RecordReader underlying_;
   uint64 offset_ = 0;
+
+  const bool batched_;
+  const int64 batch_size_;
+  thread::ThreadPool* const thread_pool_;
+  // Where the next batch will be read from.
+  uint64 read_offset_ = 0;
+  // The batch being returned, and the one after it, being verified.
+  std::unique_ptr<Batch> batch_;
+  std::unique_ptr<Batch> next_batch_;
+};
+
+// Reads uncompressed TFRecords out of a buffer holding a whole file, e.g. a
+// memory-mapped one. Records are returned as views into the buffer, without
+// any copies or file system calls.
+//
+// Note: this class is not thread safe; external synchronization required.
+class RecordBufferReader {
+ public:
+  // "buffer" must remain live while this Reader is in use.
+  explicit RecordBufferReader(StringPiece buffer) : buffer_(buffer) {}
+
+  // Points *record at the next record in the buffer. Returns OK on success,
+  // OUT_OF_RANGE at the end of the buffer, or DATA_LOSS for a truncated or
+  // corrupted record.
+  Status ReadRecord(StringPiece* record);
+
+  // Returns the current offset in the buffer.
+  uint64 TellOffset() const { return offset_; }
+
+  // Seek to this offset within the buffer and set this offset as the current
+  // offset. Unlike SequentialRecordReader, seeking backward is allowed.
+  Status SeekOffset(uint64 offset) {
+    if (offset > buffer_.size()) {
+      return errors::InvalidArgument("Trying to seek offset: ", offset,
+                                     " which is past the end of the buffer: ",
+                                     buffer_.size());
+    }
+    offset_ = offset;
+    return Status::OK();
+  }
+
+ private:
+  StringPiece buffer_;
+  uint64 offset_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RecordBufferReader);
 };
 
 }  // namespace io
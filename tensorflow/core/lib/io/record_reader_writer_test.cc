@@ -18,14 +18,17 @@ limitations under the License.
 
 #include <zlib.h>
 #include <vector>
+#include "absl/strings/match.h"
 #include "tensorflow/core/platform/env.h"
 
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
@@ -98,6 +101,37 @@ void VerifyFlush(const io::RecordWriterOptions& options) {
   }
 }
 
+// Writes `num_records` records of `record_size` bytes each, with record
+// `corrupted_index`, if any, corrupted. Returns the offset of each record.
+std::vector<uint64> WriteRecords(const string& fname, int num_records,
+                                 size_t record_size,
+                                 const io::RecordWriterOptions& options,
+                                 int corrupted_index = -1) {
+  std::vector<uint64> offsets;
+  string contents;
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(Env::Default()->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get(), options);
+    for (int i = 0; i < num_records; ++i) {
+      offsets.push_back(
+          i * (io::RecordReader::kHeaderSize + record_size +
+               io::RecordReader::kFooterSize));
+      string record(record_size, 'a' + i % 26);
+      record[0] = static_cast<char>(i);
+      TF_CHECK_OK(writer.WriteRecord(record));
+    }
+    TF_CHECK_OK(writer.Close());
+  }
+  if (corrupted_index >= 0) {
+    CHECK_EQ(options.compression_type, io::RecordWriterOptions::NONE);
+    TF_CHECK_OK(ReadFileToString(Env::Default(), fname, &contents));
+    contents[offsets[corrupted_index] + io::RecordReader::kHeaderSize] ^= 1;
+    TF_CHECK_OK(WriteStringToFile(Env::Default(), fname, contents));
+  }
+  return offsets;
+}
+
 }  // namespace
 
 TEST(RecordReaderWriterTest, TestFlush) {
@@ -196,6 +230,148 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestBufferReader) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_buffer_test";
+
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_EXPECT_OK(writer.WriteRecord(""));
+    TF_EXPECT_OK(writer.WriteRecord("defg"));
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  string contents;
+  TF_CHECK_OK(ReadFileToString(env, fname, &contents));
+  io::RecordBufferReader reader(contents);
+  StringPiece record;
+  TF_CHECK_OK(reader.ReadRecord(&record));
+  EXPECT_EQ("abc", record);
+  // Records are views into the buffer.
+  EXPECT_EQ(contents.data() + io::RecordReader::kHeaderSize, record.data());
+  const uint64 offset = reader.TellOffset();
+  TF_CHECK_OK(reader.ReadRecord(&record));
+  EXPECT_EQ("", record);
+  TF_CHECK_OK(reader.ReadRecord(&record));
+  EXPECT_EQ("defg", record);
+  EXPECT_EQ(contents.size(), reader.TellOffset());
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&record)));
+
+  // Seeking backward is allowed.
+  TF_CHECK_OK(reader.SeekOffset(offset));
+  TF_CHECK_OK(reader.ReadRecord(&record));
+  EXPECT_EQ("", record);
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(reader.SeekOffset(contents.size() + 1)));
+
+  // Truncated and corrupted records.
+  io::RecordBufferReader truncated(
+      StringPiece(contents).substr(0, contents.size() - 1));
+  TF_CHECK_OK(truncated.SeekOffset(offset));
+  TF_CHECK_OK(truncated.ReadRecord(&record));
+  EXPECT_TRUE(errors::IsDataLoss(truncated.ReadRecord(&record)));
+  contents[io::RecordReader::kHeaderSize] = 'x';
+  io::RecordBufferReader corrupted(contents);
+  EXPECT_TRUE(errors::IsDataLoss(corrupted.ReadRecord(&record)));
+}
+
+TEST(RecordReaderWriterTest, TestSampledChecksums) {
+  const string fname = testing::TmpDir() + "/record_reader_sampled_test";
+  WriteRecords(fname, 10, 100, io::RecordWriterOptions(),
+               /*corrupted_index=*/5);
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(Env::Default()->NewRandomAccessFile(fname, &read_file));
+
+  // The corrupted record is only detected if it is sampled.
+  for (int interval : {1, 5, 3}) {
+    io::RecordReaderOptions options;
+    options.checksum_mode = io::RecordReaderOptions::VERIFY_SAMPLED;
+    options.checksum_sample_interval = interval;
+    io::SequentialRecordReader reader(read_file.get(), options);
+    string record;
+    Status s;
+    int num_records = 0;
+    for (s = reader.ReadRecord(&record); s.ok();
+         s = reader.ReadRecord(&record)) {
+      ++num_records;
+    }
+    if (interval == 3) {
+      EXPECT_TRUE(errors::IsOutOfRange(s));
+      EXPECT_EQ(10, num_records);
+    } else {
+      EXPECT_TRUE(errors::IsDataLoss(s));
+      EXPECT_EQ(5, num_records);
+    }
+  }
+}
+
+TEST(RecordReaderWriterTest, TestBatchedChecksums) {
+  const string fname = testing::TmpDir() + "/record_reader_batched_test";
+  std::vector<uint64> offsets = WriteRecords(
+      fname, 20, 100, io::RecordWriterOptions(), /*corrupted_index=*/13);
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(Env::Default()->NewRandomAccessFile(fname, &read_file));
+  thread::ThreadPool pool(Env::Default(), "verify", 4);
+
+  for (thread::ThreadPool* thread_pool :
+       std::vector<thread::ThreadPool*>{&pool, nullptr}) {
+    io::RecordReaderOptions options;
+    options.checksum_mode = io::RecordReaderOptions::VERIFY_BATCHED;
+    options.checksum_batch_size = 3;
+    options.checksum_thread_pool = thread_pool;
+    io::SequentialRecordReader reader(read_file.get(), options);
+    string record;
+    TF_CHECK_OK(reader.SeekOffset(offsets[2]));
+    for (int i = 2; i < 13; ++i) {
+      TF_CHECK_OK(reader.ReadRecord(&record));
+      EXPECT_EQ(static_cast<char>(i), record[0]);
+      EXPECT_EQ(offsets[i + 1], reader.TellOffset());
+    }
+    // The corruption is reported on the affected record, every time.
+    Status s = reader.ReadRecord(&record);
+    EXPECT_TRUE(errors::IsDataLoss(s));
+    EXPECT_TRUE(
+        absl::StrContains(s.error_message(), strings::StrCat(offsets[13])));
+    EXPECT_TRUE(errors::IsDataLoss(reader.ReadRecord(&record)));
+    EXPECT_EQ(offsets[13], reader.TellOffset());
+
+    // Reading continues past it after a seek.
+    TF_CHECK_OK(reader.SeekOffset(offsets[14]));
+    for (int i = 14; i < 20; ++i) {
+      TF_CHECK_OK(reader.ReadRecord(&record));
+      EXPECT_EQ(static_cast<char>(i), record[0]);
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&record)));
+    EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&record)));
+  }
+}
+
+TEST(RecordReaderWriterTest, TestBatchedChecksumsZlib) {
+  const string fname = testing::TmpDir() + "/record_reader_batched_zlib_test";
+  io::RecordWriterOptions write_options;
+  write_options.compression_type = io::RecordWriterOptions::ZLIB_COMPRESSION;
+  WriteRecords(fname, 50, 1000, write_options);
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(Env::Default()->NewRandomAccessFile(fname, &read_file));
+  thread::ThreadPool pool(Env::Default(), "verify", 2);
+
+  io::RecordReaderOptions options = GetMatchingReaderOptions(write_options);
+  options.checksum_mode = io::RecordReaderOptions::VERIFY_BATCHED;
+  options.checksum_batch_size = 8;
+  options.checksum_thread_pool = &pool;
+  io::SequentialRecordReader reader(read_file.get(), options);
+  string record;
+  for (int i = 0; i < 50; ++i) {
+    TF_CHECK_OK(reader.ReadRecord(&record));
+    EXPECT_EQ(static_cast<char>(i), record[0]);
+    EXPECT_EQ(1000, record.size());
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&record)));
+}
+
 TEST(RecordReaderWriterTest, TestUseAfterClose) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_flush_close_test";
@@ -219,4 +395,42 @@ TEST(RecordReaderWriterTest, TestUseAfterClose) {
   }
 }
 
+// Reads a 256MB file of 64KB records. The argument is the checksum mode:
+// 0 verifies every record, 1 samples, and 2 verifies in batches on 4
+// threads.
+static void BM_SequentialReadRecords(int iters, int checksum_mode) {
+  testing::StopTiming();
+  constexpr int kNumRecords = 4096;
+  constexpr size_t kRecordSize = 64 << 10;
+  const string fname = testing::TmpDir() + "/record_reader_benchmark";
+  static bool written = [&fname]() {
+    WriteRecords(fname, kNumRecords, kRecordSize, io::RecordWriterOptions());
+    return true;
+  }();
+  CHECK(written);
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(Env::Default()->NewRandomAccessFile(fname, &read_file));
+  thread::ThreadPool pool(Env::Default(), "verify", 4);
+
+  io::RecordReaderOptions options;
+  options.buffer_size = 1 << 20;
+  options.checksum_mode =
+      static_cast<io::RecordReaderOptions::ChecksumMode>(checksum_mode);
+  options.checksum_thread_pool = &pool;
+  options.checksum_batch_size = 32;
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    io::SequentialRecordReader reader(read_file.get(), options);
+    string record;
+    int num_records = 0;
+    while (reader.ReadRecord(&record).ok()) {
+      ++num_records;
+    }
+    CHECK_EQ(kNumRecords, num_records);
+  }
+  testing::BytesProcessed(static_cast<int64>(iters) * kNumRecords *
+                          kRecordSize);
+}
+BENCHMARK(BM_SequentialReadRecords)->Arg(0)->Arg(1)->Arg(2);
+
 }  // namespace tensorflow
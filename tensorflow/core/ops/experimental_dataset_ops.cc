@@ -612,6 +612,7 @@ REGISTER_OP("PrivateThreadPoolDataset")
     .Input("input_dataset: variant")
     .Input("num_threads: int64")
     .Output("handle: variant")
+    .Attr("numa_node: int = -1")
     .Attr("output_types: list(type) >= 1")
     .Attr("output_shapes: list(shape) >= 1")
     .SetShapeFn(shape_inference::ScalarShape);
@@ -931,6 +932,7 @@ REGISTER_OP("ThreadPoolHandle")
     .SetShapeFn(shape_inference::ScalarShape)
     .Attr("num_threads: int")
     .Attr("max_intra_op_parallelism: int = 1")
+    .Attr("numa_node: int = -1")
     .Attr("display_name: string")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''");
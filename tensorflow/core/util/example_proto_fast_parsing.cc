@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include <atomic>
+#include <functional>
 #include <vector>
 
 #include "absl/base/casts.h"
@@ -895,6 +897,36 @@ Status CheckConfigDataType(DataType dtype) {
   }
 }
 
+// Maps the hash of each feature name in `config` to its index and type,
+// changing the hasher's seed if there are collisions.
+Status BuildConfigIndex(const Config& config, SeededHasher* hasher,
+                        PresizedCuckooMap<std::pair<size_t, Type>>* index) {
+  const size_t config_size = config.dense.size() + config.sparse.size();
+  index->Clear(config_size);
+  bool ok = true;
+  for (size_t i = 0; i < 1000; ++i) {
+    for (size_t d = 0; d < config.dense.size(); ++d) {
+      ok &= index->InsertUnique((*hasher)(config.dense[d].feature_name),
+                                {d, Type::Dense});
+    }
+    for (size_t d = 0; d < config.sparse.size(); ++d) {
+      ok &= index->InsertUnique((*hasher)(config.sparse[d].feature_name),
+                                {d, Type::Sparse});
+    }
+    if (ok) break;
+    LOG(WARNING) << "Collision found. This should happen only if you have "
+                    "around 2^32 entries in your config.";
+    hasher->seed++;
+    index->Clear(config_size);
+    ok = true;
+  }
+  if (!ok) {
+    return errors::Internal(
+        "Could not avoid collision. This should not happen.");
+  }
+  return Status::OK();
+}
+
 template <typename T>
 const SmallVector<T>& GetListFromBuffer(const SparseBuffer& buffer);
 
@@ -1018,31 +1050,9 @@ Status FastParseExample(const Config& config,
     result->feature_stats.resize(serialized.size());
   }
 
-  size_t config_size = config.dense.size() + config.sparse.size();
   SeededHasher hasher;
-  // Build config index.
-  PresizedCuckooMap<std::pair<size_t, Type>> config_index(config_size);
-  bool ok = true;
-  for (size_t i = 0; i < 1000; ++i) {
-    for (size_t d = 0; d < config.dense.size(); ++d) {
-      ok &= config_index.InsertUnique(hasher(config.dense[d].feature_name),
-                                      {d, Type::Dense});
-    }
-    for (size_t d = 0; d < config.sparse.size(); ++d) {
-      ok &= config_index.InsertUnique(hasher(config.sparse[d].feature_name),
-                                      {d, Type::Sparse});
-    }
-    if (ok) break;
-    LOG(WARNING) << "Collision found. This should happen only if you have "
-                    "around 2^32 entries in your config.";
-    hasher.seed++;
-    config_index.Clear(config_size);
-    ok = true;
-  }
-  if (!ok) {
-    return errors::Internal(
-        "Could not avoid collision. This should not happen.");
-  }
+  PresizedCuckooMap<std::pair<size_t, Type>> config_index(0);
+  TF_RETURN_IF_ERROR(BuildConfigIndex(config, &hasher, &config_index));
 
   // Allocate dense output for fixed length dense values
   // (variable-length dense and sparse have to be buffered).
@@ -1273,6 +1283,541 @@ Status FastParseExample(const Config& config,
   return Status::OK();
 }
 
+namespace {
+
+// Values of one variable-length dense or sparse feature for a whole batch.
+// Only the list matching the feature's dtype is used.
+struct ColumnBuffer {
+  std::vector<tstring> bytes_list;
+  std::vector<float> float_list;
+  std::vector<int64> int64_list;
+  // Same as SparseBuffer::example_end_indices, for every example in the batch.
+  std::vector<size_t> example_end_indices;
+
+  void Clear() {
+    bytes_list.clear();
+    float_list.clear();
+    int64_list.clear();
+    example_end_indices.clear();
+  }
+};
+
+template <typename T>
+struct FeatureList;
+
+template <>
+struct FeatureList<int64> {
+  static const char* TypeName() { return "int64"; }
+  template <typename Result>
+  static bool Parse(parsed::Feature* feature, Result* list) {
+    return feature->ParseInt64List(list);
+  }
+  static std::vector<int64>* Get(ColumnBuffer* column) {
+    return &column->int64_list;
+  }
+};
+
+template <>
+struct FeatureList<float> {
+  static const char* TypeName() { return "float"; }
+  template <typename Result>
+  static bool Parse(parsed::Feature* feature, Result* list) {
+    return feature->ParseFloatList(list);
+  }
+  static std::vector<float>* Get(ColumnBuffer* column) {
+    return &column->float_list;
+  }
+};
+
+template <>
+struct FeatureList<tstring> {
+  static const char* TypeName() { return "bytes"; }
+  template <typename Result>
+  static bool Parse(parsed::Feature* feature, Result* list) {
+    return feature->ParseBytesList(list);
+  }
+  static std::vector<tstring>* Get(ColumnBuffer* column) {
+    return &column->bytes_list;
+  }
+};
+
+// Runs f(i) for every i in [0, n) on up to `num_tasks` tasks, each of which
+// claims the next unprocessed index until none are left.
+void ParallelForDynamic(const std::function<void(size_t)>& f, size_t n,
+                        size_t num_tasks, thread::ThreadPool* thread_pool) {
+  std::atomic<size_t> next(0);
+  ParallelFor(
+      [&](size_t) {
+        for (size_t i = next++; i < n; i = next++) {
+          f(i);
+        }
+      },
+      std::min(n, num_tasks), thread_pool);
+}
+
+StringPiece ExampleName(gtl::ArraySlice<tstring> example_names, size_t e) {
+  return !example_names.empty() ? StringPiece(example_names[e])
+                                : StringPiece("<unknown>");
+}
+
+}  // namespace
+
+// The features of every example in the batch are stored column-major: the
+// entry for column `c` and example `e` is at `c * batch_size + e`. Columns are
+// the dense features followed by the sparse ones.
+struct ColumnarParseScratch::Buffers {
+  std::vector<parsed::Example> examples;
+  std::vector<parsed::Feature> features;
+  // DT_INVALID for features that are missing or empty.
+  std::vector<DataType> dtypes;
+  // Number of values parsed for each feature, when collecting feature stats.
+  std::vector<size_t> value_counts;
+  // Variable-length dense and sparse values, one buffer per column.
+  std::vector<ColumnBuffer> columns;
+  std::vector<Status> block_status;
+  std::vector<Status> tile_status;
+};
+
+ColumnarParseScratch::ColumnarParseScratch() : buffers_(new Buffers) {}
+
+ColumnarParseScratch::~ColumnarParseScratch() {}
+
+namespace {
+
+using ColumnarBuffers = ColumnarParseScratch::Buffers;
+
+// Parses examples [begin, end) into buffers->examples, and finds the features
+// in `config` they have. `feature_stats` is null unless collecting stats.
+Status IndexExamples(const Config& config,
+                     const PresizedCuckooMap<std::pair<size_t, Type>>& index,
+                     SeededHasher hasher, gtl::ArraySlice<tstring> serialized,
+                     size_t begin, size_t end, ColumnarBuffers* buffers,
+                     PerExampleFeatureStats* feature_stats) {
+  const size_t batch_size = serialized.size();
+  const size_t num_dense = config.dense.size();
+  std::vector<int64> last_example(num_dense + config.sparse.size(), -1);
+  for (size_t e = begin; e < end; ++e) {
+    parsed::Example& parsed_example = buffers->examples[e];
+    parsed_example.clear();
+    if (!ParseExample(serialized[e], &parsed_example)) {
+      return errors::InvalidArgument("Could not parse example input, value: '",
+                                     serialized[e], "'");
+    }
+    if (feature_stats != nullptr) {
+      feature_stats[e].features_count = parsed_example.size();
+    }
+
+    // As in FastParseSerializedExample(), the last entry for a feature wins.
+    for (auto it = parsed_example.rbegin(); it != parsed_example.rend();
+         ++it) {
+      const StringPiece feature_name = it->first;
+      std::pair<size_t, Type> d_and_type;
+      if (!index.Find(hasher(feature_name), &d_and_type)) continue;
+      const size_t d = d_and_type.first;
+      const bool is_dense = d_and_type.second == Type::Dense;
+      if (feature_name != (is_dense ? config.dense[d].feature_name
+                                    : config.sparse[d].feature_name)) {
+        continue;
+      }
+
+      parsed::Feature feature = it->second;
+      DataType example_dtype;
+      TF_RETURN_IF_ERROR(feature.ParseDataType(&example_dtype));
+      if (is_dense && example_dtype == DT_INVALID) continue;
+      const size_t c = is_dense ? d : num_dense + d;
+      if (last_example[c] == static_cast<int64>(e)) {
+        if (is_dense) {
+          LogDenseFeatureDataLoss(feature_name);
+        } else {
+          LogSparseFeatureDataLoss(feature_name);
+        }
+        continue;
+      }
+      last_example[c] = e;
+      buffers->features[c * batch_size + e] = feature;
+      buffers->dtypes[c * batch_size + e] = example_dtype;
+    }
+  }
+  return Status::OK();
+}
+
+// Parses a fixed-length dense feature of examples [begin, end) into `out`.
+template <typename T>
+Status ParseFixedDenseColumn(const Config::Dense& dense, size_t d,
+                             size_t begin, size_t end,
+                             gtl::ArraySlice<tstring> example_names,
+                             bool collect_feature_stats,
+                             ColumnarBuffers* buffers, Tensor* out) {
+  const size_t batch_size = buffers->examples.size();
+  const size_t num_elements = dense.elements_per_stride;
+  for (size_t e = begin; e < end; ++e) {
+    const size_t i = d * batch_size + e;
+    const DataType example_dtype = buffers->dtypes[i];
+    T* out_p = out->flat<T>().data() + e * num_elements;
+    if (example_dtype == DT_INVALID) {
+      const Tensor& default_value = dense.default_value;
+      if (default_value.NumElements() == 0) {
+        return errors::InvalidArgument(
+            "Name: ", ExampleName(example_names, e),
+            ", Feature: ", dense.feature_name,
+            " (data type: ", DataTypeString(dense.dtype), ")",
+            " is required but could not be found.");
+      }
+      std::copy_n(default_value.flat<T>().data(), num_elements, out_p);
+      continue;
+    }
+
+    auto example_error = [&](StringPiece suffix) {
+      return errors::InvalidArgument("Name: ", ExampleName(example_names, e),
+                                     ", Key: ", dense.feature_name,
+                                     ", Index: ", e, ".  ", suffix);
+    };
+    if (example_dtype != dense.dtype) {
+      return example_error(strings::StrCat(
+          "Data types don't match. Data type: ", DataTypeString(example_dtype),
+          " but expected type: ", DataTypeString(dense.dtype)));
+    }
+    LimitedArraySlice<T> slice(out_p, num_elements);
+    if (!FeatureList<T>::Parse(&buffers->features[i], &slice)) {
+      return example_error("Can't parse serialized Example.");
+    }
+    if (slice.EndDistance() != 0) {
+      return example_error(strings::StrCat(
+          "Number of ", FeatureList<T>::TypeName(),
+          " values != expected.  Values size: ",
+          num_elements - slice.EndDistance(),
+          " but output shape: ", dense.shape.DebugString()));
+    }
+    if (collect_feature_stats) {
+      buffers->value_counts[i] = num_elements;
+    }
+  }
+  return Status::OK();
+}
+
+// Parses column `c` of every example into buffers->columns[c]. `dense` is
+// null for sparse features.
+template <typename T>
+Status ParseVarLenColumn(const string& feature_name, DataType dtype,
+                         const Config::Dense* dense, size_t c,
+                         gtl::ArraySlice<tstring> example_names,
+                         bool collect_feature_stats,
+                         ColumnarBuffers* buffers) {
+  const size_t batch_size = buffers->examples.size();
+  ColumnBuffer& column = buffers->columns[c];
+  column.Clear();
+  column.example_end_indices.reserve(batch_size);
+  std::vector<T>* list = FeatureList<T>::Get(&column);
+  for (size_t e = 0; e < batch_size; ++e) {
+    const size_t i = c * batch_size + e;
+    const DataType example_dtype = buffers->dtypes[i];
+    const size_t start = list->size();
+    if (example_dtype != DT_INVALID) {
+      auto example_error = [&](StringPiece suffix) {
+        return errors::InvalidArgument("Name: ", ExampleName(example_names, e),
+                                       ", Key: ", feature_name,
+                                       ", Index: ", e, ".  ", suffix);
+      };
+      if (example_dtype != dtype) {
+        string message = strings::StrCat("Data types don't match. ",
+                                         "Expected type: ",
+                                         DataTypeString(dtype));
+        if (dense == nullptr) {
+          strings::StrAppend(&message,
+                             ", Actual type: ", DataTypeString(example_dtype));
+        }
+        return example_error(message);
+      }
+      if (!FeatureList<T>::Parse(&buffers->features[i], list)) {
+        return example_error("Can't parse serialized Example.");
+      }
+      if (dense != nullptr &&
+          (list->size() - start) % dense->elements_per_stride != 0) {
+        return example_error(strings::StrCat(
+            "Number of ", FeatureList<T>::TypeName(),
+            " values is not a multiple of stride length. Saw ",
+            list->size() - start,
+            " values but output shape is: ", dense->shape.DebugString()));
+      }
+    }
+    column.example_end_indices.push_back(list->size());
+    if (collect_feature_stats) {
+      buffers->value_counts[i] = list->size() - start;
+    }
+  }
+  return Status::OK();
+}
+
+// Copies buffers->columns[c] into the padded output of a variable-length
+// dense feature.
+template <typename T>
+void FillVarLenDenseOutput(const Config::Dense& dense, size_t c,
+                           ColumnarBuffers* buffers, Tensor* out) {
+  const size_t batch_size = buffers->examples.size();
+  ColumnBuffer& column = buffers->columns[c];
+  std::vector<T>& list = *FeatureList<T>::Get(&column);
+  const std::vector<size_t>& end_indices = column.example_end_indices;
+
+  size_t max_num_values = 0;
+  size_t example_start = 0;
+  for (size_t end_index : end_indices) {
+    max_num_values = std::max(max_num_values, end_index - example_start);
+    example_start = end_index;
+  }
+
+  TensorShape values_shape;
+  values_shape.AddDim(batch_size);
+  values_shape.AddDim(max_num_values / dense.elements_per_stride);
+  for (int i = 1; i < dense.shape.dims(); ++i) {
+    values_shape.AddDim(dense.shape.dim_size(i));
+  }
+  *out = Tensor(dense.dtype, values_shape);
+  if (out->NumElements() == 0) return;
+
+  T* data = out->flat<T>().data();
+  std::fill(data, data + out->NumElements(),
+            dense.default_value.flat<T>()(0));
+  example_start = 0;
+  for (size_t e = 0; e < batch_size; ++e) {
+    CopyOrMoveBlock(list.data() + example_start, list.data() + end_indices[e],
+                    data + e * max_num_values);
+    example_start = end_indices[e];
+  }
+}
+
+// Copies buffers->columns[c] into the outputs of sparse feature `s`.
+template <typename T>
+void FillSparseOutput(size_t c, size_t s, ColumnarBuffers* buffers,
+                      Result* result) {
+  const size_t batch_size = buffers->examples.size();
+  ColumnBuffer& column = buffers->columns[c];
+  std::vector<T>& list = *FeatureList<T>::Get(&column);
+  const std::vector<size_t>& end_indices = column.example_end_indices;
+
+  Tensor& indices = result->sparse_indices[s];
+  indices = Tensor(DT_INT64, TensorShape({static_cast<int64>(list.size()), 2}));
+  int64* ix_p = indices.flat<int64>().data();
+  size_t max_num_values = 0;
+  size_t example_start = 0;
+  for (size_t e = 0; e < batch_size; ++e) {
+    const size_t num_values = end_indices[e] - example_start;
+    max_num_values = std::max(max_num_values, num_values);
+    for (size_t j = 0; j < num_values; ++j) {
+      *ix_p++ = e;
+      *ix_p++ = j;
+    }
+    example_start = end_indices[e];
+  }
+
+  Tensor& values = result->sparse_values[s];
+  values = Tensor(DataTypeToEnum<T>::v(),
+                  TensorShape({static_cast<int64>(list.size())}));
+  CopyOrMoveBlock(list.data(), list.data() + list.size(),
+                  values.flat<T>().data());
+
+  Tensor& shape = result->sparse_shapes[s];
+  shape = Tensor(DT_INT64, TensorShape({2}));
+  shape.vec<int64>()(0) = batch_size;
+  shape.vec<int64>()(1) = max_num_values;
+}
+
+}  // namespace
+
+Status FastParseExampleColumnar(const Config& config,
+                                gtl::ArraySlice<tstring> serialized,
+                                gtl::ArraySlice<tstring> example_names,
+                                thread::ThreadPool* thread_pool,
+                                ColumnarParseScratch* scratch, Result* result) {
+  DCHECK(result != nullptr);
+  for (auto& c : config.sparse) {
+    TF_RETURN_IF_ERROR(CheckConfigDataType(c.dtype));
+  }
+  for (auto& c : config.dense) {
+    TF_RETURN_IF_ERROR(CheckConfigDataType(c.dtype));
+  }
+
+  SeededHasher hasher;
+  PresizedCuckooMap<std::pair<size_t, Type>> config_index(0);
+  TF_RETURN_IF_ERROR(BuildConfigIndex(config, &hasher, &config_index));
+
+  ColumnarParseScratch local_scratch;
+  ColumnarBuffers* buffers =
+      (scratch != nullptr ? scratch : &local_scratch)->buffers();
+
+  const size_t batch_size = serialized.size();
+  const size_t num_dense = config.dense.size();
+  const size_t num_columns = num_dense + config.sparse.size();
+  const bool collect_feature_stats = config.collect_feature_stats;
+  if (collect_feature_stats) {
+    result->feature_stats.assign(batch_size, PerExampleFeatureStats());
+    buffers->value_counts.assign(num_columns * batch_size, 0);
+  }
+  buffers->examples.resize(batch_size);
+  buffers->features.resize(num_columns * batch_size);
+  buffers->dtypes.assign(num_columns * batch_size, DT_INVALID);
+  if (buffers->columns.size() < num_columns) {
+    buffers->columns.resize(num_columns);
+  }
+
+  // The calling thread takes part in ParallelFor().
+  const size_t num_tasks =
+      thread_pool != nullptr ? thread_pool->NumThreads() + 1 : 1;
+
+  // Parse each example once, and find the features it has.
+  const size_t kExamplesPerBlock = 16;
+  const size_t num_blocks =
+      (batch_size + kExamplesPerBlock - 1) / kExamplesPerBlock;
+  buffers->block_status.assign(num_blocks, Status::OK());
+  ParallelForDynamic(
+      [&](size_t block) {
+        const size_t begin = block * kExamplesPerBlock;
+        const size_t end = std::min(begin + kExamplesPerBlock, batch_size);
+        buffers->block_status[block] =
+            IndexExamples(config, config_index, hasher, serialized, begin, end,
+                          buffers,
+                          collect_feature_stats ? result->feature_stats.data()
+                                                : nullptr);
+      },
+      num_blocks, num_tasks, thread_pool);
+  for (const Status& status : buffers->block_status) {
+    TF_RETURN_IF_ERROR(status);
+  }
+
+  // Then parse each feature into its output. Fixed-length dense features are
+  // split into tiles of examples as well, so that there is enough work for
+  // every task when there are few features.
+  result->dense_values.resize(num_dense);
+  result->sparse_indices.resize(config.sparse.size());
+  result->sparse_values.resize(config.sparse.size());
+  result->sparse_shapes.resize(config.sparse.size());
+  std::vector<size_t> fixed_dense;
+  std::vector<size_t> varlen_columns;
+  for (size_t d = 0; d < num_dense; ++d) {
+    if (config.dense[d].variable_length) {
+      varlen_columns.push_back(d);
+      continue;
+    }
+    TensorShape out_shape;
+    out_shape.AddDim(batch_size);
+    for (const int64 dim : config.dense[d].shape.dim_sizes()) {
+      out_shape.AddDim(dim);
+    }
+    result->dense_values[d] = Tensor(config.dense[d].dtype, out_shape);
+    fixed_dense.push_back(d);
+  }
+  for (size_t c = num_dense; c < num_columns; ++c) {
+    varlen_columns.push_back(c);
+  }
+  const size_t tiles_per_column = std::max<size_t>(
+      1, std::min(batch_size, num_tasks / std::max<size_t>(1, num_columns)));
+  const size_t num_tiles =
+      fixed_dense.size() * tiles_per_column + varlen_columns.size();
+
+  auto ParseTile = [&](size_t tile) -> Status {
+    if (tile < fixed_dense.size() * tiles_per_column) {
+      const size_t d = fixed_dense[tile / tiles_per_column];
+      const size_t part = tile % tiles_per_column;
+      const size_t begin = batch_size * part / tiles_per_column;
+      const size_t end = batch_size * (part + 1) / tiles_per_column;
+      const Config::Dense& dense = config.dense[d];
+      Tensor* out = &result->dense_values[d];
+      switch (dense.dtype) {
+        case DT_INT64:
+          return ParseFixedDenseColumn<int64>(dense, d, begin, end,
+                                              example_names,
+                                              collect_feature_stats, buffers,
+                                              out);
+        case DT_FLOAT:
+          return ParseFixedDenseColumn<float>(dense, d, begin, end,
+                                              example_names,
+                                              collect_feature_stats, buffers,
+                                              out);
+        case DT_STRING:
+          return ParseFixedDenseColumn<tstring>(dense, d, begin, end,
+                                                example_names,
+                                                collect_feature_stats,
+                                                buffers, out);
+        default:
+          LOG(FATAL) << "Should not happen.";
+      }
+    }
+
+    const size_t c =
+        varlen_columns[tile - fixed_dense.size() * tiles_per_column];
+    if (c < num_dense) {
+      const Config::Dense& dense = config.dense[c];
+      Tensor* out = &result->dense_values[c];
+      switch (dense.dtype) {
+        case DT_INT64:
+          TF_RETURN_IF_ERROR(ParseVarLenColumn<int64>(
+              dense.feature_name, dense.dtype, &dense, c, example_names,
+              collect_feature_stats, buffers));
+          FillVarLenDenseOutput<int64>(dense, c, buffers, out);
+          break;
+        case DT_FLOAT:
+          TF_RETURN_IF_ERROR(ParseVarLenColumn<float>(
+              dense.feature_name, dense.dtype, &dense, c, example_names,
+              collect_feature_stats, buffers));
+          FillVarLenDenseOutput<float>(dense, c, buffers, out);
+          break;
+        case DT_STRING:
+          TF_RETURN_IF_ERROR(ParseVarLenColumn<tstring>(
+              dense.feature_name, dense.dtype, &dense, c, example_names,
+              collect_feature_stats, buffers));
+          FillVarLenDenseOutput<tstring>(dense, c, buffers, out);
+          break;
+        default:
+          LOG(FATAL) << "Should not happen.";
+      }
+      return Status::OK();
+    }
+
+    const size_t s = c - num_dense;
+    const Config::Sparse& sparse = config.sparse[s];
+    switch (sparse.dtype) {
+      case DT_INT64:
+        TF_RETURN_IF_ERROR(ParseVarLenColumn<int64>(
+            sparse.feature_name, sparse.dtype, nullptr, c, example_names,
+            collect_feature_stats, buffers));
+        FillSparseOutput<int64>(c, s, buffers, result);
+        break;
+      case DT_FLOAT:
+        TF_RETURN_IF_ERROR(ParseVarLenColumn<float>(
+            sparse.feature_name, sparse.dtype, nullptr, c, example_names,
+            collect_feature_stats, buffers));
+        FillSparseOutput<float>(c, s, buffers, result);
+        break;
+      case DT_STRING:
+        TF_RETURN_IF_ERROR(ParseVarLenColumn<tstring>(
+            sparse.feature_name, sparse.dtype, nullptr, c, example_names,
+            collect_feature_stats, buffers));
+        FillSparseOutput<tstring>(c, s, buffers, result);
+        break;
+      default:
+        LOG(FATAL) << "Should not happen.";
+    }
+    return Status::OK();
+  };
+
+  buffers->tile_status.assign(num_tiles, Status::OK());
+  ParallelForDynamic(
+      [&](size_t tile) { buffers->tile_status[tile] = ParseTile(tile); },
+      num_tiles, num_tasks, thread_pool);
+  for (const Status& status : buffers->tile_status) {
+    TF_RETURN_IF_ERROR(status);
+  }
+
+  if (collect_feature_stats) {
+    for (size_t c = 0; c < num_columns; ++c) {
+      const size_t* counts = buffers->value_counts.data() + c * batch_size;
+      for (size_t e = 0; e < batch_size; ++e) {
+        result->feature_stats[e].feature_values_count += counts[e];
+      }
+    }
+  }
+  return Status::OK();
+}
+
 Status FastParseSingleExample(const Config& config,
                               absl::string_view serialized, Result* result) {
   DCHECK(result != nullptr);
@@ -1291,31 +1836,9 @@ Status FastParseSingleExample(const Config& config,
   }
 
   // TODO(mrry): Cache the construction of this map at Op construction time.
-  size_t config_size = config.dense.size() + config.sparse.size();
   SeededHasher hasher;
-  // Build config index.
-  PresizedCuckooMap<std::pair<size_t, Type>> config_index(config_size);
-  bool ok = true;
-  for (size_t i = 0; i < 1000; ++i) {
-    for (size_t d = 0; d < config.dense.size(); ++d) {
-      ok &= config_index.InsertUnique(hasher(config.dense[d].feature_name),
-                                      {d, Type::Dense});
-    }
-    for (size_t d = 0; d < config.sparse.size(); ++d) {
-      ok &= config_index.InsertUnique(hasher(config.sparse[d].feature_name),
-                                      {d, Type::Sparse});
-    }
-    if (ok) break;
-    LOG(WARNING) << "Collision found. This should happen only if you have "
-                    "around 2^32 entries in your config.";
-    hasher.seed++;
-    config_index.Clear(config_size);
-    ok = true;
-  }
-  if (!ok) {
-    return errors::Internal(
-        "Could not avoid collision. This should not happen.");
-  }
+  PresizedCuckooMap<std::pair<size_t, Type>> config_index(0);
+  TF_RETURN_IF_ERROR(BuildConfigIndex(config, &hasher, &config_index));
 
   // Allocate dense output tensors.
   for (size_t d = 0; d < config.dense.size(); ++d) {
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_UTIL_EXAMPLE_PROTO_FAST_PARSING_H_
 #define TENSORFLOW_CORE_UTIL_EXAMPLE_PROTO_FAST_PARSING_H_
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -28,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/sparse/sparse_tensor.h"
 
@@ -103,6 +105,36 @@ Status FastParseExample(const FastParseExampleConfig& config,
                         gtl::ArraySlice<tstring> example_names,
                         thread::ThreadPool* thread_pool, Result* result);
 
+// Buffers kept by FastParseExampleColumnar() between calls, so that parsing
+// successive batches doesn't reallocate them. Not thread safe: concurrent
+// calls need separate scratch objects.
+class ColumnarParseScratch {
+ public:
+  ColumnarParseScratch();
+  ~ColumnarParseScratch();
+
+  // Defined in example_proto_fast_parsing.cc.
+  struct Buffers;
+  Buffers* buffers() { return buffers_.get(); }
+
+ private:
+  std::unique_ptr<Buffers> buffers_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ColumnarParseScratch);
+};
+
+// Like FastParseExample(), but parses the batch a feature column at a time.
+// Each serialized Example is parsed once to find its features, and then each
+// requested feature is decoded for the whole batch straight into its output
+// tensor. Work is split across features as well as examples, which makes
+// this faster than FastParseExample() for schemas with many features.
+// `scratch` may be null.
+Status FastParseExampleColumnar(const FastParseExampleConfig& config,
+                                gtl::ArraySlice<tstring> serialized,
+                                gtl::ArraySlice<tstring> example_names,
+                                thread::ThreadPool* thread_pool,
+                                ColumnarParseScratch* scratch, Result* result);
+
 // TODO(mrry): Move the hash table construction into the config object.
 typedef FastParseExampleConfig FastParseSingleExampleConfig;
 
@@ -17,10 +17,16 @@ limitations under the License.
 
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include "absl/strings/match.h"
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -321,6 +327,206 @@ TEST(FastParse, StatsCollection) {
   }
 }
 
+// Random examples with some of the features in `config`. Features may be
+// missing or empty, and are repeated if `concatenate`, but fixed-length ones
+// have the right number of values when present.
+std::vector<tstring> MakeColumnarTestExamples(
+    const FastParseExampleConfig& config, size_t num_examples,
+    bool concatenate, random::SimplePhilox* rng) {
+  std::vector<std::pair<string, DataType>> features;
+  for (const auto& dense : config.dense) {
+    features.emplace_back(dense.feature_name, dense.dtype);
+  }
+  for (const auto& sparse : config.sparse) {
+    features.emplace_back(sparse.feature_name, sparse.dtype);
+  }
+  std::vector<tstring> serialized;
+  for (size_t e = 0; e < num_examples; ++e) {
+    string example_string;
+    // Features repeated in concatenated examples are overwritten.
+    const int num_concats = concatenate && rng->Uniform(8) == 0 ? 2 : 1;
+    for (int concat = 0; concat < num_concats; ++concat) {
+      Example example;
+      auto& feature_map = *example.mutable_features()->mutable_feature();
+      feature_map["unused"].mutable_int64_list()->add_value(1);
+      for (size_t f = 0; f < features.size(); ++f) {
+        if (rng->Uniform(4) == 0) continue;
+        Feature& feature = feature_map[features[f].first];
+        if (rng->Uniform(8) == 0) continue;
+        int num_values = rng->Uniform(3) * 2;
+        if (f < config.dense.size() && !config.dense[f].variable_length) {
+          num_values = config.dense[f].elements_per_stride;
+        }
+        switch (features[f].second) {
+          case DT_INT64:
+            feature.mutable_int64_list();
+            for (int i = 0; i < num_values; ++i) {
+              feature.mutable_int64_list()->add_value(rng->Rand64());
+            }
+            break;
+          case DT_FLOAT:
+            feature.mutable_float_list();
+            for (int i = 0; i < num_values; ++i) {
+              feature.mutable_float_list()->add_value(rng->RandFloat());
+            }
+            break;
+          case DT_STRING:
+            feature.mutable_bytes_list();
+            for (int i = 0; i < num_values; ++i) {
+              feature.mutable_bytes_list()->add_value(
+                  strings::StrCat("value_", rng->Rand32()));
+            }
+            break;
+          default:
+            LOG(FATAL) << "Unexpected dtype";
+        }
+      }
+      example_string += Serialize(example);
+    }
+    serialized.push_back(example_string);
+  }
+  return serialized;
+}
+
+FastParseExampleConfig ColumnarTestConfig() {
+  FastParseExampleConfig config;
+  AddDenseFeature("dense_int64", DT_INT64, {2}, false, 2, &config);
+  config.dense.back().default_value = test::AsTensor<int64>({-1, -2}, {2});
+  AddDenseFeature("dense_float", DT_FLOAT, {1, 2}, false, 2, &config);
+  config.dense.back().default_value = test::AsTensor<float>({-1, -2}, {1, 2});
+  AddDenseFeature("dense_string", DT_STRING, {2}, false, 2, &config);
+  config.dense.back().default_value = test::AsTensor<tstring>({"a", "b"}, {2});
+  AddDenseFeature("varlen_int64", DT_INT64, {-1}, true, 1, &config);
+  config.dense.back().default_value = test::AsScalar<int64>(7);
+  AddDenseFeature("varlen_float", DT_FLOAT, {-1, 2}, true, 2, &config);
+  config.dense.back().default_value = test::AsScalar<float>(0.5);
+  AddDenseFeature("varlen_string", DT_STRING, {-1}, true, 1, &config);
+  config.dense.back().default_value = test::AsScalar<tstring>("pad");
+  AddSparseFeature("sparse_int64", DT_INT64, &config);
+  AddSparseFeature("sparse_float", DT_FLOAT, &config);
+  AddSparseFeature("sparse_string", DT_STRING, &config);
+  return config;
+}
+
+void ExpectTensorsEqual(const Tensor& expected, const Tensor& actual) {
+  switch (expected.dtype()) {
+    case DT_INT64:
+      test::ExpectTensorEqual<int64>(expected, actual);
+      break;
+    case DT_FLOAT:
+      test::ExpectTensorEqual<float>(expected, actual);
+      break;
+    case DT_STRING:
+      test::ExpectTensorEqual<tstring>(expected, actual);
+      break;
+    default:
+      LOG(FATAL) << "Unexpected dtype";
+  }
+}
+
+void ExpectResultsEqual(const Result& expected, const Result& actual) {
+  ASSERT_EQ(expected.dense_values.size(), actual.dense_values.size());
+  for (size_t d = 0; d < expected.dense_values.size(); ++d) {
+    ExpectTensorsEqual(expected.dense_values[d], actual.dense_values[d]);
+  }
+  ASSERT_EQ(expected.sparse_values.size(), actual.sparse_values.size());
+  for (size_t s = 0; s < expected.sparse_values.size(); ++s) {
+    ExpectTensorsEqual(expected.sparse_indices[s], actual.sparse_indices[s]);
+    ExpectTensorsEqual(expected.sparse_values[s], actual.sparse_values[s]);
+    ExpectTensorsEqual(expected.sparse_shapes[s], actual.sparse_shapes[s]);
+  }
+  ASSERT_EQ(expected.feature_stats.size(), actual.feature_stats.size());
+  for (size_t e = 0; e < expected.feature_stats.size(); ++e) {
+    EXPECT_EQ(expected.feature_stats[e].features_count,
+              actual.feature_stats[e].features_count);
+    EXPECT_EQ(expected.feature_stats[e].feature_values_count,
+              actual.feature_stats[e].feature_values_count);
+  }
+}
+
+TEST(FastParseExampleColumnar, MatchesFastParseExample) {
+  random::PhiloxRandom philox(42);
+  random::SimplePhilox rng(&philox);
+  thread::ThreadPool thread_pool(Env::Default(), "test", 4);
+  FastParseExampleConfig config = ColumnarTestConfig();
+  ColumnarParseScratch scratch;
+  for (size_t num_examples : {0, 1, 7, 100, 33}) {
+    for (thread::ThreadPool* pool :
+         std::vector<thread::ThreadPool*>{nullptr, &thread_pool}) {
+      config.collect_feature_stats = num_examples % 2 == 1;
+      std::vector<tstring> serialized =
+          MakeColumnarTestExamples(config, num_examples, true, &rng);
+      Result expected;
+      TF_ASSERT_OK(FastParseExample(config, serialized, {}, pool, &expected));
+      Result actual;
+      TF_ASSERT_OK(FastParseExampleColumnar(config, serialized, {}, pool,
+                                            &scratch, &actual));
+      ExpectResultsEqual(expected, actual);
+    }
+  }
+}
+
+TEST(FastParseExampleColumnar, Errors) {
+  random::PhiloxRandom philox(42);
+  random::SimplePhilox rng(&philox);
+  FastParseExampleConfig config = ColumnarTestConfig();
+  ColumnarParseScratch scratch;
+  Result result;
+
+  // A fixed-length feature without a default value is required.
+  config.dense[0].default_value = Tensor(DT_INT64, {0});
+  Example example;
+  (*example.mutable_features()->mutable_feature())["dense_float"]
+      .mutable_float_list()
+      ->add_value(1);
+  std::vector<tstring> serialized = {Serialize(example)};
+  Status status = FastParseExampleColumnar(config, serialized, {"e0"}, nullptr,
+                                           &scratch, &result);
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_TRUE(absl::StrContains(status.error_message(),
+                                "Name: e0, Feature: dense_int64"))
+      << status;
+
+  // Wrong number of values.
+  config = ColumnarTestConfig();
+  status = FastParseExampleColumnar(config, serialized, {}, nullptr, &scratch,
+                                    &result);
+  EXPECT_TRUE(absl::StrContains(status.error_message(),
+                                "Number of float values != expected"))
+      << status;
+
+  // Wrong type.
+  (*example.mutable_features()->mutable_feature())["sparse_float"]
+      .mutable_int64_list()
+      ->add_value(1);
+  (*example.mutable_features()->mutable_feature())["dense_float"]
+      .mutable_float_list()
+      ->add_value(2);
+  serialized = {Serialize(example)};
+  status = FastParseExampleColumnar(config, serialized, {}, nullptr, &scratch,
+                                    &result);
+  EXPECT_TRUE(absl::StrContains(status.error_message(),
+                                "Key: sparse_float, Index: 0.  Data types"))
+      << status;
+
+  // Not an Example: groups aren't supported.
+  serialized = {"\x0b"};
+  status = FastParseExampleColumnar(config, serialized, {}, nullptr, &scratch,
+                                    &result);
+  EXPECT_TRUE(absl::StrContains(status.error_message(),
+                                "Could not parse example input"))
+      << status;
+
+  // The scratch is still usable after errors.
+  serialized = MakeColumnarTestExamples(config, 20, true, &rng);
+  Result expected;
+  TF_ASSERT_OK(FastParseExample(config, serialized, {}, nullptr, &expected));
+  Result actual;
+  TF_ASSERT_OK(FastParseExampleColumnar(config, serialized, {}, nullptr,
+                                        &scratch, &actual));
+  ExpectResultsEqual(expected, actual);
+}
+
 string RandStr(random::SimplePhilox* rng) {
   static const char key_char_lookup[] =
       "0123456789{}~`!@#$%^&*()"
@@ -423,6 +629,77 @@ TEST(TestFastParseExample, Empty) {
   EXPECT_TRUE(status.ok()) << status;
 }
 
+// A wide schema, like those of ranking models: `num_features` features split
+// between fixed-length dense floats and int64s, variable-length strings and
+// sparse int64 ids.
+FastParseExampleConfig WideSchemaConfig(int num_features) {
+  FastParseExampleConfig config;
+  for (int i = 0; i < num_features; ++i) {
+    const string name = strings::StrCat("feature_", i);
+    switch (i % 5) {
+      case 0:
+        AddDenseFeature(name.c_str(), DT_FLOAT, {1}, false, 1, &config);
+        config.dense.back().default_value = Tensor(DT_FLOAT, {1});
+        config.dense.back().default_value.flat<float>().setZero();
+        break;
+      case 1:
+        AddDenseFeature(name.c_str(), DT_FLOAT, {8}, false, 8, &config);
+        config.dense.back().default_value = Tensor(DT_FLOAT, {8});
+        config.dense.back().default_value.flat<float>().setZero();
+        break;
+      case 2:
+        AddDenseFeature(name.c_str(), DT_INT64, {1}, false, 1, &config);
+        config.dense.back().default_value = Tensor(DT_INT64, {1});
+        config.dense.back().default_value.flat<int64>().setZero();
+        break;
+      case 3:
+        AddDenseFeature(name.c_str(), DT_STRING, {-1}, true, 1, &config);
+        break;
+      case 4:
+        AddSparseFeature(name.c_str(), DT_INT64, &config);
+        break;
+    }
+  }
+  return config;
+}
+
+void BM_ParseWideExamples(int iters, int num_features, bool columnar) {
+  testing::StopTiming();
+  const int kBatchSize = 256;
+  random::PhiloxRandom philox(42);
+  random::SimplePhilox rng(&philox);
+  const FastParseExampleConfig config = WideSchemaConfig(num_features);
+  const std::vector<tstring> serialized =
+      MakeColumnarTestExamples(config, kBatchSize, false, &rng);
+  thread::ThreadPool thread_pool(Env::Default(), "benchmark",
+                                 port::NumSchedulableCPUs());
+  ColumnarParseScratch scratch;
+  testing::UseRealTime();
+  testing::ItemsProcessed(static_cast<int64>(iters) * kBatchSize *
+                          num_features);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    Result result;
+    if (columnar) {
+      TF_CHECK_OK(FastParseExampleColumnar(config, serialized, {},
+                                           &thread_pool, &scratch, &result));
+    } else {
+      TF_CHECK_OK(
+          FastParseExample(config, serialized, {}, &thread_pool, &result));
+    }
+  }
+}
+
+static void BM_FastParseExampleWide(int iters, int num_features) {
+  BM_ParseWideExamples(iters, num_features, false);
+}
+BENCHMARK(BM_FastParseExampleWide)->Arg(10)->Arg(100)->Arg(500);
+
+static void BM_FastParseExampleColumnarWide(int iters, int num_features) {
+  BM_ParseWideExamples(iters, num_features, true);
+}
+BENCHMARK(BM_FastParseExampleColumnarWide)->Arg(10)->Arg(100)->Arg(500);
+
 }  // namespace
 }  // namespace example
 }  // namespace tensorflow
@@ -22,6 +22,7 @@ import numpy as np
 from tensorflow.python.data.benchmarks import benchmark_base
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.framework import sparse_tensor
+from tensorflow.python.ops import array_ops
 
 
 class BatchBenchmark(benchmark_base.DatasetBenchmarkBase):
@@ -67,6 +68,27 @@ class BatchBenchmark(benchmark_base.DatasetBenchmarkBase):
               name="batch_element_size_%d_batch_size_%d%s" %
               (element_size, batch_size, tag))
 
+  def benchmark_range_map_batch(self):
+    for element_exp in [4, 8, 12]:
+      for batch_size in [32, 256]:
+        for map_and_batch_fusion in [True, False]:
+          element_size = 1 << element_exp
+          dataset = dataset_ops.Dataset.range(1000000000).map(
+              lambda x, n=element_size: array_ops.fill([n], x)).batch(
+                  batch_size)
+          options = dataset_ops.Options()
+          options.experimental_optimization.apply_default_optimizations = False
+          options.experimental_optimization.map_and_batch_fusion = (
+              map_and_batch_fusion)
+          dataset = dataset.with_options(options)
+          tag = "_fused" if map_and_batch_fusion else ""
+          self.run_and_report_benchmark(
+              dataset,
+              num_elements=(1 << 20) // (batch_size * element_size) + 10,
+              iters=5,
+              name="range_map_batch_element_size_%d_batch_size_%d%s" %
+              (element_size, batch_size, tag))
+
 
 if __name__ == "__main__":
   benchmark_base.test.main()
@@ -35,8 +35,11 @@ class AutotuneBenchmark(test.Benchmark):
     b = self._benchmark_map(autotune=True)
     c = self._benchmark_map(
         autotune=True, algorithm=dataset_ops.AutotuneAlgorithm.GRADIENT_DESCENT)
+    d = self._benchmark_map(
+        autotune=True, algorithm=dataset_ops.AutotuneAlgorithm.COST_MODEL)
     print("HillClimb vs Default speedup: %f" % (a / b))
     print("GradientDescent vs Default speedup: %f" % (a / c))
+    print("CostModel vs Default speedup: %f" % (a / d))
 
   def _benchmark_map(self,
                      autotune,
@@ -77,8 +80,11 @@ class AutotuneBenchmark(test.Benchmark):
     b = self._benchmark_map_and_batch(autotune=True)
     c = self._benchmark_map_and_batch(
         autotune=True, algorithm=dataset_ops.AutotuneAlgorithm.GRADIENT_DESCENT)
+    d = self._benchmark_map_and_batch(
+        autotune=True, algorithm=dataset_ops.AutotuneAlgorithm.COST_MODEL)
     print("HillClimb vs Default speedup: %f" % (a / b))
     print("GradientDescent vs Default speedup: %f" % (a / c))
+    print("CostModel vs Default speedup: %f" % (a / d))
 
   def _benchmark_map_and_batch(
       self, autotune, algorithm=dataset_ops.AutotuneAlgorithm.HILL_CLIMB):
@@ -122,8 +128,11 @@ class AutotuneBenchmark(test.Benchmark):
     b = self._benchmark_interleave(autotune=True)
     c = self._benchmark_interleave(
         autotune=True, algorithm=dataset_ops.AutotuneAlgorithm.GRADIENT_DESCENT)
+    d = self._benchmark_interleave(
+        autotune=True, algorithm=dataset_ops.AutotuneAlgorithm.COST_MODEL)
     print("HillClimb vs Default speedup: %f" % (a / b))
     print("GradientDescent vs Default speedup: %f" % (a / c))
+    print("CostModel vs Default speedup: %f" % (a / d))
 
   def _benchmark_interleave(self,
                             autotune,
@@ -168,8 +177,11 @@ class AutotuneBenchmark(test.Benchmark):
     b = self._benchmark_map_and_interleave(autotune=True)
     c = self._benchmark_map_and_interleave(
         autotune=True, algorithm=dataset_ops.AutotuneAlgorithm.GRADIENT_DESCENT)
+    d = self._benchmark_map_and_interleave(
+        autotune=True, algorithm=dataset_ops.AutotuneAlgorithm.COST_MODEL)
     print("HillClimb vs Default speedup: %f" % (a / b))
     print("GradientDescent vs Default speedup: %f" % (a / c))
+    print("CostModel vs Default speedup: %f" % (a / d))
 
   def _benchmark_map_and_interleave(
       self, autotune, algorithm=dataset_ops.AutotuneAlgorithm.HILL_CLIMB):
@@ -235,8 +247,11 @@ class AutotuneBenchmark(test.Benchmark):
     b = self._benchmark_map_batch_and_interleave(autotune=True)
     c = self._benchmark_map_batch_and_interleave(
         autotune=True, algorithm=dataset_ops.AutotuneAlgorithm.GRADIENT_DESCENT)
+    d = self._benchmark_map_batch_and_interleave(
+        autotune=True, algorithm=dataset_ops.AutotuneAlgorithm.COST_MODEL)
     print("HillClimb vs Default speedup: %f" % (a / b))
     print("GradientDescent vs Default speedup: %f" % (a / c))
+    print("CostModel vs Default speedup: %f" % (a / d))
 
   def _benchmark_map_batch_and_interleave(
       self, autotune, algorithm=dataset_ops.AutotuneAlgorithm.HILL_CLIMB):
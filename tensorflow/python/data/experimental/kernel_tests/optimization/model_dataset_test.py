@@ -44,6 +44,19 @@ class ModelDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
     with self.assertRaises(errors.OutOfRangeError):
       self.evaluate(get_next())
 
+  def testAutotuneProfileOption(self):
+    dataset = dataset_ops.Dataset.range(100)
+    dataset = dataset.map(lambda x: x * 2, num_parallel_calls=2).batch(10)
+    dataset = dataset.apply(optimization.assert_next(["Model"]))
+    options = dataset_ops.Options()
+    options.experimental_optimization.apply_default_optimizations = False
+    options.experimental_optimization.autotune = True
+    options.experimental_optimization.autotune_profile = True
+    dataset = dataset.with_options(options)
+    self.assertDatasetProduces(
+        dataset, expected_output=[[2 * x for x in range(i, i + 10)]
+                                  for i in range(0, 100, 10)])
+
 
 if __name__ == "__main__":
   test.main()
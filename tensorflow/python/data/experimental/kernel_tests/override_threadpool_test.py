@@ -121,6 +121,42 @@ class OverrideThreadpoolTest(test_base.DatasetTestBase,
 
     self._testNumThreadsHelper(num_threads, override_threadpool_fn)
 
+  @parameterized.named_parameters(
+      ("1", 4, 0),
+      ("2", None, 0),
+  )
+  def testNUMANode(self, num_threads, numa_node):
+    # Every host has a NUMA node 0, which is used when NUMA is not supported.
+
+    def override_threadpool_fn(dataset):
+      t_options = threading_options.ThreadingOptions()
+      if num_threads is not None:
+        t_options.private_threadpool_size = num_threads
+      t_options.private_threadpool_numa_node = numa_node
+      options = dataset_ops.Options()
+      options.experimental_threading = t_options
+      return dataset.with_options(options)
+
+    self._testNumThreadsHelper(num_threads, override_threadpool_fn)
+
+  def testNUMANodeDeprecated(self):
+
+    def override_threadpool_fn(dataset):
+      return threadpool.override_threadpool(
+          dataset,
+          threadpool.PrivateThreadPool(
+              4, display_name="private_thread_pool_numa", numa_node=0))
+
+    self._testNumThreadsHelper(4, override_threadpool_fn)
+
+  def testInvalidNUMANode(self):
+    dataset = dataset_ops.Dataset.range(10)
+    options = dataset_ops.Options()
+    options.experimental_threading.private_threadpool_numa_node = 1 << 20
+    dataset = dataset.with_options(options)
+    with self.assertRaisesRegexp(errors.InvalidArgumentError, "numa_node"):
+      self.evaluate(self.getNext(dataset)())
+
   def testMaxIntraOpParallelismAsGraphDefInternal(self):
     dataset = dataset_ops.Dataset.from_tensors(0)
     dataset = dataset_ops._MaxIntraOpParallelismDataset(dataset, 1)
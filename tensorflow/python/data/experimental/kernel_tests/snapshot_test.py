@@ -258,6 +258,45 @@ class SnapshotDatasetTest(reader_dataset_ops_test_base.TFRecordDatasetTestBase,
         snapshot.snapshot(tmpdir, compression=compression))
     self.assertDatasetProduces(dataset2, expected, assert_items_equal=True)
 
+  @combinations.generate(
+      combinations.times(
+          test_base.default_test_combinations(),
+          combinations.combine(writer_threads=[1, 4], reader_threads=[1, 3])))
+  def testReadSnapshotWithDifferentSettingsAfterWrite(
+      self, writer_threads, reader_threads):
+    self.setUpTFRecord(10, 100)
+    filenames = self.test_filenames
+
+    expected = [
+        b"Record %d of file %d" % (r, f)  # pylint:disable=g-complex-comprehension
+        for f in range(0, 10)
+        for r in range(0, 100)
+    ]
+
+    tmpdir = self.makeSnapshotDirectory()
+    dataset = core_readers._TFRecordDataset(filenames)
+    dataset = dataset.apply(
+        snapshot.snapshot(
+            tmpdir,
+            compression=snapshot.COMPRESSION_GZIP,
+            shard_size_bytes=1024,
+            num_writer_threads=writer_threads,
+            writer_buffer_size=writer_threads))
+    self.assertDatasetProduces(dataset, expected, assert_items_equal=True)
+
+    # remove the original files and read the data back only from the snapshot,
+    # using the layout and compression recorded in its metadata.
+    self.removeTFRecords()
+
+    dataset2 = core_readers._TFRecordDataset(filenames)
+    dataset2 = dataset2.apply(
+        snapshot.snapshot(
+            tmpdir,
+            compression=snapshot.COMPRESSION_NONE,
+            num_reader_threads=reader_threads,
+            reader_buffer_size=reader_threads))
+    self.assertDatasetProduces(dataset2, expected, assert_items_equal=True)
+
   @combinations.generate(test_base.default_test_combinations())
   def testSameFingerprintWithDifferentInitializationOrder(self):
     tmpdir = self.makeSnapshotDirectory()
@@ -107,6 +107,18 @@ class OptimizationOptions(options.OptionsBase):
       "are allowed but may result in CPU contention. If None, defaults to the "
       "number of schedulable CPU cores.")
 
+  autotune_profile = options.create_option(
+      name="autotune_profile",
+      ty=bool,
+      docstring=
+      "When autotuning is enabled (through `autotune`), determines whether to "
+      "collect a per-iterator profile of the input pipeline: the wall time "
+      "spent in each iterator and its inputs, the bytes it produced and the "
+      "occupancy of its buffer. The profile is logged as a tree when the "
+      "iterator is destroyed, marking the bottleneck iterator, and added to "
+      "the iterator events of the TensorFlow profiler. If None, defaults to "
+      "False.")
+
   filter_fusion = options.create_option(
       name="filter_fusion",
       ty=bool,
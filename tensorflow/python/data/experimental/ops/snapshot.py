@@ -102,7 +102,8 @@ def snapshot(path,
     path: A directory where we want to save our snapshots and/or read from a
       previously saved snapshot.
     compression: The type of compression to apply to the Dataset. Currently
-      supports "GZIP" or None. Defaults to None (no compression).
+      supports "GZIP" or None. Defaults to None (no compression). Snapshots
+      are always read back with the compression they were written with.
     reader_path_prefix: A prefix to add to the path when reading from snapshots.
       Defaults to None.
     writer_path_prefix: A prefix to add to the path when writing to snapshots.
@@ -116,6 +117,8 @@ def snapshot(path,
       operation tends to be intensive. Defaults to 1. If > 1, then this might
       introduce non-determinism i.e. the order in which the elements are
       read from the snapshot are different from the order they're written.
+      The files of the snapshot are split among the reader threads, however
+      many writer threads wrote them.
     reader_buffer_size: Maximum number of elements we can prefetch reading from
       the snapshot. Defaults to 1. Increasing this might improve performance
       but will increase memory consumption.
@@ -48,3 +48,14 @@ class ThreadingOptions(options.OptionsBase):
       ty=int,
       docstring=
       "If set, the dataset will use a private threadpool of the given size.")
+
+  private_threadpool_numa_node = options.create_option(
+      name="private_threadpool_numa_node",
+      ty=int,
+      docstring=
+      "If set, the dataset will use a private threadpool whose threads have "
+      "affinity to the given NUMA node. The threads that the dataset starts "
+      "(e.g. for `interleave`) share the affinity and its elements are "
+      "allocated from the allocator of the NUMA node. Unless "
+      "`private_threadpool_size` is set, the threadpool has one thread per "
+      "CPU core of the NUMA node.")
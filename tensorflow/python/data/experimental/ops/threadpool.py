@@ -42,13 +42,19 @@ class PrivateThreadPool(object):
   """A stateful resource that represents a private thread pool."""
 
   def __init__(self, num_threads, display_name=None,
-               max_intra_op_parallelism=1):
-    """Creates a `PrivateThreadPool` with the given number of threads."""
+               max_intra_op_parallelism=1, numa_node=-1):
+    """Creates a `PrivateThreadPool` with the given number of threads.
+
+    If `numa_node` is not -1, the threads of the pool, the threads started by
+    datasets using it and the allocations of their elements have affinity to
+    the given NUMA node.
+    """
     if context.executing_eagerly():
       shared_name = _generate_shared_name("privatethreadpool")
       self._resource = ged_ops.thread_pool_handle(
           num_threads=num_threads,
           max_intra_op_parallelism=max_intra_op_parallelism,
+          numa_node=numa_node,
           display_name=display_name,
           shared_name=shared_name)
       self._resource_deleter = resource_variable_ops.EagerResourceDeleter(
@@ -57,6 +63,7 @@ class PrivateThreadPool(object):
       self._resource = ged_ops.thread_pool_handle(
           num_threads=num_threads,
           max_intra_op_parallelism=max_intra_op_parallelism,
+          numa_node=numa_node,
           display_name=display_name)
 
 
@@ -99,6 +99,7 @@ tf_export("data.experimental.AUTOTUNE").export_constant(__name__, "AUTOTUNE")
 class AutotuneAlgorithm(enum.Enum):
   HILL_CLIMB = 0
   GRADIENT_DESCENT = 1
+  COST_MODEL = 2
 
 
 @tf_export("data.Dataset", v1=[])
@@ -284,7 +285,11 @@ class DatasetV2(tracking_base.Trackable, composite_tensor.CompositeTensor):
       if t_options.max_intra_op_parallelism is not None:
         dataset = _MaxIntraOpParallelismDataset(
             dataset, t_options.max_intra_op_parallelism)
-      if t_options.private_threadpool_size is not None:
+      if t_options.private_threadpool_numa_node is not None:
+        dataset = _PrivateThreadPoolDataset(
+            dataset, t_options.private_threadpool_size or 0,
+            t_options.private_threadpool_numa_node)
+      elif t_options.private_threadpool_size is not None:
         dataset = _PrivateThreadPoolDataset(dataset,
                                             t_options.private_threadpool_size)
     # pylint: disable=protected-access
@@ -306,6 +311,7 @@ class DatasetV2(tracking_base.Trackable, composite_tensor.CompositeTensor):
     autotune = True
     algorithm = AutotuneAlgorithm.HILL_CLIMB
     cpu_budget = 0  # Indicates that all CPU cores should be used.
+    profile = False
     if options.experimental_optimization is not None:
       if options.experimental_optimization.autotune is False:  # pylint: disable=g-bool-id-comparison
         autotune = False
@@ -313,9 +319,11 @@ class DatasetV2(tracking_base.Trackable, composite_tensor.CompositeTensor):
         algorithm = options.experimental_optimization.autotune_algorithm
       if options.experimental_optimization.autotune_cpu_budget is not None:
         cpu_budget = options.experimental_optimization.autotune_cpu_budget
+      if options.experimental_optimization.autotune_profile:
+        profile = True
 
     if autotune:
-      dataset = _ModelDataset(dataset, algorithm, cpu_budget)
+      dataset = _ModelDataset(dataset, algorithm, cpu_budget, profile)
 
     if options.experimental_stats and options.experimental_stats.aggregator:  # pylint: disable=line-too-long
       dataset = _SetStatsAggregatorDataset(  # pylint: disable=protected-access
@@ -3722,12 +3730,19 @@ class _OptionsDataset(UnaryUnchangedStructureDataset):
 class _ModelDataset(UnaryUnchangedStructureDataset):
   """A `Dataset` that acts as an identity, and models performance."""
 
-  def __init__(self, input_dataset, algorithm, cpu_budget):
+  def __init__(self, input_dataset, algorithm, cpu_budget, profile=False):
     self._input_dataset = input_dataset
     # TODO(jsimsa): This check is introduced for forward compatibility and can
     # be removed after 7/24/2019. At that point, all servers are expected to
     # recognize the `algorithm` attribute.
-    if algorithm != AutotuneAlgorithm.HILL_CLIMB:
+    if profile:
+      variant_tensor = gen_dataset_ops.model_dataset(
+          input_dataset._variant_tensor,  # pylint: disable=protected-access
+          algorithm=algorithm,
+          cpu_budget=cpu_budget,
+          profile=profile,
+          **self._flat_structure)
+    elif algorithm != AutotuneAlgorithm.HILL_CLIMB:
       variant_tensor = gen_dataset_ops.model_dataset(
           input_dataset._variant_tensor,  # pylint: disable=protected-access
           algorithm=algorithm,
@@ -3798,14 +3813,23 @@ class _MaxIntraOpParallelismDataset(UnaryUnchangedStructureDataset):
 class _PrivateThreadPoolDataset(UnaryUnchangedStructureDataset):
   """A `Dataset` that acts as an identity, setting a private threadpool."""
 
-  def __init__(self, input_dataset, num_threads):
+  def __init__(self, input_dataset, num_threads, numa_node=None):
     self._input_dataset = input_dataset
     self._num_threads = ops.convert_to_tensor(
         num_threads, dtype=dtypes.int64, name="num_threads")
-    variant_tensor = ged_ops.private_thread_pool_dataset(
-        input_dataset._variant_tensor,  # pylint: disable=protected-access
-        self._num_threads,
-        **self._flat_structure)
+    # The `numa_node` attr is only set when used, so that graphs which do not
+    # use it can be consumed by older binaries.
+    if numa_node is not None:
+      variant_tensor = ged_ops.private_thread_pool_dataset(
+          input_dataset._variant_tensor,  # pylint: disable=protected-access
+          self._num_threads,
+          numa_node=numa_node,
+          **self._flat_structure)
+    else:
+      variant_tensor = ged_ops.private_thread_pool_dataset(
+          input_dataset._variant_tensor,  # pylint: disable=protected-access
+          self._num_threads,
+          **self._flat_structure)
     super(_PrivateThreadPoolDataset, self).__init__(input_dataset,
                                                     variant_tensor)
 
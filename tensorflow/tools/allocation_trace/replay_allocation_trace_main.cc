@@ -0,0 +1,108 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Replays an allocation trace recorded by BFCAllocator (see
+// TF_BFC_ALLOCATOR_TRACE_DIR) against an allocator, and reports its peak
+// memory use, fragmentation and the latency of each call. For example:
+//
+// ./replay_allocation_trace --trace_file=/tmp/GPU_0_bfc.123.alloc_trace
+// --allocator=bfc --memory_limit_mb=4096 --allow_growth=false
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/allocation_trace.h"
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+#include "tensorflow/core/common_runtime/pool_allocator.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace {
+
+Status RealMain(int argc, char** argv) {
+  string trace_file;
+  string allocator_name = "bfc";
+  int64 memory_limit_mb = 4096;
+  bool allow_growth = true;
+  bool garbage_collection = false;
+  int64 size_class_cache_bytes = 0;
+
+  const std::vector<Flag> flag_list = {
+      Flag("trace_file", &trace_file, "Allocation trace to replay."),
+      Flag("allocator", &allocator_name,
+           "Allocator to replay against: \"bfc\" for a BFCAllocator over "
+           "host memory, or \"cpu\" for the default CPU allocator."),
+      Flag("memory_limit_mb", &memory_limit_mb,
+           "Memory limit of the BFC allocator."),
+      Flag("allow_growth", &allow_growth,
+           "Whether the BFC allocator grows its pool as needed rather than "
+           "reserving the whole limit up front."),
+      Flag("garbage_collection", &garbage_collection,
+           "Whether the BFC allocator frees unused regions before failing."),
+      Flag("size_class_cache_bytes", &size_class_cache_bytes,
+           "If positive, enables the BFC allocator's size-class caches for "
+           "allocations of up to this many bytes."),
+  };
+  const string usage = Flags::Usage(argv[0], flag_list);
+  if (!Flags::Parse(&argc, argv, flag_list)) {
+    return errors::InvalidArgument(usage);
+  }
+  port::InitMain(argv[0], &argc, &argv);
+
+  if (trace_file.empty()) {
+    return errors::InvalidArgument("trace_file is a required flag.\n", usage);
+  }
+
+  std::vector<AllocationTraceEvent> events;
+  TF_RETURN_IF_ERROR(ReadAllocationTrace(Env::Default(), trace_file, &events));
+
+  std::unique_ptr<Allocator> owned_allocator;
+  Allocator* allocator;
+  if (allocator_name == "bfc") {
+    auto* bfc = new BFCAllocator(
+        new BasicCPUAllocator(port::kNUMANoAffinity, {}, {}),
+        static_cast<size_t>(memory_limit_mb) << 20, allow_growth,
+        "replay_bfc", garbage_collection);
+    if (size_class_cache_bytes > 0) {
+      bfc->EnableSizeClassCaches(size_class_cache_bytes);
+    }
+    owned_allocator.reset(bfc);
+    allocator = bfc;
+  } else if (allocator_name == "cpu") {
+    allocator = cpu_allocator();
+  } else {
+    return errors::InvalidArgument("Unknown allocator: ", allocator_name);
+  }
+
+  AllocationTraceReplayStats stats;
+  ReplayAllocationTrace(events, allocator, &stats);
+  LOG(INFO) << "Replayed " << events.size() << " events from " << trace_file
+            << " against " << allocator->Name() << "\n"
+            << stats.DebugString();
+  return Status::OK();
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  TF_CHECK_OK(tensorflow::RealMain(argc, argv));
+  return 0;
+}